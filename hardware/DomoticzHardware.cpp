@@ -118,6 +118,22 @@ void CDomoticzHardwareBase::HandleHBCounter(const int iInterval)
 	}
 }
 
+void CDomoticzHardwareBase::AddPollJob(const int delay, const int interval, const std::function<void()> &job, const bool bBlocking)
+{
+	m_mainworker.m_pollservice.AddJob(this, delay, interval, job, bBlocking);
+}
+
+void CDomoticzHardwareBase::SetPollHeartbeat(const int maxruntime)
+{
+	m_LastHeartbeat = mytime(nullptr);
+	m_mainworker.m_pollservice.SetHeartbeat(this, maxruntime, [this] { m_LastHeartbeat = mytime(nullptr); });
+}
+
+void CDomoticzHardwareBase::RemovePollJobs()
+{
+	m_mainworker.m_pollservice.RemoveJobs(this);
+}
+
 int CDomoticzHardwareBase::SetThreadNameInt(const std::thread::native_handle_type& thread)
 {
 	return SetThreadName(thread, m_Name.c_str());
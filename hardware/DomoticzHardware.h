@@ -81,6 +81,15 @@ class CDomoticzHardwareBase : public StoppableTask
 	void StopHeartbeatThread();
 	void HandleHBCounter(int iInterval);
 
+	// Jobs on the shared poll service, for drivers that only poll and need no thread of their own
+	// First run after 'delay' seconds, then every 'interval' seconds (0 = run once)
+	// bBlocking: the job waits on the network, see CPollService
+	void AddPollJob(int delay, int interval, const std::function<void()> &job, bool bBlocking = false);
+	// Keeps m_LastHeartbeat current while no job of this hardware runs longer than 'maxruntime' seconds
+	void SetPollHeartbeat(int maxruntime);
+	// Must be called from StopHardware, waits for a running job of this hardware
+	void RemovePollJobs();
+
 	// Sensor Helpers
 	void SendTempSensor(int NodeID, int BatteryLevel, float temperature, const std::string &defaultname, int RssiLevel = 12);
 	void SendHumiditySensor(int NodeID, int BatteryLevel, int humidity, const std::string &defaultname, int RssiLevel = 12);
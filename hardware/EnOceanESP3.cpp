@@ -420,6 +420,9 @@ CEnOceanESP3::CEnOceanESP3(const int ID, const std::string &devname, const int t
 	m_szSerialPort = devname;
 	m_Type = type;
 	m_id_base = 0;
+	m_bufferpos = 0;
+	m_receivestate = ERS_SYNCBYTE;
+	m_wait_version_base = false;
 }
 
 bool CEnOceanESP3::StartHardware()
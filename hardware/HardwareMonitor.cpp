@@ -27,6 +27,12 @@
 	#include <string>
 	#include <limits>
 	#include <unistd.h>
+#if defined(__linux__)
+	#include <fcntl.h>
+	#include <dirent.h>
+	#include <mntent.h>
+	#include <sys/statvfs.h>
+#endif
 
 //USER_HZ detection, from openssl code
 #ifndef HZ
@@ -65,6 +71,15 @@ CHardwareMonitor::CHardwareMonitor(const int ID)
 	m_lastquerytime = 0;
 	m_totcpu = 0;
 	m_lastloadcpu = 0;
+#if defined(__linux__)
+	m_fdProcStat = -1;
+	m_fdMemInfo = -1;
+	m_fdProcessStatus = -1;
+	m_fdInternalTemperature = -1;
+	m_fdARMClockSpeed = -1;
+	m_fdInternalVoltage = -1;
+	m_fdInternalCurrent = -1;
+#endif
 #ifdef WIN32
 	m_pLocator = nullptr;
 	m_pServicesOHM = nullptr;
@@ -103,6 +118,9 @@ bool CHardwareMonitor::StartHardware()
 		return false;
 	}
 
+#if defined(__linux__)
+	OpenProcFiles();
+#endif
 	CheckForOnboardSensors();
 
 	RequestStart();
@@ -130,6 +148,9 @@ bool CHardwareMonitor::StopHardware()
 	}
 #ifdef WIN32
 	ExitWMI();
+#endif
+#if defined(__linux__)
+	CloseProcFiles();
 #endif
 	m_bIsStarted = false;
 	return true;
@@ -216,21 +237,35 @@ void CHardwareMonitor::SendCurrent(const unsigned long Idx, const float Curr, co
 void CHardwareMonitor::GetInternalTemperature()
 {
 	Debug(DEBUG_NORM,"Getting Internal Temperature");
-	int returncode = 0;
-	std::vector<std::string> ret = ExecuteCommandAndReturn(szInternalTemperatureCommand, returncode);
-	if (ret.empty())
-		return;
-	std::string tmpline = ret[0];
-	if (tmpline.find("temp=") == std::string::npos)
-		return;
-	tmpline = tmpline.substr(5);
-	size_t pos = tmpline.find('\'');
-	if (pos != std::string::npos)
+	float temperature = 0;
+#if defined(__linux__)
+	if (m_fdInternalTemperature != -1)
 	{
-		tmpline = tmpline.substr(0, pos);
+		double value;
+		if (!ReadSysfsValue(m_fdInternalTemperature, value))
+			return;
+		//most kernels report millidegrees
+		temperature = static_cast<float>((value < 100) ? value : value / 1000.0);
+	}
+	else
+#endif
+	{
+		int returncode = 0;
+		std::vector<std::string> ret = ExecuteCommandAndReturn(szInternalTemperatureCommand, returncode);
+		if (ret.empty())
+			return;
+		std::string tmpline = ret[0];
+		if (tmpline.find("temp=") == std::string::npos)
+			return;
+		tmpline = tmpline.substr(5);
+		size_t pos = tmpline.find('\'');
+		if (pos != std::string::npos)
+		{
+			tmpline = tmpline.substr(0, pos);
+		}
+		temperature = static_cast<float>(atof(tmpline.c_str()));
 	}
 
-	float temperature = static_cast<float>(atof(tmpline.c_str()));
 	if (temperature == 0)
 		return; //hardly possible for a on board temp sensor, if it is, it is probably not working
 
@@ -244,6 +279,18 @@ void CHardwareMonitor::GetInternalARMClockSpeed()
 {
 	Debug(DEBUG_NORM,"Getting ARM Clock speed");
 	float ArmClockSpeed = 0.0;
+#if defined(__linux__)
+	if (m_fdARMClockSpeed != -1)
+	{
+		double value;
+		if (!ReadSysfsValue(m_fdARMClockSpeed, value))
+			return;
+		ArmClockSpeed = static_cast<float>(value / 1000.0); //kHz
+		Debug(DEBUG_NORM,"Updating sensor with value %.2f",ArmClockSpeed);
+		SendCustomSensor(0, 1, 255, ArmClockSpeed, "Arm Clock Speed","MHz");
+		return;
+	}
+#endif
 	int returncode = 0;
 	std::vector<std::string> ret = ExecuteCommandAndReturn(szInternalARMSpeedCommand, returncode);
 	if (ret.empty())
@@ -336,21 +383,34 @@ void CHardwareMonitor::GetInternalCoreClockSpeed()
 void CHardwareMonitor::GetInternalVoltage()
 {
 	Debug(DEBUG_NORM,"Getting Internal Voltage");
-	int returncode = 0;
-	std::vector<std::string> ret = ExecuteCommandAndReturn(szInternalVoltageCommand, returncode);
-	if (ret.empty())
-		return;
-	std::string tmpline = ret[0];
-	if (tmpline.find("volt=") == std::string::npos)
-		return;
-	tmpline = tmpline.substr(5);
-	size_t pos = tmpline.find('\'');
-	if (pos != std::string::npos)
+	float voltage = 0;
+#if defined(__linux__)
+	if (m_fdInternalVoltage != -1)
 	{
-		tmpline = tmpline.substr(0, pos);
+		double value;
+		if (!ReadSysfsValue(m_fdInternalVoltage, value))
+			return;
+		voltage = static_cast<float>(value / 1000000.0); //uV
+	}
+	else
+#endif
+	{
+		int returncode = 0;
+		std::vector<std::string> ret = ExecuteCommandAndReturn(szInternalVoltageCommand, returncode);
+		if (ret.empty())
+			return;
+		std::string tmpline = ret[0];
+		if (tmpline.find("volt=") == std::string::npos)
+			return;
+		tmpline = tmpline.substr(5);
+		size_t pos = tmpline.find('\'');
+		if (pos != std::string::npos)
+		{
+			tmpline = tmpline.substr(0, pos);
+		}
+		voltage = static_cast<float>(atof(tmpline.c_str()));
 	}
 
-	float voltage = static_cast<float>(atof(tmpline.c_str()));
 	if (voltage == 0)
 		return; //hardly possible for a on board temp sensor, if it is, it is probably not working
 
@@ -360,21 +420,34 @@ void CHardwareMonitor::GetInternalVoltage()
 void CHardwareMonitor::GetInternalCurrent()
 {
 	Debug(DEBUG_NORM,"Getting Internal Current");
-	int returncode = 0;
-	std::vector<std::string> ret = ExecuteCommandAndReturn(szInternalCurrentCommand, returncode);
-	if (ret.empty())
-		return;
-	std::string tmpline = ret[0];
-	if (tmpline.find("curr=") == std::string::npos)
-		return;
-	tmpline = tmpline.substr(5);
-	size_t pos = tmpline.find('\'');
-	if (pos != std::string::npos)
+	float current = 0;
+#if defined(__linux__)
+	if (m_fdInternalCurrent != -1)
 	{
-		tmpline = tmpline.substr(0, pos);
+		double value;
+		if (!ReadSysfsValue(m_fdInternalCurrent, value))
+			return;
+		current = static_cast<float>(value / 1000000.0); //uA
+	}
+	else
+#endif
+	{
+		int returncode = 0;
+		std::vector<std::string> ret = ExecuteCommandAndReturn(szInternalCurrentCommand, returncode);
+		if (ret.empty())
+			return;
+		std::string tmpline = ret[0];
+		if (tmpline.find("curr=") == std::string::npos)
+			return;
+		tmpline = tmpline.substr(5);
+		size_t pos = tmpline.find('\'');
+		if (pos != std::string::npos)
+		{
+			tmpline = tmpline.substr(0, pos);
+		}
+		current = static_cast<float>(atof(tmpline.c_str()));
 	}
 
-	float current = static_cast<float>(atof(tmpline.c_str()));
 	if (current == 0)
 		return; //hardly possible for a on board temp sensor, if it is, it is probably not working
 
@@ -424,6 +497,12 @@ void CHardwareMonitor::UpdateSystemSensor(const std::string& qType, const int di
 		float usage = static_cast<float>(atof(devValue.c_str()));
 		SendCustomSensor(0, doffset + dindex, 255, usage, devName, "MB");
 	}
+	else if (qType == "ProcessLoad")
+	{
+		doffset = 1600;
+		float perc = static_cast<float>(atof(devValue.c_str()));
+		SendPercentageSensor(doffset + dindex, 0, 255, perc, devName);
+	}
 }
 
 bool CHardwareMonitor::GetOSType(nOSType &OStype)
@@ -719,38 +798,173 @@ void CHardwareMonitor::RunWMIQuery(const char* qTable, const std::string &qType)
 	}
 
 #if defined(__linux__)
+	void CHardwareMonitor::OpenProcFiles()
+	{
+		m_fdProcStat = open("/proc/stat", O_RDONLY | O_CLOEXEC);
+		m_fdMemInfo = open("/proc/meminfo", O_RDONLY | O_CLOEXEC);
+		m_fdProcessStatus = open("/proc/self/status", O_RDONLY | O_CLOEXEC);
+		m_threadticks.clear();
+	}
+
+	void CHardwareMonitor::CloseProcFiles()
+	{
+		int *fds[] = { &m_fdProcStat, &m_fdMemInfo, &m_fdProcessStatus, &m_fdInternalTemperature, &m_fdARMClockSpeed, &m_fdInternalVoltage, &m_fdInternalCurrent };
+		for (auto fd : fds)
+		{
+			if (*fd != -1)
+				close(*fd);
+			*fd = -1;
+		}
+	}
+
+	//Read a /proc or sysfs file from the start, the kernel regenerates the content for every read at offset 0
+	bool CHardwareMonitor::ReadProcFile(const int fd, char *buf, const size_t bufsize)
+	{
+		if (fd == -1)
+			return false;
+		ssize_t num_read = pread(fd, buf, bufsize - 1, 0);
+		if (num_read <= 0)
+			return false;
+		buf[num_read] = 0;
+		return true;
+	}
+
+	//(Re)open a sysfs attribute, a later detected sensor replaces the previous one
+	static void OpenSysfsFile(int &fd, const char *szPath)
+	{
+		if (fd != -1)
+			close(fd);
+		fd = open(szPath, O_RDONLY | O_CLOEXEC);
+	}
+
+	bool CHardwareMonitor::ReadSysfsValue(const int fd, double &value)
+	{
+		char buf[64];
+		if (!ReadProcFile(fd, buf, sizeof(buf)))
+			return false;
+		char *pEnd = nullptr;
+		value = strtod(buf, &pEnd);
+		return (pEnd != buf);
+	}
+
+	//Find a "Token:   value" line in a /proc file like meminfo or status
+	static bool GetProcTokenValue(const char *buf, const char *token, unsigned long &value)
+	{
+		const char *pos = buf;
+		size_t tlen = strlen(token);
+		while ((pos = strstr(pos, token)) != nullptr)
+		{
+			if ((pos == buf) || (*(pos - 1) == '\n'))
+			{
+				value = strtoul(pos + tlen, nullptr, 10);
+				return true;
+			}
+			pos += tlen;
+		}
+		return false;
+	}
+
 	float CHardwareMonitor::GetProcessMemUsage()
 	{
-		pid_t pid = getpid();
-		std::stringstream ssPidfile;
-		ssPidfile << "/proc/" << pid << "/status";
-		std::ifstream mfile(ssPidfile.str().c_str());
-		if (!mfile.is_open())
+		char buf[4096];
+		if (!ReadProcFile(m_fdProcessStatus, buf, sizeof(buf)))
 			return -1;
-		uint32_t VmRSS = -1;
-		uint32_t VmSwap = -1;
-		std::string token;
-		while (mfile >> token)
+		unsigned long VmRSS = 0;
+		unsigned long VmSwap = 0;
+		if (!GetProcTokenValue(buf, "VmRSS:", VmRSS))
+			return -1;
+		GetProcTokenValue(buf, "VmSwap:", VmSwap);
+		return (VmRSS + VmSwap) / 1000.F;
+	}
+
+	//CPU time used by our own threads since the previous call (elapsed seconds ago)
+	void CHardwareMonitor::FetchProcessThreadsCPU(const double elapsed)
+	{
+		DIR *d = opendir("/proc/self/task");
+		if (d == nullptr)
+			return;
+
+		std::map<int, long long> threadticks;
+		std::vector<std::pair<long long, std::string>> threadusage;
+		long long totalticks = 0;
+		char szPath[80];
+		char buf[1024];
+		struct dirent *de;
+		while ((de = readdir(d)) != nullptr)
 		{
-			if (token == "VmRSS:")
-				mfile >> VmRSS;
-			else if (token == "VmSwap:")
-				mfile >> VmSwap;
+			int tid = atoi(de->d_name);
+			if (tid <= 0)
+				continue;
+			sprintf(szPath, "/proc/self/task/%d/stat", tid);
+			int fd = open(szPath, O_RDONLY | O_CLOEXEC);
+			if (fd == -1)
+				continue;
+			bool bRead = ReadProcFile(fd, buf, sizeof(buf));
+			close(fd);
+			if (!bRead)
+				continue;
+			//pid (comm) state ... field 14 utime, 15 stime, the comm can contain spaces and brackets
+			char *pNameStart = strchr(buf, '(');
+			char *pNameEnd = strrchr(buf, ')');
+			if ((pNameStart == nullptr) || (pNameEnd == nullptr) || (pNameEnd < pNameStart))
+				continue;
+			unsigned long long utime, stime;
+			if (sscanf(pNameEnd + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %llu %llu", &utime, &stime) != 2)
+				continue;
+			long long ticks = utime + stime;
+			threadticks[tid] = ticks;
+
+			auto itt = m_threadticks.find(tid);
+			long long dticks = (itt != m_threadticks.end()) ? ticks - itt->second : ticks;
+			if (dticks <= 0)
+				continue;
+			totalticks += dticks;
+			threadusage.push_back(std::make_pair(dticks, std::string(pNameStart + 1, pNameEnd)));
+		}
+		closedir(d);
 
-			// ignore rest of the line
-			mfile.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+		bool bFirstTime = m_threadticks.empty();
+		m_threadticks = threadticks;
+		if ((bFirstTime) || (elapsed <= 0) || (m_totcpu < 1))
+			return;
+
+		char szTmp[50];
+		sprintf(szTmp, "%.2f", ((totalticks / (elapsed * HZ)) * 100) / double(m_totcpu));
+		UpdateSystemSensor("ProcessLoad", 0, "Process CPU Usage", szTmp);
+
+		if (_log.IsDebugLevelEnabled(DEBUG_NORM))
+		{
+			//busiest threads first, as percentage of a single core
+			std::sort(threadusage.begin(), threadusage.end(), std::greater<std::pair<long long, std::string>>());
+			for (const auto &itt : threadusage)
+				Debug(DEBUG_NORM, "Thread %s: %.2f%%", itt.second.c_str(), (itt.first / (elapsed * HZ)) * 100);
 		}
-		return (VmRSS + VmSwap) / 1000.F;
 	}
 #endif
 
+#if defined(__linux__)
+	float CHardwareMonitor::GetMemUsageLinux()
+	{
+		char buf[4096];
+		if (!ReadProcFile(m_fdMemInfo, buf, sizeof(buf)))
+			return -1;
+		unsigned long MemTotal = 0;
+		unsigned long MemFree = 0;
+		unsigned long MemBuffers = 0;
+		unsigned long MemCached = 0;
+		if ((!GetProcTokenValue(buf, "MemTotal:", MemTotal)) || (MemTotal == 0))
+			return -1;
+		GetProcTokenValue(buf, "MemFree:", MemFree);
+		GetProcTokenValue(buf, "Buffers:", MemBuffers);
+		GetProcTokenValue(buf, "Cached:", MemCached);
+		unsigned long MemUsed = MemTotal - MemFree - MemBuffers - MemCached;
+		float memusedpercentage = (100.0F / float(MemTotal)) * MemUsed;
+		return memusedpercentage;
+	}
+#elif defined(__FreeBSD__)
 	float CHardwareMonitor::GetMemUsageLinux()
 	{
-#if defined(__FreeBSD__)
 		std::ifstream mfile("/compat/linux/proc/meminfo");
-#else	// Linux
-		std::ifstream mfile("/proc/meminfo");
-#endif
 		if (!mfile.is_open())
 			return -1;
 		unsigned long MemTotal = -1;
@@ -778,6 +992,7 @@ void CHardwareMonitor::RunWMIQuery(const char* qTable, const std::string &qType)
 		float memusedpercentage = (100.0F / float(MemTotal)) * MemUsed;
 		return memusedpercentage;
 	}
+#endif
 
 #ifdef __OpenBSD__
 	float CHardwareMonitor::GetMemUsageOpenBSD()
@@ -890,6 +1105,29 @@ void CHardwareMonitor::FetchUnixCPU()
 		m_lastquerytime = time_so_far();
 		int actload1,actload2,actload3;
 		int totcpu=-1;
+#if defined(__linux__)
+		char szStat[16384];
+		if (ReadProcFile(m_fdProcStat, szStat, sizeof(szStat)))
+		{
+			bool bFirstLine = true;
+			char *pLine = szStat;
+			while (pLine != nullptr)
+			{
+				int ret = sscanf(pLine, "%49s %d %d %d", cname, &actload1, &actload2, &actload3);
+				if ((bFirstLine) && (ret == 4)) {
+					bFirstLine = false;
+					m_lastloadcpu = actload1 + actload2 + actload3;
+				}
+				if ((ret < 1) || (strstr(cname, "cpu") == nullptr))
+					break;
+				totcpu++;
+				pLine = strchr(pLine, '\n');
+				if (pLine != nullptr)
+					pLine++;
+			}
+		}
+		FetchProcessThreadsCPU(0);
+#else
 #if defined(__FreeBSD__)
 		FILE *fIn = fopen("/compat/linux/proc/stat", "r");
 #else	// Linux
@@ -912,6 +1150,7 @@ void CHardwareMonitor::FetchUnixCPU()
 			}
 			fclose(fIn);
 		}
+#endif
 		if (totcpu<1)
 			m_lastquerytime=0;
 		else
@@ -943,26 +1182,33 @@ void CHardwareMonitor::FetchUnixCPU()
 		}
 #else
 		int actload1,actload2,actload3;
+		int ret = 0;
+#if defined(__linux__)
+		if (ReadProcFile(m_fdProcStat, szTmp, sizeof(szTmp)))
+			ret = sscanf(szTmp, "%49s %d %d %d", cname, &actload1, &actload2, &actload3);
+		FetchProcessThreadsCPU(difftime(acttime, m_lastquerytime));
+#else
 #if defined(__FreeBSD__)
 		FILE *fIn = fopen("/compat/linux/proc/stat", "r");
-#else	// Linux
+#else
 		FILE *fIn = fopen("/proc/stat", "r");
 #endif
 		if (fIn != nullptr)
 		{
-			int ret=fscanf(fIn, "%s\t%d\t%d\t%d\n", cname, &actload1, &actload2, &actload3);
+			ret=fscanf(fIn, "%s\t%d\t%d\t%d\n", cname, &actload1, &actload2, &actload3);
 			fclose(fIn);
-			if (ret==4)
+		}
+#endif
+		if (ret==4)
+		{
+			long long t = (actload1+actload2+actload3)-m_lastloadcpu;
+			double cpuper=((t / (difftime(acttime,m_lastquerytime) * HZ)) * 100)/double(m_totcpu);
+			if (cpuper>0)
 			{
-				long long t = (actload1+actload2+actload3)-m_lastloadcpu;
-				double cpuper=((t / (difftime(acttime,m_lastquerytime) * HZ)) * 100)/double(m_totcpu);
-				if (cpuper>0)
-				{
-					sprintf(szTmp,"%.2f", cpuper);
-					UpdateSystemSensor("Load", 1, "CPU_Usage", szTmp);
-				}
-				m_lastloadcpu=actload1+actload2+actload3;
+				sprintf(szTmp,"%.2f", cpuper);
+				UpdateSystemSensor("Load", 1, "CPU_Usage", szTmp);
 			}
+			m_lastloadcpu=actload1+actload2+actload3;
 		}
 #endif //else Openbsd
 		m_lastquerytime=acttime;
@@ -974,57 +1220,88 @@ void CHardwareMonitor::FetchUnixDisk()
 	//Disk Usage
 	std::map<std::string, _tDUsageStruct> _disks;
 	std::map<std::string, std::string> _dmounts_;
+#if defined(__linux__)
+	//Walk the mounted filesystems ourself instead of running df
+	FILE *fMounts = setmntent("/proc/mounts", "r");
+	if (fMounts == nullptr)
+		return;
+	struct mntent *pMount;
+	while ((pMount = getmntent(fMounts)) != nullptr)
+	{
+		//only block devices, this also skips nfs/tmpfs/devtmpfs
+		if (strstr(pMount->mnt_fsname, "/dev") == nullptr)
+			continue;
+		std::map<std::string, std::string>::iterator it = _dmounts_.find(pMount->mnt_fsname);
+		if (it != _dmounts_.end())
+		{
+			if (it->second.length() < strlen(pMount->mnt_dir))
+			{
+				continue;
+			}
+		}
+		struct statvfs vfs;
+		if (statvfs(pMount->mnt_dir, &vfs) != 0)
+			continue;
+		//1K blocks, like df
+		_tDUsageStruct dusage;
+		dusage.TotalBlocks = static_cast<long long>(vfs.f_blocks) * vfs.f_frsize / 1024;
+		dusage.UsedBlocks = static_cast<long long>(vfs.f_blocks - vfs.f_bfree) * vfs.f_frsize / 1024;
+		dusage.AvailBlocks = static_cast<long long>(vfs.f_bavail) * vfs.f_frsize / 1024;
+		dusage.MountPoint = pMount->mnt_dir;
+		_disks[pMount->mnt_fsname] = dusage;
+		_dmounts_[pMount->mnt_fsname] = pMount->mnt_dir;
+	}
+	endmntent(fMounts);
+#else
 	int returncode = 0;
 	std::vector<std::string> _rlines=ExecuteCommandAndReturn(m_dfcommand, returncode);
-	if (!_rlines.empty())
+	for (const auto & ittDF : _rlines)
 	{
-		for (const auto & ittDF : _rlines)
+		char dname[200];
+		char suse[30];
+		char smountpoint[300];
+		long long numblock, usedblocks, availblocks;
+		int ret = sscanf(ittDF.c_str(), "%s\t%lld\t%lld\t%lld\t%s\t%s\n", dname, &numblock, &usedblocks, &availblocks, suse, smountpoint);
+		if (ret == 6)
 		{
-			char dname[200];
-			char suse[30];
-			char smountpoint[300];
-			long long numblock, usedblocks, availblocks;
-			int ret = sscanf(ittDF.c_str(), "%s\t%lld\t%lld\t%lld\t%s\t%s\n", dname, &numblock, &usedblocks, &availblocks, suse, smountpoint);
-			if (ret == 6)
+			std::map<std::string, std::string>::iterator it = _dmounts_.find(dname);
+			if (it != _dmounts_.end())
 			{
-				std::map<std::string, std::string>::iterator it = _dmounts_.find(dname);
-				if (it != _dmounts_.end())
+				if (it->second.length() < strlen(smountpoint))
 				{
-					if (it->second.length() < strlen(smountpoint))
-					{
-						continue;
-					}
+					continue;
 				}
-#if defined(__linux__) || defined(__FreeBSD__) || defined (__OpenBSD__)
-				if (strstr(dname, "/dev") != nullptr)
+			}
+#if defined(__FreeBSD__) || defined (__OpenBSD__)
+			if (strstr(dname, "/dev") != nullptr)
 #elif defined(__CYGWIN32__)
-				if (strstr(smountpoint, "/cygdrive/") != nullptr)
+			if (strstr(smountpoint, "/cygdrive/") != nullptr)
 #endif
-				{
-					_tDUsageStruct dusage;
-					dusage.TotalBlocks = numblock;
-					dusage.UsedBlocks = usedblocks;
-					dusage.AvailBlocks = availblocks;
-					dusage.MountPoint = smountpoint;
-					_disks[dname] = dusage;
-					_dmounts_[dname] = smountpoint;
-				}
+			{
+				_tDUsageStruct dusage;
+				dusage.TotalBlocks = numblock;
+				dusage.UsedBlocks = usedblocks;
+				dusage.AvailBlocks = availblocks;
+				dusage.MountPoint = smountpoint;
+				_disks[dname] = dusage;
+				_dmounts_[dname] = smountpoint;
 			}
 		}
-		int dindex = 0;
-		for (const auto & ittDisks : _disks)
+	}
+#endif
+	int dindex = 0;
+	for (const auto & ittDisks : _disks)
+	{
+		_tDUsageStruct dusage = ittDisks.second;
+		if (dusage.TotalBlocks > 0)
 		{
-			_tDUsageStruct dusage = ittDisks.second;
-			if (dusage.TotalBlocks > 0)
-			{
-				double UsagedPercentage = (100 / double(dusage.TotalBlocks))*double(dusage.UsedBlocks);
-				//std::cout << "Disk: " << ittDisks.first << ", Mount: " << dusage.MountPoint << ", Used: " << UsagedPercentage << std::endl;
-				char szTmp[300];
-				sprintf(szTmp, "%.2f", UsagedPercentage);
-				std::string hddname = "HDD " + dusage.MountPoint;
-				UpdateSystemSensor("Load", 2 + dindex, hddname, szTmp);
-				dindex++;
-			}
+			double UsagedPercentage = (100 / double(dusage.TotalBlocks))*double(dusage.UsedBlocks);
+			//std::cout << "Disk: " << ittDisks.first << ", Mount: " << dusage.MountPoint << ", Used: " << UsagedPercentage << std::endl;
+			char szTmp[300];
+			sprintf(szTmp, "%.2f", UsagedPercentage);
+			std::string hddname = "HDD " + dusage.MountPoint;
+			UpdateSystemSensor("Load", 2 + dindex, hddname, szTmp);
+			dindex++;
 		}
 	}
 }
@@ -1077,7 +1354,7 @@ void CHardwareMonitor::CheckForOnboardSensors()
 	return;
 #endif
 
-#if defined(__linux__) || defined(__CYGWIN32__) || defined(__FreeBSD__) || defined(__OpenBSD__)
+#if defined(__CYGWIN32__) || defined(__FreeBSD__) || defined(__OpenBSD__)
 	// Busybox df doesn't support -x parameter
 	int returncode = 0;
 	std::vector<std::string> ret = ExecuteCommandAndReturn("df -x nfs -x tmpfs -x devtmpfs 2> /dev/null", returncode);
@@ -1152,18 +1429,36 @@ void CHardwareMonitor::CheckForOnboardSensors()
 		m_OStype = OStype_Rpi;
 	}
 
+#if defined(__linux__)
+	if (bPi)
+	{
+		//same SoC sensor and ARM clock as reported by vcgencmd, without spawning it
+		OpenSysfsFile(m_fdInternalTemperature, "/sys/class/thermal/thermal_zone0/temp");
+		if (m_fdInternalTemperature != -1)
+			bHasInternalTemperature = true;
+		if (bHasInternalClockSpeeds)
+			OpenSysfsFile(m_fdARMClockSpeed, "/sys/devices/system/cpu/cpu0/cpufreq/scaling_cur_freq");
+	}
+#endif
+
 	if (!bHasInternalTemperature)
 	{
 		if (file_exist("/sys/devices/platform/sunxi-i2c.0/i2c-0/0-0034/temp1_input"))
 		{
 			Log(LOG_STATUS, "System: Cubieboard/Cubietruck");
 			szInternalTemperatureCommand = R"(cat /sys/devices/platform/sunxi-i2c.0/i2c-0/0-0034/temp1_input | awk '{ printf ("temp=%0.2f\n",$1/1000); }')";
+#if defined(__linux__)
+			OpenSysfsFile(m_fdInternalTemperature, "/sys/devices/platform/sunxi-i2c.0/i2c-0/0-0034/temp1_input");
+#endif
 			bHasInternalTemperature = true;
 		}
 		else if (file_exist("/sys/devices/virtual/thermal/thermal_zone0/temp"))
 		{
 			Log(LOG_STATUS,"System: ODroid");
 			szInternalTemperatureCommand = R"(cat /sys/devices/virtual/thermal/thermal_zone0/temp | awk '{ if ($1 < 100) printf("temp=%d\n",$1); else printf ("temp=%0.2f\n",$1/1000); }')";
+#if defined(__linux__)
+			OpenSysfsFile(m_fdInternalTemperature, "/sys/devices/virtual/thermal/thermal_zone0/temp");
+#endif
 			bHasInternalTemperature = true;
 		}
 	}
@@ -1171,12 +1466,18 @@ void CHardwareMonitor::CheckForOnboardSensors()
 	{
 		Debug(DEBUG_NORM, "Internal voltage sensor detected");
 		szInternalVoltageCommand = R"(cat /sys/class/power_supply/ac/voltage_now | awk '{ printf ("volt=%0.2f\n",$1/1000000); }')";
+#if defined(__linux__)
+		OpenSysfsFile(m_fdInternalVoltage, "/sys/class/power_supply/ac/voltage_now");
+#endif
 		bHasInternalVoltage = true;
 	}
 	if (file_exist("/sys/class/power_supply/ac/current_now"))
 	{
 		Debug(DEBUG_NORM, "Internal current sensor detected");
 		szInternalCurrentCommand = R"(cat /sys/class/power_supply/ac/current_now | awk '{ printf ("curr=%0.2f\n",$1/1000000); }')";
+#if defined(__linux__)
+		OpenSysfsFile(m_fdInternalCurrent, "/sys/class/power_supply/ac/current_now");
+#endif
 		bHasInternalCurrent = true;
 	}
 	//New Armbian Kernal 4.14+
@@ -1184,12 +1485,18 @@ void CHardwareMonitor::CheckForOnboardSensors()
 	{
 		Debug(DEBUG_NORM, "Internal voltage sensor detected");
 		szInternalVoltageCommand = R"(cat /sys/class/power_supply/axp20x-ac/voltage_now | awk '{ printf ("volt=%0.2f\n",$1/1000000); }')";
+#if defined(__linux__)
+		OpenSysfsFile(m_fdInternalVoltage, "/sys/class/power_supply/axp20x-ac/voltage_now");
+#endif
 		bHasInternalVoltage = true;
 	}
 	if (file_exist("/sys/class/power_supply/axp20x-ac/current_now"))
 	{
 		Debug(DEBUG_NORM, "Internal current sensor detected");
 		szInternalCurrentCommand = R"(cat /sys/class/power_supply/axp20x-ac/current_now | awk '{ printf ("curr=%0.2f\n",$1/1000000); }')";
+#if defined(__linux__)
+		OpenSysfsFile(m_fdInternalCurrent, "/sys/class/power_supply/axp20x-ac/current_now");
+#endif
 		bHasInternalCurrent = true;
 	}
 #endif
@@ -98,6 +98,20 @@ class CHardwareMonitor : public CDomoticzHardwareBase
 	double time_so_far();
 #if defined(__linux__)
 	float GetProcessMemUsage();
+	void FetchProcessThreadsCPU(double elapsed);
+	void OpenProcFiles();
+	void CloseProcFiles();
+	bool ReadProcFile(int fd, char *buf, size_t bufsize);
+	bool ReadSysfsValue(int fd, double &value);
+	//kept open and read with pread on every poll
+	int m_fdProcStat;
+	int m_fdMemInfo;
+	int m_fdProcessStatus;
+	int m_fdInternalTemperature;
+	int m_fdARMClockSpeed;
+	int m_fdInternalVoltage;
+	int m_fdInternalCurrent;
+	std::map<int, long long> m_threadticks; //thread id -> utime+stime
 #endif
 #if defined(__linux__) || defined(__FreeBSD__)
 	float GetMemUsageLinux();
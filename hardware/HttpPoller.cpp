@@ -14,6 +14,9 @@
 
 #define round(a) ( int ) ( a + .5 )
 
+//one request (connect and transfer timeout) and the script
+#define POLL_MAX_RUNTIME 120
+
 CHttpPoller::CHttpPoller(const int ID, const std::string& username, const std::string& password, const std::string& url, const std::string& extradata, const unsigned short refresh) :
 m_username(CURLEncode::URLEncode(username)),
 m_password(CURLEncode::URLEncode(password)),
@@ -53,44 +56,23 @@ bool CHttpPoller::WriteToHardware(const char* /*pdata*/, const unsigned char /*l
 
 bool CHttpPoller::StartHardware()
 {
-	RequestStart();
-
 	Init();
-	//Start worker thread
-	m_thread = std::make_shared<std::thread>([this] { Do_Work(); });
-	SetThreadNameInt(m_thread->native_handle());
+	//Poll on the shared poll service
+	Log(LOG_STATUS, "Worker started...");
+	SetPollHeartbeat(POLL_MAX_RUNTIME);
+	AddPollJob(5, m_refresh, [this] { GetScript(); }, true);
 	m_bIsStarted=true;
 	sOnConnected(this);
-	return (m_thread != nullptr);
+	return true;
 }
 
 bool CHttpPoller::StopHardware()
 {
-	if (m_thread)
-	{
-		RequestStop();
-		m_thread->join();
-		m_thread.reset();
-	}
-    m_bIsStarted=false;
-    return true;
-}
-
-void CHttpPoller::Do_Work()
-{
-	int sec_counter = 300 - 5;
-	Log(LOG_STATUS, "Worker started...");
-	while (!IsStopRequested(1000))
-	{
-		sec_counter++;
-		if (sec_counter % 12 == 0) {
-			m_LastHeartbeat = mytime(nullptr);
-		}
-		if (sec_counter % m_refresh == 0) {
-			GetScript();
-		}
-	}
-	Log(LOG_STATUS,"Worker stopped...");
+	RemovePollJobs();
+	if (m_bIsStarted)
+		Log(LOG_STATUS, "Worker stopped...");
+	m_bIsStarted=false;
+	return true;
 }
 
 void CHttpPoller::GetScript()
@@ -18,7 +18,6 @@ class CHttpPoller : public CDomoticzHardwareBase
 	void Init();
 	bool StartHardware() override;
 	bool StopHardware() override;
-	void Do_Work();
 	void GetScript();
 
       private:
@@ -31,5 +30,4 @@ class CHttpPoller : public CDomoticzHardwareBase
 	std::string m_postdata;
 	unsigned short m_method;
 	unsigned short m_refresh;
-	std::shared_ptr<std::thread> m_thread;
 };
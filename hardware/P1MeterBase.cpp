@@ -119,9 +119,88 @@ constexpr std::array<P1Match, 24> p1_matchlist{
 		{ _eP1MatchType::GAS, P1TYPE_GASUSAGEDSMR4, P1GUDSMR4, "gasusage", 26, 8 },	      //
 		{ _eP1MatchType::LINE17, P1TYPE_GASTIMESTAMP, P1GTS, "gastimestamp", 11, 12 },	      //
 		{ _eP1MatchType::LINE18, P1TYPE_GASUSAGE, P1GUDSMR2, "gasusage", 1, 9 },	      //
-	}											      // must keep DEVTYPE, GAS, LINE17 and LINE18 in this order at end of p1_matchlist
+	}
 };
 
+namespace
+{
+	constexpr bool KeyEquals(const char *a, const char *b)
+	{
+		while ((*a != 0) && (*a == *b))
+		{
+			a++;
+			b++;
+		}
+		return (*a == *b);
+	}
+
+	// Position of a key in p1_matchlist, evaluated by the compiler (an unknown key does not compile)
+	constexpr size_t P1Index(const char *key, const size_t ii = 0)
+	{
+		return KeyEquals(p1_matchlist.at(ii).key, key) ? ii : P1Index(key, ii + 1);
+	}
+
+	// Hash of the C.D group of an OBIS reference (A-B:C.D.E), a telegram line is hashed up to its value
+	constexpr uint32_t ObisGroup(const char *key)
+	{
+		while ((*key != 0) && (*key != ':') && (*key != '('))
+			key++;
+		if (*key != ':')
+			return 0;
+		key++;
+		uint32_t hash = 1;
+		int dots = 0;
+		while ((*key != 0) && (*key != '('))
+		{
+			if ((*key == '.') && (++dots == 2))
+				break;
+			hash = (hash * 31) + static_cast<uint8_t>(*key);
+			key++;
+		}
+		return hash;
+	}
+
+	constexpr size_t P1INDEX_EOT = P1Index(P1EOT);
+	constexpr size_t P1INDEX_GASUSAGEDSMR2 = P1Index(P1GUDSMR2);
+
+#define P1OBIS(key)	\
+	case ObisGroup(key):	\
+		return &p1_matchlist[std::integral_constant<size_t, P1Index(key)>::value];
+
+	// Candidate entry for an OBIS line, found with a single switch instead of comparing every key.
+	// The C.D group is unique for all keys (a duplicate case label would not compile),
+	// the caller still has to verify the complete key
+	const P1Match *LookupObis(const char *line)
+	{
+		switch (ObisGroup(line))
+		{
+			P1OBIS(P1VER)
+			P1OBIS(P1VERBE)
+			P1OBIS(P1PUSG)
+			P1OBIS(P1PDLV)
+			P1OBIS(P1PUC)
+			P1OBIS(P1PDC)
+			P1OBIS(P1VOLTL1)
+			P1OBIS(P1VOLTL2)
+			P1OBIS(P1VOLTL3)
+			P1OBIS(P1AMPEREL1)
+			P1OBIS(P1AMPEREL2)
+			P1OBIS(P1AMPEREL3)
+			P1OBIS(P1POWUSL1)
+			P1OBIS(P1POWUSL2)
+			P1OBIS(P1POWUSL3)
+			P1OBIS(P1POWDLL1)
+			P1OBIS(P1POWDLL2)
+			P1OBIS(P1POWDLL3)
+			P1OBIS(P1MBTYPE)
+			P1OBIS(P1GUDSMR4)
+			P1OBIS(P1GTS)
+		}
+		return nullptr;
+	}
+#undef P1OBIS
+} // namespace
+
 P1MeterBase::P1MeterBase()
 {
 	m_bDisableCRC = true;
@@ -132,6 +211,8 @@ P1MeterBase::P1MeterBase()
 P1MeterBase::~P1MeterBase()
 {
 	delete[] m_pDecryptBuffer;
+	if (m_pDecryptCtx != nullptr)
+		EVP_CIPHER_CTX_free(m_pDecryptCtx);
 }
 
 void P1MeterBase::Init()
@@ -217,397 +298,380 @@ void P1MeterBase::InitP1EncryptionState()
 }
 
 
+// Gas keys are stored as 0-n:..., the line has to start with the prefix of the M-Bus channel we found
+bool P1MeterBase::MatchGasKey(const char *key, const char *line) const
+{
+	return ((strncmp(m_gasprefix.c_str(), line, 3) == 0) && (strncmp(key + 3, line + 3, strlen(key) - 3) == 0));
+}
+
 bool P1MeterBase::MatchLine()
 {
-	if ((strlen((const char*)&l_buffer) < 1) || (l_buffer[0] == 0x0a))
+	char *line = (char *)&l_buffer;
+	size_t linelen = strlen(line);
+	if ((linelen < 1) || (line[0] == 0x0a))
 		return true; //null value (startup)
-	uint8_t i;
-	bool found = false;
-	const P1Match *t;
-	char value[20] = "";
-	std::string vString;
 
-	for (i = 0; i < p1_matchlist.size(); ++i)
+	const P1Match *t = nullptr;
+	switch (line[0])
 	{
-		if (found)
-		{
+	case '/':
+		// start of data, we do not process anything else on this line
+		m_linecount = 1;
+		return true;
+	case '!':
+		// end of data
+		t = &p1_matchlist[P1INDEX_EOT];
+		l_exclmarkfound = 1;
+		break;
+	case '(':
+		// DSMR 2.2 gas usage, on the line following the gas timestamp
+		if ((m_gasmbuschannel != 0) && (m_p1version < 4) && (m_linecount == 18))
+			t = &p1_matchlist[P1INDEX_GASUSAGEDSMR2];
+		break;
+	default:
+		t = LookupObis(line);
+		if (t == nullptr)
 			break;
-		}
-
-		t = &p1_matchlist[i];
 		switch (t->matchtype)
 		{
-		case _eP1MatchType::ID:
-			// start of data
-			if (strncmp(t->key, (const char*)&l_buffer, strlen(t->key)) == 0)
-			{
-				m_linecount = 1;
-				found = true;
-			}
-			continue; // we do not process anything else on this line
-			break;
-		case _eP1MatchType::EXCLMARK:
-			// end of data
-			if (strncmp(t->key, (const char*)&l_buffer, strlen(t->key)) == 0)
-			{
-				l_exclmarkfound = 1;
-				found = true;
-			}
-			break;
 		case _eP1MatchType::STD:
-			if (strncmp(t->key, (const char*)&l_buffer, strlen(t->key)) == 0)
-				found = true;
+			if (strncmp(t->key, line, strlen(t->key)) != 0)
+				t = nullptr;
 			break;
 		case _eP1MatchType::DEVTYPE:
-			if (m_gasmbuschannel == 0)
-			{
-				vString = (const char*)t->key + 3;
-				if (strncmp(vString.c_str(), (const char*)&l_buffer + 3, strlen(t->key) - 3) == 0)
-					found = true;
-				else
-					i += 100; // skip matches with any other gas lines - we need to find the M0-Bus channel first
-			}
+			// the channel (n) is unknown until we found the gas meter, after that the line is ignored
+			if ((m_gasmbuschannel != 0) || (strncmp(t->key + 3, line + 3, strlen(t->key) - 3) != 0))
+				t = nullptr;
 			break;
 		case _eP1MatchType::GAS:
-			if (strncmp((m_gasprefix + (t->key + 3)).c_str(), (const char*)&l_buffer, strlen(t->key)) == 0)
-			{
-				// verify that 'tariff' indicator is either 1 (Nld) or 3 (Bel)
-				if ((l_buffer[9] & 0xFD) == 0x31)
-					found = true;
-			}
-			if (m_p1version >= 4)
-				i += 100; // skip matches with any DSMR v2 gas lines
+			// verify that 'tariff' indicator is either 1 (Nld) or 3 (Bel)
+			if ((!MatchGasKey(t->key, line)) || ((line[9] & 0xFD) != 0x31))
+				t = nullptr;
 			break;
 		case _eP1MatchType::LINE17:
-			if (strncmp((m_gasprefix + (t->key + 3)).c_str(), (const char*)&l_buffer, strlen(t->key)) == 0)
-			{
+			if ((m_p1version < 4) && (MatchGasKey(t->key, line)))
 				m_linecount = 17;
-				found = true;
-			}
+			else
+				t = nullptr;
 			break;
-		case _eP1MatchType::LINE18:
-			if ((m_linecount == 18) && (strncmp(t->key, (const char*)&l_buffer, strlen(t->key)) == 0))
-				found = true;
+		default:
+			t = nullptr;
 			break;
-		} //switch
-
-		if (!found)
-			continue;
+		}
+		break;
+	}
+	if (t == nullptr)
+		return true;
 
-		if (l_exclmarkfound)
+	if (l_exclmarkfound)
+	{
+		if (m_p1version == 0)
 		{
-			if (m_p1version == 0)
-			{
-				Log(LOG_STATUS, "Meter is pre DSMR 4.0 - using DSMR 2.2 compatibility");
-				m_p1version = 2;
+			Log(LOG_STATUS, "Meter is pre DSMR 4.0 - using DSMR 2.2 compatibility");
+			m_p1version = 2;
+		}
+		time_t atime = mytime(nullptr);
+		if (difftime(atime, m_lastUpdateTime) >= m_ratelimit)
+		{
+			m_lastUpdateTime = atime;
+			sDecodeRXMessage(this, (const unsigned char *)&m_power, "Power", 255, nullptr);
+			if (m_voltagel1 != -1) {
+				SendVoltageSensor(0, 1, 255, m_voltagel1, "Voltage L1");
+			}
+			if (m_voltagel2 != -1) {
+				SendVoltageSensor(0, 2, 255, m_voltagel2, "Voltage L2");
+			}
+			if (m_voltagel3 != -1) {
+				SendVoltageSensor(0, 3, 255, m_voltagel3, "Voltage L3");
+			}
+			/* The ampere is rounded to whole numbers and therefor not accurate enough
+			//we could calculate this ourselfs I=P/U I1=(m_power.powerusage1/m_voltagel1)
+			if (m_bReceivedAmperage) {
+				SendCurrentSensor(1, 255, m_amperagel1, m_amperagel2, m_amperagel3, "Amperage" );
+			}
+			*/
+			if (m_powerusel1 != -1) {
+				SendWattMeter(0, 1, 255, m_powerusel1, "Usage L1");
+			}
+			if (m_powerusel2 != -1) {
+				SendWattMeter(0, 2, 255, m_powerusel2, "Usage L2");
+			}
+			if (m_powerusel3 != -1) {
+				SendWattMeter(0, 3, 255, m_powerusel3, "Usage L3");
 			}
-			time_t atime = mytime(nullptr);
-			if (difftime(atime, m_lastUpdateTime) >= m_ratelimit)
-			{
-				m_lastUpdateTime = atime;
-				sDecodeRXMessage(this, (const unsigned char *)&m_power, "Power", 255, nullptr);
-				if (m_voltagel1 != -1) {
-					SendVoltageSensor(0, 1, 255, m_voltagel1, "Voltage L1");
-				}
-				if (m_voltagel2 != -1) {
-					SendVoltageSensor(0, 2, 255, m_voltagel2, "Voltage L2");
-				}
-				if (m_voltagel3 != -1) {
-					SendVoltageSensor(0, 3, 255, m_voltagel3, "Voltage L3");
-				}
-				/* The ampere is rounded to whole numbers and therefor not accurate enough
-				//we could calculate this ourselfs I=P/U I1=(m_power.powerusage1/m_voltagel1)
-				if (m_bReceivedAmperage) {
-					SendCurrentSensor(1, 255, m_amperagel1, m_amperagel2, m_amperagel3, "Amperage" );
-				}
-				*/
-				if (m_powerusel1 != -1) {
-					SendWattMeter(0, 1, 255, m_powerusel1, "Usage L1");
-				}
-				if (m_powerusel2 != -1) {
-					SendWattMeter(0, 2, 255, m_powerusel2, "Usage L2");
-				}
-				if (m_powerusel3 != -1) {
-					SendWattMeter(0, 3, 255, m_powerusel3, "Usage L3");
-				}
 
-				if (m_powerdell1 != -1) {
-					SendWattMeter(0, 4, 255, m_powerdell1, "Delivery L1");
-				}
-				if (m_powerdell2 != -1) {
-					SendWattMeter(0, 5, 255, m_powerdell2, "Delivery L2");
-				}
-				if (m_powerdell3 != -1) {
-					SendWattMeter(0, 6, 255, m_powerdell3, "Delivery L3");
-				}
+			if (m_powerdell1 != -1) {
+				SendWattMeter(0, 4, 255, m_powerdell1, "Delivery L1");
+			}
+			if (m_powerdell2 != -1) {
+				SendWattMeter(0, 5, 255, m_powerdell2, "Delivery L2");
+			}
+			if (m_powerdell3 != -1) {
+				SendWattMeter(0, 6, 255, m_powerdell3, "Delivery L3");
+			}
 
-				if ((m_gas.gasusage > 0) && ((m_gas.gasusage != m_lastgasusage) || (difftime(atime, m_lastSharedSendGas) >= 300)))
+			if ((m_gas.gasusage > 0) && ((m_gas.gasusage != m_lastgasusage) || (difftime(atime, m_lastSharedSendGas) >= 300)))
+			{
+				//only update gas when there is a new value, or 5 minutes are passed
+				if (m_gasclockskew >= 300)
+				{
+					// just accept it - we cannot sync to our clock
+					m_lastSharedSendGas = atime;
+					m_lastgasusage = m_gas.gasusage;
+					sDecodeRXMessage(this, (const unsigned char *)&m_gas, "Gas", 255, nullptr);
+				}
+				else if (atime >= m_gasoktime)
 				{
-					//only update gas when there is a new value, or 5 minutes are passed
-					if (m_gasclockskew >= 300)
+					struct tm ltime;
+					localtime_r(&atime, &ltime);
+					char myts[80];
+					sprintf(myts, "%02d%02d%02d%02d%02d%02dW", ltime.tm_year % 100, ltime.tm_mon + 1, ltime.tm_mday, ltime.tm_hour, ltime.tm_min, ltime.tm_sec);
+					if (ltime.tm_isdst)
+						myts[12] = 'S';
+					if ((m_gastimestamp.length() > 13) || (strncmp((const char*)&myts, m_gastimestamp.c_str(), m_gastimestamp.length()) >= 0))
 					{
-						// just accept it - we cannot sync to our clock
 						m_lastSharedSendGas = atime;
 						m_lastgasusage = m_gas.gasusage;
+						m_gasoktime += 300;
 						sDecodeRXMessage(this, (const unsigned char *)&m_gas, "Gas", 255, nullptr);
 					}
-					else if (atime >= m_gasoktime)
+					else // gas clock is ahead
 					{
-						struct tm ltime;
-						localtime_r(&atime, &ltime);
-						char myts[80];
-						sprintf(myts, "%02d%02d%02d%02d%02d%02dW", ltime.tm_year % 100, ltime.tm_mon + 1, ltime.tm_mday, ltime.tm_hour, ltime.tm_min, ltime.tm_sec);
-						if (ltime.tm_isdst)
-							myts[12] = 'S';
-						if ((m_gastimestamp.length() > 13) || (strncmp((const char*)&myts, m_gastimestamp.c_str(), m_gastimestamp.length()) >= 0))
+						struct tm gastm;
+						gastm.tm_year = atoi(m_gastimestamp.substr(0, 2).c_str()) + 100;
+						gastm.tm_mon = atoi(m_gastimestamp.substr(2, 2).c_str()) - 1;
+						gastm.tm_mday = atoi(m_gastimestamp.substr(4, 2).c_str());
+						gastm.tm_hour = atoi(m_gastimestamp.substr(6, 2).c_str());
+						gastm.tm_min = atoi(m_gastimestamp.substr(8, 2).c_str());
+						gastm.tm_sec = atoi(m_gastimestamp.substr(10, 2).c_str());
+						if (m_gastimestamp.length() == 12)
+							gastm.tm_isdst = -1;
+						else if (m_gastimestamp[12] == 'W')
+							gastm.tm_isdst = 0;
+						else
+							gastm.tm_isdst = 1;
+
+						time_t gtime = mktime(&gastm);
+						m_gasclockskew = difftime(gtime, atime);
+						if (m_gasclockskew >= 300)
 						{
-							m_lastSharedSendGas = atime;
-							m_lastgasusage = m_gas.gasusage;
-							m_gasoktime += 300;
-							sDecodeRXMessage(this, (const unsigned char *)&m_gas, "Gas", 255, nullptr);
+							Log(LOG_ERROR, "Unable to synchronize to the gas meter clock because it is more than 5 minutes ahead of my time");
 						}
-						else // gas clock is ahead
-						{
-							struct tm gastm;
-							gastm.tm_year = atoi(m_gastimestamp.substr(0, 2).c_str()) + 100;
-							gastm.tm_mon = atoi(m_gastimestamp.substr(2, 2).c_str()) - 1;
-							gastm.tm_mday = atoi(m_gastimestamp.substr(4, 2).c_str());
-							gastm.tm_hour = atoi(m_gastimestamp.substr(6, 2).c_str());
-							gastm.tm_min = atoi(m_gastimestamp.substr(8, 2).c_str());
-							gastm.tm_sec = atoi(m_gastimestamp.substr(10, 2).c_str());
-							if (m_gastimestamp.length() == 12)
-								gastm.tm_isdst = -1;
-							else if (m_gastimestamp[12] == 'W')
-								gastm.tm_isdst = 0;
-							else
-								gastm.tm_isdst = 1;
-
-							time_t gtime = mktime(&gastm);
-							m_gasclockskew = difftime(gtime, atime);
-							if (m_gasclockskew >= 300)
-							{
-								Log(LOG_ERROR, "Unable to synchronize to the gas meter clock because it is more than 5 minutes ahead of my time");
-							}
-							else {
-								m_gasoktime = gtime;
-								Log(LOG_STATUS, "Gas meter clock is %i seconds ahead - wait for my clock to catch up", (int)m_gasclockskew);
-							}
+						else {
+							m_gasoktime = gtime;
+							Log(LOG_STATUS, "Gas meter clock is %i seconds ahead - wait for my clock to catch up", (int)m_gasclockskew);
 						}
 					}
 				}
 			}
-			m_linecount = 0;
-			l_exclmarkfound = 0;
 		}
-		else
-		{
-			vString = (const char*)&l_buffer + t->start;
-			size_t ePos = t->width;
-			ePos = vString.find_first_of("*)");
+		m_linecount = 0;
+		l_exclmarkfound = 0;
+	}
+	else
+	{
+		// the value is parsed in place, the number conversions stop at the '*' or ')' delimiter
+		char *value = line + std::min<size_t>(t->start, linelen);
+		size_t ePos = strcspn(value, "*)");
 
-			if (ePos == std::string::npos)
-			{
-				// invalid message: value not delimited
-				Log(LOG_NORM, "Dismiss incoming - value is not delimited in line \"%s\"", l_buffer);
-				return false;
-			}
+		if (value[ePos] == 0)
+		{
+			// invalid message: value not delimited
+			Log(LOG_NORM, "Dismiss incoming - value is not delimited in line \"%s\"", l_buffer);
+			return false;
+		}
 
-			if (ePos > 19)
-			{
-				// invalid message: line too long
-				Log(LOG_NORM, "Dismiss incoming - value in line \"%s\" is oversized", l_buffer);
-				return false;
-			}
+		if (ePos > 19)
+		{
+			// invalid message: line too long
+			Log(LOG_NORM, "Dismiss incoming - value in line \"%s\" is oversized", l_buffer);
+			return false;
+		}
 
-			if (ePos > 0)
-			{
-				strcpy(value, vString.substr(0, ePos).c_str());
 #ifdef _DEBUG
-				Log(LOG_NORM, "Key: %s, Value: %s", t->topic, value);
+		if (ePos > 0)
+			Log(LOG_NORM, "Key: %s, Value: %.*s", t->topic, (int)ePos, value);
 #endif
-			}
 
-			unsigned long temp_usage = 0;
-			float temp_volt = 0;
-			float temp_ampere = 0;
-			float temp_power = 0;
-			char* validate = value + ePos;
+		unsigned long temp_usage = 0;
+		float temp_volt = 0;
+		float temp_ampere = 0;
+		float temp_power = 0;
+		char* validate = value + ePos;
 
-			switch (t->type)
+		switch (t->type)
+		{
+		case P1TYPE_VERSION:
+			if (m_p1version == 0)
 			{
-			case P1TYPE_VERSION:
-				if (m_p1version == 0)
-				{
-					m_p1version = value[0] - 0x30;
-					char szVersion[12];
-					if (t->width == 5)
-					{
-						// Belgian meter
-						sprintf(szVersion, "ESMR %c.%c.%c", value[0], value[1], value[2]);
-					}
-					else // if (t->width == 2)
-					{
-						// Dutch meter
-						sprintf(szVersion, "ESMR %c.%c", value[0], value[1]);
-						if (m_p1version < 5)
-							szVersion[0] = 'D';
-					}
-					Log(LOG_STATUS, "Meter reports as %s", szVersion);
-				}
-				break;
-			case P1TYPE_MBUSDEVICETYPE:
-				temp_usage = (unsigned long)(strtod(value, &validate));
-				if (temp_usage == 3)
-				{
-					m_gasmbuschannel = (char)l_buffer[2];
-					m_gasprefix[2] = m_gasmbuschannel;
-					Log(LOG_STATUS, "Found gas meter on M-Bus channel %c", m_gasmbuschannel);
-				}
-				break;
-			case P1TYPE_POWERUSAGE:
-				temp_usage = (unsigned long)(strtod(value, &validate) * 1000.0F);
-				if ((l_buffer[8] & 0xFE) == 0x30)
-				{
-					// map tariff IDs 0 (Lux) and 1 (Bel, Nld) both to powerusage1
-					if (!m_power.powerusage1 || m_p1version >= 4)
-						m_power.powerusage1 = temp_usage;
-					else if (temp_usage - m_power.powerusage1 < 10000)
-						m_power.powerusage1 = temp_usage;
-				}
-				else if (l_buffer[8] == 0x32)
-				{
-					if (!m_power.powerusage2 || m_p1version >= 4)
-						m_power.powerusage2 = temp_usage;
-					else if (temp_usage - m_power.powerusage2 < 10000)
-						m_power.powerusage2 = temp_usage;
-				}
-				break;
-			case P1TYPE_POWERDELIV:
-				temp_usage = (unsigned long)(strtod(value, &validate) * 1000.0F);
-				if ((l_buffer[8] & 0xFE) == 0x30)
-				{
-					// map tariff IDs 0 (Lux) and 1 (Bel, Nld) both to powerdeliv1
-					if (!m_power.powerdeliv1 || m_p1version >= 4)
-						m_power.powerdeliv1 = temp_usage;
-					else if (temp_usage - m_power.powerdeliv1 < 10000)
-						m_power.powerdeliv1 = temp_usage;
-				}
-				else if (l_buffer[8] == 0x32)
-				{
-					if (!m_power.powerdeliv2 || m_p1version >= 4)
-						m_power.powerdeliv2 = temp_usage;
-					else if (temp_usage - m_power.powerdeliv2 < 10000)
-						m_power.powerdeliv2 = temp_usage;
-				}
-				break;
-			case P1TYPE_USAGECURRENT:
-				temp_usage = (unsigned long)(strtod(value, &validate) * 1000.0F); // Watt
-				if (temp_usage < 17250)
-					m_power.usagecurrent = temp_usage;
-				break;
-			case P1TYPE_DELIVCURRENT:
-				temp_usage = (unsigned long)(strtod(value, &validate) * 1000.0F); // Watt;
-				if (temp_usage < 17250)
-					m_power.delivcurrent = temp_usage;
-				break;
-			case P1TYPE_VOLTAGEL1:
-				temp_volt = strtof(value, &validate);
-				if (temp_volt < 300)
-					m_voltagel1 = temp_volt; //Voltage L1;
-				break;
-			case P1TYPE_VOLTAGEL2:
-				temp_volt = strtof(value, &validate);
-				if (temp_volt < 300)
-					m_voltagel2 = temp_volt; //Voltage L2;
-				break;
-			case P1TYPE_VOLTAGEL3:
-				temp_volt = strtof(value, &validate);
-				if (temp_volt < 300)
-					m_voltagel3 = temp_volt; //Voltage L3;
-				break;
-			case P1TYPE_AMPERAGEL1:
-				temp_ampere = strtof(value, &validate);
-				if (temp_ampere < 100)
-				{
-					m_amperagel1 = temp_ampere; //Amperage L1;
-					m_bReceivedAmperage = true;
-				}
-				break;
-			case P1TYPE_AMPERAGEL2:
-				temp_ampere = strtof(value, &validate);
-				if (temp_ampere < 100)
+				m_p1version = value[0] - 0x30;
+				char szVersion[12];
+				if (t->width == 5)
 				{
-					m_amperagel2 = temp_ampere; //Amperage L2;
-					m_bReceivedAmperage = true;
+					// Belgian meter
+					sprintf(szVersion, "ESMR %c.%c.%c", value[0], value[1], value[2]);
 				}
-				break;
-			case P1TYPE_AMPERAGEL3:
-				temp_ampere = strtof(value, &validate);
-				if (temp_ampere < 100)
+				else // if (t->width == 2)
 				{
-					m_amperagel3 = temp_ampere; //Amperage L3;
-					m_bReceivedAmperage = true;
+					// Dutch meter
+					sprintf(szVersion, "ESMR %c.%c", value[0], value[1]);
+					if (m_p1version < 5)
+						szVersion[0] = 'D';
 				}
-				break;
-			case P1TYPE_POWERUSEL1:
-				temp_power = static_cast<float>(strtod(value, &validate) * 1000.0F);
-				if (temp_power < 10000)
-					m_powerusel1 = temp_power; //Power Used L1;
-				break;
-			case P1TYPE_POWERUSEL2:
-				temp_power = static_cast<float>(strtod(value, &validate) * 1000.0F);
-				if (temp_power < 10000)
-					m_powerusel2 = temp_power; //Power Used L2;
-				break;
-			case P1TYPE_POWERUSEL3:
-				temp_power = static_cast<float>(strtod(value, &validate) * 1000.0F);
-				if (temp_power < 10000)
-					m_powerusel3 = temp_power; //Power Used L3;
-				break;
-			case P1TYPE_POWERDELL1:
-				temp_power = static_cast<float>(strtod(value, &validate) * 1000.0F);
-				if (temp_power < 10000)
-					m_powerdell1 = temp_power; //Power Used L1;
-				break;
-			case P1TYPE_POWERDELL2:
-				temp_power = static_cast<float>(strtod(value, &validate) * 1000.0F);
-				if (temp_power < 10000)
-					m_powerdell2 = temp_power; //Power Used L2;
-				break;
-			case P1TYPE_POWERDELL3:
-				temp_power = static_cast<float>(strtod(value, &validate) * 1000.0F);
-				if (temp_power < 10000)
-					m_powerdell3 = temp_power; //Power Used L3;
-				break;
-			case P1TYPE_GASTIMESTAMP:
-				m_gastimestamp = std::string(value);
-				break;
-			case P1TYPE_GASUSAGE:
-			case P1TYPE_GASUSAGEDSMR4:
-				temp_usage = (unsigned long)(strtod(value, &validate) * 1000.0F);
-				if (!m_gas.gasusage || m_p1version >= 4)
-					m_gas.gasusage = temp_usage;
-				else if (temp_usage - m_gas.gasusage < 20000)
-					m_gas.gasusage = temp_usage;
-				break;
+				Log(LOG_STATUS, "Meter reports as %s", szVersion);
 			}
-
-			if (ePos > 0 && ((validate - value) != ePos))
+			break;
+		case P1TYPE_MBUSDEVICETYPE:
+			temp_usage = (unsigned long)(strtod(value, &validate));
+			if (temp_usage == 3)
 			{
-				// invalid message: value is not a number
-				Log(LOG_NORM, "Dismiss incoming - value in line \"%s\" is not a number", l_buffer);
-				return false;
+				m_gasmbuschannel = (char)l_buffer[2];
+				m_gasprefix[2] = m_gasmbuschannel;
+				Log(LOG_STATUS, "Found gas meter on M-Bus channel %c", m_gasmbuschannel);
 			}
-
-			if (t->type == P1TYPE_GASUSAGEDSMR4)
+			break;
+		case P1TYPE_POWERUSAGE:
+			temp_usage = (unsigned long)(strtod(value, &validate) * 1000.0F);
+			if ((l_buffer[8] & 0xFE) == 0x30)
+			{
+				// map tariff IDs 0 (Lux) and 1 (Bel, Nld) both to powerusage1
+				if (!m_power.powerusage1 || m_p1version >= 4)
+					m_power.powerusage1 = temp_usage;
+				else if (temp_usage - m_power.powerusage1 < 10000)
+					m_power.powerusage1 = temp_usage;
+			}
+			else if (l_buffer[8] == 0x32)
 			{
-				// need to get timestamp from this line as well
-				vString = (const char*)&l_buffer + 11;
-				m_gastimestamp = vString.substr(0, 13);
+				if (!m_power.powerusage2 || m_p1version >= 4)
+					m_power.powerusage2 = temp_usage;
+				else if (temp_usage - m_power.powerusage2 < 10000)
+					m_power.powerusage2 = temp_usage;
+			}
+			break;
+		case P1TYPE_POWERDELIV:
+			temp_usage = (unsigned long)(strtod(value, &validate) * 1000.0F);
+			if ((l_buffer[8] & 0xFE) == 0x30)
+			{
+				// map tariff IDs 0 (Lux) and 1 (Bel, Nld) both to powerdeliv1
+				if (!m_power.powerdeliv1 || m_p1version >= 4)
+					m_power.powerdeliv1 = temp_usage;
+				else if (temp_usage - m_power.powerdeliv1 < 10000)
+					m_power.powerdeliv1 = temp_usage;
+			}
+			else if (l_buffer[8] == 0x32)
+			{
+				if (!m_power.powerdeliv2 || m_p1version >= 4)
+					m_power.powerdeliv2 = temp_usage;
+				else if (temp_usage - m_power.powerdeliv2 < 10000)
+					m_power.powerdeliv2 = temp_usage;
+			}
+			break;
+		case P1TYPE_USAGECURRENT:
+			temp_usage = (unsigned long)(strtod(value, &validate) * 1000.0F); // Watt
+			if (temp_usage < 17250)
+				m_power.usagecurrent = temp_usage;
+			break;
+		case P1TYPE_DELIVCURRENT:
+			temp_usage = (unsigned long)(strtod(value, &validate) * 1000.0F); // Watt;
+			if (temp_usage < 17250)
+				m_power.delivcurrent = temp_usage;
+			break;
+		case P1TYPE_VOLTAGEL1:
+			temp_volt = strtof(value, &validate);
+			if (temp_volt < 300)
+				m_voltagel1 = temp_volt; //Voltage L1;
+			break;
+		case P1TYPE_VOLTAGEL2:
+			temp_volt = strtof(value, &validate);
+			if (temp_volt < 300)
+				m_voltagel2 = temp_volt; //Voltage L2;
+			break;
+		case P1TYPE_VOLTAGEL3:
+			temp_volt = strtof(value, &validate);
+			if (temp_volt < 300)
+				m_voltagel3 = temp_volt; //Voltage L3;
+			break;
+		case P1TYPE_AMPERAGEL1:
+			temp_ampere = strtof(value, &validate);
+			if (temp_ampere < 100)
+			{
+				m_amperagel1 = temp_ampere; //Amperage L1;
+				m_bReceivedAmperage = true;
+			}
+			break;
+		case P1TYPE_AMPERAGEL2:
+			temp_ampere = strtof(value, &validate);
+			if (temp_ampere < 100)
+			{
+				m_amperagel2 = temp_ampere; //Amperage L2;
+				m_bReceivedAmperage = true;
+			}
+			break;
+		case P1TYPE_AMPERAGEL3:
+			temp_ampere = strtof(value, &validate);
+			if (temp_ampere < 100)
+			{
+				m_amperagel3 = temp_ampere; //Amperage L3;
+				m_bReceivedAmperage = true;
+			}
+			break;
+		case P1TYPE_POWERUSEL1:
+			temp_power = static_cast<float>(strtod(value, &validate) * 1000.0F);
+			if (temp_power < 10000)
+				m_powerusel1 = temp_power; //Power Used L1;
+			break;
+		case P1TYPE_POWERUSEL2:
+			temp_power = static_cast<float>(strtod(value, &validate) * 1000.0F);
+			if (temp_power < 10000)
+				m_powerusel2 = temp_power; //Power Used L2;
+			break;
+		case P1TYPE_POWERUSEL3:
+			temp_power = static_cast<float>(strtod(value, &validate) * 1000.0F);
+			if (temp_power < 10000)
+				m_powerusel3 = temp_power; //Power Used L3;
+			break;
+		case P1TYPE_POWERDELL1:
+			temp_power = static_cast<float>(strtod(value, &validate) * 1000.0F);
+			if (temp_power < 10000)
+				m_powerdell1 = temp_power; //Power Used L1;
+			break;
+		case P1TYPE_POWERDELL2:
+			temp_power = static_cast<float>(strtod(value, &validate) * 1000.0F);
+			if (temp_power < 10000)
+				m_powerdell2 = temp_power; //Power Used L2;
+			break;
+		case P1TYPE_POWERDELL3:
+			temp_power = static_cast<float>(strtod(value, &validate) * 1000.0F);
+			if (temp_power < 10000)
+				m_powerdell3 = temp_power; //Power Used L3;
+			break;
+		case P1TYPE_GASTIMESTAMP:
+			m_gastimestamp.assign(value, ePos);
+			break;
+		case P1TYPE_GASUSAGE:
+		case P1TYPE_GASUSAGEDSMR4:
+			temp_usage = (unsigned long)(strtod(value, &validate) * 1000.0F);
+			if (!m_gas.gasusage || m_p1version >= 4)
+				m_gas.gasusage = temp_usage;
+			else if (temp_usage - m_gas.gasusage < 20000)
+				m_gas.gasusage = temp_usage;
+			break;
+		}
+
+		if (ePos > 0 && ((validate - value) != ePos))
+		{
+			// invalid message: value is not a number
+			Log(LOG_NORM, "Dismiss incoming - value in line \"%s\" is not a number", l_buffer);
+			return false;
+		}
+
+		if (t->type == P1TYPE_GASUSAGEDSMR4)
+		{
+			// need to get timestamp from this line as well
+			m_gastimestamp.assign(line + 11, 13);
 #ifdef _DEBUG
-				Log(LOG_NORM, "Key: gastimestamp, Value: %s", m_gastimestamp.c_str());
+			Log(LOG_NORM, "Key: gastimestamp, Value: %s", m_gastimestamp.c_str());
 #endif
-			}
 		}
 	}
 	return true;
@@ -727,6 +791,12 @@ bool P1MeterBase::ParseP1EncryptedData(const uint8_t p1_byte)
 		}
 		else if (m_currentBytePosition >= m_changeToNextStateAt)
 		{
+			if (m_dataLength < 17)
+			{
+				//Length does not even cover the header. Dropping telegram
+				m_p1_encryption_state = P1EcryptionState::waitingForStartByte;
+				break;
+			}
 			m_p1_encryption_state = P1EcryptionState::readSeparator30;
 			m_changeToNextStateAt++;
 		}
@@ -809,20 +879,16 @@ void P1MeterBase::ParseP1Data(const uint8_t* pDataIn, const int LenIn, const boo
 				try
 				{
 					//We have a complete Telegram
-					std::string iv, cipherText;
-					iv.reserve(m_systemTitle.size() + 4);
-					cipherText.reserve(m_dataPayload.size() + GCMTagLength);
-
-					iv.append(m_systemTitle.begin(), m_systemTitle.end());
-					iv.append(1, (m_frameCounter & 0xFF000000) >> 24);
-					iv.append(1, (m_frameCounter & 0x00FF0000) >> 16);
-					iv.append(1, (m_frameCounter & 0x0000FF00) >> 8);
-					iv.append(1, m_frameCounter & 0x000000FF);
-
-					cipherText.append(m_dataPayload.begin(), m_dataPayload.end());
-					cipherText.append(m_gcmTag.begin(), m_gcmTag.end());
-
-					size_t neededDecryptBufferSize = std::min(2048, static_cast<int>(cipherText.size() + 16));
+					uint8_t iv[255 + 4];
+					size_t ivlen = std::min<size_t>(m_systemTitle.size(), 255);
+					memcpy(iv, m_systemTitle.data(), ivlen);
+					iv[ivlen++] = (m_frameCounter & 0xFF000000) >> 24;
+					iv[ivlen++] = (m_frameCounter & 0x00FF0000) >> 16;
+					iv[ivlen++] = (m_frameCounter & 0x0000FF00) >> 8;
+					iv[ivlen++] = m_frameCounter & 0x000000FF;
+
+					//the GCM tag is not part of the cipher text, only the payload is decrypted
+					size_t neededDecryptBufferSize = std::min(2048, static_cast<int>(m_dataPayload.size() + 16));
 					if (neededDecryptBufferSize > m_DecryptBufferSize)
 					{
 						delete[] m_pDecryptBuffer;
@@ -832,25 +898,25 @@ void P1MeterBase::ParseP1Data(const uint8_t* pDataIn, const int LenIn, const boo
 						if (m_pDecryptBuffer == nullptr)
 							return;
 					}
-					memset(m_pDecryptBuffer, 0, m_DecryptBufferSize);
 
-					EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
-					if (ctx == nullptr)
-						return;
-					EVP_DecryptInit_ex(ctx, EVP_aes_128_gcm(), nullptr, nullptr, nullptr);
-					EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_SET_IVLEN, iv.size(), nullptr);
-
-					EVP_DecryptInit_ex(ctx, nullptr, nullptr, (const unsigned char *)m_szHexKey.data(),
-							   (const unsigned char *)iv.c_str());
+					if (m_pDecryptCtx == nullptr)
+					{
+						m_pDecryptCtx = EVP_CIPHER_CTX_new();
+						if (m_pDecryptCtx == nullptr)
+							return;
+						EVP_DecryptInit_ex(m_pDecryptCtx, EVP_aes_128_gcm(), nullptr, nullptr, nullptr);
+					}
+					EVP_CIPHER_CTX_ctrl(m_pDecryptCtx, EVP_CTRL_AEAD_SET_IVLEN, static_cast<int>(ivlen), nullptr);
+					EVP_DecryptInit_ex(m_pDecryptCtx, nullptr, nullptr, (const unsigned char *)m_szHexKey.data(), iv);
 
 					int outlen = 0;
 					// std::vector<char> m_szDecodeAdd = HexToBytes(_szDecodeAdd);
 					// EVP_DecryptUpdate(ctx, nullptr, &outlen, (const uint8_t*)m_szDecodeAdd.data(),
 					// m_szDecodeAdd.size());
-					EVP_DecryptUpdate(ctx, (uint8_t*)m_pDecryptBuffer, &outlen, (uint8_t*)cipherText.c_str(), cipherText.size());
-					EVP_CIPHER_CTX_free(ctx);
+					EVP_DecryptUpdate(m_pDecryptCtx, (uint8_t*)m_pDecryptBuffer, &outlen, (const uint8_t*)m_dataPayload.data(), static_cast<int>(m_dataPayload.size()));
 					if (outlen <= 0)
 						return;
+					m_pDecryptBuffer[std::min<size_t>(outlen, m_DecryptBufferSize - 1)] = 0;
 /*
 					CryptoPP::GCM< CryptoPP::AES >::Decryption decryptor;
 					decryptor.SetKeyWithIV((uint8_t*)m_szHexKey.data(), 16, (uint8_t*)iv.c_str(), 12);
@@ -874,10 +940,12 @@ void P1MeterBase::ParseP1Data(const uint8_t* pDataIn, const int LenIn, const boo
 	int ii = 0;
 	m_ratelimit = ratelimit;
 	// a new message should not start with an empty line, but just in case it does (crude check is sufficient here)
-	while ((m_linecount == 0) && (pData[ii] < 0x10))
+	while ((ii < Len) && (m_linecount == 0) && (pData[ii] < 0x10))
 	{
 		ii++;
 	}
+	if (ii == Len)
+		return; // nothing but control characters
 
 	// re enable reading pData when a new message starts, empty buffers
 	if (pData[ii] == 0x2f)
@@ -3,11 +3,14 @@
 #include "DomoticzHardware.h"
 #include "hardwaretypes.h"
 
+struct evp_cipher_ctx_st;
+
 class P1MeterBase : public CDomoticzHardwareBase
 {
 	friend class P1MeterSerial;
 	friend class P1MeterTCP;
 	friend class CRFXBase;
+	friend class CP1MeterFuzzer;
 
       public:
 	P1MeterBase();
@@ -19,6 +22,7 @@ class P1MeterBase : public CDomoticzHardwareBase
       private:
 	void Init();
 	bool MatchLine();
+	bool MatchGasKey(const char *key, const char *line) const;
 	void ParseP1Data(const uint8_t *pDataIn, int LenIn, bool disable_crc, int ratelimit);
 
 	bool CheckCRC();
@@ -92,6 +96,7 @@ class P1MeterBase : public CDomoticzHardwareBase
 	std::string m_gcmTag;
 	uint8_t *m_pDecryptBuffer = nullptr;
 	size_t m_DecryptBufferSize = 0;
+	evp_cipher_ctx_st *m_pDecryptCtx = nullptr; // kept for all telegrams, only the IV changes
 	void InitP1EncryptionState();
 	bool ParseP1EncryptedData(uint8_t p1_byte);
 };
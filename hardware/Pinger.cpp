@@ -18,6 +18,7 @@
 #include "pinger/ipv4_header.h"
 
 #include <iostream>
+#include <queue>
 
 #if BOOST_VERSION >= 107000
 #define GET_IO_SERVICE(s) ((boost::asio::io_context&)(s).get_executor().context())
@@ -25,41 +26,79 @@
 #define GET_IO_SERVICE(s) ((s).get_io_service())
 #endif
 
-class pinger
+//Pings a list of hosts at once over a single ICMP socket
+//Replies are matched on identifier, sequence number and source address,
+//every outstanding request has its own deadline in a timer heap
+class multi_pinger
 	: private domoticz::noncopyable
 {
+	struct _tHost
+	{
+		boost::asio::ip::icmp::endpoint destination;
+		bool bResolved = false;
+		bool bReplied = false;
+		int num_tries = 0;
+		unsigned short sequence_number = 0;
+		boost::posix_time::ptime deadline;
+	};
+	typedef std::pair<boost::posix_time::ptime, size_t> deadline_entry;
 public:
-  pinger(boost::asio::io_service &io_service, const char *destination, const int iPingTimeoutms)
-	  : num_replies_(0)
-	  , m_PingState(false)
-	  , resolver_(io_service)
-	  , socket_(io_service, boost::asio::ip::icmp::v4())
-	  , timer_(io_service)
-	  , sequence_number_(0)
-  {
-	  boost::asio::ip::icmp::resolver::query query(boost::asio::ip::icmp::v4(), destination, "");
-	  destination_ = *resolver_.resolve(query);
-
-	  num_tries_ = 1;
-	  PingTimeoutms_ = iPingTimeoutms;
-	  start_send();
-	  start_receive();
-  }
-	int num_replies_;
-	int num_tries_;
-	int PingTimeoutms_;
-	bool m_PingState;
+	multi_pinger(boost::asio::io_service &io_service, const std::vector<std::string> &destinations, const int iPingTimeoutms, const std::function<bool()> &stop_requested)
+		: resolver_(io_service)
+		, socket_(io_service, boost::asio::ip::icmp::v4())
+		, timer_(io_service)
+		, PingTimeoutms_(iPingTimeoutms)
+		, stop_requested_(stop_requested)
+		, sequence_number_(0)
+		, num_pending_(0)
+	{
+		hosts_.resize(destinations.size());
+		for (size_t ii = 0; ii < destinations.size(); ii++)
+		{
+			try
+			{
+				boost::asio::ip::icmp::resolver::query query(boost::asio::ip::icmp::v4(), destinations[ii], "");
+				hosts_[ii].destination = *resolver_.resolve(query);
+				hosts_[ii].bResolved = true;
+			}
+			catch (std::exception& e)
+			{
+				//a host that can not be resolved is not reachable
+				(void)e;
+			}
+		}
+		for (size_t ii = 0; ii < hosts_.size(); ii++)
+		{
+			if (!hosts_[ii].bResolved)
+				continue;
+			num_pending_++;
+			start_send(ii);
+		}
+		if (num_pending_ == 0)
+			return;
+		start_receive();
+		start_timer();
+	}
+	bool ping_state(const size_t idx) const
+	{
+		return hosts_[idx].bReplied;
+	}
 private:
-	void start_send()
+	void start_send(const size_t idx)
 	{
+		_tHost &host = hosts_[idx];
 		std::string body("Domoticz");
 
+		host.num_tries++;
+		host.sequence_number = ++sequence_number_;
+		sequences_[host.sequence_number] = idx;
+
 		// Create an ICMP header for an echo request.
 		icmp_header echo_request;
 		echo_request.type(icmp_header::echo_request);
 		echo_request.code(0);
 		echo_request.identifier(get_identifier());
-		echo_request.sequence_number(++sequence_number_);
+		echo_request.sequence_number(host.sequence_number);
 		compute_checksum(echo_request, body.begin(), body.end());
 
 		// Encode the request packet.
@@ -67,34 +106,52 @@ private:
 		std::ostream os(&request_buffer);
 		os << echo_request << body;
 
-		// Send the request.
-		time_sent_ = boost::posix_time::microsec_clock::universal_time();
-		socket_.send_to(request_buffer.data(), destination_);
+		// Send the request, a failed send is handled as a request without reply
+		boost::system::error_code ec;
+		socket_.send_to(request_buffer.data(), host.destination, 0, ec);
+
+		//all requests use the same timeout, so the heap top stays the earliest deadline
+		host.deadline = boost::posix_time::microsec_clock::universal_time() + boost::posix_time::milliseconds(PingTimeoutms_);
+		deadlines_.push(deadline_entry(host.deadline, idx));
+	}
 
-		num_replies_ = 0;
-		timer_.expires_at(time_sent_ + boost::posix_time::milliseconds(PingTimeoutms_));
+	void start_timer()
+	{
+		if (deadlines_.empty())
+			return;
+		timer_.expires_at(deadlines_.top().first);
 		timer_.async_wait([this](auto err) { handle_timeout(err); });
 	}
 
 	void handle_timeout(const boost::system::error_code& error)
 	{
-		if (error != boost::asio::error::operation_aborted)
+		if (error == boost::asio::error::operation_aborted)
+			return;
+		if (stop_requested_())
 		{
-			if (num_replies_ == 0)
-			{
-				m_PingState = false;
-				timer_.expires_at(time_sent_ + boost::posix_time::milliseconds(PingTimeoutms_));
-				num_tries_++;
-				if (num_tries_ > 4)
-				{
-					GET_IO_SERVICE(resolver_).stop();
-				}
-				else
-				{
-					timer_.async_wait([this](auto &) { start_send(); });
-				}
-			}
+			GET_IO_SERVICE(resolver_).stop();
+			return;
+		}
+		boost::posix_time::ptime now = boost::posix_time::microsec_clock::universal_time();
+		while ((!deadlines_.empty()) && (deadlines_.top().first <= now))
+		{
+			deadline_entry entry = deadlines_.top();
+			deadlines_.pop();
+			_tHost &host = hosts_[entry.second];
+			if ((host.bReplied) || (host.deadline != entry.first))
+				continue; //already answered or sent again
+			sequences_.erase(host.sequence_number);
+			if (host.num_tries < 4)
+				start_send(entry.second);
+			else
+				num_pending_--;
+		}
+		if (num_pending_ == 0)
+		{
+			GET_IO_SERVICE(resolver_).stop();
+			return;
 		}
+		start_timer();
 	}
 
 	void start_receive()
@@ -103,11 +160,13 @@ private:
 		reply_buffer_.consume(reply_buffer_.size());
 
 		// Wait for a reply. We prepare the buffer to receive up to 64KB.
-		socket_.async_receive(reply_buffer_.prepare(65536), [this](auto, auto bytes) { handle_receive(bytes); });
+		socket_.async_receive(reply_buffer_.prepare(65536), [this](auto err, auto bytes) { handle_receive(err, bytes); });
 	}
 
-	void handle_receive(std::size_t length)
+	void handle_receive(const boost::system::error_code& error, std::size_t length)
 	{
+		if (error)
+			return; //outstanding requests will time out
 		// The actual number of bytes received is committed to the buffer so that we
 		// can extract it using a std::istream object.
 		reply_buffer_.commit(length);
@@ -119,24 +178,28 @@ private:
 		is >> ipv4_hdr >> icmp_hdr;
 
 		// We can receive all ICMP packets received by the host, so we need to
-		// filter out only the echo replies that match the our identifier and
-		// expected sequence number.
+		// filter out only the echo replies that match one of our outstanding requests.
+		// DD 2 possible 'invalid' replies that will be discarded are:
+		// Type 8: Echo request, happens when we ping ourselves (localhost)
+		// Type 3: Destination host unreachable.
 		if (is && icmp_hdr.type() == icmp_header::echo_reply
-			&& icmp_hdr.identifier() == get_identifier()
-			&& icmp_hdr.sequence_number() == sequence_number_)
+			&& icmp_hdr.identifier() == get_identifier())
 		{
-			if (num_replies_++ == 0)
-				timer_.cancel();
-			m_PingState = true;
-			GET_IO_SERVICE(resolver_).stop();
-		}
-		else
-		{
-			// DD 2 possible 'invalid' replies that will be discarded are:
-			// Type 8: Echo request, happens when we ping ourselves (localhost)
-			// Type 3: Destination host unreachable.
-			start_receive();
+			auto itt = sequences_.find(icmp_hdr.sequence_number());
+			if ((itt != sequences_.end()) && (ipv4_hdr.source_address() == hosts_[itt->second].destination.address().to_v4()))
+			{
+				hosts_[itt->second].bReplied = true;
+				sequences_.erase(itt);
+				num_pending_--;
+				if (num_pending_ == 0)
+				{
+					timer_.cancel();
+					GET_IO_SERVICE(resolver_).stop();
+					return;
+				}
+			}
 		}
+		start_receive();
 	}
 
 	static unsigned short get_identifier()
@@ -148,16 +211,19 @@ private:
 #endif
 	}
 	boost::asio::ip::icmp::resolver resolver_;
-	boost::asio::ip::icmp::endpoint destination_;
 	boost::asio::ip::icmp::socket socket_;
 	boost::asio::deadline_timer timer_;
+	int PingTimeoutms_;
+	std::function<bool()> stop_requested_;
 	unsigned short sequence_number_;
-	boost::posix_time::ptime time_sent_;
+	size_t num_pending_;
+	std::vector<_tHost> hosts_;
+	std::map<unsigned short, size_t> sequences_; //outstanding sequence number -> host
+	std::priority_queue<deadline_entry, std::vector<deadline_entry>, std::greater<deadline_entry>> deadlines_;
 	boost::asio::streambuf reply_buffer_;
 };
 
-CPinger::CPinger(const int ID, const int PollIntervalsec, const int PingTimeoutms) :
-	m_iThreadsRunning(0)
+CPinger::CPinger(const int ID, const int PollIntervalsec, const int PingTimeoutms)
 {
 	m_HwdID = ID;
 	m_bSkipReceiveCheck = true;
@@ -177,7 +243,6 @@ bool CPinger::StartHardware()
 
 	m_bIsStarted = true;
 	sOnConnected(this);
-	m_iThreadsRunning = 0;
 
 	StartHeartbeatThread();
 
@@ -330,32 +395,6 @@ void CPinger::ReloadNodes()
 	}
 }
 
-void CPinger::Do_Ping_Worker(const PingNode &Node)
-{
-	bool bPingOK = false;
-	boost::asio::io_service io_service;
-	try
-	{
-		pinger p(io_service, Node.IP.c_str(), m_iPingTimeoutms);
-		io_service.run();
-		if (p.m_PingState == true)
-		{
-			bPingOK = true;
-		}
-	}
-	catch (std::exception& e)
-	{
-		(void)e;
-		bPingOK = false;
-	}
-	catch (...)
-	{
-		bPingOK = false;
-	}
-	UpdateNodeStatus(Node, bPingOK);
-	if (m_iThreadsRunning > 0) m_iThreadsRunning--;
-}
-
 void CPinger::UpdateNodeStatus(const PingNode &Node, const bool bPingOK)
 {
 	//Log(LOG_STATUS, "%s = %s", Node.Name.c_str(), (bPingOK == true) ? "OK" : "Error");
@@ -392,18 +431,30 @@ void CPinger::UpdateNodeStatus(const PingNode &Node, const bool bPingOK)
 void CPinger::DoPingHosts()
 {
 	std::lock_guard<std::mutex> l(m_mutex);
+	if (m_nodes.empty())
+		return;
+
+	std::vector<std::string> destinations;
 	for (const auto &node : m_nodes)
+		destinations.push_back(node.IP);
+
+	std::vector<bool> results(m_nodes.size(), false);
+	try
 	{
-		if (IsStopRequested(0))
-			return;
-		if (m_iThreadsRunning < 1000)
-		{
-			//m_iThreadsRunning++;
-			boost::thread t([this, node] { Do_Ping_Worker(node); });
-			SetThreadName(t.native_handle(), "PingerWorker");
-			t.join();
-		}
+		boost::asio::io_service io_service;
+		multi_pinger p(io_service, destinations, m_iPingTimeoutms, [this] { return IsStopRequested(0); });
+		io_service.run();
+		for (size_t ii = 0; ii < m_nodes.size(); ii++)
+			results[ii] = p.ping_state(ii);
 	}
+	catch (std::exception& e)
+	{
+		Debug(DEBUG_HARDWARE, "Ping failed: %s", e.what());
+	}
+	if (IsStopRequested(0))
+		return;
+	for (size_t ii = 0; ii < m_nodes.size(); ii++)
+		UpdateNodeStatus(m_nodes[ii], results[ii]);
 }
 
 void CPinger::Do_Work()
@@ -427,11 +478,6 @@ void CPinger::Do_Work()
 			}
 		}
 	}
-	//Make sure all our background workers are stopped
-	while (m_iThreadsRunning > 0)
-	{
-		sleep_milliseconds(150);
-	}
 	Log(LOG_STATUS, "Worker stopped...");
 }
 
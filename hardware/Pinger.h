@@ -30,12 +30,10 @@ class CPinger : public CDomoticzHardwareBase
 	bool StartHardware() override;
 	bool StopHardware() override;
 	void DoPingHosts();
-	void Do_Ping_Worker(const PingNode &Node);
 	void UpdateNodeStatus(const PingNode &Node, bool bPingOK);
 	void ReloadNodes();
 
       private:
-	int m_iThreadsRunning;
 	int m_iPollInterval;
 	int m_iPingTimeoutms;
 	std::vector<PingNode> m_nodes;
@@ -7,10 +7,6 @@
 #include "hardwaretypes.h"
 #include "../main/localtime_r.h"
 #include "../main/SQLHelper.h"
-
-#include "../main/mainworker.h"
-#include "../main/WebServer.h"
-#include "../webserver/cWebem.h"
 #include <json/json.h>
 
 #ifdef _DEBUG
@@ -701,10 +697,10 @@ bool CRFLinkBase::ParseLine(const std::string &sLine)
 				versionhi = RFLinkGetIntStringValue(results[2]);
 				versionlo = RFLinkGetIntDecStringValue(results[2]);
 			}
-			if (results[3].find("REV") != std::string::npos){
+			if ((results.size() > 3) && (results[3].find("REV") != std::string::npos)) {
 				revision = RFLinkGetIntStringValue(results[3]);
 			}
-			if (results[4].find("BUILD") != std::string::npos) {
+			if ((results.size() > 4) && (results[4].find("BUILD") != std::string::npos)) {
 				build = RFLinkGetIntStringValue(results[4]);
 			}
 			Log(LOG_STATUS, "RFLink Detected, Version: %d.%d Revision: %d Build: %d", versionhi, versionlo, revision, build);
@@ -1150,86 +1146,3 @@ bool CRFLinkBase::ParseLine(const std::string &sLine)
 
     return true;
 }
-
-//Webserver helpers
-namespace http {
-	namespace server {
-		void CWebServer::RType_CreateRFLinkDevice(WebEmSession & session, const request& req, Json::Value &root)
-		{
-			if (session.rights != 2)
-			{
-				session.reply_status = reply::forbidden;
-				return; //Only admin user allowed
-			}
-
-			std::string idx = request::findValue(&req, "idx");
-			std::string scommand = request::findValue(&req, "command");
-			if (idx.empty() || scommand.empty())
-			{
-				return;
-			}
-
-			#ifdef _DEBUG
-			_log.Log(LOG_STATUS, "RFLink Custom Command: %s", scommand.c_str());
-			_log.Log(LOG_STATUS, "RFLink Custom Command idx: %s", idx.c_str());
-			#endif
-
-			bool bCreated = false;						// flag to know if the command was a success
-			CRFLinkBase *pRFLINK = reinterpret_cast<CRFLinkBase*>(m_mainworker.GetHardware(atoi(idx.c_str())));
-			if (pRFLINK == nullptr)
-				return;
-
-			if (scommand.substr(0, 14) == "10;rfdebug=on;")
-			{
-				pRFLINK->m_bRFDebug = true; // enable debug
-				_log.Log(LOG_STATUS, "User: %s initiated RFLink Enable Debug mode with command: %s", session.username.c_str(), scommand.c_str());
-				pRFLINK->WriteInt("10;RFDEBUG=ON;\n");
-				root["status"] = "OK";
-				root["title"] = "DebugON";
-				return;
-			}
-			if (scommand.substr(0, 15) == "10;rfdebug=off;")
-			{
-				pRFLINK->m_bRFDebug = false; // disable debug
-				_log.Log(LOG_STATUS, "User: %s initiated RFLink Disable Debug mode with command: %s", session.username.c_str(), scommand.c_str());
-				pRFLINK->WriteInt("10;RFDEBUG=OFF;\n");
-				root["status"] = "OK";
-				root["title"] = "DebugOFF";
-				return;
-			}
-
-			_log.Log(LOG_STATUS, "User: %s initiated a RFLink Device Create command: %s", session.username.c_str(), scommand.c_str());
-			scommand = "11;" + scommand;
-			#ifdef _DEBUG
-			_log.Log(LOG_STATUS, "User: %s initiated a RFLink Device Create command: %s", session.username.c_str(), scommand.c_str());
-			#endif
-			scommand += "\r\n";
-
-			bCreated = true;
-			pRFLINK->m_bTXokay = false; // clear OK flag
-			pRFLINK->WriteInt(scommand);
-			time_t atime = mytime(nullptr);
-			time_t btime = mytime(nullptr);
-
-			// Wait for an OK response from RFLink to make sure the command was executed
-			while (pRFLINK->m_bTXokay == false) {
-				if (difftime(btime,atime) > 4) {
-					_log.Log(LOG_ERROR, "TX time out...");
-					bCreated = false;
-					break;
-				}
-				btime = mytime(nullptr);
-			}
-
-			#ifdef _DEBUG
-			_log.Log(LOG_STATUS, "RFLink custom command done");
-			#endif
-
-			if (bCreated)
-			{
-				root["status"] = "OK";
-				root["title"] = "CreateRFLinkDevice";
-			}
-		}
-	} // namespace server
-} // namespace http
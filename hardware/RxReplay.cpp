@@ -0,0 +1,312 @@
+#include "stdafx.h"
+#include "RxReplay.h"
+#include "../main/Helper.h"
+#include "../main/Logger.h"
+#include "../main/localtime_r.h"
+#include "../main/mainworker.h"
+#include "../main/RFXtrx.h"
+#include "hardwaretypes.h"
+#include <cstddef>
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
+#include <set>
+
+#define RXRECORD_MAGIC "DZRX"
+#define RXRECORD_VERSION 1
+#define RXREPLAY_STATISTICS_INTERVAL 10 //seconds
+
+namespace
+{
+	void PutLE(std::vector<uint8_t> &buffer, const uint32_t value, const size_t bytes)
+	{
+		for (size_t ii = 0; ii < bytes; ii++)
+			buffer.push_back(static_cast<uint8_t>((value >> (8 * ii)) & 0xFF));
+	}
+
+	uint32_t GetLE(const uint8_t *pData, const size_t bytes)
+	{
+		uint32_t value = 0;
+		for (size_t ii = 0; ii < bytes; ii++)
+			value |= static_cast<uint32_t>(pData[ii]) << (8 * ii);
+		return value;
+	}
+
+	//Gives copy N of a frame its own device: adds N to the ID the decoder builds for the packet type
+	//Returns false for packet types whose ID layout is not known here
+	bool RemapFrameID(std::vector<uint8_t> &frame, const int iCopy)
+	{
+		switch (frame[1])
+		{
+		//RFXtrx sensors, ID = (id1 * 256) + id2, id1/id2 follow the sequence number
+		case pTypeChime:
+		case pTypeThermostat1:
+		case pTypeBBQ:
+		case pTypeTEMP_RAIN:
+		case pTypeTEMP:
+		case pTypeHUM:
+		case pTypeTEMP_HUM:
+		case pTypeTEMP_HUM_BARO:
+		case pTypeRAIN:
+		case pTypeWIND:
+		case pTypeUV:
+		case pTypeDT:
+		case pTypeCURRENT:
+		case pTypeENERGY:
+		case pTypeCURRENTENERGY:
+		case pTypePOWER:
+		case pTypeWEIGHT:
+		case pTypeRFXMeter:
+		case pTypeWEATHER:
+		case pTypeSOLAR:
+		{
+			if (frame.size() < 6)
+				return false;
+			uint16_t id = static_cast<uint16_t>(((frame[4] << 8) | frame[5]) + iCopy);
+			frame[4] = static_cast<uint8_t>(id >> 8);
+			frame[5] = static_cast<uint8_t>(id & 0xFF);
+			return true;
+		}
+		case pTypeGeneralSwitch:
+		{
+			//recorded from a struct in memory, so host byte order
+			const size_t offset = offsetof(_tGeneralSwitch, id);
+			if (frame.size() < offset + sizeof(int32_t))
+				return false;
+			int32_t id;
+			memcpy(&id, &frame[offset], sizeof(id));
+			id += iCopy;
+			memcpy(&frame[offset], &id, sizeof(id));
+			return true;
+		}
+		default:
+			return false;
+		}
+	}
+} // namespace
+
+CRxRecorder::~CRxRecorder()
+{
+	Close();
+}
+
+bool CRxRecorder::Open(const std::string &szFilename)
+{
+	std::lock_guard<std::mutex> l(m_mutex);
+	if (m_file != nullptr)
+		fclose(m_file);
+	m_file = fopen(szFilename.c_str(), "wb");
+	if (m_file == nullptr)
+	{
+		_log.Log(LOG_ERROR, "RxRecorder: Could not create file: %s", szFilename.c_str());
+		return false;
+	}
+	fwrite(RXRECORD_MAGIC, 1, 4, m_file);
+	fputc(RXRECORD_VERSION, m_file);
+	m_tLastRecord = std::chrono::steady_clock::now();
+	_log.Log(LOG_STATUS, "RxRecorder: Recording received frames to: %s", szFilename.c_str());
+	return true;
+}
+
+void CRxRecorder::Close()
+{
+	std::lock_guard<std::mutex> l(m_mutex);
+	if (m_file == nullptr)
+		return;
+	fclose(m_file);
+	m_file = nullptr;
+}
+
+void CRxRecorder::Record(const int HwdID, const uint8_t *pRXCommand, const char *defaultName, const int BatteryLevel)
+{
+	std::lock_guard<std::mutex> l(m_mutex);
+	if (m_file == nullptr)
+		return;
+
+	auto now = std::chrono::steady_clock::now();
+	uint32_t delayms = static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::milliseconds>(now - m_tLastRecord).count());
+	m_tLastRecord = now;
+
+	size_t namelen = (defaultName != nullptr) ? std::min<size_t>(strlen(defaultName), 255) : 0;
+
+	std::vector<uint8_t> record;
+	record.reserve(11 + namelen + pRXCommand[0] + 1);
+	PutLE(record, delayms, 4);
+	PutLE(record, static_cast<uint32_t>(HwdID), 4);
+	PutLE(record, static_cast<uint16_t>(static_cast<int16_t>(BatteryLevel)), 2);
+	record.push_back(static_cast<uint8_t>(namelen));
+	if (namelen != 0)
+		record.insert(record.end(), defaultName, defaultName + namelen);
+	record.insert(record.end(), pRXCommand, pRXCommand + pRXCommand[0] + 1);
+	fwrite(record.data(), 1, record.size(), m_file);
+}
+
+CRxReplay::CRxReplay(const int ID, const std::string &szFilename, const int Speed, const int Copies, const bool bLoop)
+	: m_szFilename(szFilename)
+	, m_iSpeed((Speed > 0) ? Speed : 0)
+	, m_iCopies((Copies > 1) ? std::min(Copies, 65536) : 1)
+	, m_bLoop(bLoop)
+{
+	m_HwdID = ID;
+	m_bSkipReceiveCheck = true;
+}
+
+bool CRxReplay::WriteToHardware(const char * /*pdata*/, const unsigned char /*length*/)
+{
+	return false;
+}
+
+bool CRxReplay::StartHardware()
+{
+	RequestStart();
+
+	if (!LoadRecording())
+		return false;
+
+	//Start worker thread
+	m_thread = std::make_shared<std::thread>([this] { Do_Work(); });
+	SetThreadNameInt(m_thread->native_handle());
+	m_bIsStarted = true;
+	sOnConnected(this);
+	return (m_thread != nullptr);
+}
+
+bool CRxReplay::StopHardware()
+{
+	if (m_thread)
+	{
+		RequestStop();
+		m_thread->join();
+		m_thread.reset();
+	}
+	m_bIsStarted = false;
+	return true;
+}
+
+bool CRxReplay::LoadRecording()
+{
+	m_records.clear();
+
+	FILE *fIn = fopen(m_szFilename.c_str(), "rb");
+	if (fIn == nullptr)
+	{
+		Log(LOG_ERROR, "Could not open recording: %s", m_szFilename.c_str());
+		return false;
+	}
+	std::vector<uint8_t> buffer;
+	uint8_t block[4096];
+	size_t bread;
+	while ((bread = fread(block, 1, sizeof(block), fIn)) > 0)
+		buffer.insert(buffer.end(), block, block + bread);
+	fclose(fIn);
+
+	if ((buffer.size() < 5) || (memcmp(buffer.data(), RXRECORD_MAGIC, 4) != 0) || (buffer[4] != RXRECORD_VERSION))
+	{
+		Log(LOG_ERROR, "Not a recording (or unsupported version): %s", m_szFilename.c_str());
+		return false;
+	}
+
+	size_t pos = 5;
+	while (pos + 11 <= buffer.size())
+	{
+		_tRxRecord record;
+		record.delayms = GetLE(&buffer[pos], 4);
+		//the recorded hardware id is not used, all frames are replayed as this hardware
+		record.BatteryLevel = static_cast<int16_t>(GetLE(&buffer[pos + 8], 2));
+		size_t namelen = buffer[pos + 10];
+		pos += 11;
+		if (pos + namelen >= buffer.size())
+			break;
+		record.Name.assign(reinterpret_cast<const char *>(&buffer[pos]), namelen);
+		pos += namelen;
+		size_t framelen = buffer[pos] + 1;
+		if (pos + framelen > buffer.size())
+			break;
+		record.Frame.assign(buffer.begin() + pos, buffer.begin() + pos + framelen);
+		pos += framelen;
+		m_records.push_back(record);
+	}
+	if (pos != buffer.size())
+		Log(LOG_ERROR, "Recording is truncated, replaying the first %d frames", static_cast<int>(m_records.size()));
+	if (m_records.empty())
+	{
+		Log(LOG_ERROR, "Recording contains no frames: %s", m_szFilename.c_str());
+		return false;
+	}
+	return true;
+}
+
+void CRxReplay::Do_Work()
+{
+	Log(LOG_STATUS, "Replaying %d frames (speed: %s, copies: %d)", static_cast<int>(m_records.size()), (m_iSpeed == 0) ? "max" : std_format("%dx", m_iSpeed).c_str(), m_iCopies);
+
+	m_tStart = std::chrono::steady_clock::now();
+	m_nMessages = 0;
+	m_fTotalLatencyms = 0;
+	m_fMaxLatencyms = 0;
+
+	auto tLastStatistics = m_tStart;
+	//frames are scheduled relative to the start of the run, so slow processing does not add up
+	auto tNextFrame = m_tStart;
+	std::vector<uint8_t> frame;
+	std::set<uint8_t> skippedtypes; //logged once
+	bool bDone = false;
+	while (!bDone)
+	{
+		for (const auto &record : m_records)
+		{
+			if (m_iSpeed != 0)
+			{
+				tNextFrame += std::chrono::milliseconds(record.delayms / m_iSpeed);
+				auto waitms = std::chrono::duration_cast<std::chrono::milliseconds>(tNextFrame - std::chrono::steady_clock::now()).count();
+				if ((waitms > 0) && (IsStopRequested(static_cast<int>(waitms))))
+					break;
+			}
+			if (IsStopRequested(0))
+				break;
+			for (int iCopy = 0; iCopy < m_iCopies; iCopy++)
+			{
+				frame = record.Frame;
+				std::string szName = record.Name;
+				if (iCopy != 0)
+				{
+					if ((frame.size() < 2) || (!RemapFrameID(frame, iCopy)))
+					{
+						if ((frame.size() >= 2) && (skippedtypes.insert(frame[1]).second))
+							Log(LOG_STATUS, "Packet type 0x%02X has no known ID layout, replaying it without copies", frame[1]);
+						break;
+					}
+					if (!szName.empty())
+						szName += std_format(" #%d", iCopy);
+				}
+				m_LastHeartbeat = mytime(nullptr);
+
+				//wait for the frame to be processed (decode, database, event queue) to measure the latency
+				auto tSend = std::chrono::steady_clock::now();
+				m_mainworker.PushAndWaitRxMessage(this, frame.data(), (szName.empty()) ? nullptr : szName.c_str(), record.BatteryLevel, m_Name.c_str());
+				double latencyms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - tSend).count();
+				m_nMessages++;
+				m_fTotalLatencyms += latencyms;
+				m_fMaxLatencyms = std::max(m_fMaxLatencyms, latencyms);
+			}
+			auto now = std::chrono::steady_clock::now();
+			if (now - tLastStatistics >= std::chrono::seconds(RXREPLAY_STATISTICS_INTERVAL))
+			{
+				tLastStatistics = now;
+				LogStatistics("Progress");
+			}
+		}
+		bDone = ((!m_bLoop) || (IsStopRequested(0)));
+	}
+	LogStatistics((IsStopRequested(0)) ? "Stopped" : "Finished");
+
+	//stay alive, the hardware is only restarted by the user
+	while (!IsStopRequested(1000))
+		m_LastHeartbeat = mytime(nullptr);
+}
+
+void CRxReplay::LogStatistics(const char *szPrefix)
+{
+	double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_tStart).count();
+	Log(LOG_STATUS, "%s: %" PRIu64 " messages in %.1f sec, %.1f msg/sec, latency avg: %.2f ms, max: %.2f ms", szPrefix, m_nMessages, elapsed,
+	    (elapsed > 0) ? m_nMessages / elapsed : 0.0, (m_nMessages != 0) ? m_fTotalLatencyms / m_nMessages : 0.0, m_fMaxLatencyms);
+}
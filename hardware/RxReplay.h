@@ -0,0 +1,73 @@
+#pragma once
+
+#include "DomoticzHardware.h"
+#include <cstdio>
+#include <mutex>
+
+//Records every received frame (as pushed to the RX queue) into a compact binary file
+//
+//File layout: "DZRX" + version byte, followed by records of
+//	uint32 ms since previous record, uint32 hardware id, int16 battery level,
+//	uint8 name length + name, frame (length = frame[0] + 1)
+//All numbers are little endian
+class CRxRecorder
+{
+      public:
+	CRxRecorder() = default;
+	~CRxRecorder();
+
+	bool Open(const std::string &szFilename);
+	void Close();
+	bool IsOpen() const
+	{
+		return (m_file != nullptr);
+	}
+	void Record(int HwdID, const uint8_t *pRXCommand, const char *defaultName, int BatteryLevel);
+
+      private:
+	std::mutex m_mutex;
+	FILE *m_file = { nullptr };
+	std::chrono::steady_clock::time_point m_tLastRecord;
+};
+
+//Replays a file written by CRxRecorder through the RX pipeline, for load and regression testing without real gateways
+//Speed: 0 = as fast as possible, N = N times the recorded speed
+//Copies: every frame is sent this many times, copy N has N added to its device ID, to synthesize extra devices
+//        (only for the packet types with a known ID layout, other frames are sent once)
+class CRxReplay : public CDomoticzHardwareBase
+{
+	struct _tRxRecord
+	{
+		uint32_t delayms;
+		int16_t BatteryLevel;
+		std::string Name;
+		std::vector<uint8_t> Frame;
+	};
+
+      public:
+	CRxReplay(int ID, const std::string &szFilename, int Speed, int Copies, bool bLoop);
+	~CRxReplay() override = default;
+	bool WriteToHardware(const char *pdata, unsigned char length) override;
+
+      private:
+	bool StartHardware() override;
+	bool StopHardware() override;
+	bool LoadRecording();
+	void Do_Work();
+	void LogStatistics(const char *szPrefix);
+
+      private:
+	std::string m_szFilename;
+	int m_iSpeed;
+	int m_iCopies;
+	bool m_bLoop;
+	std::vector<_tRxRecord> m_records;
+
+	//statistics of the current run
+	std::chrono::steady_clock::time_point m_tStart;
+	uint64_t m_nMessages = { 0 };
+	double m_fTotalLatencyms = { 0 };
+	double m_fMaxLatencyms = { 0 };
+
+	std::shared_ptr<std::thread> m_thread;
+};
@@ -13,6 +13,9 @@
 
 #define SE_VOLT_DC 20
 
+//the first poll does the site, inverter and meter requests
+#define POLL_MAX_RUNTIME 330
+
 #ifdef _DEBUG
 	//#define DEBUG_SolarEdgeAPIR_SITE
 	//#define DEBUG_SolarEdgeAPIR_INVERTERS
@@ -61,51 +64,34 @@ SolarEdgeAPI::SolarEdgeAPI(const int ID, const std::string& APIKey) :
 
 bool SolarEdgeAPI::StartHardware()
 {
-	RequestStart();
-
-	//Start worker thread
-	m_thread = std::make_shared<std::thread>([this] { Do_Work(); });
-	SetThreadNameInt(m_thread->native_handle());
+	//Poll on the shared poll service
+	Log(LOG_STATUS, "Worker started...");
+	SetPollHeartbeat(POLL_MAX_RUNTIME);
+	AddPollJob(5, 300, [this] { Do_Poll(); }, true);
 	m_bIsStarted = true;
 	sOnConnected(this);
-	return (m_thread != nullptr);
+	return true;
 }
 
 bool SolarEdgeAPI::StopHardware()
 {
-	if (m_thread)
-	{
-		RequestStop();
-		m_thread->join();
-		m_thread.reset();
-	}
+	RemovePollJobs();
+	if (m_bIsStarted)
+		Log(LOG_STATUS, "Worker stopped...");
 	m_bIsStarted = false;
 	return true;
 }
 
-void SolarEdgeAPI::Do_Work()
+void SolarEdgeAPI::Do_Poll()
 {
-	Log(LOG_STATUS, "Worker started...");
-	int sec_counter = 295;
-	while (!IsStopRequested(1000))
+	if (m_SiteID == 0)
 	{
-		sec_counter++;
-		if (sec_counter % 12 == 0) {
-			m_LastHeartbeat = mytime(nullptr);
-		}
-		if (sec_counter % 300 == 0)
-		{
-			if (m_SiteID == 0)
-			{
-				if (!GetSite())
-					continue;
-				GetInverters();
-			}
-			if (!m_inverters.empty())
-				GetMeterDetails();
-		}
+		if (!GetSite())
+			return;
+		GetInverters();
 	}
-	Log(LOG_STATUS, "Worker stopped...");
+	if (!m_inverters.empty())
+		GetMeterDetails();
 }
 
 bool SolarEdgeAPI::WriteToHardware(const char* pdata, const unsigned char length)
@@ -21,7 +21,7 @@ class SolarEdgeAPI : public CDomoticzHardwareBase
       private:
 	bool StartHardware() override;
 	bool StopHardware() override;
-	void Do_Work();
+	void Do_Poll();
 	bool GetSite();
 	void GetInverters();
 	void GetMeterDetails();
@@ -35,6 +35,4 @@ class SolarEdgeAPI : public CDomoticzHardwareBase
 
 	double m_totalActivePower;
 	double m_totalEnergy;
-
-	std::shared_ptr<std::thread> m_thread;
 };
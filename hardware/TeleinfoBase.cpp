@@ -61,7 +61,7 @@ int CTeleinfoBase::AlertLevel(int Iinst, int Isousc, char* text)
 	int level;
 	float flevel;
 
-	flevel = (float)(Iinst * 100) / Isousc;
+	flevel = (Iinst * 100.0F) / Isousc;
 	level = 1;
 	sprintf(text, " < 80%% de %iA souscrits", Isousc);
 	if (flevel > 80)
@@ -207,7 +207,9 @@ void CTeleinfoBase::ProcessTeleinfo(const std::string &name, int rank, Teleinfo
 				m_pappHPJW = 0;
 				m_pappHCJR = 0;
 				m_pappHPJR = 0;
-				if (teleinfo.PTEC.substr(3, 1) == "B")
+				// PTEC is HPJB, HCJW, ... the 4th character is the color of the day, a truncated line can be shorter
+				const char cColor = (teleinfo.PTEC.size() > 3) ? teleinfo.PTEC[3] : 0;
+				if (cColor == 'B')
 				{
 					teleinfo.color = "Bleu";
 					color_alert = 1;
@@ -216,7 +218,7 @@ void CTeleinfoBase::ProcessTeleinfo(const std::string &name, int rank, Teleinfo
 					else
 						m_pappHPJB = teleinfo.PAPP;
 				}
-				else if (teleinfo.PTEC.substr(3, 1) == "W")
+				else if (cColor == 'W')
 				{
 					teleinfo.color = "Blanc";
 					color_alert = 2;
@@ -225,7 +227,7 @@ void CTeleinfoBase::ProcessTeleinfo(const std::string &name, int rank, Teleinfo
 					else
 						m_pappHPJW = teleinfo.PAPP;
 				}
-				else if (teleinfo.PTEC.substr(3, 1) == "R")
+				else if (cColor == 'R')
 				{
 					teleinfo.color = "Rouge";
 					color_alert = 3;
@@ -114,6 +114,12 @@ namespace Plugins {
 		m_sRetainedData.assign(sData.c_str(), sData.c_str() + sData.length()); // retain any residual for next time
 	}
 
+	// Received text is not always valid UTF-8, invalid sequences are replaced instead of failing the conversion
+	static PyObject* ReceivedString(const std::string& value)
+	{
+		return PyUnicode_DecodeUTF8(value.c_str(), value.length(), "replace");
+	}
+
 	static void AddBytesToDict(PyObject* pDict, const char* key, const std::string& value)
 	{
 		PyNewRef pObj = Py_BuildValue("y#", value.c_str(), value.length());
@@ -123,7 +129,7 @@ namespace Plugins {
 
 	static void AddStringToDict(PyObject* pDict, const char* key, const std::string& value)
 	{
-		PyNewRef pObj = Py_BuildValue("s#", value.c_str(), value.length());
+		PyNewRef pObj = ReceivedString(value);
 		if (PyDict_SetItemString(pDict, key, pObj) == -1)
 			_log.Log(LOG_ERROR, "(%s) failed to add key '%s', value '%s' to dictionary.", __func__, key, value.c_str());
 	}
@@ -443,11 +449,20 @@ namespace Plugins {
 		*pData = pData->substr(pData->find_first_of('\n') + 1);
 		while (pData->length() && ((*pData)[0] != '\r'))
 		{
-			std::string		sHeaderLine = pData->substr(0, pData->find_first_of('\r'));
-			std::string		sHeaderName = pData->substr(0, sHeaderLine.find_first_of(':'));
+			// Header line not complete yet, wait for more data
+			size_t			uLineEnd = pData->find_first_of('\n');
+			if (uLineEnd == std::string::npos)
+			{
+				pData->clear();
+				return;
+			}
+			std::string		sHeaderLine = pData->substr(0, uLineEnd);
+			if (!sHeaderLine.empty() && (sHeaderLine.back() == '\r'))
+				sHeaderLine.pop_back();
+			std::string		sHeaderName = sHeaderLine.substr(0, sHeaderLine.find_first_of(':'));
 			std::string		uHeaderName = sHeaderName;
 			stdupper(uHeaderName);
-			std::string		sHeaderText = sHeaderLine.substr(sHeaderName.length() + 2);
+			std::string		sHeaderText = sHeaderLine.substr(std::min(sHeaderName.length() + 2, sHeaderLine.length()));
 			if (uHeaderName == "CONTENT-LENGTH")
 			{
 				m_ContentLength = atoi(sHeaderText.c_str());
@@ -459,7 +474,7 @@ namespace Plugins {
 				if (uHeaderText == "CHUNKED")
 					m_Chunked = true;
 			}
-			PyNewRef		pObj = Py_BuildValue("s", sHeaderText.c_str());
+			PyNewRef		pObj = ReceivedString(sHeaderText);
 			PyBorrowedRef	pPrevObj = PyDict_GetItemString((PyObject *)m_Headers, sHeaderName.c_str());
 			// Encode multi headers in a list
 			if (pPrevObj)
@@ -496,7 +511,8 @@ namespace Plugins {
 		if (!m_sRetainedData.empty())
 		{
 			// Forced buffer clear, make sure the plugin gets a look at the data in case it wants it
-			ProcessInbound(new ReadEvent(pPlugin, pConnection, 0, nullptr));
+			ReadEvent	Message(pPlugin, pConnection, 0, nullptr);
+			ProcessInbound(&Message);
 			m_sRetainedData.clear();
 		}
 	}
@@ -575,7 +591,7 @@ namespace Plugins {
 					if ((m_ContentLength == sData.length()) || (Message->m_Buffer.empty()))
 					{
 						PyObject* pDataDict = PyDict_New();
-						PyNewRef pObj = Py_BuildValue("s", m_Status.c_str());
+						PyNewRef pObj = ReceivedString(m_Status);
 						if (PyDict_SetItemString(pDataDict, "Status", pObj) == -1)
 							_log.Log(LOG_ERROR, "(%s) failed to add key '%s', value '%s' to dictionary.", "HTTP", "Status", m_Status.c_str());
 
@@ -618,14 +634,27 @@ namespace Plugins {
 							        break;
 							}
 							std::string		sChunkLine = sData.substr(0, uSizeEnd);
-							m_RemainingChunk = strtol(sChunkLine.c_str(), nullptr, 16);
+							long lChunkSize = strtol(sChunkLine.c_str(), nullptr, 16);
+							if (lChunkSize < 0)
+							{
+								// would wait forever for data that never arrives
+								_log.Log(LOG_ERROR, "(%s) Invalid chunk size '%s', response discarded.", "HTTP", sChunkLine.c_str());
+								m_sRetainedData.clear();
+								if (m_Headers)
+								{
+									Py_DECREF((PyObject*)m_Headers);
+									m_Headers = nullptr;
+								}
+								break;
+							}
+							m_RemainingChunk = lChunkSize;
 							sData = sData.substr(sData.find_first_of('\n') + 1);
 
 							// last chunk is zero length, but still has a terminator.  We aren't done until we have received the terminator as well
 							if (m_RemainingChunk == 0 && (sData.find_first_of('\n') != std::string::npos))
 							{
 								PyObject* pDataDict = PyDict_New();
-								PyNewRef pObj = Py_BuildValue("s", m_Status.c_str());
+								PyNewRef pObj = ReceivedString(m_Status);
 								if (PyDict_SetItemString(pDataDict, "Status", pObj) == -1)
 									_log.Log(LOG_ERROR, "(%s) failed to add key '%s', value '%s' to dictionary.", "HTTP", "Status", m_Status.c_str());
 
@@ -684,12 +713,13 @@ namespace Plugins {
 				{
 					PyObject* DataDict = PyDict_New();
 					std::string		sVerb = sFirstLine.substr(0, sFirstLine.find_first_of(' '));
-					PyNewRef pObj = Py_BuildValue("s", sVerb.c_str());
+					PyNewRef pObj = ReceivedString(sVerb);
 					if (PyDict_SetItemString(DataDict, "Verb", pObj) == -1)
 						_log.Log(LOG_ERROR, "(%s) failed to add key '%s', value '%s' to dictionary.", "HTTP", "Verb", sVerb.c_str());
 
-					std::string		sURL = sFirstLine.substr(sVerb.length() + 1, sFirstLine.find_first_of(' ', sVerb.length() + 1));
-					PyNewRef pURL = Py_BuildValue("s", sURL.c_str());
+					size_t			uURLStart = std::min(sVerb.length() + 1, sFirstLine.length());
+					std::string		sURL = sFirstLine.substr(uURLStart, sFirstLine.find_first_of(' ', uURLStart) - uURLStart);
+					PyNewRef pURL = ReceivedString(sURL);
 					if (PyDict_SetItemString(DataDict, "URL", pURL) == -1)
 						_log.Log(LOG_ERROR, "(%s) failed to add key '%s', value '%s' to dictionary.", "HTTP", "URL", sURL.c_str());
 
@@ -1209,6 +1239,8 @@ namespace Plugins {
 
 		byte loop = 0;
 		m_sRetainedData.insert(m_sRetainedData.end(), Message->m_Buffer.begin(), Message->m_Buffer.end());
+		if (m_sRetainedData.empty())
+			return;
 
 		do {
 			std::vector<byte>::iterator it = m_sRetainedData.begin();
@@ -1225,12 +1257,19 @@ namespace Plugins {
 
 			do
 			{
+				if (it == m_sRetainedData.end())
+				{
+					// Remaining Length has not arrived completely, wait for more data
+					Py_DECREF(pMqttDict);
+					return;
+				}
 				encodedByte = *it++;
 				iRemainingLength += (encodedByte & 127) * multiplier;
 				multiplier *= 128;
 				if (multiplier > 128 * 128 * 128)
 				{
 					_log.Log(LOG_ERROR, "(%s) Malformed Remaining Length.", __func__);
+					Py_DECREF(pMqttDict);
 					return;
 				}
 			} while ((encodedByte & 128) != 0);
@@ -1239,6 +1278,7 @@ namespace Plugins {
 			{
 				// Full packet has not arrived, wait for more data
 				_log.Debug(DEBUG_NORM, "(%s) Not enough data received (got %ld, expected %ld).", __func__, (long)std::distance(it, m_sRetainedData.end()), iRemainingLength);
+				Py_DECREF(pMqttDict);
 				return;
 			}
 
@@ -1293,9 +1333,6 @@ namespace Plugins {
 			case MQTT_SUBACK:
 			{
 				AddStringToDict(pMqttDict, "Verb", std::string("SUBACK"));
-				iPacketIdentifier = (*it++ << 8) + *it++;
-				AddIntToDict(pMqttDict, "PacketIdentifier", iPacketIdentifier);
-
 				if (flags != 0)
 				{
 					_log.Log(LOG_ERROR, "(%s) MQTT protocol violation: Invalid message flags %u for packet type '%u'", __func__, flags, bResponseType >> 4);
@@ -1304,6 +1341,9 @@ namespace Plugins {
 				}
 				if (iRemainingLength >= 3) // check length is acceptable
 				{
+					iPacketIdentifier = (*it++ << 8) + *it++;
+					AddIntToDict(pMqttDict, "PacketIdentifier", iPacketIdentifier);
+
 					PyObject* pResponsesList = PyList_New(0);
 					if (PyDict_SetItemString(pMqttDict, "Topics", pResponsesList) == -1)
 					{
@@ -1412,6 +1452,12 @@ namespace Plugins {
 				AddIntToDict(pMqttDict, "QoS", (int)iQoS);
 				PyDict_SetItemString(pMqttDict, "Retain", PyBool_FromLong(flags & 0x01));
 				// Variable Header
+				if (iRemainingLength < 2)
+				{
+					_log.Log(LOG_ERROR, "(%s) MQTT protocol violation: Invalid message length %ld for packet type '%u'", __func__, iRemainingLength, bResponseType >> 4);
+					m_bErrored = true;
+					break;
+				}
 				int		topicLen = (*it++ << 8) + *it++;
 				if (topicLen + 2 + (iQoS ? 2 : 0) > iRemainingLength)
 				{
@@ -1472,6 +1518,7 @@ namespace Plugins {
 			}
 
 			if (!m_bErrored) Message->m_pPlugin->MessagePlugin(new onMessageCallback(Message->m_pPlugin, Message->m_pConnection, pMqttDict));
+			else Py_DECREF(pMqttDict);
 
 			m_sRetainedData.erase(m_sRetainedData.begin(), pktend);
 		} while (!m_bErrored && !m_sRetainedData.empty());
@@ -1846,6 +1893,10 @@ namespace Plugins {
 			long		lMaskingKey = 0;
 			bool		bFinish = false;
 
+			// Header (opcode and length) not complete yet
+			if (vMessage.size() < 2)
+				return false;
+
 			bFinish = (vMessage[iOffset] & 0x80);				// Indicates that this is the final fragment in a message if true
 			if (vMessage[iOffset] & 0x0F)
 			{
@@ -1861,7 +1912,7 @@ namespace Plugins {
 			long	lPayloadLength = (vMessage[iOffset] & 0x7F);	// if < 126 then this is the length
 			if (lPayloadLength == 126)
 			{
-				if (vMessage.size() < (iOffset + 2))
+				if (vMessage.size() < (iOffset + 3))
 					return false;
 				lPayloadLength = (vMessage[iOffset + 1] << 8) + vMessage[iOffset + 2];
 				iOffset += 2;
@@ -1878,7 +1929,7 @@ namespace Plugins {
 			byte *pbMask = nullptr;
 			if (bMasked)
 			{
-				if (vMessage.size() < iOffset)
+				if (vMessage.size() < (iOffset + 4))
 					return false;
 				lMaskingKey = (long)vMessage[iOffset];
 				pbMask = &vMessage[iOffset];
@@ -1925,7 +1976,7 @@ namespace Plugins {
 			case 0x01:	// Text message
 			{
 				std::string		sPayload(vPayload.begin(), vPayload.end());
-				pPayload = Py_BuildValue("s", sPayload.c_str());
+				pPayload = ReceivedString(sPayload);
 				break;
 			}
 			case 0x02:	// Binary message
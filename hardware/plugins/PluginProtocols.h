@@ -12,6 +12,7 @@ namespace Plugins {
 
 	      public:
 		CPluginProtocol() = default;
+		virtual ~CPluginProtocol() = default;
 		virtual void				ProcessInbound(const ReadEvent* Message);
 		virtual std::vector<byte>	ProcessOutbound(const WriteDirective* WriteMessage);
 		virtual void				Flush(CPlugin* pPlugin, CConnection* pConnection);
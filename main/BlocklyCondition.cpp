@@ -0,0 +1,594 @@
+#include "stdafx.h"
+#include "BlocklyCondition.h"
+#include <cerrno>
+
+namespace
+{
+	const struct
+	{
+		const char *name;
+		CBlocklyCondition::_eTable table;
+	} BlocklyTables[] = {
+		{ "device", CBlocklyCondition::BT_DEVICE },
+		{ "variable", CBlocklyCondition::BT_VARIABLE },
+		{ "temperaturedevice", CBlocklyCondition::BT_TEMPERATURE },
+		{ "dewpointdevice", CBlocklyCondition::BT_DEWPOINT },
+		{ "humiditydevice", CBlocklyCondition::BT_HUMIDITY },
+		{ "barometerdevice", CBlocklyCondition::BT_BAROMETER },
+		{ "utilitydevice", CBlocklyCondition::BT_UTILITY },
+		{ "weatherdevice", CBlocklyCondition::BT_WEATHER },
+		{ "raindevice", CBlocklyCondition::BT_RAIN },
+		{ "rainlasthourdevice", CBlocklyCondition::BT_RAINLASTHOUR },
+		{ "uvdevice", CBlocklyCondition::BT_UV },
+		{ "winddirdevice", CBlocklyCondition::BT_WINDDIR },
+		{ "windspeeddevice", CBlocklyCondition::BT_WINDSPEED },
+		{ "windgustdevice", CBlocklyCondition::BT_WINDGUST },
+		{ "zwavealarms", CBlocklyCondition::BT_ZWAVEALARMS },
+	};
+
+	const char *TypeName(const CBlocklyCondition::_tValue &value)
+	{
+		switch (value.type)
+		{
+		case CBlocklyCondition::_tValue::VT_BOOL:
+			return "boolean";
+		case CBlocklyCondition::_tValue::VT_NUMBER:
+			return "number";
+		case CBlocklyCondition::_tValue::VT_STRING:
+			return "string";
+		default:
+			return "nil";
+		}
+	}
+
+	bool IsTrue(const CBlocklyCondition::_tValue &value)
+	{
+		if (value.type == CBlocklyCondition::_tValue::VT_NIL)
+			return false;
+		if (value.type == CBlocklyCondition::_tValue::VT_BOOL)
+			return (value.number != 0);
+		return true;
+	}
+
+	//tostring() of a Lua number
+	std::string NumberToString(const CBlocklyCondition::_tValue &value)
+	{
+		char szTmp[64];
+		if (value.bInteger)
+		{
+			sprintf(szTmp, "%lld", static_cast<long long>(value.number));
+			return szTmp;
+		}
+		sprintf(szTmp, "%.14g", value.number);
+		if (szTmp[strspn(szTmp, "-0123456789")] == 0)
+			strcat(szTmp, ".0");
+		return szTmp;
+	}
+
+	//tonumber() of a string, nil when it is not a number
+	bool StringToNumber(const std::string &str, CBlocklyCondition::_tValue &result)
+	{
+		size_t begin = str.find_first_not_of(" \t\r\n\f\v");
+		size_t end = str.find_last_not_of(" \t\r\n\f\v");
+		if ((begin == std::string::npos) || (str.find_first_of("nN") != std::string::npos))
+			return false;
+		std::string szNumber = str.substr(begin, end - begin + 1);
+		const char *pNumber = szNumber.c_str();
+		char *pEnd = nullptr;
+		if (szNumber.find_first_not_of("-0123456789") == std::string::npos)
+		{
+			long long value = strtoll(pNumber, &pEnd, 10);
+			if ((pEnd != pNumber) && (*pEnd == 0))
+			{
+				result.SetNumber(static_cast<double>(value), true);
+				return true;
+			}
+		}
+		double value = strtod(pNumber, &pEnd);
+		if ((pEnd == pNumber) || (*pEnd != 0))
+			return false;
+		result.SetNumber(value, false);
+		return true;
+	}
+} // namespace
+
+struct CBlocklyCondition::_tParser
+{
+	const std::string &s;
+	size_t pos = 0;
+
+	explicit _tParser(const std::string &str)
+		: s(str)
+	{
+	}
+
+	void SkipSpace()
+	{
+		while ((pos < s.size()) && (isspace(static_cast<unsigned char>(s[pos]))))
+			pos++;
+	}
+	bool AtEnd()
+	{
+		SkipSpace();
+		return (pos >= s.size());
+	}
+	bool Accept(const char *token)
+	{
+		SkipSpace();
+		size_t len = strlen(token);
+		if (s.compare(pos, len, token) != 0)
+			return false;
+		pos += len;
+		return true;
+	}
+	bool PeekIdent(std::string &ident)
+	{
+		SkipSpace();
+		size_t end = pos;
+		while ((end < s.size()) && ((isalnum(static_cast<unsigned char>(s[end]))) || (s[end] == '_')))
+			end++;
+		if ((end == pos) || (isdigit(static_cast<unsigned char>(s[pos]))))
+			return false;
+		ident = s.substr(pos, end - pos);
+		return true;
+	}
+	bool AcceptWord(const char *word)
+	{
+		std::string ident;
+		if ((!PeekIdent(ident)) || (ident != word))
+			return false;
+		pos += ident.size();
+		return true;
+	}
+	bool ReadNumber(_tValue &value)
+	{
+		SkipSpace();
+		if ((pos >= s.size()) || ((!isdigit(static_cast<unsigned char>(s[pos]))) && (s[pos] != '.')))
+			return false;
+		size_t end = pos;
+		while ((end < s.size()) && ((isalnum(static_cast<unsigned char>(s[end]))) || (s[end] == '.')))
+			end++;
+		std::string szNumber = s.substr(pos, end - pos);
+		if ((szNumber.find_first_of("xX") != std::string::npos) || (!StringToNumber(szNumber, value)))
+			return false;
+		pos = end;
+		return true;
+	}
+	bool ReadInteger(int &value)
+	{
+		_tValue number;
+		if ((!ReadNumber(number)) || (!number.bInteger))
+			return false;
+		value = static_cast<int>(number.number);
+		return true;
+	}
+	bool ReadString(_tValue &value)
+	{
+		SkipSpace();
+		if ((pos >= s.size()) || ((s[pos] != '"') && (s[pos] != '\'')))
+			return false;
+		size_t end = s.find(s[pos], pos + 1);
+		if (end == std::string::npos)
+			return false;
+		std::string str = s.substr(pos + 1, end - pos - 1);
+		//escape sequences are left to Lua
+		if (str.find_first_of("\\\n") != std::string::npos)
+			return false;
+		value.SetString(str);
+		pos = end + 1;
+		return true;
+	}
+};
+
+void CBlocklyCondition::GetTriggers(const std::string &conditions, _tTriggers &triggers)
+{
+	triggers.ids.clear();
+	triggers.variables.clear();
+	size_t pos = conditions.find('[');
+	while (pos != std::string::npos)
+	{
+		size_t end = conditions.find_first_not_of("0123456789", pos + 1);
+		if ((end != std::string::npos) && (end > pos + 1) && (conditions[end] == ']'))
+		{
+			//the conditions are user XML, an index that does not fit can never match a device or variable
+			errno = 0;
+			uint64_t id = strtoull(conditions.c_str() + pos + 1, nullptr, 10);
+			if (errno != ERANGE)
+			{
+				triggers.ids.insert(id);
+				if ((pos >= 8) && (conditions.compare(pos - 8, 8, "variable") == 0))
+					triggers.variables.insert(id);
+			}
+		}
+		pos = conditions.find('[', pos + 1);
+	}
+	triggers.bSecurity = (conditions.find("securitystatus") != std::string::npos);
+	triggers.bTime = ((conditions.find("timeofday") != std::string::npos) || (conditions.find("weekday") != std::string::npos));
+}
+
+bool CBlocklyCondition::Compile(const std::string &conditions)
+{
+	m_nodes.clear();
+	m_bUsesMeasurements = false;
+	_tParser p(conditions);
+	m_root = ParseOr(p);
+	if ((m_root < 0) || (!p.AtEnd()))
+	{
+		m_nodes.clear();
+		m_root = -1;
+		return false;
+	}
+	return true;
+}
+
+int CBlocklyCondition::AddNode(const _tNode &node)
+{
+	m_nodes.push_back(node);
+	return static_cast<int>(m_nodes.size()) - 1;
+}
+
+int CBlocklyCondition::ParseOr(_tParser &p)
+{
+	int left = ParseAnd(p);
+	while ((left >= 0) && (p.AcceptWord("or")))
+	{
+		_tNode node;
+		node.type = NT_OR;
+		node.left = left;
+		node.right = ParseAnd(p);
+		if (node.right < 0)
+			return -1;
+		left = AddNode(node);
+	}
+	return left;
+}
+
+int CBlocklyCondition::ParseAnd(_tParser &p)
+{
+	int left = ParseCompare(p);
+	while ((left >= 0) && (p.AcceptWord("and")))
+	{
+		_tNode node;
+		node.type = NT_AND;
+		node.left = left;
+		node.right = ParseCompare(p);
+		if (node.right < 0)
+			return -1;
+		left = AddNode(node);
+	}
+	return left;
+}
+
+//Every operand of and/or is a comparison or a parenthesized condition
+int CBlocklyCondition::ParseCompare(_tParser &p)
+{
+	if (p.Accept("("))
+	{
+		int inner = ParseOr(p);
+		if ((inner < 0) || (!p.Accept(")")))
+			return -1;
+		return inner;
+	}
+	_tNode node;
+	node.type = NT_COMPARE;
+	node.left = ParseArith(p);
+	if (node.left < 0)
+		return -1;
+	static const char *operators[] = { "==", "~=", "<=", ">=", "<", ">" };
+	bool bFound = false;
+	for (const auto &op : operators)
+	{
+		if (p.Accept(op))
+		{
+			strcpy(node.op, op);
+			bFound = true;
+			break;
+		}
+	}
+	if (!bFound)
+		return -1;
+	node.right = ParseArith(p);
+	if (node.right < 0)
+		return -1;
+	return AddNode(node);
+}
+
+int CBlocklyCondition::ParseArith(_tParser &p)
+{
+	int left = ParseTerm(p);
+	while (left >= 0)
+	{
+		_tNode node;
+		node.type = NT_ARITH;
+		if (p.Accept("+"))
+			strcpy(node.op, "+");
+		else if (p.Accept("-"))
+		{
+			if (p.Accept("-"))
+				return -1; //a comment, left to Lua
+			strcpy(node.op, "-");
+		}
+		else
+			break;
+		node.left = left;
+		node.right = ParseTerm(p);
+		if (node.right < 0)
+			return -1;
+		left = AddNode(node);
+	}
+	return left;
+}
+
+int CBlocklyCondition::ParseTerm(_tParser &p)
+{
+	int left = ParseUnary(p);
+	while (left >= 0)
+	{
+		_tNode node;
+		node.type = NT_ARITH;
+		if (p.Accept("*"))
+			strcpy(node.op, "*");
+		else if (p.Accept("/"))
+		{
+			if (p.Accept("/"))
+				return -1; //floor division, left to Lua
+			strcpy(node.op, "/");
+		}
+		else
+			break;
+		node.left = left;
+		node.right = ParseUnary(p);
+		if (node.right < 0)
+			return -1;
+		left = AddNode(node);
+	}
+	return left;
+}
+
+int CBlocklyCondition::ParseUnary(_tParser &p)
+{
+	if (p.Accept("-"))
+	{
+		if (p.Accept("-"))
+			return -1; //a comment, left to Lua
+		_tNode node;
+		node.type = NT_NEGATE;
+		node.left = ParseUnary(p);
+		if (node.left < 0)
+			return -1;
+		return AddNode(node);
+	}
+	return ParsePrimary(p);
+}
+
+int CBlocklyCondition::ParsePrimary(_tParser &p)
+{
+	_tNode node;
+	node.type = NT_CONST;
+	if ((p.ReadNumber(node.value)) || (p.ReadString(node.value)))
+		return AddNode(node);
+
+	if (p.Accept("@"))
+	{
+		if (p.AcceptWord("Sunrise"))
+			node.type = NT_SUNRISE;
+		else if (p.AcceptWord("Sunset"))
+			node.type = NT_SUNSET;
+		else
+			return -1;
+		return AddNode(node);
+	}
+
+	std::string ident;
+	if (!p.PeekIdent(ident))
+		return -1;
+	p.pos += ident.size();
+
+	if (ident == "timeofday")
+		node.type = NT_TIMEOFDAY;
+	else if (ident == "weekday")
+		node.type = NT_WEEKDAY;
+	else if (ident == "securitystatus")
+		node.type = NT_SECURITYSTATUS;
+	else if (ident == "tonumber")
+	{
+		//tonumber(string.sub(x,from,to)), used to convert a hh:mm variable
+		node.type = NT_TONUMBERSUB;
+		if ((!p.Accept("(")) || (!p.AcceptWord("string")) || (!p.Accept(".")) || (!p.AcceptWord("sub")) || (!p.Accept("(")))
+			return -1;
+		node.left = ParseArith(p);
+		if ((node.left < 0) || (!p.Accept(",")) || (!p.ReadInteger(node.from)) || (!p.Accept(",")) || (!p.ReadInteger(node.to)) || (!p.Accept(")")) || (!p.Accept(")")))
+			return -1;
+	}
+	else
+	{
+		bool bFound = false;
+		for (const auto &table : BlocklyTables)
+		{
+			if (ident == table.name)
+			{
+				node.type = NT_TABLE;
+				node.table = table.table;
+				bFound = true;
+				break;
+			}
+		}
+		if (!bFound)
+			return -1;
+		_tValue id;
+		if ((!p.Accept("[")) || (!p.ReadNumber(id)) || (!id.bInteger) || (id.number < 0) || (!p.Accept("]")))
+			return -1;
+		node.id = static_cast<uint64_t>(id.number);
+		if ((node.table != BT_DEVICE) && (node.table != BT_VARIABLE))
+			m_bUsesMeasurements = true;
+	}
+	return AddNode(node);
+}
+
+bool CBlocklyCondition::Evaluate(const _tContext &ctx, bool &bResult, std::string &szError) const
+{
+	bResult = false;
+	if (m_root < 0)
+	{
+		szError = "condition not compiled";
+		return false;
+	}
+	_tValue result;
+	if (!Eval(m_root, ctx, result, szError))
+		return false;
+	bResult = IsTrue(result);
+	return true;
+}
+
+bool CBlocklyCondition::Eval(const int inode, const _tContext &ctx, _tValue &result, std::string &szError) const
+{
+	const _tNode &node = m_nodes[inode];
+	switch (node.type)
+	{
+	case NT_OR:
+		if (!Eval(node.left, ctx, result, szError))
+			return false;
+		if (IsTrue(result))
+			return true;
+		return Eval(node.right, ctx, result, szError);
+	case NT_AND:
+		if (!Eval(node.left, ctx, result, szError))
+			return false;
+		if (!IsTrue(result))
+			return true;
+		return Eval(node.right, ctx, result, szError);
+	case NT_COMPARE:
+	{
+		_tValue left, right;
+		if ((!Eval(node.left, ctx, left, szError)) || (!Eval(node.right, ctx, right, szError)))
+			return false;
+		bool bTrue;
+		if ((node.op[0] == '=') || (node.op[0] == '~'))
+		{
+			if (left.type != right.type)
+				bTrue = false;
+			else if (left.type == _tValue::VT_STRING)
+				bTrue = (left.str == right.str);
+			else
+				bTrue = (left.number == right.number);
+			if (node.op[0] == '~')
+				bTrue = !bTrue;
+		}
+		else
+		{
+			int cmp;
+			if ((left.type == _tValue::VT_NUMBER) && (right.type == _tValue::VT_NUMBER))
+				cmp = (left.number < right.number) ? -1 : ((left.number > right.number) ? 1 : 0);
+			else if ((left.type == _tValue::VT_STRING) && (right.type == _tValue::VT_STRING))
+				cmp = strcoll(left.str.c_str(), right.str.c_str());
+			else
+			{
+				szError = std::string("attempt to compare ") + TypeName(left) + " with " + TypeName(right);
+				return false;
+			}
+			if (node.op[0] == '<')
+				bTrue = (node.op[1] == '=') ? (cmp <= 0) : (cmp < 0);
+			else
+				bTrue = (node.op[1] == '=') ? (cmp >= 0) : (cmp > 0);
+		}
+		result.type = _tValue::VT_BOOL;
+		result.number = bTrue ? 1 : 0;
+		return true;
+	}
+	case NT_ARITH:
+	case NT_NEGATE:
+	{
+		_tValue operands[2];
+		int count = (node.type == NT_NEGATE) ? 1 : 2;
+		for (int ii = 0; ii < count; ii++)
+		{
+			if (!Eval((ii == 0) ? node.left : node.right, ctx, operands[ii], szError))
+				return false;
+			//strings are converted like Lua does for arithmetic
+			if (operands[ii].type == _tValue::VT_STRING)
+			{
+				std::string str = operands[ii].str;
+				if (!StringToNumber(str, operands[ii]))
+					operands[ii].type = _tValue::VT_STRING;
+			}
+			if (operands[ii].type != _tValue::VT_NUMBER)
+			{
+				szError = std::string("attempt to perform arithmetic on a ") + TypeName(operands[ii]) + " value";
+				return false;
+			}
+		}
+		if (node.type == NT_NEGATE)
+		{
+			result.SetNumber(-operands[0].number, operands[0].bInteger);
+			return true;
+		}
+		bool bInteger = ((operands[0].bInteger) && (operands[1].bInteger));
+		switch (node.op[0])
+		{
+		case '+':
+			result.SetNumber(operands[0].number + operands[1].number, bInteger);
+			break;
+		case '-':
+			result.SetNumber(operands[0].number - operands[1].number, bInteger);
+			break;
+		case '*':
+			result.SetNumber(operands[0].number * operands[1].number, bInteger);
+			break;
+		default:
+			result.SetNumber(operands[0].number / operands[1].number, false);
+			break;
+		}
+		return true;
+	}
+	case NT_CONST:
+		result = node.value;
+		return true;
+	case NT_TABLE:
+		result = _tValue();
+		if (!ctx.lookup(node.table, node.id, result))
+		{
+			szError = std::string("attempt to index a nil value (global '") + BlocklyTables[node.table].name + "')";
+			return false;
+		}
+		return true;
+	case NT_TIMEOFDAY:
+		result.SetNumber(ctx.timeofday, true);
+		return true;
+	case NT_WEEKDAY:
+		result.SetNumber(ctx.weekday, true);
+		return true;
+	case NT_SECURITYSTATUS:
+		result.SetNumber(ctx.securitystatus, false);
+		return true;
+	case NT_SUNRISE:
+		result.SetNumber(ctx.sunrise, true);
+		return true;
+	case NT_SUNSET:
+		result.SetNumber(ctx.sunset, true);
+		return true;
+	case NT_TONUMBERSUB:
+	{
+		_tValue value;
+		if (!Eval(node.left, ctx, value, szError))
+			return false;
+		std::string str;
+		if (value.type == _tValue::VT_STRING)
+			str = value.str;
+		else if (value.type == _tValue::VT_NUMBER)
+			str = NumberToString(value);
+		else
+		{
+			szError = std::string("bad argument #1 to 'sub' (string expected, got ") + TypeName(value) + ")";
+			return false;
+		}
+		//string.sub with positive positions, 1 based and inclusive
+		int from = std::max(node.from, 1);
+		int to = std::min(node.to, static_cast<int>(str.size()));
+		str = (from <= to) ? str.substr(from - 1, to - from + 1) : "";
+		result = _tValue();
+		StringToNumber(str, result);
+		return true;
+	}
+	}
+	return false;
+}
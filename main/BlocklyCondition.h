@@ -0,0 +1,140 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <set>
+#include <string>
+#include <vector>
+
+//Compiled form of the conditions generated by the Blockly editor, evaluated natively instead of in a Lua state
+//
+//The editor generates a small subset of Lua: comparisons of table entries (device[12], variable[3], temperaturedevice[7], ...),
+//timeofday, weekday, securitystatus, @Sunrise/@Sunset, strings and numbers, combined with and/or and parentheses.
+//Comparisons follow the Lua rules (no coercion between strings and numbers, ordering them is an error).
+//Conditions that use anything else do not compile, those are still evaluated by Lua.
+class CBlocklyCondition
+{
+public:
+	enum _eTable
+	{
+		BT_DEVICE = 0,
+		BT_VARIABLE,
+		BT_TEMPERATURE,
+		BT_DEWPOINT,
+		BT_HUMIDITY,
+		BT_BAROMETER,
+		BT_UTILITY,
+		BT_WEATHER,
+		BT_RAIN,
+		BT_RAINLASTHOUR,
+		BT_UV,
+		BT_WINDDIR,
+		BT_WINDSPEED,
+		BT_WINDGUST,
+		BT_ZWAVEALARMS,
+		BT_MAX
+	};
+
+	struct _tValue
+	{
+		enum _eType
+		{
+			VT_NIL = 0,
+			VT_BOOL,
+			VT_NUMBER,
+			VT_STRING
+		} type = VT_NIL;
+		bool bInteger = false;
+		double number = 0;
+		std::string str;
+
+		void SetNumber(const double value, const bool bIsInteger)
+		{
+			type = VT_NUMBER;
+			number = value;
+			bInteger = bIsInteger;
+		}
+		void SetString(const std::string &value)
+		{
+			type = VT_STRING;
+			str = value;
+		}
+	};
+
+	struct _tContext
+	{
+		int timeofday;
+		int weekday;
+		int securitystatus;
+		int sunrise;
+		int sunset;
+		//false when the table does not exist (a table without entries is not published to Lua either)
+		std::function<bool(_eTable table, uint64_t id, _tValue &value)> lookup;
+	};
+
+	//What a condition refers to, decides if a rule has to be evaluated for an event
+	struct _tTriggers
+	{
+		std::set<uint64_t> ids; //any [id], matches device events
+		std::set<uint64_t> variables; //variable[id]
+		bool bSecurity = false;
+		bool bTime = false;
+	};
+
+	static void GetTriggers(const std::string &conditions, _tTriggers &triggers);
+
+	bool Compile(const std::string &conditions);
+	//false with szError set when Lua would have raised an error
+	bool Evaluate(const _tContext &ctx, bool &bResult, std::string &szError) const;
+	//the condition reads measurement tables (temperaturedevice, ...), which have to be refreshed first
+	bool UsesMeasurements() const
+	{
+		return m_bUsesMeasurements;
+	}
+
+private:
+	enum _eNodeType
+	{
+		NT_OR = 0,
+		NT_AND,
+		NT_COMPARE,
+		NT_ARITH,
+		NT_NEGATE,
+		NT_CONST,
+		NT_TABLE,
+		NT_TIMEOFDAY,
+		NT_WEEKDAY,
+		NT_SECURITYSTATUS,
+		NT_SUNRISE,
+		NT_SUNSET,
+		NT_TONUMBERSUB
+	};
+	struct _tNode
+	{
+		_eNodeType type;
+		char op[3]; //compare or arithmetic operator
+		int left = -1;
+		int right = -1;
+		_eTable table = BT_DEVICE;
+		uint64_t id = 0;
+		int from = 0, to = 0; //string.sub
+		_tValue value;
+	};
+
+	struct _tParser;
+
+	int AddNode(const _tNode &node);
+	int ParseOr(_tParser &p);
+	int ParseAnd(_tParser &p);
+	int ParseCompare(_tParser &p);
+	int ParseArith(_tParser &p);
+	int ParseTerm(_tParser &p);
+	int ParseUnary(_tParser &p);
+	int ParsePrimary(_tParser &p);
+
+	bool Eval(int node, const _tContext &ctx, _tValue &result, std::string &szError) const;
+
+	std::vector<_tNode> m_nodes;
+	int m_root = -1;
+	bool m_bUsesMeasurements = false;
+};
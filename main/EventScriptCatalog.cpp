@@ -0,0 +1,277 @@
+#include "stdafx.h"
+#include "EventScriptCatalog.h"
+#include "Helper.h"
+#include "Logger.h"
+#include "localtime_r.h"
+#include <sys/stat.h>
+
+#if defined(__linux__) || defined(__linux) || defined(linux)
+#define SCRIPTCATALOG_INOTIFY
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+extern "C"
+{
+#include <lua.h>
+#include <lauxlib.h>
+}
+
+namespace
+{
+	const char *ScriptMarkers[] = { "_device_", "_time_", "_security_", "_notification_", "_variable_" };
+
+	int LuaBytecodeWriter(lua_State * /*lua_state*/, const void *p, size_t sz, void *ud)
+	{
+		static_cast<std::string *>(ud)->append(static_cast<const char *>(p), sz);
+		return 0;
+	}
+
+	//script_device_<name>.lua, every "_device_" ... ".lua" part of the name is a possible device name
+	std::set<std::string> DeviceScriptTargets(const std::string &filename)
+	{
+		std::set<std::string> targets;
+		size_t dpos = filename.find("_device_");
+		while (dpos != std::string::npos)
+		{
+			size_t epos = filename.find(".lua", dpos + 8);
+			while (epos != std::string::npos)
+			{
+				targets.insert(filename.substr(dpos + 8, epos - dpos - 8));
+				epos = filename.find(".lua", epos + 1);
+			}
+			dpos = filename.find("_device_", dpos + 1);
+		}
+		return targets;
+	}
+} // namespace
+
+CEventScriptCatalog::CEventScriptCatalog()
+{
+#ifdef SCRIPTCATALOG_INOTIFY
+	m_inotifyfd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (m_inotifyfd < 0)
+		_log.Log(LOG_ERROR, "EventSystem: Could not watch the script folders (inotify), checking their modification time instead");
+#else
+	m_inotifyfd = -1;
+#endif
+	for (auto &dir : m_dirs)
+	{
+		dir.wd = -1;
+		dir.bDirty = false;
+		dir.mtime = 0;
+		dir.scantime = 0;
+		dir.nFiles = 0;
+	}
+	m_dirs[SDIR_LUA].extension = ".lua";
+	m_dirs[SDIR_PYTHON].extension = ".py";
+	m_dirs[SDIR_DZVENTS].extension = ".lua";
+}
+
+CEventScriptCatalog::~CEventScriptCatalog()
+{
+#ifdef SCRIPTCATALOG_INOTIFY
+	if (m_inotifyfd >= 0)
+		close(m_inotifyfd);
+#endif
+}
+
+void CEventScriptCatalog::SetDirectory(const _eScriptDir sdir, const std::string &path)
+{
+	std::lock_guard<std::mutex> l(m_mutex);
+	_tScriptDir &dir = m_dirs[sdir];
+	if (dir.path == path)
+		return;
+#ifdef SCRIPTCATALOG_INOTIFY
+	if (dir.wd >= 0)
+		inotify_rm_watch(m_inotifyfd, dir.wd);
+#endif
+	dir.wd = -1;
+	dir.path = path;
+	dir.bDirty = true;
+}
+
+void CEventScriptCatalog::Refresh()
+{
+	std::lock_guard<std::mutex> l(m_mutex);
+#ifdef SCRIPTCATALOG_INOTIFY
+	if (m_inotifyfd >= 0)
+	{
+		char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+		ssize_t len;
+		while ((len = read(m_inotifyfd, buffer, sizeof(buffer))) > 0)
+		{
+			const char *ptr = buffer;
+			while (ptr < buffer + len)
+			{
+				const struct inotify_event *event = reinterpret_cast<const struct inotify_event *>(ptr);
+				for (auto &dir : m_dirs)
+				{
+					if ((event->mask & IN_Q_OVERFLOW) || (dir.wd == event->wd))
+						dir.bDirty = true;
+					//folder removed, it is watched again when it is scanned
+					if ((dir.wd == event->wd) && (event->mask & IN_IGNORED))
+						dir.wd = -1;
+				}
+				ptr += sizeof(struct inotify_event) + event->len;
+			}
+		}
+	}
+#endif
+	for (auto &dir : m_dirs)
+	{
+		if (dir.path.empty())
+			continue;
+		if ((!dir.bDirty) && (dir.wd < 0))
+		{
+			//not watched, a change in the same second as the last scan could be missed, so check again until that second has passed
+			struct stat st;
+			time_t mtime = (stat(dir.path.c_str(), &st) == 0) ? st.st_mtime : 0;
+			dir.bDirty = ((mtime != dir.mtime) || ((mtime != 0) && (mtime >= dir.scantime)));
+		}
+		if (dir.bDirty)
+			ScanDirectory(dir);
+	}
+}
+
+void CEventScriptCatalog::ScanDirectory(_tScriptDir &dir)
+{
+	//start watching before listing, a file added in between is then picked up by the next Refresh
+#ifdef SCRIPTCATALOG_INOTIFY
+	if ((m_inotifyfd >= 0) && (dir.wd < 0))
+		dir.wd = inotify_add_watch(m_inotifyfd, dir.path.c_str(), IN_CREATE | IN_DELETE | IN_CLOSE_WRITE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF);
+#endif
+	struct stat st;
+	dir.mtime = (stat(dir.path.c_str(), &st) == 0) ? st.st_mtime : 0;
+	dir.scantime = mytime(nullptr);
+	dir.bDirty = false;
+
+	std::vector<std::string> FileEntries;
+	DirectoryListing(FileEntries, dir.path, false, true);
+
+	const std::string demo = "_demo" + dir.extension;
+	dir.scripts.clear();
+	dir.nFiles = 0;
+	for (const auto &filename : FileEntries)
+	{
+		if ((filename.length() <= dir.extension.length()) || (filename.compare(filename.length() - dir.extension.length(), dir.extension.length(), dir.extension) != 0))
+			continue;
+		dir.nFiles++;
+		if (filename.find(demo) != std::string::npos)
+			continue;
+		for (const auto &marker : ScriptMarkers)
+		{
+			if (filename.find(marker) != std::string::npos)
+				dir.scripts[marker].push_back(filename);
+		}
+	}
+
+	if (&dir == &m_dirs[SDIR_LUA])
+	{
+		m_devicetargets.clear();
+		for (const auto &filename : dir.scripts["_device_"])
+			m_devicetargets.push_back(DeviceScriptTargets(filename));
+		IndexDeviceScripts();
+	}
+}
+
+void CEventScriptCatalog::SetDeviceNames(const std::set<std::string> &names)
+{
+	std::lock_guard<std::mutex> l(m_mutex);
+	m_devicenames = names;
+	IndexDeviceScripts();
+}
+
+void CEventScriptCatalog::IndexDeviceScripts()
+{
+	m_genericdevicescripts.clear();
+	m_devicescripts.clear();
+	for (size_t ii = 0; ii < m_devicetargets.size(); ii++)
+	{
+		bool bFound = false;
+		for (const auto &target : m_devicetargets[ii])
+		{
+			if (m_devicenames.find(target) != m_devicenames.end())
+			{
+				m_devicescripts[target].push_back(ii);
+				bFound = true;
+			}
+		}
+		if (!bFound)
+			m_genericdevicescripts.push_back(ii);
+	}
+}
+
+void CEventScriptCatalog::GetScripts(const _eScriptDir sdir, const std::string &marker, std::vector<std::string> &scripts)
+{
+	std::lock_guard<std::mutex> l(m_mutex);
+	scripts.clear();
+	const auto itt = m_dirs[sdir].scripts.find(marker);
+	if (itt != m_dirs[sdir].scripts.end())
+		scripts = itt->second;
+}
+
+void CEventScriptCatalog::GetDeviceScripts(const std::string &deviceName, std::vector<std::string> &scripts)
+{
+	std::lock_guard<std::mutex> l(m_mutex);
+	scripts.clear();
+	const auto ditt = m_dirs[SDIR_LUA].scripts.find("_device_");
+	if (ditt == m_dirs[SDIR_LUA].scripts.end())
+		return;
+	const std::vector<std::string> &files = ditt->second;
+
+	//merge both lists to keep the folder order
+	static const std::vector<size_t> none;
+	const auto itt = m_devicescripts.find(deviceName);
+	const std::vector<size_t> &named = (itt != m_devicescripts.end()) ? itt->second : none;
+	auto gitt = m_genericdevicescripts.begin();
+	auto nitt = named.begin();
+	while ((gitt != m_genericdevicescripts.end()) || (nitt != named.end()))
+	{
+		if ((nitt == named.end()) || ((gitt != m_genericdevicescripts.end()) && (*gitt < *nitt)))
+			scripts.push_back(files[*gitt++]);
+		else
+			scripts.push_back(files[*nitt++]);
+	}
+}
+
+bool CEventScriptCatalog::HasScripts(const _eScriptDir sdir)
+{
+	std::lock_guard<std::mutex> l(m_mutex);
+	return (m_dirs[sdir].nFiles != 0);
+}
+
+int CEventScriptCatalog::LoadLuaFile(lua_State *lua_state, const std::string &filename)
+{
+	struct stat st;
+	if (stat(filename.c_str(), &st) != 0)
+	{
+		std::lock_guard<std::mutex> l(m_bytecodemutex);
+		m_bytecode.erase(filename);
+		return luaL_loadfile(lua_state, filename.c_str()); //reports the error
+	}
+
+	//same chunk name as luaL_loadfile, so errors still show the file
+	const std::string chunkname = "@" + filename;
+	{
+		std::lock_guard<std::mutex> l(m_bytecodemutex);
+		const auto itt = m_bytecode.find(filename);
+		if ((itt != m_bytecode.end()) && (itt->second.mtime == st.st_mtime) && (itt->second.size == static_cast<int64_t>(st.st_size)))
+			return luaL_loadbuffer(lua_state, itt->second.code.data(), itt->second.code.size(), chunkname.c_str());
+	}
+
+	int status = luaL_loadfile(lua_state, filename.c_str());
+	//a file modified in the current second could still change without a new modification time
+	if ((status != 0) || (st.st_mtime >= mytime(nullptr)))
+		return status;
+
+	_tBytecode bytecode;
+	bytecode.mtime = st.st_mtime;
+	bytecode.size = static_cast<int64_t>(st.st_size);
+	if (lua_dump(lua_state, LuaBytecodeWriter, &bytecode.code, 0) == 0)
+	{
+		std::lock_guard<std::mutex> l(m_bytecodemutex);
+		m_bytecode[filename] = std::move(bytecode);
+	}
+	return status;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <ctime>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+struct lua_State;
+
+//Keeps the listing of the Lua, Python and dzVents script folders, so the event dispatcher does not have to
+//list the folders and match every file against every device for each event
+//
+//On Linux the folders are watched with inotify, elsewhere the modification time of the folder is checked.
+//Compiled Lua chunks are cached as bytecode and reused as long as the file is not modified.
+class CEventScriptCatalog
+{
+public:
+	enum _eScriptDir
+	{
+		SDIR_LUA = 0,
+		SDIR_PYTHON,
+		SDIR_DZVENTS,
+		SDIR_MAX
+	};
+
+	CEventScriptCatalog();
+	~CEventScriptCatalog();
+
+	//Folder (with trailing separator) to keep a listing of, nothing happens when it did not change
+	void SetDirectory(_eScriptDir sdir, const std::string &path);
+	//Rescan the folders that changed since the last call
+	void Refresh();
+	//Normalized (lowercase, spaces replaced by underscores) names of all devices, used to resolve script_device_<name>.lua
+	void SetDeviceNames(const std::set<std::string> &names);
+
+	//Scripts of a folder whose name contains the marker (_device_, _time_, ...), in folder order
+	void GetScripts(_eScriptDir sdir, const std::string &marker, std::vector<std::string> &scripts);
+	//Lua device scripts for a device, the ones named after this device and the ones not named after any device
+	void GetDeviceScripts(const std::string &deviceName, std::vector<std::string> &scripts);
+	bool HasScripts(_eScriptDir sdir);
+
+	//luaL_loadfile replacement that loads the cached bytecode of an unmodified file
+	int LoadLuaFile(lua_State *lua_state, const std::string &filename);
+
+private:
+	struct _tScriptDir
+	{
+		std::string path;
+		std::string extension;
+		int wd;
+		bool bDirty;
+		time_t mtime;
+		time_t scantime;
+		std::map<std::string, std::vector<std::string>> scripts; //marker -> files
+		size_t nFiles;
+	};
+	struct _tBytecode
+	{
+		time_t mtime;
+		int64_t size;
+		std::string code;
+	};
+
+	void ScanDirectory(_tScriptDir &dir);
+	void IndexDeviceScripts();
+
+	std::mutex m_mutex;
+	int m_inotifyfd;
+	_tScriptDir m_dirs[SDIR_MAX];
+
+	std::set<std::string> m_devicenames;
+	std::vector<std::set<std::string>> m_devicetargets; //per Lua device script, the device names its file name could refer to
+	std::vector<size_t> m_genericdevicescripts; //device scripts not named after an existing device
+	std::map<std::string, std::vector<size_t>> m_devicescripts; //device name -> device scripts named after it
+
+	std::mutex m_bytecodemutex;
+	std::map<std::string, _tBytecode> m_bytecode;
+};
@@ -235,6 +235,8 @@ void CEventSystem::LoadEvents()
 			eitem.Actions = sd[3];
 			eitem.EventStatus = atoi(sd[4].c_str());
 			eitem.SequenceNo = atoi(sd[5].c_str());
+			if (eitem.Interpreter == "Blockly")
+				PrepareBlocklyEvent(eitem);
 			m_events.push_back(eitem);
 		}
 	}
@@ -436,6 +438,7 @@ void CEventSystem::GetCurrentStates()
 
 	_log.Log(LOG_STATUS, "EventSystem: reset all device statuses...");
 	m_devicestates.clear();
+	m_iDeviceNamesVersion++;
 
 	result = m_sql.safe_query(
 		"SELECT A.HardwareID, A.ID, A.Name, A.nValue, A.sValue, A.Type, A.SubType, A.SwitchType, A.LastUpdate, A.LastLevel, A.Options, A.Description, A.BatteryLevel, A.SignalLevel, A.Unit, A.DeviceID, A.Protected, A.AddjValue, A.AddjMulti, A.AddjValue2, A.AddjMulti2 "
@@ -487,6 +490,7 @@ void CEventSystem::GetCurrentStates()
 
 			sitem.nValue = atoi(sd[3].c_str());
 			sitem.sValue = l_sValue.assign(sd[4]);
+			sitem.sValueFields.Parse(sitem.sValue);
 
 			sitem.switchtype = atoi(sd[7].c_str());
 			_eSwitchType switchtype = (_eSwitchType)sitem.switchtype;
@@ -618,12 +622,12 @@ void CEventSystem::GetCurrentMeasurementStates()
 
 	for (const auto &state : m_devicestates)
 	{
-		_tDeviceStatus sitem = state.second;
-		std::vector<std::string> splitresults;
-		StringSplit(sitem.sValue, ";", splitresults);
+		const _tDeviceStatus &sitem = state.second;
+		const double *svalues = sitem.sValueFields.value;
+		size_t nsvalues = sitem.sValueFields.count;
 
-		if ((state.second.devType == pTypeGeneral) && (state.second.subType == sTypeCounterIncremental))
-			splitresults.clear();
+		if ((sitem.devType == pTypeGeneral) && (sitem.subType == sTypeCounterIncremental))
+			nsvalues = 0;
 
 		float temp = 0;
 		int humidity = 0;
@@ -656,34 +660,34 @@ void CEventSystem::GetCurrentMeasurementStates()
 		{
 		case pTypeRego6XXTemp:
 		case pTypeTEMP:
-			if (!splitresults.empty())
+			if (nsvalues != 0)
 			{
-				temp = static_cast<float>(atof(splitresults[0].c_str()));
+				temp = static_cast<float>(svalues[0]);
 				isTemp = true;
 			}
 			break;
 		case pTypeThermostat:
 			if (sitem.subType == sTypeThermTemperature)
 			{
-				if (!splitresults.empty())
+				if (nsvalues != 0)
 				{
-					temp = static_cast<float>(atof(splitresults[0].c_str()));
+					temp = static_cast<float>(svalues[0]);
 					isTemp = true;
 				}
 			}
 			else
 			{
-				if (!splitresults.empty())
+				if (nsvalues != 0)
 				{
-					utilityval = static_cast<float>(atof(splitresults[0].c_str()));
+					utilityval = static_cast<float>(svalues[0]);
 					isUtility = true;
 				}
 			}
 			break;
 		case pTypeThermostat1:
-			if (!splitresults.empty())
+			if (nsvalues != 0)
 			{
-				temp = static_cast<float>(atof(splitresults[0].c_str()));
+				temp = static_cast<float>(svalues[0]);
 				isTemp = true;
 			}
 			break;
@@ -692,10 +696,10 @@ void CEventSystem::GetCurrentMeasurementStates()
 			isHum = true;
 			break;
 		case pTypeTEMP_HUM:
-			if (splitresults.size() > 1)
+			if (nsvalues > 1)
 			{
-				temp = static_cast<float>(atof(splitresults[0].c_str()));
-				humidity = atoi(splitresults[1].c_str());
+				temp = static_cast<float>(svalues[0]);
+				humidity = static_cast<int>(svalues[1]);
 				dewpoint = (float)CalculateDewPoint(temp, humidity);
 				isTemp = true;
 				isHum = true;
@@ -703,13 +707,13 @@ void CEventSystem::GetCurrentMeasurementStates()
 			}
 			break;
 		case pTypeTEMP_HUM_BARO:
-			if (splitresults.size() < 5) {
+			if (nsvalues < 5) {
 				_log.Log(LOG_ERROR, "EventSystem: TEMP_HUM_BARO missing values : ID=%" PRIu64 ", sValue=%s", sitem.ID, sitem.sValue.c_str());
 				continue;
 			}
-			temp = static_cast<float>(atof(splitresults[0].c_str()));
-			humidity = atoi(splitresults[1].c_str());
-			barometer = static_cast<float>(atof(splitresults[3].c_str()));
+			temp = static_cast<float>(svalues[0]);
+			humidity = static_cast<int>(svalues[1]);
+			barometer = static_cast<float>(svalues[3]);
 			dewpoint = (float)CalculateDewPoint(temp, humidity);
 			isTemp = true;
 			isHum = true;
@@ -717,54 +721,54 @@ void CEventSystem::GetCurrentMeasurementStates()
 			isDew = true;
 			break;
 		case pTypeTEMP_BARO:
-			if (splitresults.size() > 1)
+			if (nsvalues > 1)
 			{
-				temp = static_cast<float>(atof(splitresults[0].c_str()));
-				barometer = static_cast<float>(atof(splitresults[1].c_str()));
+				temp = static_cast<float>(svalues[0]);
+				barometer = static_cast<float>(svalues[1]);
 				isTemp = true;
 				isBaro = true;
 			}
 			break;
 		case pTypeBARO:
-			barometer = static_cast<float>(atof(splitresults[0].c_str()));
+			barometer = static_cast<float>(svalues[0]);
 			isBaro = true;
 			break;
 		case pTypeRadiator1:
 			if (sitem.subType == sTypeSmartwares)
 			{
-				utilityval = static_cast<float>(atof(sitem.sValue.c_str()));
+				utilityval = static_cast<float>(svalues[0]);
 				isUtility = true;
 			}
 			break;
 		case pTypeUV:
-			if (splitresults.size() == 2)
+			if (nsvalues == 2)
 			{
-				uv = static_cast<float>(atof(splitresults[0].c_str()));
+				uv = static_cast<float>(svalues[0]);
 				isUV = true;
 				weatherval = uv;
 				isWeather = true;
 
 				if (sitem.subType == sTypeUV3)
 				{
-					temp = static_cast<float>(atof(splitresults[1].c_str()));
+					temp = static_cast<float>(svalues[1]);
 					isTemp = true;
 				}
 			}
 			break;
 		case pTypeWIND:
-			if (splitresults.size() == 6)
+			if (nsvalues == 6)
 			{
-				winddir = static_cast<float>(atof(splitresults[0].c_str()));
+				winddir = static_cast<float>(svalues[0]);
 				isWindDir = true;
 
 				if (sitem.subType != sTypeWIND5)
 				{
-					int intSpeed = atoi(splitresults[2].c_str());
+					int intSpeed = static_cast<int>(svalues[2]);
 					windspeed = float(intSpeed) * 0.1F; // m/s
 					isWindSpeed = true;
 				}
 
-				int intGust = atoi(splitresults[3].c_str());
+				int intGust = static_cast<int>(svalues[3]);
 				windgust = float(intGust) * 0.1F; // m/s
 				isWindGust = true;
 				if ((windgust == 0) && (windspeed != 0))
@@ -779,8 +783,8 @@ void CEventSystem::GetCurrentMeasurementStates()
 				}
 				if ((sitem.subType == sTypeWIND4) || (sitem.subType == sTypeWINDNoTemp))
 				{
-					temp = static_cast<float>(atof(splitresults[4].c_str()));
-					//chill = static_cast<float>(atof(splitresults[5].c_str()));
+					temp = static_cast<float>(svalues[4]);
+					//chill = static_cast<float>(svalues[5]);
 					isTemp = true;
 				}
 			}
@@ -788,15 +792,15 @@ void CEventSystem::GetCurrentMeasurementStates()
 		case pTypeRFXSensor:
 			if (sitem.subType == sTypeRFXSensorTemp)
 			{
-				if (!splitresults.empty())
+				if (nsvalues != 0)
 				{
-					temp = static_cast<float>(atof(splitresults[0].c_str()));
+					temp = static_cast<float>(svalues[0]);
 					isTemp = true;
 				}
 			}
 			else if ((sitem.subType == sTypeRFXSensorVolt) || (sitem.subType == sTypeRFXSensorAD))
 			{
-				utilityval = static_cast<float>(atof(sitem.sValue.c_str()));
+				utilityval = static_cast<float>(svalues[0]);
 				isUtility = true;
 			}
 			break;
@@ -805,57 +809,57 @@ void CEventSystem::GetCurrentMeasurementStates()
 			isUtility = true;
 			break;
 		case pTypeENERGY:
-			if (!splitresults.empty())
+			if (nsvalues != 0)
 			{
-				if (splitresults.size() == 2)
-					utilityval = static_cast<float>(atof(splitresults[1].c_str()));
+				if (nsvalues == 2)
+					utilityval = static_cast<float>(svalues[1]);
 				else
-					utilityval = static_cast<float>(atof(splitresults[0].c_str()));
+					utilityval = static_cast<float>(svalues[0]);
 				isUtility = true;
 			}
 			break;
 		case pTypePOWER:
-			if (!splitresults.empty())
+			if (nsvalues != 0)
 			{
-				utilityval = static_cast<float>(atof(splitresults[0].c_str()));
+				utilityval = static_cast<float>(svalues[0]);
 				isUtility = true;
 			}
 			break;
 		case pTypeUsage:
-			if (!splitresults.empty())
+			if (nsvalues != 0)
 			{
-				utilityval = static_cast<float>(atof(splitresults[0].c_str()));
+				utilityval = static_cast<float>(svalues[0]);
 				isUtility = true;
 			}
 			break;
 		case pTypeP1Power:
-			if (splitresults.size() == 6)
+			if (nsvalues == 6)
 			{
-				utilityval = static_cast<float>(atof(splitresults[4].c_str()));
+				utilityval = static_cast<float>(svalues[4]);
 				isUtility = true;
 			}
 			break;
 		case pTypeLux:
-			if (!splitresults.empty())
+			if (nsvalues != 0)
 			{
-				utilityval = static_cast<float>(atof(splitresults[0].c_str()));
+				utilityval = static_cast<float>(svalues[0]);
 				isUtility = true;
 			}
 			break;
 		case pTypeGeneral:
 		{
-			if (!splitresults.empty())
+			if (nsvalues != 0)
 			{
 				if ((sitem.subType == sTypeVisibility) || (sitem.subType == sTypeSolarRadiation))
 				{
-					utilityval = static_cast<float>(atof(splitresults[0].c_str()));
+					utilityval = static_cast<float>(svalues[0]);
 					isUtility = true;
 					weatherval = utilityval;
 					isWeather = true;
 				}
 				else if (sitem.subType == sTypeBaro)
 				{
-					barometer = static_cast<float>(atof(splitresults[0].c_str()));
+					barometer = static_cast<float>(svalues[0]);
 					isBaro = true;
 				}
 				else if ((sitem.subType == sTypeAlert)
@@ -870,7 +874,7 @@ void CEventSystem::GetCurrentMeasurementStates()
 					|| (sitem.subType == sTypeSoundLevel)
 					)
 				{
-					utilityval = static_cast<float>(atof(splitresults[0].c_str()));
+					utilityval = static_cast<float>(svalues[0]);
 					isUtility = true;
 				}
 			}
@@ -912,8 +916,8 @@ void CEventSystem::GetCurrentMeasurementStates()
 
 					float divider = m_sql.GetCounterDivider(int(metertype), int(sitem.devType), float(sitem.AddjValue2));
 
-					if (splitresults.size() > 1) {
-						float usage = std::stof(splitresults[1]);
+					if (nsvalues > 1) {
+						float usage = static_cast<float>(svalues[1]);
 						if (usage < 0.0) {
 							usage = 0.0;
 						}
@@ -926,10 +930,10 @@ void CEventSystem::GetCurrentMeasurementStates()
 		}
 		break;
 		case pTypeRAIN:
-			if (splitresults.size() == 2)
+			if (nsvalues == 2)
 			{
 				rainmm = 0;
-				rainmmlasthour = static_cast<float>(atof(splitresults[0].c_str())) / 100.0F;
+				rainmmlasthour = static_cast<float>(svalues[0]) / 100.0F;
 				isRain = true;
 				weatherval = rainmmlasthour;
 				isWeather = true;
@@ -942,7 +946,7 @@ void CEventSystem::GetCurrentMeasurementStates()
 				if (sitem.subType == sTypeRAINWU || sitem.subType == sTypeRAINByRate)
 				{
 					result2 = m_sql.safe_query(
-						"SELECT Total, Total FROM Rain WHERE (DeviceRowID=%" PRIu64 " AND Date>='%q') ORDER BY ROWID DESC LIMIT 1",
+						"SELECT Total, Total FROM Rain WHERE (DeviceRowID=%" PRIu64 " AND Date>='%q') ORDER BY Date DESC LIMIT 1",
 						sitem.ID, szDate.c_str());
 				}
 				else
@@ -962,7 +966,7 @@ void CEventSystem::GetCurrentMeasurementStates()
 					else
 					{
 						float total_min = static_cast<float>(atof(sd2[0].c_str()));
-						float total_max = static_cast<float>(atof(splitresults[1].c_str()));
+						float total_max = static_cast<float>(svalues[1]);
 						total_real = total_max - total_min;
 					}
 					rainmm = float(total_real);
@@ -1088,6 +1092,7 @@ void CEventSystem::RemoveSingleState(const uint64_t ulDevID, const _eReason reas
 	{
 		boost::unique_lock<boost::shared_mutex> devicestatesMutexLock(m_devicestatesMutex);
 		m_devicestates.erase(ulDevID);
+		m_iDeviceNamesVersion++;
 	}
 	else if (reason == REASON_SCENEGROUP)
 	{
@@ -1269,6 +1274,21 @@ bool CEventSystem::UpdateSceneGroup(const uint64_t ulDevID, const int nValue, co
 	return bEventTrigger;
 }
 
+//The status of a Scene/Group changed because of its members, no event is triggered for this
+void CEventSystem::UpdateSceneGroupStatus(const uint64_t ulDevID, const int nValue)
+{
+	boost::unique_lock<boost::shared_mutex> scenesgroupsMutexLock(m_scenesgroupsMutex);
+	std::map<uint64_t, _tScenesGroups>::iterator itt = m_scenesgroups.find(ulDevID);
+	if (itt == m_scenesgroups.end())
+		return;
+	if (nValue == 0)
+		itt->second.scenesgroupValue = "Off";
+	else if (nValue == 1)
+		itt->second.scenesgroupValue = "On";
+	else
+		itt->second.scenesgroupValue = "Mixed";
+}
+
 void CEventSystem::UpdateUserVariable(const uint64_t ulDevID, const std::string &varValue, const std::string &lastUpdate)
 {
 	if (!m_bEnabled)
@@ -1342,12 +1362,17 @@ std::string CEventSystem::UpdateSingleState(
 	{
 		//_log.Log(LOG_STATUS,"EventSystem: update device %" PRIu64 "",ulDevID);
 		_tDeviceStatus replaceitem = itt->second;
+		if (replaceitem.deviceName != l_deviceName)
+			m_iDeviceNamesVersion++;
 		replaceitem.deviceName = l_deviceName;
 		//replaceitem.batteryLevel = batteryLevel;
 		if (nValue != -1)
 			replaceitem.nValue = nValue;
 		if (!sValue.empty())
+		{
 			replaceitem.sValue = l_sValue;
+			replaceitem.sValueFields.Parse(l_sValue);
+		}
 		if (!l_nValueWording.empty() || l_nValueWording != "-1")
 			replaceitem.nValueWording = l_nValueWording;
 		if (!lastUpdate.empty())
@@ -1372,6 +1397,7 @@ std::string CEventSystem::UpdateSingleState(
 		newitem.deviceName = l_deviceName;
 		newitem.nValue = nValue;
 		newitem.sValue = l_sValue;
+		newitem.sValueFields.Parse(l_sValue);
 		newitem.nValueWording = l_nValueWording;
 		newitem.lastUpdate = l_lastUpdate;
 		newitem.lastLevel = lastLevel;
@@ -1382,6 +1408,7 @@ std::string CEventSystem::UpdateSingleState(
 			UpdateJsonMap(newitem, ulDevID);
 		}
 		m_devicestates[newitem.ID] = newitem;
+		m_iDeviceNamesVersion++;
 	}
 	return nValueWording;
 }
@@ -1534,99 +1561,77 @@ void CEventSystem::EvaluateEvent(const std::vector<_tEventQueue> &items)
 	if (!m_bEnabled)
 		return;
 
-	std::vector<std::string> FileEntries;
-	std::string filename;
+	CdzVents* dzvents = CdzVents::GetInstance();
+	m_scriptcatalog.SetDirectory(CEventScriptCatalog::SDIR_LUA, m_lua_Dir);
 #ifdef ENABLE_PYTHON
-	std::vector<std::string> FileEntriesPython;
-	DirectoryListing(FileEntriesPython, m_python_Dir, false, true);
+	m_scriptcatalog.SetDirectory(CEventScriptCatalog::SDIR_PYTHON, m_python_Dir);
 #endif
+	m_scriptcatalog.SetDirectory(CEventScriptCatalog::SDIR_DZVENTS, dzvents->m_scriptsDir);
+	m_scriptcatalog.Refresh();
+
+	boost::shared_lock<boost::shared_mutex> devicestatesMutexLock(m_devicestatesMutex);
+	if (m_iScriptDeviceNamesVersion != m_iDeviceNamesVersion)
+	{
+		m_iScriptDeviceNamesVersion = m_iDeviceNamesVersion;
+		std::set<std::string> deviceNames;
+		for (const auto &state : m_devicestates)
+			deviceNames.insert(SpaceToUnderscore(LowerCase(state.second.deviceName)));
+		devicestatesMutexLock.unlock();
+		m_scriptcatalog.SetDeviceNames(deviceNames);
+	}
+	else
+		devicestatesMutexLock.unlock();
 
 	if (!m_sql.m_bDisableDzVentsSystem)
 	{
-		CdzVents* dzvents = CdzVents::GetInstance();
-		if (dzvents->m_bdzVentsExist)
+		if ((dzvents->m_bdzVentsExist) || (m_scriptcatalog.HasScripts(CEventScriptCatalog::SDIR_DZVENTS)))
 			EvaluateLua(items, dzvents->m_runtimeDir + "dzVents.lua", "");
-		else
-		{
-			DirectoryListing(FileEntries, dzvents->m_scriptsDir, false, true);
-			for (const auto &filename : FileEntries)
-			{
-				if (filename.length() > 4 &&
-					filename.compare(filename.length() - 4, 4, ".lua") == 0)
-				{
-					EvaluateLua(items, dzvents->m_runtimeDir + "dzVents.lua", "");
-					break;
-				}
-			}
-			FileEntries.clear();
-		}
 	}
 
-	bool bDeviceFileFound = false;
-	DirectoryListing(FileEntries, m_lua_Dir, false, true);
+	std::vector<std::string> FileEntries;
 	for (const auto &item : items)
 	{
-		for (const auto &filename : FileEntries)
+		std::string marker;
+		switch (item.reason)
 		{
-			if (filename.length() > 4 &&
-				filename.compare(filename.length() - 4, 4, ".lua") == 0 &&
-				filename.find("_demo.lua") == std::string::npos)
-			{
-				if (item.reason == REASON_DEVICE && filename.find("_device_") != std::string::npos)
-				{
-					bDeviceFileFound = false;
-					boost::shared_lock<boost::shared_mutex> devicestatesMutexLock(m_devicestatesMutex);
-					for (const auto &state : m_devicestates)
-					{
-						std::string deviceName = SpaceToUnderscore(LowerCase(state.second.deviceName));
-						if (filename.find("_device_" + deviceName + ".lua") != std::string::npos)
-						{
-							bDeviceFileFound = true;
-							if (deviceName == SpaceToUnderscore(LowerCase(item.devname)))
-							{
-								devicestatesMutexLock.unlock();
-								EvaluateLua(item, m_lua_Dir + filename, "");
-								break;
-							}
-						}
-					}
-					if (!bDeviceFileFound)
-					{
-						devicestatesMutexLock.unlock();
-						EvaluateLua(item, m_lua_Dir + filename, "");
-					}
-				}
-				else if ((item.reason == REASON_TIME && filename.find("_time_") != std::string::npos)
-					 || (item.reason == REASON_SECURITY && filename.find("_security_") != std::string::npos)
-					 || (item.reason == REASON_NOTIFICATION && filename.find("_notification_") != std::string::npos)
-					 || (item.reason == REASON_USERVARIABLE && filename.find("_variable_") != std::string::npos))
-				{
-					EvaluateLua(item, m_lua_Dir + filename, "");
-				}
-			}
-			// else _log.Log(LOG_STATUS,"EventSystem: ignore file not .lua or is demo file: %s", filename.c_str());
+		case REASON_DEVICE:
+			marker = "_device_";
+			break;
+		case REASON_TIME:
+			marker = "_time_";
+			break;
+		case REASON_SECURITY:
+			marker = "_security_";
+			break;
+		case REASON_NOTIFICATION:
+			marker = "_notification_";
+			break;
+		case REASON_USERVARIABLE:
+			marker = "_variable_";
+			break;
+		default:
+			break;
 		}
 
+		// device scripts named after a device only run for that device
+		if (item.reason == REASON_DEVICE)
+			m_scriptcatalog.GetDeviceScripts(SpaceToUnderscore(LowerCase(item.devname)), FileEntries);
+		else if (!marker.empty())
+			m_scriptcatalog.GetScripts(CEventScriptCatalog::SDIR_LUA, marker, FileEntries);
+		else
+			FileEntries.clear();
+		for (const auto &filename : FileEntries)
+			EvaluateLua(item, m_lua_Dir + filename, "");
+
 #ifdef ENABLE_PYTHON
 		boost::unique_lock<boost::shared_mutex> uservariablesMutexLock(m_uservariablesMutex);
 		try
 		{
-			for (const auto &filename : FileEntriesPython)
-			{
-				if (filename.length() > 3 &&
-					filename.compare(filename.length() - 3, 3, ".py") == 0 &&
-					filename.find("_demo.py") == std::string::npos)
-				{
-					if ((item.reason == REASON_DEVICE && filename.find("_device_") != std::string::npos)
-					    || (item.reason == REASON_TIME && filename.find("_time_") != std::string::npos)
-					    || (item.reason == REASON_SECURITY && filename.find("_security_") != std::string::npos)
-					    || (item.reason == REASON_USERVARIABLE && filename.find("_variable_") != std::string::npos))
-					{
-						EvaluatePython(item, m_python_Dir + filename, "");
-					}
-				}
-				// else _log.Log(LOG_STATUS,"EventSystem: ignore file not .py or is demo file: %s", filename.c_str());
-			}
+			FileEntries.clear();
+			if ((!marker.empty()) && (item.reason != REASON_NOTIFICATION))
+				m_scriptcatalog.GetScripts(CEventScriptCatalog::SDIR_PYTHON, marker, FileEntries);
+			for (const auto &filename : FileEntries)
+				EvaluatePython(item, m_python_Dir + filename, "");
 		}
 		catch (...)
 		{
@@ -1840,6 +1845,122 @@ lua_State *CEventSystem::CreateBlocklyLuaState()
 	return lua_state;
 }
 
+void CEventSystem::PrepareBlocklyEvent(_tEventItem &item)
+{
+	CBlocklyCondition::GetTriggers(item.Conditions, item.BlocklyTriggers);
+	ParseBlocklyActionList(item.Actions, item.BlocklyActions);
+	item.BlocklyCondition = std::make_shared<CBlocklyCondition>();
+	if (!item.BlocklyCondition->Compile(item.Conditions))
+	{
+		_log.Debug(DEBUG_EVENTSYSTEM, "EventSystem: Blockly conditions of %s are evaluated by Lua", item.Name.c_str());
+		item.BlocklyCondition.reset();
+	}
+}
+
+void CEventSystem::InitBlocklyContext(CBlocklyCondition::_tContext &ctx)
+{
+	time_t now = mytime(nullptr);
+	struct tm ltime;
+	localtime_r(&now, &ltime);
+	ctx.timeofday = (ltime.tm_hour * 60) + ltime.tm_min;
+	ctx.weekday = ltime.tm_wday + 1;
+	ctx.securitystatus = m_SecStatus;
+	ctx.sunrise = getSunRiseSunSetMinutes("Sunrise");
+	ctx.sunset = getSunRiseSunSetMinutes("Sunset");
+	ctx.lookup = [this](const CBlocklyCondition::_eTable table, const uint64_t id, CBlocklyCondition::_tValue &value) { return GetBlocklyValue(table, id, value); };
+}
+
+namespace
+{
+	template <typename T> bool GetMeasurementValue(const std::map<uint64_t, T> &values, const uint64_t id, CBlocklyCondition::_tValue &value)
+	{
+		if (values.empty())
+			return false;
+		const auto itt = values.find(id);
+		if (itt != values.end())
+			value.SetNumber(itt->second, false);
+		return true;
+	}
+} // namespace
+
+// Same values as the tables CreateBlocklyLuaState publishes
+bool CEventSystem::GetBlocklyValue(const CBlocklyCondition::_eTable table, const uint64_t id, CBlocklyCondition::_tValue &value)
+{
+	if (table == CBlocklyCondition::BT_DEVICE)
+	{
+		boost::shared_lock<boost::shared_mutex> devicestatesMutexLock(m_devicestatesMutex);
+		const auto itt = m_devicestates.find(id);
+		if (itt != m_devicestates.end())
+			value.SetString(itt->second.nValueWording);
+		return true;
+	}
+	if (table == CBlocklyCondition::BT_VARIABLE)
+	{
+		boost::shared_lock<boost::shared_mutex> uservariablesMutexLock(m_uservariablesMutex);
+		const auto itt = m_uservariables.find(id);
+		if (itt != m_uservariables.end())
+		{
+			if (itt->second.variableType == 0)
+				value.SetNumber(atoi(itt->second.variableValue.c_str()), true);
+			else if (itt->second.variableType == 1)
+				value.SetNumber(atof(itt->second.variableValue.c_str()), false);
+			else
+				value.SetString(itt->second.variableValue);
+		}
+		return true;
+	}
+
+	std::lock_guard<std::mutex> measurementStatesMutexLock(m_measurementStatesMutex);
+	switch (table)
+	{
+	case CBlocklyCondition::BT_TEMPERATURE:
+		return GetMeasurementValue(m_tempValuesByID, id, value);
+	case CBlocklyCondition::BT_DEWPOINT:
+		return GetMeasurementValue(m_dewValuesByID, id, value);
+	case CBlocklyCondition::BT_HUMIDITY:
+		return GetMeasurementValue(m_humValuesByID, id, value);
+	case CBlocklyCondition::BT_BAROMETER:
+		return GetMeasurementValue(m_baroValuesByID, id, value);
+	case CBlocklyCondition::BT_UTILITY:
+		return GetMeasurementValue(m_utilityValuesByID, id, value);
+	case CBlocklyCondition::BT_WEATHER:
+		return GetMeasurementValue(m_weatherValuesByID, id, value);
+	case CBlocklyCondition::BT_RAIN:
+		return GetMeasurementValue(m_rainValuesByID, id, value);
+	case CBlocklyCondition::BT_RAINLASTHOUR:
+		return GetMeasurementValue(m_rainLastHourValuesByID, id, value);
+	case CBlocklyCondition::BT_UV:
+		return GetMeasurementValue(m_uvValuesByID, id, value);
+	case CBlocklyCondition::BT_WINDDIR:
+		return GetMeasurementValue(m_winddirValuesByID, id, value);
+	case CBlocklyCondition::BT_WINDSPEED:
+		return GetMeasurementValue(m_windspeedValuesByID, id, value);
+	case CBlocklyCondition::BT_WINDGUST:
+		return GetMeasurementValue(m_windgustValuesByID, id, value);
+	case CBlocklyCondition::BT_ZWAVEALARMS:
+		return GetMeasurementValue(m_zwaveAlarmValuesByID, id, value);
+	default:
+		return false;
+	}
+}
+
+void CEventSystem::EvaluateBlockly(const _tEventItem &item, const CBlocklyCondition::_tContext &ctx)
+{
+	bool ruleTrue = false;
+	std::string szError;
+	if (!item.BlocklyCondition->Evaluate(ctx, ruleTrue, szError))
+	{
+		_log.Log(LOG_ERROR, "EventSystem: Blockly rule error, Name: %s => %s", item.Name.c_str(), szError.c_str());
+		return;
+	}
+	if (ruleTrue)
+	{
+		if (m_sql.m_bLogEventScriptTrigger)
+			_log.Log(LOG_NORM, "EventSystem: Event triggered: %s", item.Name.c_str());
+		parseBlocklyActions(item);
+	}
+}
+
 lua_State *CEventSystem::ParseBlocklyLua(lua_State *lua_state, const _tEventItem &item)
 {
 	std::string conditions = item.Conditions;
@@ -1883,6 +2004,9 @@ lua_State *CEventSystem::ParseBlocklyLua(lua_State *lua_state, const _tEventItem
 void CEventSystem::EvaluateDatabaseEvents(const _tEventQueue &item)
 {
 	lua_State *lua_state = nullptr;
+	CBlocklyCondition::_tContext blocklyContext;
+	bool bBlocklyContext = false;
+	bool bMeasurementStates = false;
 
 	boost::shared_lock<boost::shared_mutex> eventsMutexLock(m_eventsMutex);
 	try
@@ -1896,35 +2020,35 @@ void CEventSystem::EvaluateDatabaseEvents(const _tEventQueue &item)
 			{
 				if (event.Interpreter == "Blockly")
 				{
-					std::size_t found = std::string::npos;
+					const CBlocklyCondition::_tTriggers &triggers = event.BlocklyTriggers;
+					bool bTriggered = false;
 					if ((item.reason == REASON_DEVICE) && (item.id > 0))
-					{
-						std::stringstream sstr;
-						sstr << "[" << item.id << "]";
-						found = event.Conditions.find(sstr.str());
-					}
+						bTriggered = (triggers.ids.find(item.id) != triggers.ids.end());
 					else if (item.reason == REASON_SECURITY)
-					{
-						// security status change
-						std::stringstream sstr;
-						sstr << "securitystatus";
-						found = event.Conditions.find(sstr.str());
-					}
+						bTriggered = triggers.bSecurity; // security status change
 					else if (item.reason == REASON_TIME)
-					{
-						// time rules will only run when time or date based criteria are found
-						found = event.Conditions.find("timeofday");
-						if (found == std::string::npos)
-							found = event.Conditions.find("weekday");
-					}
+						bTriggered = triggers.bTime; // time rules will only run when time or date based criteria are found
 					else if ((item.reason == REASON_USERVARIABLE) && (item.id > 0))
+						bTriggered = (triggers.variables.find(item.id) != triggers.variables.end());
+
+					if (!bTriggered)
+						continue;
+					if (event.BlocklyCondition)
 					{
-						std::stringstream sstr;
-						sstr << "variable[" << item.id << "]";
-						found = event.Conditions.find(sstr.str());
+						if (!bBlocklyContext)
+						{
+							InitBlocklyContext(blocklyContext);
+							bBlocklyContext = true;
+						}
+						if ((event.BlocklyCondition->UsesMeasurements()) && (!bMeasurementStates))
+						{
+							std::lock_guard<std::mutex> measurementStatesMutexLock(m_measurementStatesMutex);
+							GetCurrentMeasurementStates();
+							bMeasurementStates = true;
+						}
+						EvaluateBlockly(event, blocklyContext);
 					}
-
-					if (found != std::string::npos)
+					else
 						lua_state = ParseBlocklyLua(lua_state, event);
 				}
 				else if (event.Interpreter == "Lua")
@@ -2136,16 +2260,12 @@ std::string CEventSystem::ParseBlocklyString(const std::string &oString)
 	return retString;
 }
 
-bool CEventSystem::parseBlocklyActions(const _tEventItem &item)
+// Splits the actions of a Blockly rule into separate commands, done once when the events are loaded
+void CEventSystem::ParseBlocklyActionList(const std::string &Actions, std::vector<_tBlocklyAction> &actions)
 {
-	if (isEventscheduled(item.Name))
-	{
-		//_log.Log(LOG_NORM,"Already scheduled this event, skipping");
-		return false;
-	}
-	bool actionsDone = false;
+	actions.clear();
 	std::string csubstr;
-	std::string tmpstr(item.Actions);
+	std::string tmpstr(Actions);
 	size_t sPos = 0, ePos;
 	do
 	{
@@ -2160,29 +2280,44 @@ bool CEventSystem::parseBlocklyActions(const _tEventItem &item)
 			csubstr = tmpstr;
 			tmpstr.clear();
 		}
+		_tBlocklyAction action;
+		action.csubstr = csubstr;
+		action.bMalformed = true;
+
 		sPos = csubstr.find_first_of('[');
 		ePos = csubstr.find_first_of(']');
-
-		if ((sPos == std::string::npos) || (ePos == std::string::npos))
+		size_t eQPos = csubstr.find_first_of('=');
+		if ((sPos != std::string::npos) && (ePos != std::string::npos) && (eQPos != std::string::npos))
 		{
-			_log.Log(LOG_ERROR, "EventSystem: Malformed action sequence!");
-			break;
+			action.doWhat = csubstr.substr(eQPos + 1);
+			StripQuotes(action.doWhat);
+			action.deviceName = csubstr.substr(sPos + 1, ePos - sPos - 1);
+			action.bMalformed = action.deviceName.empty();
 		}
-
-		size_t eQPos = csubstr.find_first_of('=');
-		if (eQPos == std::string::npos) {
-			_log.Log(LOG_ERROR, "EventSystem: Malformed action sequence!");
+		actions.push_back(action);
+		if (action.bMalformed)
 			break;
-		}
-		std::string doWhat = csubstr.substr(eQPos + 1);
-		StripQuotes(doWhat);
+	} while ((sPos = tmpstr.find("commandArray[")) == 0);
+}
 
-		std::string deviceName = csubstr.substr(sPos + 1, ePos - sPos - 1);
-		if (deviceName.empty())
+bool CEventSystem::parseBlocklyActions(const _tEventItem &item)
+{
+	if (isEventscheduled(item.Name))
+	{
+		//_log.Log(LOG_NORM,"Already scheduled this event, skipping");
+		return false;
+	}
+	bool actionsDone = false;
+	for (const auto &action : item.BlocklyActions)
+	{
+		if (action.bMalformed)
 		{
 			_log.Log(LOG_ERROR, "EventSystem: Malformed action sequence!");
 			break;
 		}
+		const std::string &csubstr = action.csubstr;
+		const std::string &deviceName = action.deviceName;
+		std::string doWhat = action.doWhat;
 
 		int deviceNo = atoi(deviceName.c_str());
 		if (deviceNo)
@@ -2441,7 +2576,7 @@ bool CEventSystem::parseBlocklyActions(const _tEventItem &item)
 			_log.Log(LOG_ERROR, "EventSystem: Unknown action sequence! (%s)", csubstr.c_str());
 			break;
 		}
-	} while ((sPos = tmpstr.find("commandArray[")) == 0);
+	}
 	return actionsDone;
 }
 
@@ -3118,7 +3253,7 @@ void CEventSystem::EvaluateLua(const std::vector<_tEventQueue> &items, const std
 
 	int status = 0;
 	if (LuaString.length() == 0)
-		status = luaL_loadfile(lua_state, filename.c_str());
+		status = m_scriptcatalog.LoadLuaFile(lua_state, filename);
 	else
 		status = luaL_loadstring(lua_state, LuaString.c_str());
 
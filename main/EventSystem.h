@@ -9,6 +9,10 @@
 #include "concurrent_queue.h"
 #include "StoppableTask.h"
 #include "NotificationObserver.h"
+#include "Helper.h"
+#include "SValueFields.h"
+#include "EventScriptCatalog.h"
+#include "BlocklyCondition.h"
 
 class CEventSystem : public CLuaCommon, StoppableTask, CNotificationObserver
 {
@@ -16,6 +20,14 @@ class CEventSystem : public CLuaCommon, StoppableTask, CNotificationObserver
 	friend class CLuaHandler;
 	typedef struct lua_State lua_State;
 
+	struct _tBlocklyAction
+	{
+		std::string csubstr; //complete action, for error messages
+		std::string deviceName;
+		std::string doWhat;
+		bool bMalformed;
+	};
+
 	struct _tEventItem
 	{
 		uint64_t ID;
@@ -27,6 +39,10 @@ class CEventSystem : public CLuaCommon, StoppableTask, CNotificationObserver
 		int SequenceNo;
 		int EventStatus;
 
+		//Blockly, prepared when the events are loaded
+		std::shared_ptr<CBlocklyCondition> BlocklyCondition; //nullptr when the conditions are evaluated by Lua
+		CBlocklyCondition::_tTriggers BlocklyTriggers;
+		std::vector<_tBlocklyAction> BlocklyActions;
 	};
 
 	struct _tActionParseResults
@@ -58,6 +74,7 @@ public:
 		std::string deviceName;
 		int nValue;
 		std::string sValue;
+		_tSValueFields sValueFields; //sValue parsed when it is stored, used by the measurement tables
 		uint8_t devType;
 		uint8_t subType;
 		std::string nValueWording;
@@ -131,6 +148,7 @@ public:
 	void GetCurrentScenesGroups();
 	void GetCurrentUserVariables();
 	bool UpdateSceneGroup(uint64_t ulDevID, int nValue, const std::string &lastUpdate);
+	void UpdateSceneGroupStatus(uint64_t ulDevID, int nValue);
 	void UpdateUserVariable(uint64_t ulDevID, const std::string &varValue, const std::string &lastUpdate);
 	bool PythonScheduleEvent(const std::string &ID, const std::string &Action, const std::string &eventName);
 	bool GetEventTrigger(uint64_t ulDevID, _eReason reason, bool bEventTrigger);
@@ -199,6 +217,9 @@ private:
 	StoppableTask m_TaskQueue;
 	int m_SecStatus;
 	std::string m_lua_Dir;
+	CEventScriptCatalog m_scriptcatalog;
+	uint64_t m_iDeviceNamesVersion = 0; //changed when a device is added, renamed or removed
+	uint64_t m_iScriptDeviceNamesVersion = 0; //version the script catalog knows
 	std::string m_szStartTime;
 
 	static const std::string m_szReason[], m_szSecStatus[];
@@ -214,6 +235,11 @@ private:
 	void EvaluateDatabaseEvents(const _tEventQueue &item);
 	lua_State *ParseBlocklyLua(lua_State *lua_state, const _tEventItem &item);
 	bool parseBlocklyActions(const _tEventItem &item);
+	void ParseBlocklyActionList(const std::string &Actions, std::vector<_tBlocklyAction> &actions);
+	void PrepareBlocklyEvent(_tEventItem &item);
+	void InitBlocklyContext(CBlocklyCondition::_tContext &ctx);
+	bool GetBlocklyValue(CBlocklyCondition::_eTable table, uint64_t id, CBlocklyCondition::_tValue &value);
+	void EvaluateBlockly(const _tEventItem &item, const CBlocklyCondition::_tContext &ctx);
 	std::string ProcessVariableArgument(const std::string &Argument);
 #ifdef ENABLE_PYTHON
 	std::string m_python_Dir;
@@ -83,19 +83,46 @@ unsigned int Crc32(unsigned int crc, const unsigned char* buf, size_t size)
 	return crc ^ ~0U;
 }
 
+//str is taken by value, so it can be an element of results
 void StringSplit(std::string str, const std::string &delim, std::vector<std::string> &results)
 {
 	results.clear();
+	if (delim.empty())
+	{
+		if (!str.empty())
+			results.push_back(str);
+		return;
+	}
+	size_t start = 0;
 	size_t cutAt;
-	while( (cutAt = str.find(delim)) != std::string::npos )
+	while ((cutAt = str.find(delim, start)) != std::string::npos)
+	{
+		results.emplace_back(str, start, cutAt - start);
+		start = cutAt + delim.size();
+	}
+	if (start < str.size())
 	{
-		results.push_back(str.substr(0,cutAt));
-		str = str.substr(cutAt+ delim.size());
+		results.emplace_back(str, start, std::string::npos);
 	}
-	if (!str.empty())
+}
+
+//Split a string of numbers (like a sValue "21.5;65;1") and convert the fields like atof does, without allocating
+//Returns the number of fields, counted the same way as StringSplit. Only the first maxresults values are stored
+size_t StringSplitDouble(const char *str, const char delim, double *results, const size_t maxresults)
+{
+	size_t nfields = 0;
+	const char *pField = str;
+	while (*pField != 0)
 	{
-		results.push_back(str);
+		if (nfields < maxresults)
+			results[nfields] = strtod(pField, nullptr);
+		nfields++;
+		const char *pDelim = strchr(pField, delim);
+		if (pDelim == nullptr)
+			break;
+		pField = pDelim + 1;
 	}
+	return nfields;
 }
 
 uint64_t hexstrtoui64(const std::string &str)
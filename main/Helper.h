@@ -13,6 +13,7 @@ enum _eTimeFormat
 
 unsigned int Crc32(unsigned int crc, const unsigned char* buf, size_t size);
 void StringSplit(std::string str, const std::string &delim, std::vector<std::string> &results);
+size_t StringSplitDouble(const char *str, char delim, double *results, size_t maxresults);
 uint64_t hexstrtoui64(const std::string &str);
 std::string ToHexString(const uint8_t *pSource, size_t length);
 std::vector<char> HexToBytes(const std::string& hex);
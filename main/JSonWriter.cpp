@@ -0,0 +1,166 @@
+#include "stdafx.h"
+#include "JSonWriter.h"
+#include "json_helper.h"
+#include <zlib.h>
+
+#define JSONWRITER_CHUNK_SIZE (64 * 1024) //uncompressed bytes passed to the compressor at once
+
+CJSonWriter::CJSonWriter(std::string &output, const bool bGZip)
+	: m_output(output)
+{
+	if (!bGZip)
+		return;
+	m_zstream = std::unique_ptr<z_stream_s>(new z_stream_s());
+	//windowBits + 16: gzip header and trailer
+	if (deflateInit2(m_zstream.get(), Z_DEFAULT_COMPRESSION, Z_DEFLATED, MAX_WBITS + 16, MAX_MEM_LEVEL, Z_DEFAULT_STRATEGY) != Z_OK)
+		m_zstream.reset();
+	else
+		m_buffer.reserve(JSONWRITER_CHUNK_SIZE);
+}
+
+CJSonWriter::~CJSonWriter()
+{
+	if (m_zstream != nullptr)
+		deflateEnd(m_zstream.get());
+}
+
+void CJSonWriter::Separator()
+{
+	if (m_bAfterKey)
+	{
+		m_bAfterKey = false;
+		return;
+	}
+	if (m_first.empty())
+		return;
+	if (!m_first.back())
+		Write(",", 1);
+	m_first.back() = false;
+}
+
+void CJSonWriter::BeginObject()
+{
+	Separator();
+	Write("{", 1);
+	m_first.push_back(true);
+}
+
+void CJSonWriter::EndObject()
+{
+	m_first.pop_back();
+	Write("}", 1);
+}
+
+void CJSonWriter::BeginArray()
+{
+	Separator();
+	Write("[", 1);
+	m_first.push_back(true);
+}
+
+void CJSonWriter::EndArray()
+{
+	m_first.pop_back();
+	Write("]", 1);
+}
+
+void CJSonWriter::Key(const char *szKey)
+{
+	Separator();
+	Write(Json::valueToQuotedString(szKey));
+	Write(":", 1);
+	m_bAfterKey = true;
+}
+
+void CJSonWriter::Value(const char *szValue)
+{
+	Separator();
+	Write(Json::valueToQuotedString(szValue));
+}
+
+void CJSonWriter::Value(const std::string &value)
+{
+	Value(value.c_str());
+}
+
+void CJSonWriter::Value(const int value)
+{
+	Separator();
+	Write(std::to_string(value));
+}
+
+void CJSonWriter::Value(const int64_t value)
+{
+	Separator();
+	Write(std::to_string(value));
+}
+
+void CJSonWriter::Value(const uint64_t value)
+{
+	Separator();
+	Write(std::to_string(value));
+}
+
+void CJSonWriter::Value(const double value)
+{
+	Separator();
+	//same notation as a Json::Value tree
+	Write(Json::valueToString(value));
+}
+
+void CJSonWriter::Value(const bool value)
+{
+	Separator();
+	if (value)
+		Write("true", 4);
+	else
+		Write("false", 5);
+}
+
+void CJSonWriter::Value(const Json::Value &value)
+{
+	Separator();
+	Write(JSonToRawString(value));
+}
+
+void CJSonWriter::Null()
+{
+	Separator();
+	Write("null", 4);
+}
+
+void CJSonWriter::Write(const char *pData, const size_t length)
+{
+	if (m_zstream == nullptr)
+	{
+		m_output.append(pData, length);
+		return;
+	}
+	m_buffer.append(pData, length);
+	if (m_buffer.size() >= JSONWRITER_CHUNK_SIZE)
+		Deflate(false);
+}
+
+void CJSonWriter::Deflate(const bool bFinish)
+{
+	m_zstream->next_in = reinterpret_cast<Bytef *>(const_cast<char *>(m_buffer.data()));
+	m_zstream->avail_in = static_cast<uInt>(m_buffer.size());
+	Bytef out[16384];
+	do
+	{
+		m_zstream->next_out = out;
+		m_zstream->avail_out = sizeof(out);
+		deflate(m_zstream.get(), (bFinish) ? Z_FINISH : Z_NO_FLUSH);
+		m_output.append(reinterpret_cast<const char *>(out), sizeof(out) - m_zstream->avail_out);
+	} while (m_zstream->avail_out == 0);
+	m_buffer.clear();
+}
+
+void CJSonWriter::Finish()
+{
+	if (m_bFinished)
+		return;
+	m_bFinished = true;
+	if (m_zstream != nullptr)
+		Deflate(true);
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <json/json.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct z_stream_s;
+
+//Writes compact JSON directly into a response buffer, for responses too large to build as a Json::Value tree first
+//
+//With gzip the data is compressed while it is written, so only the compressed response is kept in memory.
+//Keys and values are written in document order, the writer only takes care of the separators.
+class CJSonWriter
+{
+public:
+	//bGZip: compress into output, falls back to plain output when the compressor can not be initialized
+	CJSonWriter(std::string &output, bool bGZip);
+	~CJSonWriter();
+
+	void BeginObject();
+	void EndObject();
+	void BeginArray();
+	void EndArray();
+	void Key(const char *szKey);
+
+	void Value(const char *szValue);
+	void Value(const std::string &value);
+	void Value(int value);
+	void Value(int64_t value);
+	void Value(uint64_t value);
+	void Value(double value);
+	void Value(bool value);
+	//a tree built the usual way, for the small parts of a response
+	void Value(const Json::Value &value);
+	void Null();
+
+	template <typename T> void Member(const char *szKey, const T &value)
+	{
+		Key(szKey);
+		Value(value);
+	}
+
+	//Flushes the compressor, the output is complete after this
+	void Finish();
+	bool IsGZip() const
+	{
+		return (m_zstream != nullptr);
+	}
+
+private:
+	void Separator();
+	void Write(const char *pData, size_t length);
+	void Write(const std::string &data)
+	{
+		Write(data.data(), data.size());
+	}
+	void Deflate(bool bFinish);
+
+	std::string &m_output;
+	std::string m_buffer; //not yet compressed
+	std::unique_ptr<z_stream_s> m_zstream;
+	std::vector<bool> m_first; //per open object/array: nothing written in it yet
+	bool m_bAfterKey = false;
+	bool m_bFinished = false;
+};
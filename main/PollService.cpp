@@ -0,0 +1,215 @@
+#include "stdafx.h"
+#include "PollService.h"
+#include "localtime_r.h"
+#include "Logger.h"
+#include "Helper.h"
+#include <algorithm>
+#include <set>
+
+CPollService::~CPollService()
+{
+	Stop();
+}
+
+void CPollService::Start(const size_t workers)
+{
+	Stop();
+	m_bStopRequested = false;
+	m_timerthread = std::make_shared<std::thread>([this] { Do_Timer(); });
+	SetThreadName(m_timerthread->native_handle(), "PollTimer");
+	for (size_t ii = 0; ii < workers; ii++)
+	{
+		auto worker = std::make_shared<std::thread>([this] { Do_Worker(); });
+		SetThreadName(worker->native_handle(), "PollWorker");
+		m_workers.push_back(worker);
+	}
+}
+
+void CPollService::Stop()
+{
+	if (!m_timerthread)
+		return;
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_bStopRequested = true;
+	}
+	m_timercond.notify_all();
+	m_readycond.notify_all();
+	m_timerthread->join();
+	m_timerthread.reset();
+	for (auto &worker : m_workers)
+		worker->join();
+	m_workers.clear();
+}
+
+uint64_t CPollService::AddJob(const void *owner, const int delay, const int interval, const std::function<void()> &job, const bool bBlocking)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	uint64_t id = m_nextid++;
+	_tPollJob &pjob = m_jobs[id];
+	pjob.owner = owner;
+	pjob.interval = (interval > 0) ? interval : 0;
+	pjob.job = job;
+	pjob.bBlocking = bBlocking;
+	pjob.bRunning = false;
+	pjob.started = 0;
+	m_wheel.Schedule(id, mytime(nullptr) + ((delay > 0) ? delay : 0));
+	return id;
+}
+
+void CPollService::RemoveJobs(const void *owner)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_heartbeats.erase(owner);
+	for (const auto &itt : m_jobs)
+	{
+		if (itt.second.owner == owner)
+			m_wheel.Cancel(itt.first);
+	}
+	auto ritt = m_ready.begin();
+	while (ritt != m_ready.end())
+	{
+		auto itt = m_jobs.find(*ritt);
+		if ((itt != m_jobs.end()) && (itt->second.owner == owner))
+			ritt = m_ready.erase(ritt);
+		else
+			++ritt;
+	}
+
+	//a job that stops its own hardware can not wait for itself
+	const std::thread::id self = std::this_thread::get_id();
+	m_donecond.wait(lock, [&] {
+		for (const auto &itt : m_jobs)
+		{
+			if ((itt.second.owner == owner) && (itt.second.bRunning) && (itt.second.worker != self))
+				return false;
+		}
+		return true;
+	});
+
+	auto itt = m_jobs.begin();
+	while (itt != m_jobs.end())
+	{
+		if (itt->second.owner == owner)
+			itt = m_jobs.erase(itt);
+		else
+			++itt;
+	}
+}
+
+void CPollService::SetHeartbeat(const void *owner, const int maxruntime, const std::function<void()> &beat)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	_tPollHeartbeat &heartbeat = m_heartbeats[owner];
+	heartbeat.maxruntime = maxruntime;
+	heartbeat.beat = beat;
+}
+
+//called with m_mutex locked
+void CPollService::DoHeartbeats()
+{
+	if (m_heartbeats.empty())
+		return;
+	time_t now = mytime(nullptr);
+	std::set<const void *> overdue;
+	for (const auto &itt : m_jobs)
+	{
+		if (!itt.second.bRunning)
+			continue;
+		auto hitt = m_heartbeats.find(itt.second.owner);
+		if ((hitt != m_heartbeats.end()) && (difftime(now, itt.second.started) > hitt->second.maxruntime))
+			overdue.insert(itt.second.owner);
+	}
+	for (const auto &itt : m_heartbeats)
+	{
+		if (overdue.find(itt.first) == overdue.end())
+			itt.second.beat();
+	}
+}
+
+//called with m_mutex locked, first ready job that may start now
+std::deque<uint64_t>::iterator CPollService::NextRunnable()
+{
+	if ((m_blockingrunning == 0) || (m_blockingrunning + 1 < m_workers.size()))
+		return m_ready.begin();
+	return std::find_if(m_ready.begin(), m_ready.end(), [this](const uint64_t id) {
+		auto itt = m_jobs.find(id);
+		return ((itt == m_jobs.end()) || (!itt->second.bBlocking));
+	});
+}
+
+void CPollService::Do_Timer()
+{
+	std::vector<uint64_t> expired;
+	std::unique_lock<std::mutex> lock(m_mutex);
+	while (!m_bStopRequested)
+	{
+		m_timercond.wait_for(lock, std::chrono::seconds(1));
+		if (m_bStopRequested)
+			break;
+		DoHeartbeats();
+		m_wheel.Advance(mytime(nullptr), expired);
+		if (expired.empty())
+			continue;
+		m_ready.insert(m_ready.end(), expired.begin(), expired.end());
+		m_readycond.notify_all();
+	}
+}
+
+void CPollService::Do_Worker()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	while (true)
+	{
+		std::deque<uint64_t>::iterator ritt;
+		m_readycond.wait(lock, [&] {
+			if (m_bStopRequested)
+				return true;
+			ritt = NextRunnable();
+			return (ritt != m_ready.end());
+		});
+		if (m_bStopRequested)
+			break;
+		uint64_t id = *ritt;
+		m_ready.erase(ritt);
+		auto itt = m_jobs.find(id);
+		if (itt == m_jobs.end())
+			continue;
+		const bool bBlocking = itt->second.bBlocking;
+		if (bBlocking)
+			m_blockingrunning++;
+		itt->second.bRunning = true;
+		itt->second.started = mytime(nullptr);
+		itt->second.worker = std::this_thread::get_id();
+		//copy, the job could remove itself while it runs
+		std::function<void()> job = itt->second.job;
+		lock.unlock();
+
+		try
+		{
+			job();
+		}
+		catch (const std::exception &e)
+		{
+			_log.Log(LOG_ERROR, "PollService: Exception in job: %s", e.what());
+		}
+
+		lock.lock();
+		if (bBlocking)
+		{
+			m_blockingrunning--;
+			//a worker may be waiting for a free slot
+			m_readycond.notify_all();
+		}
+		itt = m_jobs.find(id);
+		if (itt != m_jobs.end())
+		{
+			itt->second.bRunning = false;
+			if (itt->second.interval > 0)
+				m_wheel.Schedule(id, mytime(nullptr) + itt->second.interval);
+			else
+				m_jobs.erase(itt);
+		}
+		m_donecond.notify_all();
+	}
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <condition_variable>
+#include <ctime>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "TimerWheel.h"
+
+//Runs the periodic and one-shot jobs of polling hardware on one timer thread and a small pool of workers,
+//instead of every driver keeping its own thread that sleeps most of the time
+//
+//A job never runs concurrently with itself, a periodic job is re-armed 'interval' seconds after it finished
+//Blocking jobs (network I/O) never take the last free worker, so a few slow polls can not starve the others
+class CPollService
+{
+public:
+	CPollService() = default;
+	~CPollService();
+
+	void Start(size_t workers = 4);
+	void Stop();
+
+	//First run after 'delay' seconds, then every 'interval' seconds (0 = run once)
+	uint64_t AddJob(const void *owner, int delay, int interval, const std::function<void()> &job, bool bBlocking = false);
+	//Removes all jobs and the heartbeat of an owner and waits for a running one to finish (unless called from that job)
+	void RemoveJobs(const void *owner);
+	//Calls 'beat' from the timer thread every second, as long as no job of the owner has been running for more than 'maxruntime' seconds
+	//'beat' runs with the service locked and should only stamp a time
+	void SetHeartbeat(const void *owner, int maxruntime, const std::function<void()> &beat);
+
+private:
+	struct _tPollJob
+	{
+		const void *owner;
+		int interval;
+		std::function<void()> job;
+		bool bBlocking;
+		bool bRunning;
+		time_t started;
+		std::thread::id worker;
+	};
+	struct _tPollHeartbeat
+	{
+		int maxruntime;
+		std::function<void()> beat;
+	};
+
+	void Do_Timer();
+	void Do_Worker();
+	void DoHeartbeats();
+	std::deque<uint64_t>::iterator NextRunnable();
+
+	std::mutex m_mutex;
+	std::condition_variable m_timercond;
+	std::condition_variable m_readycond; //jobs are waiting in m_ready
+	std::condition_variable m_donecond; //a running job finished
+	std::map<uint64_t, _tPollJob> m_jobs;
+	CTimerWheel<uint64_t> m_wheel; //job id -> next run
+	std::deque<uint64_t> m_ready;
+	std::map<const void *, _tPollHeartbeat> m_heartbeats;
+	size_t m_blockingrunning = 0;
+	uint64_t m_nextid = 1;
+	bool m_bStopRequested = false;
+
+	std::shared_ptr<std::thread> m_timerthread;
+	std::vector<std::shared_ptr<std::thread>> m_workers;
+};
@@ -219,6 +219,7 @@ enum _eHardwareTypes {
 	HTYPE_Mercedes,				//122
 	HTYPE_AirconWithMe,         //123
 	HTYPE_TeleinfoMeterTCP,		//124
+	HTYPE_RxReplay,				//125
 	HTYPE_END
 };
 
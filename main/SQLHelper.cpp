@@ -14,6 +14,7 @@
 #include "localtime_r.h"
 #include "Logger.h"
 #include "mainworker.h"
+#include "SValueFields.h"
 #include "../main/json_helper.h"
 #include <sqlite3.h>
 #include "../hardware/hardwaretypes.h"
@@ -477,6 +478,19 @@ constexpr auto sqlCreateFan_Calendar =
 "[Speed_Avg] INTEGER DEFAULT 0, "
 "[Date] DATE NOT NULL);";
 
+//Short log and calendar tables, with the prefix of their indexes
+//In the compact layout these tables are clustered on (DeviceRowID, Date) and need no indexes
+constexpr struct
+{
+	const char *szTable;
+	const char *szIndexPrefix;
+} HistoryTables[] = {
+	{ "Fan", "f" },		{ "Fan_Calendar", "fc" },	  { "Meter", "m" },	      { "Meter_Calendar", "mc" },
+	{ "MultiMeter", "mm" }, { "MultiMeter_Calendar", "mmc" }, { "Percentage", "p" },      { "Percentage_Calendar", "pc" },
+	{ "Rain", "r" },	{ "Rain_Calendar", "rc" },	  { "Temperature", "t" },     { "Temperature_Calendar", "tc" },
+	{ "UV", "u" },		{ "UV_Calendar", "uv" },	  { "Wind", "w" },	      { "Wind_Calendar", "wc" },
+};
+
 constexpr auto sqlCreateBackupLog =
 "CREATE TABLE IF NOT EXISTS [BackupLog] ("
 "[Key] VARCHAR(50) NOT NULL, "
@@ -588,13 +602,83 @@ constexpr auto sqlCreateMobileDevices =
 "[LastUpdate] DATETIME DEFAULT(datetime('now', 'localtime'))"
 ");";
 
+//Tables and triggers, created when they do not exist yet
+constexpr const char *sqlCreateSchema[] = {
+	sqlCreateDeviceStatus,
+	sqlCreateDeviceStatusTrigger,
+	sqlCreateLightingLog,
+	sqlCreateSceneLog,
+	sqlCreatePreferences,
+	sqlCreateRain,
+	sqlCreateRain_Calendar,
+	sqlCreateTemperature,
+	sqlCreateTemperature_Calendar,
+	sqlCreateTimers,
+	sqlCreateSetpointTimers,
+	sqlCreateUV,
+	sqlCreateUV_Calendar,
+	sqlCreateWind,
+	sqlCreateWind_Calendar,
+	sqlCreateMeter,
+	sqlCreateMeter_Calendar,
+	sqlCreateMultiMeter,
+	sqlCreateMultiMeter_Calendar,
+	sqlCreateNotifications,
+	sqlCreateHardware,
+	sqlCreateUsers,
+	sqlCreateLightSubDevices,
+	sqlCreateCameras,
+	sqlCreateCamerasActiveDevices,
+	sqlCreatePlanMappings,
+	sqlCreateDevicesToPlanStatusTrigger,
+	sqlCreatePlans,
+	sqlCreatePlanOrderTrigger,
+	sqlCreateScenes,
+	sqlCreateScenesTrigger,
+	sqlCreateSceneDevices,
+	sqlCreateSceneDeviceTrigger,
+	sqlCreateTimerPlans,
+	sqlCreateSceneTimers,
+	sqlCreateSharedDevices,
+	sqlCreateEventMaster,
+	sqlCreateEventRules,
+	sqlCreateZWaveNodes,
+	sqlCreateWOLNodes,
+	sqlCreatePercentage,
+	sqlCreatePercentage_Calendar,
+	sqlCreateFan,
+	sqlCreateFan_Calendar,
+	sqlCreateBackupLog,
+	sqlCreateEnoceanSensors,
+	sqlCreatePushLink,
+	sqlCreateUserVariables,
+	sqlCreateFloorplans,
+	sqlCreateFloorplanOrderTrigger,
+	sqlCreateCustomImages,
+	sqlCreateMySensors,
+	sqlCreateMySensorsVariables,
+	sqlCreateMySensorsChilds,
+	sqlCreateToonDevices,
+	sqlCreateUserSessions,
+	sqlCreateMobileDevices,
+};
+
+constexpr const char *sqlCreateIndexes[] = {
+	"create index if not exists ds_hduts_idx	on DeviceStatus(HardwareID, DeviceID, Unit, Type, SubType);",
+	"create index if not exists ll_id_idx	   on LightingLog(DeviceRowID);",
+	"create index if not exists ll_id_date_idx  on LightingLog(DeviceRowID, Date);",
+	"create index if not exists sl_id_idx	   on SceneLog(SceneRowID);",
+	"create index if not exists sl_id_date_idx  on SceneLog(SceneRowID, Date);",
+};
+
 extern std::string szUserDataFolder;
 
 CSQLHelper::CSQLHelper()
 {
 	m_LastSwitchRowID = 0;
 	m_dbase = nullptr;
-	m_sensortimeoutcounter = 0;
+	m_SensorTimeout = 60;
+	m_SensorTimeoutCheckInterval = 0;
 	m_bAcceptNewHardware = true;
 	m_bAllowWidgetOrdering = true;
 	m_ActiveTimerPlan = 0;
@@ -610,6 +694,9 @@ CSQLHelper::CSQLHelper()
 	m_ShortLogInterval = 5;
 	m_bPreviousAcceptNewHardware = false;
 	m_bLogEventScriptTrigger = false;
+	m_bCompactHistory = false;
+	for (auto &version : m_tableversion)
+		version = 1;
 
 	SetDatabaseName("domoticz.db");
 }
@@ -622,6 +709,16 @@ CSQLHelper::~CSQLHelper()
 
 bool CSQLHelper::OpenDatabase()
 {
+	//time spent per phase, logged when done
+	auto tStart = std::chrono::steady_clock::now();
+	auto tPhase = tStart;
+	std::string szTimings;
+	auto phaseDone = [&](const char *szPhase) {
+		auto now = std::chrono::steady_clock::now();
+		szTimings += std_format("%s%s: %d ms", (szTimings.empty()) ? "" : ", ", szPhase, static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(now - tPhase).count()));
+		tPhase = now;
+	};
+
 	//Open Database
 	int rc = sqlite3_open(m_dbase_name.c_str(), &m_dbase);
 	if (rc)
@@ -635,6 +732,11 @@ bool CSQLHelper::OpenDatabase()
 	sqlite3_exec(m_dbase, "PRAGMA synchronous = NORMAL", nullptr, nullptr, nullptr);
 	sqlite3_exec(m_dbase, "PRAGMA foreign_keys = ON", nullptr, nullptr, nullptr);
 	sqlite3_exec(m_dbase, "PRAGMA busy_timeout = 1000", nullptr, nullptr, nullptr);
+	sqlite3_update_hook(m_dbase, UpdateHook, this);
+	//(another) database, nothing cached is valid anymore
+	for (auto &version : m_tableversion)
+		version++;
+	InvalidateSceneStatus();
 
 	std::vector<std::vector<std::string> > result = query("SELECT name FROM sqlite_master WHERE type='table' AND name='DeviceStatus'");
 	bool bNewInstall = (result.empty());
@@ -654,107 +756,38 @@ bool CSQLHelper::OpenDatabase()
 		//Pre-SQL Patches
 	}
 
-	//create database (if not exists)
-	sqlite3_exec(m_dbase, "BEGIN TRANSACTION;", nullptr, nullptr, nullptr);
-	query(sqlCreateDeviceStatus);
-	query(sqlCreateDeviceStatusTrigger);
-	query(sqlCreateLightingLog);
-	query(sqlCreateSceneLog);
-	query(sqlCreatePreferences);
-	query(sqlCreateRain);
-	query(sqlCreateRain_Calendar);
-	query(sqlCreateTemperature);
-	query(sqlCreateTemperature_Calendar);
-	query(sqlCreateTimers);
-	query(sqlCreateSetpointTimers);
-	query(sqlCreateUV);
-	query(sqlCreateUV_Calendar);
-	query(sqlCreateWind);
-	query(sqlCreateWind_Calendar);
-	query(sqlCreateMeter);
-	query(sqlCreateMeter_Calendar);
-	query(sqlCreateMultiMeter);
-	query(sqlCreateMultiMeter_Calendar);
-	query(sqlCreateNotifications);
-	query(sqlCreateHardware);
-	query(sqlCreateUsers);
-	query(sqlCreateLightSubDevices);
-	query(sqlCreateCameras);
-	query(sqlCreateCamerasActiveDevices);
-	query(sqlCreatePlanMappings);
-	query(sqlCreateDevicesToPlanStatusTrigger);
-	query(sqlCreatePlans);
-	query(sqlCreatePlanOrderTrigger);
-	query(sqlCreateScenes);
-	query(sqlCreateScenesTrigger);
-	query(sqlCreateSceneDevices);
-	query(sqlCreateSceneDeviceTrigger);
-	query(sqlCreateTimerPlans);
-	query(sqlCreateSceneTimers);
-	query(sqlCreateSharedDevices);
-	query(sqlCreateEventMaster);
-	query(sqlCreateEventRules);
-	query(sqlCreateZWaveNodes);
-	query(sqlCreateWOLNodes);
-	query(sqlCreatePercentage);
-	query(sqlCreatePercentage_Calendar);
-	query(sqlCreateFan);
-	query(sqlCreateFan_Calendar);
-	query(sqlCreateBackupLog);
-	query(sqlCreateEnoceanSensors);
-	query(sqlCreatePushLink);
-	query(sqlCreateUserVariables);
-	query(sqlCreateFloorplans);
-	query(sqlCreateFloorplanOrderTrigger);
-	query(sqlCreateCustomImages);
-	query(sqlCreateMySensors);
-	query(sqlCreateMySensorsVariables);
-	query(sqlCreateMySensorsChilds);
-	query(sqlCreateToonDevices);
-	query(sqlCreateUserSessions);
-	query(sqlCreateMobileDevices);
-	//Add indexes to log tables
-	query("create index if not exists ds_hduts_idx	on DeviceStatus(HardwareID, DeviceID, Unit, Type, SubType);");
-	query("create index if not exists f_id_idx		on Fan(DeviceRowID);");
-	query("create index if not exists f_id_date_idx   on Fan(DeviceRowID, Date);");
-	query("create index if not exists fc_id_idx	   on Fan_Calendar(DeviceRowID);");
-	query("create index if not exists fc_id_date_idx  on Fan_Calendar(DeviceRowID, Date);");
-	query("create index if not exists ll_id_idx	   on LightingLog(DeviceRowID);");
-	query("create index if not exists ll_id_date_idx  on LightingLog(DeviceRowID, Date);");
-	query("create index if not exists sl_id_idx	   on SceneLog(SceneRowID);");
-	query("create index if not exists sl_id_date_idx  on SceneLog(SceneRowID, Date);");
-	query("create index if not exists m_id_idx		on Meter(DeviceRowID);");
-	query("create index if not exists m_id_date_idx   on Meter(DeviceRowID, Date);");
-	query("create index if not exists mc_id_idx	   on Meter_Calendar(DeviceRowID);");
-	query("create index if not exists mc_id_date_idx  on Meter_Calendar(DeviceRowID, Date);");
-	query("create index if not exists mm_id_idx	   on MultiMeter(DeviceRowID);");
-	query("create index if not exists mm_id_date_idx  on MultiMeter(DeviceRowID, Date);");
-	query("create index if not exists mmc_id_idx	  on MultiMeter_Calendar(DeviceRowID);");
-	query("create index if not exists mmc_id_date_idx on MultiMeter_Calendar(DeviceRowID, Date);");
-	query("create index if not exists p_id_idx		on Percentage(DeviceRowID);");
-	query("create index if not exists p_id_date_idx   on Percentage(DeviceRowID, Date);");
-	query("create index if not exists pc_id_idx	   on Percentage_Calendar(DeviceRowID);");
-	query("create index if not exists pc_id_date_idx  on Percentage_Calendar(DeviceRowID, Date);");
-	query("create index if not exists r_id_idx		on Rain(DeviceRowID);");
-	query("create index if not exists r_id_date_idx   on Rain(DeviceRowID, Date);");
-	query("create index if not exists rc_id_idx	   on Rain_Calendar(DeviceRowID);");
-	query("create index if not exists rc_id_date_idx  on Rain_Calendar(DeviceRowID, Date);");
-	query("create index if not exists t_id_idx		on Temperature(DeviceRowID);");
-	query("create index if not exists t_id_date_idx   on Temperature(DeviceRowID, Date);");
-	query("create index if not exists tc_id_idx	   on Temperature_Calendar(DeviceRowID);");
-	query("create index if not exists tc_id_date_idx  on Temperature_Calendar(DeviceRowID, Date);");
-	query("create index if not exists u_id_idx		on UV(DeviceRowID);");
-	query("create index if not exists u_id_date_idx   on UV(DeviceRowID, Date);");
-	query("create index if not exists uv_id_idx	   on UV_Calendar(DeviceRowID);");
-	query("create index if not exists uv_id_date_idx  on UV_Calendar(DeviceRowID, Date);");
-	query("create index if not exists w_id_idx		on Wind(DeviceRowID);");
-	query("create index if not exists w_id_date_idx   on Wind(DeviceRowID, Date);");
-	query("create index if not exists wc_id_idx	   on Wind_Calendar(DeviceRowID);");
-	query("create index if not exists wc_id_date_idx  on Wind_Calendar(DeviceRowID, Date);");
-	sqlite3_exec(m_dbase, "END TRANSACTION;", nullptr, nullptr, nullptr);
+	phaseDone("open");
+
+	//The create statements only have to run when the code or the database schema changed since the last start
+	std::string szSchemaHash = GetSchemaHash();
+	std::string szStoredSchemaHash;
+	bool bSchemaUnchanged = ((!bNewInstall) && (dbversion == DB_VERSION) && (GetPreferencesVar("DB_SchemaHash", szStoredSchemaHash)) && (szStoredSchemaHash == szSchemaHash));
+	if (!bSchemaUnchanged)
+	{
+		//create database (if not exists)
+		sqlite3_exec(m_dbase, "BEGIN TRANSACTION;", nullptr, nullptr, nullptr);
+		for (const auto &statement : sqlCreateSchema)
+			query(statement);
+		//Add indexes to log tables
+		for (const auto &statement : sqlCreateIndexes)
+			query(statement);
+		for (const auto &table : HistoryTables)
+		{
+			if (IsCompactHistoryTable(table.szTable))
+				continue;
+			query(std_format("create index if not exists %s_id_idx on %s(DeviceRowID);", table.szIndexPrefix, table.szTable));
+			query(std_format("create index if not exists %s_id_date_idx on %s(DeviceRowID, Date);", table.szIndexPrefix, table.szTable));
+		}
+		sqlite3_exec(m_dbase, "END TRANSACTION;", nullptr, nullptr, nullptr);
+		phaseDone("schema");
+	}
 
 	if ((!bNewInstall) && (dbversion < DB_VERSION))
 	{
+		_log.Log(LOG_STATUS, "SQLHelper: Upgrading database from version %d to %d...", dbversion, DB_VERSION);
+		//all patches in one transaction, instead of a journal commit per statement
+		sqlite3_exec(m_dbase, "PRAGMA foreign_keys=off", nullptr, nullptr, nullptr);
+		sqlite3_exec(m_dbase, "BEGIN TRANSACTION;", nullptr, nullptr, nullptr);
 		//Post-SQL Patches
 		if (dbversion < 2)
 		{
@@ -855,7 +888,14 @@ bool CSQLHelper::OpenDatabase()
 		}
 		if (dbversion < 13)
 		{
-			DeleteHardware("1001");
+			//not DeleteHardware(), DeleteDevices() would commit the upgrade transaction halfway
+			//and notify the event system and web servers, which are not running yet
+			std::vector<std::vector<std::string> > result;
+			result = query("SELECT ID FROM DeviceStatus WHERE (HardwareID == 1001)");
+			std::lock_guard<std::mutex> l(m_sqlQueryMutex);
+			for (const auto &sd : result)
+				DeleteDeviceRows(sd[0]);
+			DeleteHardwareRows("1001");
 		}
 		if (dbversion < 14)
 		{
@@ -916,18 +956,7 @@ bool CSQLHelper::OpenDatabase()
 		if (dbversion < 23)
 		{
 			query("ALTER TABLE Temperature_Calendar ADD COLUMN [Temp_Avg] FLOAT default 0");
-
-			std::vector<std::vector<std::string> > result;
-			result = query("SELECT RowID, (Temp_Max+Temp_Min)/2 FROM Temperature_Calendar");
-			if (!result.empty())
-			{
-				sqlite3_exec(m_dbase, "BEGIN TRANSACTION;", nullptr, nullptr, nullptr);
-				for (const auto &sd : result)
-				{
-					safe_query("UPDATE Temperature_Calendar SET Temp_Avg=%.1f WHERE RowID='%q'", atof(sd[1].c_str()), sd[0].c_str());
-				}
-				sqlite3_exec(m_dbase, "END TRANSACTION;", nullptr, nullptr, nullptr);
-			}
+			query("UPDATE Temperature_Calendar SET Temp_Avg=round((Temp_Max+Temp_Min)/2, 1)");
 		}
 		if (dbversion < 24)
 		{
@@ -1306,7 +1335,6 @@ bool CSQLHelper::OpenDatabase()
 			std::stringstream szQuery;
 			std::vector<std::vector<std::string> > result;
 			std::vector<std::vector<std::string> > result2;
-			std::vector<std::vector<std::string> > result3;
 			szQuery << "SELECT ID FROM HARDWARE WHERE([Type]==" << HTYPE_TOONTHERMOSTAT << ")";
 			result = query(szQuery.str());
 			for (const auto &sd : result)
@@ -1320,35 +1348,22 @@ bool CSQLHelper::OpenDatabase()
 				for (const auto &sd : result2)
 				{
 					//First the shortlog
+					//value1 = powerusage1;
+					//value2 = powerdeliv1;
+					//value5 = powerusage2;
+					//value6 = powerdeliv2;
+					//value3 = usagecurrent;
+					//value4 = delivcurrent;
+					//(the right hand side of an UPDATE sees the old values, so the columns are swapped in place)
 					szQuery.clear();
 					szQuery.str("");
-					szQuery << "SELECT ROWID, Value1, Value2, Value3, Value4, Value5, Value6 FROM MultiMeter WHERE (DeviceRowID==" << sd[0] << ")";
-					result3 = query(szQuery.str());
-					for (const auto &sd : result3)
-					{
-						//value1 = powerusage1;
-						//value2 = powerdeliv1;
-						//value5 = powerusage2;
-						//value6 = powerdeliv2;
-						//value3 = usagecurrent;
-						//value4 = delivcurrent;
-						szQuery.clear();
-						szQuery.str("");
-						szQuery << "UPDATE MultiMeter SET Value1=" << sd[5] << ", Value2=" << sd[6] << ", Value5=" << sd[1] << ", Value6=" << sd[2] << " WHERE (ROWID=" << sd[0] << ")";
-						query(szQuery.str());
-					}
+					szQuery << "UPDATE MultiMeter SET Value1=Value5, Value2=Value6, Value5=Value1, Value6=Value2 WHERE (DeviceRowID==" << sd[0] << ")";
+					query(szQuery.str());
 					//Next for the calendar
 					szQuery.clear();
 					szQuery.str("");
-					szQuery << "SELECT ROWID, Value1, Value2, Value3, Value4, Value5, Value6, Counter1, Counter2, Counter3, Counter4 FROM MultiMeter_Calendar WHERE (DeviceRowID==" << sd[0] << ")";
-					result3 = query(szQuery.str());
-					for (const auto &sd : result3)
-					{
-						szQuery.clear();
-						szQuery.str("");
-						szQuery << "UPDATE MultiMeter_Calendar SET Value1=" << sd[5] << ", Value2=" << sd[6] << ", Value5=" << sd[1] << ", Value6=" << sd[2] << ", Counter1=" << sd[9] << ", Counter2=" << sd[10] << ", Counter3=" << sd[7] << ", Counter4=" << sd[8] << " WHERE (ROWID=" << sd[0] << ")";
-						query(szQuery.str());
-					}
+					szQuery << "UPDATE MultiMeter_Calendar SET Value1=Value5, Value2=Value6, Value5=Value1, Value6=Value2, Counter1=Counter3, Counter2=Counter4, Counter3=Counter1, Counter4=Counter2 WHERE (DeviceRowID==" << sd[0] << ")";
+					query(szQuery.str());
 				}
 			}
 		}
@@ -1657,9 +1672,6 @@ bool CSQLHelper::OpenDatabase()
 			std::string fieldList = "[ID],[HardwareID],[DeviceID],[Unit],[Name],[Used],[Type],[SubType],[SwitchType],[Favorite],[SignalLevel],[BatteryLevel],[nValue],[sValue],[LastUpdate],[Order],[AddjValue],[AddjMulti],[AddjValue2],[AddjMulti2],[StrParam1],[StrParam2],[LastLevel],[Protected],[CustomImage],[Description],[Options]";
 			std::stringstream szQuery;
 
-			sqlite3_exec(m_dbase, "PRAGMA foreign_keys=off", nullptr, nullptr, nullptr);
-			sqlite3_exec(m_dbase, "BEGIN TRANSACTION", nullptr, nullptr, nullptr);
-
 			// Drop indexes and trigger
 			safe_query("DROP TRIGGER IF EXISTS devicestatusupdate");
 			// Save all table rows
@@ -1681,9 +1693,6 @@ bool CSQLHelper::OpenDatabase()
 			szQuery.str("");
 			szQuery << "DROP TABLE IF EXISTS _" << tableName << "_old";
 			safe_query(szQuery.str().c_str());
-
-			sqlite3_exec(m_dbase, "END TRANSACTION", nullptr, nullptr, nullptr);
-			sqlite3_exec(m_dbase, "PRAGMA foreign_keys=on", nullptr, nullptr, nullptr);
 		}
 		if (dbversion < 93)
 		{
@@ -2776,6 +2785,10 @@ bool CSQLHelper::OpenDatabase()
 				query("ALTER TABLE Hardware ADD COLUMN [LogLevel] INTEGER DEFAULT 7"); // LOG_NORM + LOG_STATUS + LOG_ERROR
 			}
 		}
+		sqlite3_exec(m_dbase, "END TRANSACTION;", nullptr, nullptr, nullptr);
+		sqlite3_exec(m_dbase, "PRAGMA foreign_keys=on", nullptr, nullptr, nullptr);
+		phaseDone("upgrade");
+		_log.Log(LOG_STATUS, "SQLHelper: Database upgraded to version %d", DB_VERSION);
 	}
 	else if (bNewInstall)
 	{
@@ -2784,7 +2797,8 @@ bool CSQLHelper::OpenDatabase()
 		// Add hardware for internal use
 		m_sql.safe_query("INSERT INTO Hardware (Name, Enabled, Type, Address, Port, Username, Password, Mode1, Mode2, Mode3, Mode4, Mode5, Mode6) VALUES ('Domoticz Internal',1, %d,'',1,'','',0,0,0,0,0,0)", HTYPE_DomoticzInternal);
 	}
-	UpdatePreferencesVar("DB_Version", DB_VERSION);
+	if (dbversion != DB_VERSION)
+		UpdatePreferencesVar("DB_Version", DB_VERSION);
 
 	//Check preferences table for extreme sized sValues
 	result = safe_query("SELECT Key FROM Preferences WHERE LENGTH(sValue) > 1000");
@@ -3260,6 +3274,20 @@ bool CSQLHelper::OpenDatabase()
 		nValue = 6000;
 	m_max_kwh_usage = nValue;
 
+	phaseDone("preferences");
+
+	if (m_bCompactHistory)
+	{
+		CompactHistoryTables();
+		phaseDone("compact history");
+	}
+	if (!bSchemaUnchanged)
+		UpdatePreferencesVar("DB_SchemaHash", GetSchemaHash());
+
+	ReloadSensorTimeouts();
+	_log.Log(LOG_STATUS, "SQLHelper: Database opened in %d ms (%s)",
+		 static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - tStart).count()), szTimings.c_str());
+
 	//Start background thread
 	if (!StartThread())
 		return false;
@@ -3932,6 +3960,131 @@ void CSQLHelper::SetJournalMode(const std::string& mode)
 	m_journal_mode = mode;
 }
 
+void CSQLHelper::SetCompactHistory(const bool bCompact)
+{
+	m_bCompactHistory = bCompact;
+}
+
+//Called by SQLite for every row inserted, updated or deleted (not for a DELETE without WHERE clause)
+void CSQLHelper::UpdateHook(void *pHelper, int /*op*/, const char * /*szDatabase*/, const char *szTable, long long /*rowid*/)
+{
+	CSQLHelper *pSQLHelper = static_cast<CSQLHelper *>(pHelper);
+	if (strcmp(szTable, "Hardware") == 0)
+		pSQLHelper->m_tableversion[WTABLE_HARDWARE]++;
+	else if ((strcmp(szTable, "Timers") == 0) || (strcmp(szTable, "SetpointTimers") == 0))
+		pSQLHelper->m_tableversion[WTABLE_TIMERS]++;
+	else if (strcmp(szTable, "LightSubDevices") == 0)
+		pSQLHelper->m_tableversion[WTABLE_LIGHTSUBDEVICES]++;
+}
+
+uint64_t CSQLHelper::GetTableVersion(const _eWatchedTable table) const
+{
+	return m_tableversion[table];
+}
+
+//Identifies the schema the code expects together with the schema the database has
+std::string CSQLHelper::GetSchemaHash()
+{
+	std::string szSchema = std::to_string(DB_VERSION);
+	for (const auto &statement : sqlCreateSchema)
+		szSchema += statement;
+	for (const auto &statement : sqlCreateIndexes)
+		szSchema += statement;
+	for (const auto &table : HistoryTables)
+		szSchema += std::string(table.szTable) + table.szIndexPrefix;
+	auto result = query("SELECT type, name, sql FROM sqlite_master ORDER BY type, name");
+	for (const auto &sd : result)
+		szSchema += sd[0] + sd[1] + sd[2];
+	return GenerateMD5Hash(szSchema);
+}
+
+bool CSQLHelper::IsCompactHistoryTable(const std::string& tablename)
+{
+	auto result = safe_query("SELECT sql FROM sqlite_master WHERE (type=='table') AND (name=='%q')", tablename.c_str());
+	return ((!result.empty()) && (result[0][0].find("WITHOUT ROWID") != std::string::npos));
+}
+
+//One time conversion of the history tables to WITHOUT ROWID tables, clustered on (DeviceRowID, Date)
+//Graphs and cleanups read a device's range from consecutive pages, and the two indexes per table are no longer needed
+//(DeviceRowID, Date) is the only row key of these tables, code that works on one row must not use ROWID
+void CSQLHelper::CompactHistoryTables()
+{
+	struct _tCompactTable
+	{
+		std::string szName;
+		std::string szColumns; //column definitions
+		int64_t nRows;
+	};
+	std::vector<_tCompactTable> tables;
+	for (const auto &table : HistoryTables)
+	{
+		auto result = safe_query("SELECT sql FROM sqlite_master WHERE (type=='table') AND (name=='%q')", table.szTable);
+		if ((result.empty()) || (result[0][0].find("WITHOUT ROWID") != std::string::npos))
+			continue;
+		//columns added later with ALTER TABLE are part of the stored definition
+		const std::string &szCreate = result[0][0];
+		size_t spos = szCreate.find('(');
+		size_t epos = szCreate.rfind(')');
+		if ((spos == std::string::npos) || (epos == std::string::npos) || (epos < spos))
+		{
+			_log.Log(LOG_ERROR, "SQLHelper: Could not convert table %s, unexpected definition", table.szTable);
+			continue;
+		}
+		std::string szColumns = szCreate.substr(spos + 1, epos - spos - 1);
+		result = safe_query("SELECT COUNT(*) FROM [%q] WHERE ([Date] IS NOT NULL)", table.szTable);
+		int64_t nRows = (!result.empty()) ? std::stoll(result[0][0]) : 0;
+		tables.push_back({ table.szTable, szColumns, nRows });
+	}
+	if (tables.empty())
+		return;
+
+	std::vector<_tCompactTable> converted;
+	std::unique_lock<std::mutex> l(m_sqlQueryMutex);
+	for (const auto &table : tables)
+	{
+		_log.Log(LOG_STATUS, "SQLHelper: Converting table %s to the compact history layout...", table.szName.c_str());
+		std::string szTmpTable = table.szName + "_compact";
+		//A plain key: after the conversion a second row for the same device and date is refused (and logged), not silently replaced.
+		//Rows that are already doubled in the old table (a calendar day added twice) keep the first one that was logged.
+		std::string szQuery = std_format("BEGIN TRANSACTION;"
+						 "DROP TABLE IF EXISTS [%s];"
+						 "CREATE TABLE [%s] (%s, PRIMARY KEY ([DeviceRowID], [Date])) WITHOUT ROWID;"
+						 "INSERT OR IGNORE INTO [%s] SELECT * FROM [%s] WHERE ([Date] IS NOT NULL) ORDER BY [DeviceRowID], [Date], [rowid];"
+						 "DROP TABLE [%s];"
+						 "ALTER TABLE [%s] RENAME TO [%s];"
+						 "COMMIT;",
+						 szTmpTable.c_str(), szTmpTable.c_str(), table.szColumns.c_str(), szTmpTable.c_str(), table.szName.c_str(), table.szName.c_str(),
+						 szTmpTable.c_str(), table.szName.c_str());
+		char *errorMessage = nullptr;
+		if (sqlite3_exec(m_dbase, szQuery.c_str(), nullptr, nullptr, &errorMessage) != SQLITE_OK)
+		{
+			_log.Log(LOG_ERROR, "SQLHelper: Could not convert table %s: %s", table.szName.c_str(), (errorMessage != nullptr) ? errorMessage : "unknown error");
+			sqlite3_free(errorMessage);
+			sqlite3_exec(m_dbase, "ROLLBACK;", nullptr, nullptr, nullptr);
+			continue;
+		}
+		converted.push_back(table);
+	}
+	l.unlock();
+	for (const auto &table : converted)
+	{
+		auto result = safe_query("SELECT COUNT(*) FROM [%q]", table.szName.c_str());
+		int64_t nRows = (!result.empty()) ? std::stoll(result[0][0]) : 0;
+		if (nRows != table.nRows)
+			_log.Log(LOG_STATUS, "SQLHelper: Table %s: %" PRId64 " rows with the same device and date as an earlier row were left out", table.szName.c_str(), table.nRows - nRows);
+	}
+	//give the space of the old tables and indexes back
+	VacuumDatabase();
+	_log.Log(LOG_STATUS, "SQLHelper: Compact history layout ready");
+}
+
+//The daily schedule runs again after a restart around midnight, a day it adds again replaces the earlier result
+//(in the compact layout a second row for the same device and date would be refused)
+void CSQLHelper::ClearHistoryRow(const char *szTable, const uint64_t DeviceRowID, const char *szDate)
+{
+	safe_query("DELETE FROM [%q] WHERE (DeviceRowID==%" PRIu64 ") AND (Date=='%q')", szTable, DeviceRowID, szDate);
+}
+
 bool CSQLHelper::DoesColumnExistsInTable(const std::string& columnname, const std::string& tablename)
 {
 	if (!m_dbase)
@@ -4720,6 +4873,7 @@ uint64_t CSQLHelper::UpdateValueInt(const int HardwareID, const char* ID, const
 		{
 			return -1;
 		}
+		ScheduleSensorTimeout(ulID, devType, mytime(nullptr));
 
 #ifdef ENABLE_PYTHON
 		//TODO: Plugins should perhaps be blocked from implicitly adding a device by update? It's most likely a bug due to updating a removed device..
@@ -4746,11 +4900,12 @@ uint64_t CSQLHelper::UpdateValueInt(const int HardwareID, const char* ID, const
 		time_t now = time(nullptr);
 		struct tm ltime;
 		localtime_r(&now, &ltime);
+		ScheduleSensorTimeout(ulID, devType, now);
 		//Commit: If Option 1: energy is computed as usage*time
 		//Default is option 0, read from device
 		if (options["EnergyMeterMode"] == "1" && devType == pTypeGeneral && subType == sTypeKwh)
 		{
-			std::vector<std::string> parts;
+			double parts[2];
 			struct tm ntime;
 			double interval;
 			float nEnergy;
@@ -4760,15 +4915,14 @@ uint64_t CSQLHelper::UpdateValueInt(const int HardwareID, const char* ID, const
 			ParseSQLdatetime(lutime, ntime, sLastUpdate, ltime.tm_isdst);
 
 			interval = difftime(now, lutime);
-			StringSplit(old_sValue, ";", parts);
-			if (parts.size() == 2)
+			//parsed like atof, some users seem to have a illegal sValue in the database that causes std::stof to crash
+			if (StringSplitDouble(old_sValue.c_str(), ';', parts, 2) == 2)
 			{
-				//we need to use atof here because some users seem to have a illegal sValue in the database that causes std::stof to crash
-				nEnergy = static_cast<float>(atof(parts[0].c_str()) * interval / 3600 + atof(parts[1].c_str()));
-				StringSplit(sValue, ";", parts);
-				if (!parts.empty())
+				nEnergy = static_cast<float>(parts[0] * interval / 3600 + parts[1]);
+				if (*sValue != 0)
 				{
-					sprintf(sCompValue, "%s;%.1f", parts[0].c_str(), nEnergy);
+					//keep the usage field of the new value as it was sent
+					snprintf(sCompValue, sizeof(sCompValue), "%.*s;%.1f", static_cast<int>(strcspn(sValue, ";")), sValue, nEnergy);
 					old_sValue = sCompValue;
 				}
 			}
@@ -5431,24 +5585,20 @@ bool CSQLHelper::HasTimers(const uint64_t Idx)
 	if (!m_dbase)
 		return false;
 
-	std::vector<std::vector<std::string> > result;
-
-	result = safe_query("SELECT COUNT(*) FROM Timers WHERE (DeviceRowID==%" PRIu64 ") AND (TimerPlan==%d)", Idx, m_ActiveTimerPlan);
-	if (!result.empty())
+	//device listings ask this for every switch, so all devices with timers are loaded at once until the timers change
+	std::lock_guard<std::mutex> l(m_timerdevicesMutex);
+	uint64_t version = GetTableVersion(WTABLE_TIMERS);
+	int timerplan = m_ActiveTimerPlan;
+	if ((version != m_timerdevicesversion) || (timerplan != m_timerdevicesplan))
 	{
-		std::vector<std::string> sd = result[0];
-		int totaltimers = atoi(sd[0].c_str());
-		if (totaltimers > 0)
-			return true;
-	}
-	result = safe_query("SELECT COUNT(*) FROM SetpointTimers WHERE (DeviceRowID==%" PRIu64 ") AND (TimerPlan==%d)", Idx, m_ActiveTimerPlan);
-	if (!result.empty())
-	{
-		std::vector<std::string> sd = result[0];
-		int totaltimers = atoi(sd[0].c_str());
-		return (totaltimers > 0);
+		m_timerdevices.clear();
+		auto result = safe_query("SELECT DeviceRowID FROM Timers WHERE (TimerPlan==%d) UNION SELECT DeviceRowID FROM SetpointTimers WHERE (TimerPlan==%d)", timerplan, timerplan);
+		for (const auto &sd : result)
+			m_timerdevices.insert(std::stoull(sd[0]));
+		m_timerdevicesversion = version;
+		m_timerdevicesplan = timerplan;
 	}
-	return false;
+	return (m_timerdevices.find(Idx) != m_timerdevices.end());
 }
 
 bool CSQLHelper::HasTimers(const std::string& Idx)
@@ -5599,9 +5749,9 @@ void CSQLHelper::UpdateTemperatureLog()
 					continue;
 			}
 
-			std::vector<std::string> splitresults;
-			StringSplit(sValue, ";", splitresults);
-			if (splitresults.empty())
+			_tSValueFields fields;
+			fields.Parse(sValue);
+			if (fields.count == 0)
 				continue; //impossible
 
 			float temp = 0;
@@ -5616,98 +5766,101 @@ void CSQLHelper::UpdateTemperatureLog()
 			case pTypeRego6XXTemp:
 			case pTypeTEMP:
 			case pTypeThermostat:
-				temp = static_cast<float>(atof(splitresults[0].c_str()));
+				temp = static_cast<float>(fields.value[0]);
 				break;
 			case pTypeThermostat1:
-				temp = static_cast<float>(atof(splitresults[0].c_str()));
+				temp = static_cast<float>(fields.value[0]);
 				break;
 			case pTypeRadiator1:
-				temp = static_cast<float>(atof(splitresults[0].c_str()));
+				temp = static_cast<float>(fields.value[0]);
 				break;
 			case pTypeEvohomeWater:
-				if (splitresults.size() >= 2)
+				if (fields.count >= 2)
 				{
-					temp = static_cast<float>(atof(splitresults[0].c_str()));
+					temp = static_cast<float>(fields.value[0]);
+					//the setpoint field can also hold the state of the hot water
+					std::vector<std::string> splitresults;
+					StringSplit(sValue, ";", splitresults);
 					if (splitresults[1] == "On")
 						setpoint = 60;
 					else if (splitresults[1] == "Off")
 						setpoint = 0;
 					else
-						setpoint = static_cast<float>(atof(splitresults[1].c_str()));
+						setpoint = static_cast<float>(fields.value[1]);
 				}
 				break;
 			case pTypeEvohomeZone:
-				if (splitresults.size() >= 2)
+				if (fields.count >= 2)
 				{
-					temp = static_cast<float>(atof(splitresults[0].c_str()));
-					setpoint = static_cast<float>(atof(splitresults[1].c_str()));
+					temp = static_cast<float>(fields.value[0]);
+					setpoint = static_cast<float>(fields.value[1]);
 				}
 				break;
 			case pTypeHUM:
 				humidity = nValue;
 				break;
 			case pTypeTEMP_HUM:
-				if (splitresults.size() >= 2)
+				if (fields.count >= 2)
 				{
-					temp = static_cast<float>(atof(splitresults[0].c_str()));
-					humidity = atoi(splitresults[1].c_str());
+					temp = static_cast<float>(fields.value[0]);
+					humidity = static_cast<int>(fields.value[1]);
 					dewpoint = (float)CalculateDewPoint(temp, humidity);
 				}
 				break;
 			case pTypeTEMP_HUM_BARO:
-				if (splitresults.size() == 5)
+				if (fields.count == 5)
 				{
-					temp = static_cast<float>(atof(splitresults[0].c_str()));
-					humidity = atoi(splitresults[1].c_str());
+					temp = static_cast<float>(fields.value[0]);
+					humidity = static_cast<int>(fields.value[1]);
 					if (dSubType == sTypeTHBFloat)
-						barometer = int(atof(splitresults[3].c_str()) * 10.0F);
+						barometer = int(fields.value[3] * 10.0F);
 					else
-						barometer = atoi(splitresults[3].c_str());
+						barometer = static_cast<int>(fields.value[3]);
 					dewpoint = (float)CalculateDewPoint(temp, humidity);
 				}
 				break;
 			case pTypeTEMP_BARO:
-				if (splitresults.size() >= 2)
+				if (fields.count >= 2)
 				{
-					temp = static_cast<float>(atof(splitresults[0].c_str()));
-					barometer = int(atof(splitresults[1].c_str()) * 10.0F);
+					temp = static_cast<float>(fields.value[0]);
+					barometer = int(fields.value[1] * 10.0F);
 				}
 				break;
 			case pTypeUV:
 				if (dSubType != sTypeUV3)
 					continue;
-				if (splitresults.size() >= 2)
+				if (fields.count >= 2)
 				{
-					temp = static_cast<float>(atof(splitresults[1].c_str()));
+					temp = static_cast<float>(fields.value[1]);
 				}
 				break;
 			case pTypeWIND:
 				if (dSubType == sTypeWINDNoTempNoChill)
 					continue;
-				if (splitresults.size() >= 6)
+				if (fields.count >= 6)
 				{
 					if (dSubType != sTypeWINDNoTemp)
 					{
-						temp = static_cast<float>(atof(splitresults[4].c_str()));
+						temp = static_cast<float>(fields.value[4]);
 					}
-					chill = static_cast<float>(atof(splitresults[5].c_str()));
+					chill = static_cast<float>(fields.value[5]);
 				}
 				break;
 			case pTypeRFXSensor:
 				if (dSubType != sTypeRFXSensorTemp)
 					continue;
-				temp = static_cast<float>(atof(splitresults[0].c_str()));
+				temp = static_cast<float>(fields.value[0]);
 				break;
 			case pTypeGeneral:
 				if (dSubType == sTypeSystemTemp)
 				{
-					temp = static_cast<float>(atof(splitresults[0].c_str()));
+					temp = static_cast<float>(fields.value[0]);
 				}
 				else if (dSubType == sTypeBaro)
 				{
-					if (splitresults.size() != 2)
+					if (fields.count != 2)
 						continue;
-					barometer = int(atof(splitresults[0].c_str()) * 10.0F);
+					barometer = int(fields.value[0] * 10.0F);
 				}
 				break;
 			}
@@ -5759,13 +5912,13 @@ void CSQLHelper::UpdateRainLog()
 			if (difftime(now, checktime) >= SensorTimeOut * 60)
 				continue;
 
-			std::vector<std::string> splitresults;
-			StringSplit(sValue, ";", splitresults);
-			if (splitresults.size() < 2)
+			_tSValueFields fields;
+			fields.Parse(sValue);
+			if (fields.count < 2)
 				continue; //impossible
 
-			int rate = atoi(splitresults[0].c_str());
-			float total = static_cast<float>(atof(splitresults[1].c_str()));
+			int rate = static_cast<int>(fields.value[0]);
+			float total = static_cast<float>(fields.value[1]);
 
 			//insert record
 			safe_query(
@@ -5816,15 +5969,15 @@ void CSQLHelper::UpdateWindLog()
 			if (difftime(now, checktime) >= SensorTimeOut * 60)
 				continue;
 
-			std::vector<std::string> splitresults;
-			StringSplit(sValue, ";", splitresults);
-			if (splitresults.size() < 4)
+			_tSValueFields fields;
+			fields.Parse(sValue);
+			if (fields.count < 4)
 				continue; //impossible
 
-			float direction = static_cast<float>(atof(splitresults[0].c_str()));
+			float direction = static_cast<float>(fields.value[0]);
 
-			int speed = atoi(splitresults[2].c_str());
-			int gust = atoi(splitresults[3].c_str());
+			int speed = static_cast<int>(fields.value[2]);
+			int gust = static_cast<int>(fields.value[3]);
 
 			auto ittWC = m_mainworker.m_wind_calculator.find(DeviceID);
 			if (ittWC != m_mainworker.m_wind_calculator.end())
@@ -5885,12 +6038,12 @@ void CSQLHelper::UpdateUVLog()
 			if (difftime(now, checktime) >= SensorTimeOut * 60)
 				continue;
 
-			std::vector<std::string> splitresults;
-			StringSplit(sValue, ";", splitresults);
-			if (splitresults.empty())
+			_tSValueFields fields;
+			fields.Parse(sValue);
+			if (fields.count == 0)
 				continue; //impossible
 
-			float level = static_cast<float>(atof(splitresults[0].c_str()));
+			float level = static_cast<float>(fields.value[0]);
 
 			//insert record
 			safe_query(
@@ -6262,16 +6415,15 @@ void CSQLHelper::UpdateMeter()
 			}
 			else if ((dType == pTypeGeneral) && (dSubType == sTypeKwh))
 			{
-				std::vector<std::string> splitresults;
-				StringSplit(sValue, ";", splitresults);
-				if (splitresults.size() < 2)
+				double fValues[2];
+				if (StringSplitDouble(sValue.c_str(), ';', fValues, 2) < 2)
 					continue;
 
-				double fValue = atof(splitresults[0].c_str()) * 10.0F;
+				double fValue = fValues[0] * 10.0F;
 				sprintf(szTmp, "%.0f", fValue);
 				sUsage = szTmp;
 
-				fValue = atof(splitresults[1].c_str());
+				fValue = fValues[1];
 				sprintf(szTmp, "%.0f", fValue);
 				sValue = szTmp;
 			}
@@ -6510,9 +6662,7 @@ void CSQLHelper::UpdatePercentageLog()
 			if (difftime(now, checktime) >= SensorTimeOut * 60)
 				continue;
 
-			std::vector<std::string> splitresults;
-			StringSplit(sValue, ";", splitresults);
-			if (splitresults.empty())
+			if (sValue.empty())
 				continue; //impossible
 
 			float percentage = static_cast<float>(atof(sValue.c_str()));
@@ -6563,9 +6713,7 @@ void CSQLHelper::UpdateFanLog()
 			if (difftime(now, checktime) >= SensorTimeOut * 60)
 				continue;
 
-			std::vector<std::string> splitresults;
-			StringSplit(sValue, ";", splitresults);
-			if (splitresults.empty())
+			if (sValue.empty())
 				continue; //impossible
 
 			int speed = (int)atoi(sValue.c_str());
@@ -6628,6 +6776,7 @@ void CSQLHelper::AddCalendarTemperature()
 			float setpoint_min = static_cast<float>(atof(sd[8].c_str()));
 			float setpoint_max = static_cast<float>(atof(sd[9].c_str()));
 			float setpoint_avg = static_cast<float>(atof(sd[10].c_str()));
+			ClearHistoryRow("Temperature_Calendar", ID, szDateStart);
 			result = safe_query(
 				"INSERT INTO Temperature_Calendar (DeviceRowID, Temp_Min, Temp_Max, Temp_Avg, Chill_Min, Chill_Max, Humidity, Barometer, DewPoint, SetPoint_Min, SetPoint_Max, SetPoint_Avg, Date) "
 				"VALUES ('%" PRIu64 "', '%.2f', '%.2f', '%.2f', '%.2f', '%.2f', '%d', '%d', '%.2f', '%.2f', '%.2f', '%.2f', '%q')",
@@ -6686,7 +6835,7 @@ void CSQLHelper::AddCalendarUpdateRain()
 
 		if (subType == sTypeRAINWU || subType == sTypeRAINByRate)
 		{
-			result = safe_query("SELECT Total, Total, Rate FROM Rain WHERE (DeviceRowID='%" PRIu64 "' AND Date>='%q' AND Date<='%q 00:00:00') ORDER BY ROWID DESC LIMIT 1",
+			result = safe_query("SELECT Total, Total, Rate FROM Rain WHERE (DeviceRowID='%" PRIu64 "' AND Date>='%q' AND Date<='%q 00:00:00') ORDER BY Date DESC LIMIT 1",
 				ID,
 				szDateStart,
 				szDateEnd
@@ -6721,6 +6870,7 @@ void CSQLHelper::AddCalendarUpdateRain()
 
 			if (total_real < 1000)
 			{
+				ClearHistoryRow("Rain_Calendar", ID, szDateStart);
 				result = safe_query(
 					"INSERT INTO Rain_Calendar (DeviceRowID, Total, Rate, Date) "
 					"VALUES ('%" PRIu64 "', '%.2f', '%d', '%q')",
@@ -6871,6 +7021,7 @@ void CSQLHelper::AddCalendarUpdateMeter()
 				double total_real = total_max - total_min;
 				double counter = total_max;
 
+				ClearHistoryRow("Meter_Calendar", ID, szDateStart);
 				result = safe_query(
 					"INSERT INTO Meter_Calendar (DeviceRowID, Value, Counter, Date) "
 					"VALUES ('%" PRIu64 "', '%.2f', '%.2f', '%q')",
@@ -6914,6 +7065,7 @@ void CSQLHelper::AddCalendarUpdateMeter()
 			else
 			{
 				//AirQuality/Usage Meter/Moisture/RFXSensor/Voltage/Lux/SoundLevel insert into MultiMeter_Calendar table
+				ClearHistoryRow("MultiMeter_Calendar", ID, szDateStart);
 				result = safe_query("INSERT INTO MultiMeter_Calendar (DeviceRowID, Value1,Value2,Value3,Value4,Value5,Value6, Date) "
 						    "VALUES ('%" PRIu64 "', '%.2f','%.2f','%.2f','%.2f','%.2f','%.2f', '%q')",
 						    ID, total_min, total_max, avg_value, 0.0F, 0.0F, 0.0F, szDateStart);
@@ -6934,11 +7086,12 @@ void CSQLHelper::AddCalendarUpdateMeter()
 				(devType != pTypeWEIGHT)
 				)
 			{
-				result = safe_query("SELECT Value FROM Meter WHERE (DeviceRowID='%" PRIu64 "') ORDER BY ROWID DESC LIMIT 1", ID);
+				result = safe_query("SELECT Value FROM Meter WHERE (DeviceRowID='%" PRIu64 "') ORDER BY Date DESC LIMIT 1", ID);
 				if (!result.empty())
 				{
 					std::vector<std::string> sd = result[0];
 					//Insert the last (max) counter value into the meter table to get the "today" value correct.
+					ClearHistoryRow("Meter", ID, szDateEnd);
 					result = safe_query(
 						"INSERT INTO Meter (DeviceRowID, Value, Date) "
 						"VALUES ('%" PRIu64 "', '%q', '%q')",
@@ -6952,6 +7105,7 @@ void CSQLHelper::AddCalendarUpdateMeter()
 		else
 		{
 			//no new meter result received in last day
+			ClearHistoryRow("Meter_Calendar", ID, szDateStart);
 			result = safe_query("INSERT INTO Meter_Calendar (DeviceRowID, Value, Date) "
 					    "VALUES ('%" PRIu64 "', '%.2f', '%q')",
 					    ID, 0.0F, szDateStart);
@@ -7054,6 +7208,7 @@ void CSQLHelper::AddCalendarUpdateMultiMeter()
 				}
 			}
 
+			ClearHistoryRow("MultiMeter_Calendar", ID, szDateStart);
 			result = safe_query(
 				"INSERT INTO MultiMeter_Calendar (DeviceRowID, Value1, Value2, Value3, Value4, Value5, Value6, Counter1, Counter2, Counter3, Counter4, Date) "
 				"VALUES ('%" PRIu64 "', '%.2f', '%.2f', '%.2f', '%.2f', '%.2f', '%.2f', '%.2f', '%.2f', '%.2f', '%.2f', '%q')",
@@ -7139,6 +7294,7 @@ void CSQLHelper::AddCalendarUpdateWind()
 			int gust_min = atoi(sd[3].c_str());
 			int gust_max = atoi(sd[4].c_str());
 
+			ClearHistoryRow("Wind_Calendar", ID, szDateStart);
 			result = safe_query(
 				"INSERT INTO Wind_Calendar (DeviceRowID, Direction, Speed_Min, Speed_Max, Gust_Min, Gust_Max, Date) "
 				"VALUES ('%" PRIu64 "', '%.2f', '%d', '%d', '%d', '%d', '%q')",
@@ -7192,6 +7348,7 @@ void CSQLHelper::AddCalendarUpdateUV()
 
 			float level = static_cast<float>(atof(sd[0].c_str()));
 
+			ClearHistoryRow("UV_Calendar", ID, szDateStart);
 			result = safe_query(
 				"INSERT INTO UV_Calendar (DeviceRowID, Level, Date) "
 				"VALUES ('%" PRIu64 "', '%g', '%q')",
@@ -7242,6 +7399,7 @@ void CSQLHelper::AddCalendarUpdatePercentage()
 			float percentage_min = static_cast<float>(atof(sd[0].c_str()));
 			float percentage_max = static_cast<float>(atof(sd[1].c_str()));
 			float percentage_avg = static_cast<float>(atof(sd[2].c_str()));
+			ClearHistoryRow("Percentage_Calendar", ID, szDateStart);
 			result = safe_query(
 				"INSERT INTO Percentage_Calendar (DeviceRowID, Percentage_Min, Percentage_Max, Percentage_Avg, Date) "
 				"VALUES ('%" PRIu64 "', '%g', '%g', '%g','%q')",
@@ -7294,6 +7452,7 @@ void CSQLHelper::AddCalendarUpdateFan()
 			int speed_min = (int)atoi(sd[0].c_str());
 			int speed_max = (int)atoi(sd[1].c_str());
 			int speed_avg = (int)atoi(sd[2].c_str());
+			ClearHistoryRow("Fan_Calendar", ID, szDateStart);
 			result = safe_query(
 				"INSERT INTO Fan_Calendar (DeviceRowID, Speed_Min, Speed_Max, Speed_Avg, Date) "
 				"VALUES ('%" PRIu64 "', '%d', '%d', '%d','%q')",
@@ -7383,9 +7542,7 @@ void CSQLHelper::OptimizeDatabase(sqlite3* dbase)
 
 void CSQLHelper::DeleteHardware(const std::string& idx)
 {
-	safe_query("DELETE FROM Hardware WHERE (ID == '%q')", idx.c_str());
-
-	//and now delete all records in the DeviceStatus table itself
+	//delete all records in the DeviceStatus table itself
 	std::vector<std::vector<std::string> > result;
 	result = safe_query("SELECT ID FROM DeviceStatus WHERE (HardwareID == '%q')", idx.c_str());
 	if (!result.empty())
@@ -7399,11 +7556,18 @@ void CSQLHelper::DeleteHardware(const std::string& idx)
 		}
 		DeleteDevices(devs2delete);
 	}
-	//also delete all records in other tables
-	safe_query("DELETE FROM ZWaveNodes WHERE (HardwareID== '%q')", idx.c_str());
-	safe_query("DELETE FROM EnoceanSensors WHERE (HardwareID== '%q')", idx.c_str());
-	safe_query("DELETE FROM MySensors WHERE (HardwareID== '%q')", idx.c_str());
-	safe_query("DELETE FROM WOLNodes WHERE (HardwareID == '%q')", idx.c_str());
+	std::lock_guard<std::mutex> l(m_sqlQueryMutex);
+	DeleteHardwareRows(idx);
+}
+
+//The hardware and its records in other tables, the caller holds m_sqlQueryMutex
+void CSQLHelper::DeleteHardwareRows(const std::string& idx)
+{
+	safe_exec_no_return("DELETE FROM Hardware WHERE (ID == '%q')", idx.c_str());
+	safe_exec_no_return("DELETE FROM ZWaveNodes WHERE (HardwareID== '%q')", idx.c_str());
+	safe_exec_no_return("DELETE FROM EnoceanSensors WHERE (HardwareID== '%q')", idx.c_str());
+	safe_exec_no_return("DELETE FROM MySensors WHERE (HardwareID== '%q')", idx.c_str());
+	safe_exec_no_return("DELETE FROM WOLNodes WHERE (HardwareID == '%q')", idx.c_str());
 }
 
 void CSQLHelper::DeleteCamera(const std::string& idx)
@@ -7423,6 +7587,41 @@ void CSQLHelper::DeleteEvent(const std::string& idx)
 	safe_query("DELETE FROM EventMaster WHERE (ID == '%q')", idx.c_str());
 }
 
+//A device and its history, without a transaction of its own or notifications, the caller holds m_sqlQueryMutex
+void CSQLHelper::DeleteDeviceRows(const std::string& idx)
+{
+	safe_exec_no_return("DELETE FROM LightingLog WHERE (DeviceRowID == '%q')", idx.c_str());
+	safe_exec_no_return("DELETE FROM LightSubDevices WHERE (ParentID == '%q')", idx.c_str());
+	safe_exec_no_return("DELETE FROM LightSubDevices WHERE (DeviceRowID == '%q')", idx.c_str());
+	safe_exec_no_return("DELETE FROM Notifications WHERE (DeviceRowID == '%q')", idx.c_str());
+	safe_exec_no_return("DELETE FROM Rain WHERE (DeviceRowID == '%q')", idx.c_str());
+	safe_exec_no_return("DELETE FROM Rain_Calendar WHERE (DeviceRowID == '%q')", idx.c_str());
+	safe_exec_no_return("DELETE FROM Temperature WHERE (DeviceRowID == '%q')", idx.c_str());
+	safe_exec_no_return("DELETE FROM Temperature_Calendar WHERE (DeviceRowID == '%q')", idx.c_str());
+	safe_exec_no_return("DELETE FROM Timers WHERE (DeviceRowID == '%q')", idx.c_str());
+	safe_exec_no_return("DELETE FROM SetpointTimers WHERE (DeviceRowID == '%q')", idx.c_str());
+	safe_exec_no_return("DELETE FROM UV WHERE (DeviceRowID == '%q')", idx.c_str());
+	safe_exec_no_return("DELETE FROM UV_Calendar WHERE (DeviceRowID == '%q')", idx.c_str());
+	safe_exec_no_return("DELETE FROM Wind WHERE (DeviceRowID == '%q')", idx.c_str());
+	safe_exec_no_return("DELETE FROM Wind_Calendar WHERE (DeviceRowID == '%q')", idx.c_str());
+	safe_exec_no_return("DELETE FROM Meter WHERE (DeviceRowID == '%q')", idx.c_str());
+	safe_exec_no_return("DELETE FROM Meter_Calendar WHERE (DeviceRowID == '%q')", idx.c_str());
+	safe_exec_no_return("DELETE FROM MultiMeter WHERE (DeviceRowID == '%q')", idx.c_str());
+	safe_exec_no_return("DELETE FROM MultiMeter_Calendar WHERE (DeviceRowID == '%q')", idx.c_str());
+	safe_exec_no_return("DELETE FROM Percentage WHERE (DeviceRowID == '%q')", idx.c_str());
+	safe_exec_no_return("DELETE FROM Percentage_Calendar WHERE (DeviceRowID == '%q')", idx.c_str());
+	safe_exec_no_return("DELETE FROM Fan WHERE (DeviceRowID == '%q')", idx.c_str());
+	safe_exec_no_return("DELETE FROM Fan_Calendar WHERE (DeviceRowID == '%q')", idx.c_str());
+	safe_exec_no_return("DELETE FROM SceneDevices WHERE (DeviceRowID == '%q')", idx.c_str());
+	safe_exec_no_return("DELETE FROM DeviceToPlansMap WHERE (DeviceRowID == '%q')", idx.c_str());
+	safe_exec_no_return("DELETE FROM CamerasActiveDevices WHERE (DevSceneType==0) AND (DevSceneRowID == '%q')",
+				idx.c_str());
+	safe_exec_no_return("DELETE FROM SharedDevices WHERE (DeviceRowID== '%q')", idx.c_str());
+	safe_exec_no_return("DELETE FROM PushLink WHERE (DeviceRowID== '%q')", idx.c_str());
+	//and now delete all records in the DeviceStatus table itself
+	safe_exec_no_return("DELETE FROM DeviceStatus WHERE (ID == '%q')", idx.c_str());
+}
+
 //Argument, one or multiple devices separated by a semicolumn (;)
 void CSQLHelper::DeleteDevices(const std::string& idx)
 {
@@ -7460,42 +7659,15 @@ void CSQLHelper::DeleteDevices(const std::string& idx)
 
 		for (const auto &str : _idx)
 		{
-			safe_exec_no_return("DELETE FROM LightingLog WHERE (DeviceRowID == '%q')", str.c_str());
-			safe_exec_no_return("DELETE FROM LightSubDevices WHERE (ParentID == '%q')", str.c_str());
-			safe_exec_no_return("DELETE FROM LightSubDevices WHERE (DeviceRowID == '%q')", str.c_str());
-			safe_exec_no_return("DELETE FROM Notifications WHERE (DeviceRowID == '%q')", str.c_str());
-			safe_exec_no_return("DELETE FROM Rain WHERE (DeviceRowID == '%q')", str.c_str());
-			safe_exec_no_return("DELETE FROM Rain_Calendar WHERE (DeviceRowID == '%q')", str.c_str());
-			safe_exec_no_return("DELETE FROM Temperature WHERE (DeviceRowID == '%q')", str.c_str());
-			safe_exec_no_return("DELETE FROM Temperature_Calendar WHERE (DeviceRowID == '%q')", str.c_str());
-			safe_exec_no_return("DELETE FROM Timers WHERE (DeviceRowID == '%q')", str.c_str());
-			safe_exec_no_return("DELETE FROM SetpointTimers WHERE (DeviceRowID == '%q')", str.c_str());
-			safe_exec_no_return("DELETE FROM UV WHERE (DeviceRowID == '%q')", str.c_str());
-			safe_exec_no_return("DELETE FROM UV_Calendar WHERE (DeviceRowID == '%q')", str.c_str());
-			safe_exec_no_return("DELETE FROM Wind WHERE (DeviceRowID == '%q')", str.c_str());
-			safe_exec_no_return("DELETE FROM Wind_Calendar WHERE (DeviceRowID == '%q')", str.c_str());
-			safe_exec_no_return("DELETE FROM Meter WHERE (DeviceRowID == '%q')", str.c_str());
-			safe_exec_no_return("DELETE FROM Meter_Calendar WHERE (DeviceRowID == '%q')", str.c_str());
-			safe_exec_no_return("DELETE FROM MultiMeter WHERE (DeviceRowID == '%q')", str.c_str());
-			safe_exec_no_return("DELETE FROM MultiMeter_Calendar WHERE (DeviceRowID == '%q')", str.c_str());
-			safe_exec_no_return("DELETE FROM Percentage WHERE (DeviceRowID == '%q')", str.c_str());
-			safe_exec_no_return("DELETE FROM Percentage_Calendar WHERE (DeviceRowID == '%q')", str.c_str());
-			safe_exec_no_return("DELETE FROM Fan WHERE (DeviceRowID == '%q')", str.c_str());
-			safe_exec_no_return("DELETE FROM Fan_Calendar WHERE (DeviceRowID == '%q')", str.c_str());
-			safe_exec_no_return("DELETE FROM SceneDevices WHERE (DeviceRowID == '%q')", str.c_str());
-			safe_exec_no_return("DELETE FROM DeviceToPlansMap WHERE (DeviceRowID == '%q')", str.c_str());
-			safe_exec_no_return("DELETE FROM CamerasActiveDevices WHERE (DevSceneType==0) AND (DevSceneRowID == '%q')",
-						str.c_str());
-			safe_exec_no_return("DELETE FROM SharedDevices WHERE (DeviceRowID== '%q')", str.c_str());
-			safe_exec_no_return("DELETE FROM PushLink WHERE (DeviceRowID== '%q')", str.c_str());
+			DeleteDeviceRows(str);
 			//notify eventsystem device is no longer present
 			uint64_t ullidx = std::stoull(str);
 			m_mainworker.m_eventsystem.RemoveSingleState(ullidx, m_mainworker.m_eventsystem.REASON_DEVICE);
-			//and now delete all records in the DeviceStatus table itself
-			safe_exec_no_return("DELETE FROM DeviceStatus WHERE (ID == '%q')", str.c_str());
 		}
 		sqlite3_exec(m_dbase, "COMMIT TRANSACTION", nullptr, nullptr, &errorMessage);
 	}
+	m_webservers.ReloadSharedDevices();
+	InvalidateSceneStatus();
 #ifdef ENABLE_PYTHON
 	for (const auto& it : removeddevices)
 	{
@@ -7543,6 +7715,8 @@ void CSQLHelper::DeleteScenes(const std::string& idx)
 		sqlite3_exec(m_dbase, "COMMIT TRANSACTION", nullptr, nullptr, &errorMessage);
 	}
 
+	InvalidateSceneStatus();
+	m_mainworker.ReloadSceneActivators();
 	m_notifications.ReloadNotifications();
 }
 
@@ -7556,6 +7730,7 @@ void CSQLHelper::TransferDevice(const std::string& idx, const std::string& newid
 	safe_query("UPDATE Notifications SET DeviceRowID='%q' WHERE (DeviceRowID == '%q')", newidx.c_str(), idx.c_str());
 	safe_query("UPDATE DeviceToPlansMap SET DeviceRowID='%q' WHERE (DeviceRowID == '%q')", newidx.c_str(), idx.c_str());
 	safe_query("UPDATE SharedDevices SET DeviceRowID='%q' WHERE (DeviceRowID == '%q')", newidx.c_str(), idx.c_str());
+	m_webservers.ReloadSharedDevices();
 	safe_query("UPDATE Timers SET DeviceRowID='%q' WHERE (DeviceRowID == '%q')", newidx.c_str(), idx.c_str());
 
 	//Rain
@@ -7730,15 +7905,128 @@ void CSQLHelper::CheckSceneStatusWithDevice(const std::string& DevIdx)
 	return CheckSceneStatusWithDevice(idxll);
 }
 
-void CSQLHelper::CheckSceneStatusWithDevice(const uint64_t DevIdx)
+static bool IsSceneMemberOn(const std::string &sType, const std::string &sSubType, const std::string &sSwitchType, const std::string &snValue, const std::string &sValue)
+{
+	std::string lstatus;
+	int llevel = 0;
+	bool bHaveDimmer = false;
+	bool bHaveGroupCmd = false;
+	int maxDimLevel = 0;
+
+	GetLightStatus((unsigned char)atoi(sType.c_str()), (unsigned char)atoi(sSubType.c_str()), (_eSwitchType)atoi(sSwitchType.c_str()), atoi(snValue.c_str()), sValue, lstatus, llevel,
+		       bHaveDimmer, maxDimLevel, bHaveGroupCmd);
+	return IsLightSwitchOn(lstatus);
+}
+
+static int GetSceneStatusValue(const size_t totOn, const size_t totMembers)
+{
+	if (totOn == totMembers)
+		return 1; //All are on
+	if (totOn == 0)
+		return 0; //All are Off
+	return 2; //Some are on, some are off
+}
+
+//Load the members of all Scenes/Groups with their current on/off state
+//m_scenestatusMutex should be locked by the caller
+void CSQLHelper::LoadSceneStatus()
 {
+	m_devicescenes.clear();
+	m_scenestatus.clear();
+
 	std::vector<std::vector<std::string> > result;
+	result = safe_query("SELECT ID, nValue FROM Scenes");
+	for (const auto &sd : result)
+		m_scenestatus[std::stoull(sd[0])].nValue = atoi(sd[1].c_str());
 
-	result = safe_query("SELECT SceneRowID FROM SceneDevices WHERE (DeviceRowID == %" PRIu64 ")", DevIdx);
+	result = safe_query("SELECT DISTINCT b.SceneRowID, a.ID, a.Type, a.SubType, a.SwitchType, a.nValue, a.sValue FROM DeviceStatus AS a, SceneDevices as b WHERE (a.ID == b.DeviceRowID)");
 	for (const auto &sd : result)
 	{
-		CheckSceneStatus(sd[0]);
+		uint64_t SceneIdx = std::stoull(sd[0]);
+		uint64_t DevIdx = std::stoull(sd[1]);
+		auto itt = m_scenestatus.find(SceneIdx);
+		if (itt == m_scenestatus.end())
+			continue; //scene was deleted
+		if (itt->second.Members.find(DevIdx) != itt->second.Members.end())
+			continue; //device is added multiple times
+		bool bOn = IsSceneMemberOn(sd[2], sd[3], sd[4], sd[5], sd[6]);
+		itt->second.Members[DevIdx] = bOn;
+		if (bOn)
+			itt->second.totOn++;
+		m_devicescenes[DevIdx].push_back(SceneIdx);
+	}
+	m_bSceneStatusLoaded = true;
+}
+
+//Should be called when Scene/Group members are added or removed
+void CSQLHelper::InvalidateSceneStatus()
+{
+	std::lock_guard<std::mutex> l(m_scenestatusMutex);
+	m_bSceneStatusLoaded = false;
+	m_devicescenes.clear();
+	m_scenestatus.clear();
+}
+
+//The Scene/Group was switched, remember its new value
+void CSQLHelper::SetSceneStatusValue(const uint64_t Idx, const int nValue)
+{
+	std::lock_guard<std::mutex> l(m_scenestatusMutex);
+	auto itt = m_scenestatus.find(Idx);
+	if (itt != m_scenestatus.end())
+		itt->second.nValue = nValue;
+}
+
+void CSQLHelper::SetSceneStatus(const uint64_t Idx, const int nValue)
+{
+	safe_query("UPDATE Scenes SET nValue=%d WHERE (ID == %" PRIu64 ")", nValue, Idx);
+	if (m_sql.m_bEnableEventSystem)  // Only when eventSystem is active
+		m_mainworker.m_eventsystem.UpdateSceneGroupStatus(Idx, nValue);
+}
+
+//A device was updated, only the Scenes/Groups it belongs to are updated with its new state
+void CSQLHelper::CheckSceneStatusWithDevice(const uint64_t DevIdx)
+{
+	std::vector<std::pair<uint64_t, int>> changedScenes;
+	{
+		std::lock_guard<std::mutex> l(m_scenestatusMutex);
+		if (!m_bSceneStatusLoaded)
+			LoadSceneStatus();
+
+		auto ittDevice = m_devicescenes.find(DevIdx);
+		if (ittDevice == m_devicescenes.end())
+			return; //not a member of any Scene/Group
+
+		std::vector<std::vector<std::string> > result;
+		result = safe_query("SELECT Type, SubType, SwitchType, nValue, sValue FROM DeviceStatus WHERE (ID == %" PRIu64 ")", DevIdx);
+		if (result.empty())
+			return;
+		const std::vector<std::string> &sd = result[0];
+		bool bOn = IsSceneMemberOn(sd[0], sd[1], sd[2], sd[3], sd[4]);
+
+		for (const auto SceneIdx : ittDevice->second)
+		{
+			_tSceneStatus &status = m_scenestatus[SceneIdx];
+			auto ittMember = status.Members.find(DevIdx);
+			if (ittMember == status.Members.end())
+				continue;
+			if (ittMember->second != bOn)
+			{
+				ittMember->second = bOn;
+				if (bOn)
+					status.totOn++;
+				else
+					status.totOn--;
+			}
+			int newValue = GetSceneStatusValue(status.totOn, status.Members.size());
+			if (newValue != status.nValue)
+			{
+				status.nValue = newValue;
+				changedScenes.push_back(std::make_pair(SceneIdx, newValue));
+			}
+		}
 	}
+	for (const auto &itt : changedScenes)
+		SetSceneStatus(itt.first, itt.second);
 }
 
 void CSQLHelper::CheckSceneStatus(const std::string& Idx)
@@ -7747,6 +8035,7 @@ void CSQLHelper::CheckSceneStatus(const std::string& Idx)
 	return CheckSceneStatus(idxll);
 }
 
+//Recalculate the status of a Scene/Group from all its members
 void CSQLHelper::CheckSceneStatus(const uint64_t Idx)
 {
 	std::vector<std::vector<std::string> > result;
@@ -7755,68 +8044,36 @@ void CSQLHelper::CheckSceneStatus(const uint64_t Idx)
 	if (result.empty())
 		return; //not found
 
-	unsigned char orgValue = (unsigned char)atoi(result[0][0].c_str());
-	unsigned char newValue = orgValue;
+	int orgValue = atoi(result[0][0].c_str());
 
-	result = safe_query("SELECT a.ID, a.DeviceID, a.Unit, a.Type, a.SubType, a.SwitchType, a.nValue, a.sValue FROM DeviceStatus AS a, SceneDevices as b WHERE (a.ID == b.DeviceRowID) AND (b.SceneRowID == %" PRIu64 ")",
+	result = safe_query("SELECT a.ID, a.Type, a.SubType, a.SwitchType, a.nValue, a.sValue FROM DeviceStatus AS a, SceneDevices as b WHERE (a.ID == b.DeviceRowID) AND (b.SceneRowID == %" PRIu64 ")",
 		Idx);
 	if (result.empty())
 		return; //no devices in scene
 
-	std::vector<bool> _DeviceStatusResults;
-
+	_tSceneStatus status;
 	for (const auto &sd : result)
 	{
-		int nValue = atoi(sd[6].c_str());
-		std::string sValue = sd[7];
-		//unsigned char Unit=atoi(sd[2].c_str());
-		unsigned char dType = atoi(sd[3].c_str());
-		unsigned char dSubType = atoi(sd[4].c_str());
-		_eSwitchType switchtype = (_eSwitchType)atoi(sd[5].c_str());
-
-		std::string lstatus;
-		int llevel = 0;
-		bool bHaveDimmer = false;
-		bool bHaveGroupCmd = false;
-		int maxDimLevel = 0;
-
-		GetLightStatus(dType, dSubType, switchtype, nValue, sValue, lstatus, llevel, bHaveDimmer, maxDimLevel, bHaveGroupCmd);
-		_DeviceStatusResults.push_back(IsLightSwitchOn(lstatus));
+		bool bOn = IsSceneMemberOn(sd[1], sd[2], sd[3], sd[4], sd[5]);
+		uint64_t DevIdx = std::stoull(sd[0]);
+		if (status.Members.find(DevIdx) != status.Members.end())
+			continue;
+		status.Members[DevIdx] = bOn;
+		if (bOn)
+			status.totOn++;
 	}
+	status.nValue = GetSceneStatusValue(status.totOn, status.Members.size());
 
-	//Check if all on/off
-	size_t totOn = 0;
-	size_t totOff = 0;
-
-	for (const auto &r : _DeviceStatusResults)
-	{
-		if (r == true)
-			totOn++;
-		else
-			totOff++;
-	}
-	if (totOn == _DeviceStatusResults.size())
-	{
-		//All are on
-		newValue = 1;
-	}
-	else if (totOff == _DeviceStatusResults.size())
 	{
-		//All are Off
-		newValue = 0;
+		std::lock_guard<std::mutex> l(m_scenestatusMutex);
+		if (m_bSceneStatusLoaded)
+			m_scenestatus[Idx] = status;
 	}
-	else
-	{
-		//Some are on, some are off
-		newValue = 2;
-	}
-	if (newValue != orgValue)
+
+	if (status.nValue != orgValue)
 	{
 		//Set new Scene status
-		safe_query("UPDATE Scenes SET nValue=%d WHERE (ID == %" PRIu64 ")",
-			int(newValue), Idx);
-		if (m_sql.m_bEnableEventSystem)  // Only when eventSystem is active
-			m_mainworker.m_eventsystem.GetCurrentScenesGroups();
+		SetSceneStatus(Idx, status.nValue);
 	}
 }
 
@@ -8005,36 +8262,63 @@ bool CSQLHelper::BackupDatabase(const std::string& OutputFile)
 	if (!m_dbase)
 		return false; //database not open!
 
-	//First cleanup the database
-	OptimizeDatabase(m_dbase);
-	VacuumDatabase();
+	//In WAL mode the backup reads a snapshot through its own connection,
+	//so queries, inserts and the event system can continue while the pages are copied
+	sqlite3* pSource = nullptr;
+	bool bSnapshot = false;
+	std::string journal_mode = m_journal_mode;
+	stdlower(journal_mode);
+	if (journal_mode == "wal")
+	{
+		if (sqlite3_open_v2(m_dbase_name.c_str(), &pSource, SQLITE_OPEN_READONLY, nullptr) == SQLITE_OK)
+		{
+			sqlite3_busy_timeout(pSource, 1000);
+			//keep the read transaction open for the whole backup, changes made by other connections would otherwise restart it
+			bSnapshot = (sqlite3_exec(pSource, "BEGIN; SELECT COUNT(*) FROM sqlite_master;", nullptr, nullptr, nullptr) == SQLITE_OK);
+		}
+		if (!bSnapshot)
+		{
+			_log.Log(LOG_ERROR, "SQLHelper: Could not open a snapshot for the backup (%s), blocking the database while copying", sqlite3_errmsg(pSource));
+			sqlite3_close(pSource);
+			pSource = nullptr;
+		}
+	}
 
-	std::lock_guard<std::mutex> l(m_sqlQueryMutex);
+	std::unique_lock<std::mutex> l(m_sqlQueryMutex, std::defer_lock);
+	if (!bSnapshot)
+		l.lock();
 
 	int rc;					 // Function return code
 	sqlite3* pFile;			 // Database connection opened on zFilename
 	sqlite3_backup* pBackup;	// Backup handle used to copy data
+	bool bResult = false;
 
 	// Open the database file identified by zFilename.
 	rc = sqlite3_open(OutputFile.c_str(), &pFile);
 	if (rc != SQLITE_OK)
+	{
+		sqlite3_close(pFile);
+		if (pSource != nullptr)
+		{
+			sqlite3_exec(pSource, "COMMIT;", nullptr, nullptr, nullptr);
+			sqlite3_close(pSource);
+		}
 		return false;
+	}
+	//the backup file is written in one go, a journal only slows that down
+	sqlite3_exec(pFile, "PRAGMA journal_mode = OFF; PRAGMA synchronous = OFF;", nullptr, nullptr, nullptr);
 
 	// Open the sqlite3_backup object used to accomplish the transfer
-	pBackup = sqlite3_backup_init(pFile, "main", m_dbase, "main");
+	pBackup = sqlite3_backup_init(pFile, "main", (bSnapshot) ? pSource : m_dbase, "main");
 
 	time_t startTime = time(nullptr);
 
 	if (pBackup)
 	{
-		// Each iteration of this loop copies 5 database pages from database
-		// pDb to the backup database.
+		//With a snapshot the copy is done in steps, nothing waits for it
+		//Without one all pages are copied in one step, to hold the query mutex as short as possible
 		do {
-			rc = sqlite3_backup_step(pBackup, 256);
-			//xProgress(  sqlite3_backup_remaining(pBackup), sqlite3_backup_pagecount(pBackup) );
-			if( rc==SQLITE_BUSY || rc==SQLITE_LOCKED ){
-			  sqlite3_sleep(250);
-			}
+			rc = sqlite3_backup_step(pBackup, (bSnapshot) ? 1024 : -1);
 			if (rc == SQLITE_BUSY || rc == SQLITE_LOCKED) {
 				time_t actTime = time(nullptr);
 				if (actTime - startTime > 2 * 60)
@@ -8043,18 +8327,27 @@ bool CSQLHelper::BackupDatabase(const std::string& OutputFile)
 					_log.Log(LOG_ERROR, "SQLHelper: Problem making backup! Check destination folder/rights. Process timeout!");
 					break;
 				}
+				sqlite3_sleep(50);
 			}
 		} while (rc == SQLITE_OK || rc == SQLITE_BUSY || rc == SQLITE_LOCKED);
+		bResult = (rc == SQLITE_DONE);
 
 		/* Release resources allocated by backup_init(). */
-		sqlite3_backup_finish(pBackup);
+		if (sqlite3_backup_finish(pBackup) != SQLITE_OK)
+			bResult = false;
 	}
-	rc = sqlite3_errcode(pFile);
+	if (!bResult)
+		_log.Log(LOG_ERROR, "SQLHelper: Problem making backup to %s: %s", OutputFile.c_str(), sqlite3_errmsg(pFile));
 	// Close the database connection opened on database file zFilename
 	// and return the result of this function.
 	sqlite3_close(pFile);
 
-	return (rc == SQLITE_OK);
+	if (pSource != nullptr)
+	{
+		sqlite3_exec(pSource, "COMMIT;", nullptr, nullptr, nullptr);
+		sqlite3_close(pSource);
+	}
+	return bResult;
 }
 
 uint64_t CSQLHelper::UpdateValueLighting2GroupCmd(const int HardwareID, const char* ID, const unsigned char unit,
@@ -8327,65 +8620,125 @@ void CSQLHelper::CheckBatteryLow()
 	}
 }
 
-//Executed every hour
-void CSQLHelper::CheckDeviceTimeout()
+static bool IsSensorTimeoutType(const unsigned char devType)
+{
+	switch (devType)
+	{
+	case pTypeLighting1:
+	case pTypeLighting2:
+	case pTypeLighting3:
+	case pTypeLighting4:
+	case pTypeLighting5:
+	case pTypeLighting6:
+	case pTypeFan:
+	case pTypeRadiator1:
+	case pTypeColorSwitch:
+	case pTypeSecurity1:
+	case pTypeCurtain:
+	case pTypeBlinds:
+	case pTypeRFY:
+	case pTypeChime:
+	case pTypeThermostat2:
+	case pTypeThermostat3:
+	case pTypeThermostat4:
+	case pTypeRemote:
+	case pTypeGeneralSwitch:
+	case pTypeHomeConfort:
+	case pTypeFS20:
+	case pTypeHunter:
+		return false;
+	}
+	return true;
+}
+
+//(Re)build the sensor timeout wheel, called at startup and when the timeout preferences change
+void CSQLHelper::ReloadSensorTimeouts()
 {
-	int TimeoutCheckInterval = 1;
+	int SensorTimeOut = 60;
+	GetPreferencesVar("SensorTimeout", SensorTimeOut);
+	int TimeoutCheckInterval = 0;
 	GetPreferencesVar("SensorTimeoutNotification", TimeoutCheckInterval);
 
-	if (TimeoutCheckInterval == 0)
+	std::vector<std::vector<std::string> > result;
+	result = safe_query("SELECT ID, Type, LastUpdate FROM DeviceStatus WHERE (Used!=0)");
+
+	time_t now = mytime(nullptr);
+	struct tm tm1;
+	localtime_r(&now, &tm1);
+
+	std::lock_guard<std::mutex> l(m_sensortimeoutMutex);
+	m_SensorTimeout = SensorTimeOut;
+	m_SensorTimeoutCheckInterval = TimeoutCheckInterval;
+	m_sensortimeoutwheel.Clear();
+	if (m_SensorTimeoutCheckInterval == 0)
+		return; //disabled
+
+	for (const auto &sd : result)
+	{
+		unsigned char devType = (unsigned char)atoi(sd[1].c_str());
+		if (!IsSensorTimeoutType(devType))
+			continue;
+		time_t lastupdate;
+		struct tm ntime;
+		if (!ParseSQLdatetime(lastupdate, ntime, sd[2], tm1.tm_isdst))
+			continue;
+		m_sensortimeoutwheel.Schedule(std::stoull(sd[0]), lastupdate + (m_SensorTimeout * 60));
+	}
+}
+
+void CSQLHelper::ScheduleSensorTimeout(const uint64_t ulID, const unsigned char devType, const time_t lastupdate)
+{
+	if (!IsSensorTimeoutType(devType))
 		return;
-	m_sensortimeoutcounter += 1;
-	if (m_sensortimeoutcounter < TimeoutCheckInterval)
+	std::lock_guard<std::mutex> l(m_sensortimeoutMutex);
+	if (m_SensorTimeoutCheckInterval == 0)
 		return;
-	m_sensortimeoutcounter = 0;
+	m_sensortimeoutwheel.Schedule(ulID, lastupdate + (m_SensorTimeout * 60));
+}
 
-	int SensorTimeOut = 60;
-	GetPreferencesVar("SensorTimeout", SensorTimeOut);
+//Executed every second, only the devices whose timeout expired are handled
+void CSQLHelper::CheckDeviceTimeout()
+{
+	std::vector<uint64_t> expired;
 	time_t now = mytime(nullptr);
+	{
+		std::lock_guard<std::mutex> l(m_sensortimeoutMutex);
+		if (m_SensorTimeoutCheckInterval == 0)
+			return;
+		m_sensortimeoutwheel.Advance(now, expired);
+	}
+	if (expired.empty())
+		return;
+
 	struct tm stoday;
 	localtime_r(&now, &stoday);
-	now -= (SensorTimeOut * 60);
-	struct tm ltime;
-	localtime_r(&now, &ltime);
-
-	std::vector<std::vector<std::string> > result;
-	result = safe_query(
-		"SELECT ID, Name, LastUpdate FROM DeviceStatus WHERE (Used!=0 AND LastUpdate<='%04d-%02d-%02d %02d:%02d:%02d' "
-		"AND Type!=%d AND Type!=%d AND Type!=%d AND Type!=%d AND Type!=%d AND Type!=%d AND Type!=%d AND Type!=%d AND Type!=%d "
-		"AND Type!=%d AND Type!=%d AND Type!=%d AND Type!=%d AND Type!=%d AND Type!=%d AND Type!=%d AND Type!=%d AND Type!=%d AND Type!=%d AND Type!=%d AND Type!=%d AND Type!=%d) "
-		"ORDER BY Name",
-		ltime.tm_year + 1900, ltime.tm_mon + 1, ltime.tm_mday, ltime.tm_hour, ltime.tm_min, ltime.tm_sec,
-		pTypeLighting1,
-		pTypeLighting2,
-		pTypeLighting3,
-		pTypeLighting4,
-		pTypeLighting5,
-		pTypeLighting6,
-		pTypeFan,
-		pTypeRadiator1,
-		pTypeColorSwitch,
-		pTypeSecurity1,
-		pTypeCurtain,
-		pTypeBlinds,
-		pTypeRFY,
-		pTypeChime,
-		pTypeThermostat2,
-		pTypeThermostat3,
-		pTypeThermostat4,
-		pTypeRemote,
-		pTypeGeneralSwitch,
-		pTypeHomeConfort,
-		pTypeFS20,
-		pTypeHunter
-	);
-	if (result.empty())
-		return;
 
 	//check if last timeout_notification is not sent today and if true, send notification
-	for (const auto &sd : result)
+	for (const auto ulID : expired)
 	{
-		uint64_t ulID = std::stoull(sd[0]);
+		std::vector<std::vector<std::string> > result;
+		result = safe_query("SELECT Name, LastUpdate, Type FROM DeviceStatus WHERE (ID==%" PRIu64 ") AND (Used!=0)", ulID);
+		if (result.empty())
+			continue; //removed or not used anymore, it will be scheduled again on its next update
+
+		time_t lastupdate;
+		struct tm ntime;
+		if (!ParseSQLdatetime(lastupdate, ntime, result[0][1], stoday.tm_isdst))
+			continue;
+
+		{
+			std::lock_guard<std::mutex> l(m_sensortimeoutMutex);
+			if (m_sensortimeoutwheel.IsScheduled(ulID))
+				continue; //updated in the meantime
+			if (difftime(now, lastupdate) < m_SensorTimeout * 60)
+			{
+				m_sensortimeoutwheel.Schedule(ulID, lastupdate + (m_SensorTimeout * 60));
+				continue;
+			}
+			//remind again after the check interval while the sensor stays silent
+			m_sensortimeoutwheel.Schedule(ulID, now + (m_SensorTimeoutCheckInterval * 60 * 60));
+		}
+
 		bool bDoSend = true;
 		auto sitt = m_timeoutlastsend.find(ulID);
 		if (sitt != m_timeoutlastsend.end())
@@ -8395,7 +8748,7 @@ void CSQLHelper::CheckDeviceTimeout()
 		if (bDoSend)
 		{
 			char szTmp[300];
-			sprintf(szTmp, "Sensor Timeout: %s, Last Received: %s", sd[1].c_str(), sd[2].c_str());
+			sprintf(szTmp, "Sensor Timeout: %s, Last Received: %s", result[0][0].c_str(), result[0][1].c_str());
 			m_notifications.SendMessageEx(0, std::string(""), NOTIFYALL, szTmp, szTmp, std::string(""), 1, std::string(""), true);
 			m_timeoutlastsend[ulID] = stoday.tm_mday;
 		}
@@ -8404,6 +8757,10 @@ void CSQLHelper::CheckDeviceTimeout()
 
 void CSQLHelper::FixDaylightSavingTableSimple(const std::string& TableName)
 {
+	//in the compact layout the primary key already rules out two rows for the same device and date
+	if (IsCompactHistoryTable(TableName))
+		return;
+
 	std::vector<std::vector<std::string> > result;
 
 	result = safe_query("SELECT t.RowID, u.RowID, t.Date FROM %s as t, %s as u WHERE (t.[Date] == u.[Date]) AND (t.[DeviceRowID] == u.[DeviceRowID]) AND (t.[RowID] != u.[RowID]) ORDER BY t.[RowID]",
@@ -8464,7 +8821,8 @@ void CSQLHelper::FixDaylightSaving()
 	//Meter_Calendar
 	std::vector<std::vector<std::string> > result;
 
-	result = safe_query("SELECT t.RowID, u.RowID, t.Value, u.Value, t.Date from Meter_Calendar as t, Meter_Calendar as u WHERE (t.[Date] == u.[Date]) AND (t.[DeviceRowID] == u.[DeviceRowID]) AND (t.[RowID] != u.[RowID]) ORDER BY t.[RowID]");
+	if (!IsCompactHistoryTable("Meter_Calendar"))
+		result = safe_query("SELECT t.RowID, u.RowID, t.Value, u.Value, t.Date from Meter_Calendar as t, Meter_Calendar as u WHERE (t.[Date] == u.[Date]) AND (t.[DeviceRowID] == u.[DeviceRowID]) AND (t.[RowID] != u.[RowID]) ORDER BY t.[RowID]");
 	if (!result.empty())
 	{
 		std::stringstream sstr;
@@ -8521,7 +8879,9 @@ void CSQLHelper::FixDaylightSaving()
 	}
 
 	//Last (but not least) MultiMeter_Calendar
-	result = safe_query("SELECT t.RowID, u.RowID, t.Value1, t.Value2, t.Value3, t.Value4, t.Value5, t.Value6, u.Value1, u.Value2, u.Value3, u.Value4, u.Value5, u.Value6, t.Date from MultiMeter_Calendar as t, MultiMeter_Calendar as u WHERE (t.[Date] == u.[Date]) AND (t.[DeviceRowID] == u.[DeviceRowID]) AND (t.[RowID] != u.[RowID]) ORDER BY t.[RowID]");
+	result.clear();
+	if (!IsCompactHistoryTable("MultiMeter_Calendar"))
+		result = safe_query("SELECT t.RowID, u.RowID, t.Value1, t.Value2, t.Value3, t.Value4, t.Value5, t.Value6, u.Value1, u.Value2, u.Value3, u.Value4, u.Value5, u.Value6, t.Date from MultiMeter_Calendar as t, MultiMeter_Calendar as u WHERE (t.[Date] == u.[Date]) AND (t.[DeviceRowID] == u.[DeviceRowID]) AND (t.[RowID] != u.[RowID]) ORDER BY t.[RowID]");
 	if (!result.empty())
 	{
 		std::stringstream sstr;
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <atomic>
+#include <set>
 #include <string>
 #include "RFXNames.h"
 #include "../hardware/hardwaretypes.h"
@@ -7,6 +9,7 @@
 #include "../httpclient/UrlEncode.h"
 #include "../httpclient/HTTPClient.h"
 #include "StoppableTask.h"
+#include "TimerWheel.h"
 
 #define timer_resolution_hz 25
 
@@ -328,10 +331,22 @@ class CSQLHelper : public StoppableTask
 
 	void SetDatabaseName(const std::string &DBName);
 	void SetJournalMode(const std::string &mode);
+	//Convert the history tables to the compact (clustered WITHOUT ROWID) layout when the database is opened
+	void SetCompactHistory(bool bCompact);
 
 	bool OpenDatabase();
 	void CloseDatabase();
 
+	//Tables whose modifications are counted, so what is derived from them can be cached until they change
+	enum _eWatchedTable
+	{
+		WTABLE_HARDWARE = 0,
+		WTABLE_TIMERS, //Timers and SetpointTimers
+		WTABLE_LIGHTSUBDEVICES,
+		WTABLE_MAX
+	};
+	uint64_t GetTableVersion(_eWatchedTable table) const;
+
 	bool BackupDatabase(const std::string &OutputFile);
 	bool RestoreDatabase(const std::string &dbase);
 
@@ -387,6 +402,8 @@ class CSQLHelper : public StoppableTask
 	void CheckSceneStatus(const std::string &Idx);
 	void CheckSceneStatusWithDevice(uint64_t DevIdx);
 	void CheckSceneStatusWithDevice(const std::string &DevIdx);
+	void SetSceneStatusValue(uint64_t Idx, int nValue);
+	void InvalidateSceneStatus();
 
 	void ScheduleShortlog();
 	void ScheduleDay();
@@ -415,6 +432,7 @@ class CSQLHelper : public StoppableTask
 
 	void SetUnitsAndScale();
 
+	void ReloadSensorTimeouts();
 	void CheckDeviceTimeout();
 	void CheckBatteryLow();
 
@@ -483,8 +501,33 @@ class CSQLHelper : public StoppableTask
 	sqlite3 *m_dbase;
 	std::string m_dbase_name;
 	std::string m_journal_mode;
-	unsigned char m_sensortimeoutcounter;
+	bool m_bCompactHistory;
+	std::atomic<uint64_t> m_tableversion[WTABLE_MAX];
+	static void UpdateHook(void *pHelper, int op, const char *szDatabase, const char *szTable, long long rowid);
+	//devices with timers in the active timer plan, for HasTimers
+	std::mutex m_timerdevicesMutex;
+	uint64_t m_timerdevicesversion = 0;
+	int m_timerdevicesplan = -1;
+	std::set<uint64_t> m_timerdevices;
+	std::mutex m_sensortimeoutMutex;
+	CTimerWheel<uint64_t> m_sensortimeoutwheel; //device rowid -> LastUpdate + SensorTimeout
+	int m_SensorTimeout; //minutes
+	int m_SensorTimeoutCheckInterval; //hours, 0 = disabled
 	std::map<uint64_t, int> m_timeoutlastsend;
+
+	//Scene/Group status, the on/off state of the members is kept so a device update does not re-scan all members
+	struct _tSceneStatus
+	{
+		std::map<uint64_t, bool> Members; //device idx -> on
+		size_t totOn = 0;
+		int nValue = 0; //0=Off, 1=On, 2=Mixed
+	};
+	std::mutex m_scenestatusMutex;
+	bool m_bSceneStatusLoaded = false;
+	std::map<uint64_t, std::vector<uint64_t>> m_devicescenes; //device idx -> scenes/groups it is a member of
+	std::map<uint64_t, _tSceneStatus> m_scenestatus;
+	void LoadSceneStatus();
+	void SetSceneStatus(uint64_t Idx, int nValue);
 	std::map<uint64_t, int> m_batterylowlastsend;
 	bool m_bAcceptHardwareTimerActive;
 	float m_iAcceptHardwareTimerCounter;
@@ -496,6 +539,7 @@ class CSQLHelper : public StoppableTask
 	bool StartThread();
 	void StopThread();
 	void Do_Work();
+	void ScheduleSensorTimeout(uint64_t ulID, unsigned char devType, time_t lastupdate);
 #ifndef WIN32
 	void ManageExecuteScriptTimeout(int pid, int timeout, bool *stillRunning, bool *timeoutOccurred);
 #endif
@@ -517,6 +561,13 @@ class CSQLHelper : public StoppableTask
 	void CheckAndUpdateDeviceOrder();
 	void CheckAndUpdateSceneDeviceOrder();
 
+	std::string GetSchemaHash();
+	bool IsCompactHistoryTable(const std::string &tablename);
+	void CompactHistoryTables();
+	void ClearHistoryRow(const char *szTable, uint64_t DeviceRowID, const char *szDate);
+	void DeleteHardwareRows(const std::string &idx);
+	void DeleteDeviceRows(const std::string &idx);
+
 	void CleanupLightSceneLog();
 
 	void UpdateTemperatureLog();
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <string>
+#include "Helper.h"
+
+//Numeric view of a "value1;value2;..." sValue, parsed once and kept next to the string
+#define SVALUE_MAX_FIELDS 8
+struct _tSValueFields
+{
+	size_t count = 0; //number of fields in the sValue, can be larger than SVALUE_MAX_FIELDS
+	double value[SVALUE_MAX_FIELDS] = { 0 };
+
+	void Parse(const std::string &sValue)
+	{
+		for (auto &field : value)
+			field = 0;
+		count = StringSplitDouble(sValue.c_str(), ';', value, SVALUE_MAX_FIELDS);
+	}
+};
@@ -39,6 +39,11 @@ void CScheduler::StopScheduler()
 	if (m_thread)
 	{
 		RequestStop();
+		{
+			std::lock_guard<std::mutex> l(m_mutex);
+			m_bWakeUp = true;
+		}
+		m_cond.notify_all();
 		m_thread->join();
 		m_thread.reset();
 	}
@@ -334,6 +339,21 @@ void CScheduler::ReloadSchedules()
 				m_scheduleitems.push_back(titem);
 		}
 	}
+	RebuildScheduleQueue();
+	//let the scheduler thread pick up the new first fire time
+	m_bWakeUp = true;
+	m_cond.notify_all();
+}
+
+//m_mutex should be locked by the caller
+void CScheduler::RebuildScheduleQueue()
+{
+	m_schedulequeue = decltype(m_schedulequeue)();
+	for (size_t ii = 0; ii < m_scheduleitems.size(); ii++)
+	{
+		if (m_scheduleitems[ii].bEnabled)
+			m_schedulequeue.push(std::make_pair(m_scheduleitems[ii].startTime, ii));
+	}
 }
 
 void CScheduler::SetSunRiseSetTimers(const std::string &sSunRise, const std::string &sSunSet, const std::string &sSunAtSouth, const std::string &sCivTwStart, const std::string &sCivTwEnd, const std::string &sNautTwStart, const std::string &sNautTwEnd, const std::string &sAstTwStart, const std::string &sAstTwEnd)
@@ -686,22 +706,36 @@ bool CScheduler::AdjustScheduleItem(tScheduleItem *pItem, bool bForceAddDay)
 
 void CScheduler::Do_Work()
 {
-	while (!IsStopRequested(1000))
+	time_t lastHeartbeat = 0;
+	time_t lastCleanup = 0;
+	while (!IsStopRequested(0))
 	{
 		time_t atime = mytime(nullptr);
-		struct tm ltime;
-		localtime_r(&atime, &ltime);
 
-
-		if (ltime.tm_sec % 12 == 0) {
+		if ((atime - lastHeartbeat >= 12) || (atime < lastHeartbeat))
+		{
 			m_mainworker.HeartbeatUpdate("Scheduler");
+			lastHeartbeat = atime;
 		}
 
 		CheckSchedules();
 
-		if (ltime.tm_sec == 0) {
+		if ((atime / 60) != (lastCleanup / 60))
+		{
 			DeleteExpiredTimers();
+			lastCleanup = atime;
 		}
+
+		//Sleep until the first item is due, we also wake up for the heartbeat, the cleanup each minute,
+		//when the schedules are reloaded or when we need to stop
+		time_t nextWake = std::min(lastHeartbeat + 12, ((atime / 60) + 1) * 60);
+		std::unique_lock<std::mutex> lock(m_mutex);
+		if (!m_schedulequeue.empty())
+			nextWake = std::min(nextWake, m_schedulequeue.top().first + 1);
+		if (nextWake <= atime)
+			nextWake = atime + 1;
+		m_cond.wait_until(lock, std::chrono::system_clock::from_time_t(nextWake), [this] { return m_bWakeUp; });
+		m_bWakeUp = false;
 	}
 	_log.Log(LOG_STATUS, "Scheduler stopped...");
 }
@@ -714,217 +748,237 @@ void CScheduler::CheckSchedules()
 	struct tm ltime;
 	localtime_r(&atime, &ltime);
 
-	for (auto &item : m_scheduleitems)
+	if ((m_tLastCheck != 0) && (atime + 60 < m_tLastCheck))
+	{
+		//clock went backwards, the fire times computed before are too far in the future
+		for (auto &item : m_scheduleitems)
+		{
+			if ((item.bEnabled) && (item.timerType != TTYPE_FIXEDDATETIME))
+				AdjustScheduleItem(&item, false);
+		}
+		RebuildScheduleQueue();
+	}
+	m_tLastCheck = atime;
+
+	//Only the items that are due are visited, after a forward clock jump every missed item fires once
+	while ((!m_schedulequeue.empty()) && (atime > m_schedulequeue.top().first))
 	{
-		if ((item.bEnabled) && (atime > item.startTime))
+		time_t fireTime = m_schedulequeue.top().first;
+		size_t itemIdx = m_schedulequeue.top().second;
+		m_schedulequeue.pop();
+		if (itemIdx >= m_scheduleitems.size())
+			continue;
+		tScheduleItem &item = m_scheduleitems[itemIdx];
+		if ((!item.bEnabled) || (item.startTime != fireTime))
+			continue; //outdated entry
+		//check if we are on a valid day
+		bool bOkToFire = false;
+		if (item.timerType == TTYPE_FIXEDDATETIME)
+		{
+			bOkToFire = true;
+		}
+		else if (item.timerType == TTYPE_DAYSODD)
+		{
+			bOkToFire = (ltime.tm_mday % 2 != 0);
+		}
+		else if (item.timerType == TTYPE_DAYSEVEN)
+		{
+			bOkToFire = (ltime.tm_mday % 2 == 0);
+		}
+		else
 		{
-			//check if we are on a valid day
-			bool bOkToFire = false;
-			if (item.timerType == TTYPE_FIXEDDATETIME)
+			if (item.Days & 0x80)
 			{
+				//everyday
 				bOkToFire = true;
 			}
-			else if (item.timerType == TTYPE_DAYSODD)
+			else if (item.Days & 0x100)
 			{
-				bOkToFire = (ltime.tm_mday % 2 != 0);
+				//weekdays
+				if ((ltime.tm_wday > 0) && (ltime.tm_wday < 6))
+					bOkToFire = true;
 			}
-			else if (item.timerType == TTYPE_DAYSEVEN)
+			else if (item.Days & 0x200)
 			{
-				bOkToFire = (ltime.tm_mday % 2 == 0);
+				//weekends
+				if ((ltime.tm_wday == 0) || (ltime.tm_wday == 6))
+					bOkToFire = true;
 			}
 			else
 			{
-				if (item.Days & 0x80)
-				{
-					//everyday
-					bOkToFire = true;
-				}
-				else if (item.Days & 0x100)
-				{
-					//weekdays
-					if ((ltime.tm_wday > 0) && (ltime.tm_wday < 6))
-						bOkToFire = true;
-				}
-				else if (item.Days & 0x200)
-				{
-					//weekends
-					if ((ltime.tm_wday == 0) || (ltime.tm_wday == 6))
-						bOkToFire = true;
-				}
-				else
+				//custom days
+				if ((item.Days & 0x01) && (ltime.tm_wday == 1))
+					bOkToFire = true;//Monday
+				if ((item.Days & 0x02) && (ltime.tm_wday == 2))
+					bOkToFire = true;//Tuesday
+				if ((item.Days & 0x04) && (ltime.tm_wday == 3))
+					bOkToFire = true;//Wednesday
+				if ((item.Days & 0x08) && (ltime.tm_wday == 4))
+					bOkToFire = true;//Thursday
+				if ((item.Days & 0x10) && (ltime.tm_wday == 5))
+					bOkToFire = true;//Friday
+				if ((item.Days & 0x20) && (ltime.tm_wday == 6))
+					bOkToFire = true;//Saturday
+				if ((item.Days & 0x40) && (ltime.tm_wday == 0))
+					bOkToFire = true;//Sunday
+			}
+			if (bOkToFire)
+			{
+				if ((item.timerType == TTYPE_WEEKSODD) || (item.timerType == TTYPE_WEEKSEVEN))
 				{
-					//custom days
-					if ((item.Days & 0x01) && (ltime.tm_wday == 1))
-						bOkToFire = true;//Monday
-					if ((item.Days & 0x02) && (ltime.tm_wday == 2))
-						bOkToFire = true;//Tuesday
-					if ((item.Days & 0x04) && (ltime.tm_wday == 3))
-						bOkToFire = true;//Wednesday
-					if ((item.Days & 0x08) && (ltime.tm_wday == 4))
-						bOkToFire = true;//Thursday
-					if ((item.Days & 0x10) && (ltime.tm_wday == 5))
-						bOkToFire = true;//Friday
-					if ((item.Days & 0x20) && (ltime.tm_wday == 6))
-						bOkToFire = true;//Saturday
-					if ((item.Days & 0x40) && (ltime.tm_wday == 0))
-						bOkToFire = true;//Sunday
+					struct tm timeinfo;
+					localtime_r(&item.startTime, &timeinfo);
+
+					boost::gregorian::date d = boost::gregorian::date(
+						timeinfo.tm_year + 1900,
+						timeinfo.tm_mon + 1,
+						timeinfo.tm_mday);
+					int w = d.week_number();
+
+					if (item.timerType == TTYPE_WEEKSODD)
+						bOkToFire = (w % 2 != 0);
+					else
+						bOkToFire = (w % 2 == 0);
 				}
-				if (bOkToFire)
+			}
+		}
+		if (bOkToFire)
+		{
+			char ltimeBuf[30];
+			strftime(ltimeBuf, sizeof(ltimeBuf), "%Y-%m-%d %H:%M:%S", &ltime);
+
+			if (item.bIsScene == true)
+				_log.Log(LOG_STATUS, "Schedule item started! Name: %s, Type: %s, SceneID: %" PRIu64 ", Time: %s",
+					 item.DeviceName.c_str(), Timer_Type_Desc(item.timerType), item.RowID, ltimeBuf);
+			else if (item.bIsThermostat == true)
+				_log.Log(LOG_STATUS,
+					 "Schedule item started! Name: %s, Type: %s, ThermostatID: %" PRIu64 ", Time: %s",
+					 item.DeviceName.c_str(), Timer_Type_Desc(item.timerType), item.RowID, ltimeBuf);
+			else
+				_log.Log(LOG_STATUS, "Schedule item started! Name: %s, Type: %s, DevID: %" PRIu64 ", Time: %s",
+					 item.DeviceName.c_str(), Timer_Type_Desc(item.timerType), item.RowID, ltimeBuf);
+			std::string switchcmd;
+			if (item.timerCmd == TCMD_ON)
+				switchcmd = "On";
+			else if (item.timerCmd == TCMD_OFF)
+				switchcmd = "Off";
+			if (switchcmd.empty())
+			{
+				_log.Log(LOG_ERROR, "Unknown switch command in timer!!....");
+			}
+			else
+			{
+				if (item.bIsScene == true)
 				{
-					if ((item.timerType == TTYPE_WEEKSODD) || (item.timerType == TTYPE_WEEKSEVEN))
+					/*
+											if (
+												(item.timerType ==
+					   TTYPE_BEFORESUNRISE) || (item.timerType == TTYPE_AFTERSUNRISE) || (item.timerType ==
+					   TTYPE_BEFORESUNSET) || (item.timerType == TTYPE_AFTERSUNSET)
+												)
+											{
+
+											}
+					*/
+					if (!m_mainworker.SwitchScene(item.RowID, switchcmd, "timer"))
 					{
-						struct tm timeinfo;
-						localtime_r(&item.startTime, &timeinfo);
-
-						boost::gregorian::date d = boost::gregorian::date(
-							timeinfo.tm_year + 1900,
-							timeinfo.tm_mon + 1,
-							timeinfo.tm_mday);
-						int w = d.week_number();
-
-						if (item.timerType == TTYPE_WEEKSODD)
-							bOkToFire = (w % 2 != 0);
-						else
-							bOkToFire = (w % 2 == 0);
+						_log.Log(LOG_ERROR, "Error switching Scene command, SceneID: %" PRIu64 ", Time: %s",
+							 item.RowID, ltimeBuf);
 					}
 				}
-			}
-			if (bOkToFire)
-			{
-				char ltimeBuf[30];
-				strftime(ltimeBuf, sizeof(ltimeBuf), "%Y-%m-%d %H:%M:%S", &ltime);
-
-				if (item.bIsScene == true)
-					_log.Log(LOG_STATUS, "Schedule item started! Name: %s, Type: %s, SceneID: %" PRIu64 ", Time: %s",
-						 item.DeviceName.c_str(), Timer_Type_Desc(item.timerType), item.RowID, ltimeBuf);
 				else if (item.bIsThermostat == true)
-					_log.Log(LOG_STATUS,
-						 "Schedule item started! Name: %s, Type: %s, ThermostatID: %" PRIu64 ", Time: %s",
-						 item.DeviceName.c_str(), Timer_Type_Desc(item.timerType), item.RowID, ltimeBuf);
-				else
-					_log.Log(LOG_STATUS, "Schedule item started! Name: %s, Type: %s, DevID: %" PRIu64 ", Time: %s",
-						 item.DeviceName.c_str(), Timer_Type_Desc(item.timerType), item.RowID, ltimeBuf);
-				std::string switchcmd;
-				if (item.timerCmd == TCMD_ON)
-					switchcmd = "On";
-				else if (item.timerCmd == TCMD_OFF)
-					switchcmd = "Off";
-				if (switchcmd.empty())
 				{
-					_log.Log(LOG_ERROR, "Unknown switch command in timer!!....");
+					std::stringstream sstr;
+					sstr << item.RowID;
+					if (!m_mainworker.SetSetPoint(sstr.str(), item.Temperature))
+					{
+						_log.Log(LOG_ERROR,
+							 "Error setting thermostat setpoint, ThermostatID: %" PRIu64 ", Time: %s",
+							 item.RowID, ltimeBuf);
+					}
 				}
 				else
 				{
-					if (item.bIsScene == true)
-					{
-						/*
-												if (
-													(item.timerType ==
-						   TTYPE_BEFORESUNRISE) || (item.timerType == TTYPE_AFTERSUNRISE) || (item.timerType ==
-						   TTYPE_BEFORESUNSET) || (item.timerType == TTYPE_AFTERSUNSET)
-													)
-												{
-
-												}
-						*/
-						if (!m_mainworker.SwitchScene(item.RowID, switchcmd, "timer"))
-						{
-							_log.Log(LOG_ERROR, "Error switching Scene command, SceneID: %" PRIu64 ", Time: %s",
-								 item.RowID, ltimeBuf);
-						}
-					}
-					else if (item.bIsThermostat == true)
+					//Get SwitchType
+					std::vector<std::vector<std::string> > result;
+					result = m_sql.safe_query(
+						"SELECT Type,SubType,SwitchType FROM DeviceStatus WHERE (ID == %" PRIu64 ")",
+						item.RowID);
+					if (!result.empty())
 					{
-						std::stringstream sstr;
-						sstr << item.RowID;
-						if (!m_mainworker.SetSetPoint(sstr.str(), item.Temperature))
+						std::vector<std::string> sd = result[0];
+
+						unsigned char dType = atoi(sd[0].c_str());
+						unsigned char dSubType = atoi(sd[1].c_str());
+						_eSwitchType switchtype = (_eSwitchType)atoi(sd[2].c_str());
+						std::string lstatus;
+						int llevel = 0;
+						bool bHaveDimmer = false;
+						bool bHaveGroupCmd = false;
+						int maxDimLevel = 0;
+
+						GetLightStatus(dType, dSubType, switchtype, 0, "", lstatus, llevel, bHaveDimmer, maxDimLevel, bHaveGroupCmd);
+						int ilevel = maxDimLevel;
+						if ((switchtype == STYPE_BlindsPercentage) || (switchtype == STYPE_BlindsPercentageInverted))
 						{
-							_log.Log(LOG_ERROR,
-								 "Error setting thermostat setpoint, ThermostatID: %" PRIu64 ", Time: %s",
-								 item.RowID, ltimeBuf);
+							if (item.timerCmd == TCMD_ON)
+							{
+								switchcmd = "Set Level";
+								float fLevel = (maxDimLevel / 100.0F) * item.Level;
+								if (fLevel > 100)
+									fLevel = 100;
+								ilevel = int(fLevel);
+							}
+							else if (item.timerCmd == TCMD_OFF)
+								ilevel = 0;
 						}
-					}
-					else
-					{
-						//Get SwitchType
-						std::vector<std::vector<std::string> > result;
-						result = m_sql.safe_query(
-							"SELECT Type,SubType,SwitchType FROM DeviceStatus WHERE (ID == %" PRIu64 ")",
-							item.RowID);
-						if (!result.empty())
+						else if ((switchtype == STYPE_Dimmer) && (maxDimLevel != 0))
 						{
-							std::vector<std::string> sd = result[0];
-
-							unsigned char dType = atoi(sd[0].c_str());
-							unsigned char dSubType = atoi(sd[1].c_str());
-							_eSwitchType switchtype = (_eSwitchType)atoi(sd[2].c_str());
-							std::string lstatus;
-							int llevel = 0;
-							bool bHaveDimmer = false;
-							bool bHaveGroupCmd = false;
-							int maxDimLevel = 0;
-
-							GetLightStatus(dType, dSubType, switchtype, 0, "", lstatus, llevel, bHaveDimmer, maxDimLevel, bHaveGroupCmd);
-							int ilevel = maxDimLevel;
-							if ((switchtype == STYPE_BlindsPercentage) || (switchtype == STYPE_BlindsPercentageInverted))
+							if (item.timerCmd == TCMD_ON)
 							{
-								if (item.timerCmd == TCMD_ON)
-								{
-									switchcmd = "Set Level";
-									float fLevel = (maxDimLevel / 100.0F) * item.Level;
-									if (fLevel > 100)
-										fLevel = 100;
-									ilevel = int(fLevel);
-								}
-								else if (item.timerCmd == TCMD_OFF)
-									ilevel = 0;
+								switchcmd = "Set Level";
+								float fLevel = (maxDimLevel / 100.0F) * item.Level;
+								if (fLevel > 100)
+									fLevel = 100;
+								ilevel = int(fLevel);
 							}
-							else if ((switchtype == STYPE_Dimmer) && (maxDimLevel != 0))
+						} else if (switchtype == STYPE_Selector) {
+							if (item.timerCmd == TCMD_ON)
 							{
-								if (item.timerCmd == TCMD_ON)
-								{
-									switchcmd = "Set Level";
-									float fLevel = (maxDimLevel / 100.0F) * item.Level;
-									if (fLevel > 100)
-										fLevel = 100;
-									ilevel = int(fLevel);
-								}
-							} else if (switchtype == STYPE_Selector) {
-								if (item.timerCmd == TCMD_ON)
-								{
-									switchcmd = "Set Level";
-									ilevel = item.Level;
-								}
-								else if (item.timerCmd == TCMD_OFF)
-								{
-									ilevel = 0; // force level to a valid value for Selector
-								}
+								switchcmd = "Set Level";
+								ilevel = item.Level;
 							}
-							if (!m_mainworker.SwitchLight(item.RowID, switchcmd, ilevel, item.Color, false, 0,
-										      "timer"))
+							else if (item.timerCmd == TCMD_OFF)
 							{
-								_log.Log(LOG_ERROR,
-									 "Error sending switch command, DevID: %" PRIu64 ", Time: %s",
-									 item.RowID, ltimeBuf);
+								ilevel = 0; // force level to a valid value for Selector
 							}
 						}
+						if (!m_mainworker.SwitchLight(item.RowID, switchcmd, ilevel, item.Color, false, 0,
+									      "timer"))
+						{
+							_log.Log(LOG_ERROR,
+								 "Error sending switch command, DevID: %" PRIu64 ", Time: %s",
+								 item.RowID, ltimeBuf);
+						}
 					}
 				}
 			}
-			if (!AdjustScheduleItem(&item, true))
+		}
+		if (!AdjustScheduleItem(&item, true))
+		{
+			//something is wrong, probably no sunset/rise
+			if (item.timerType != TTYPE_FIXEDDATETIME)
 			{
-				//something is wrong, probably no sunset/rise
-				if (item.timerType != TTYPE_FIXEDDATETIME)
-				{
-					item.startTime += atime + (24 * 3600);
-				}
-				else
-				{
-					//Disable timer
-					item.bEnabled = false;
-				}
+				item.startTime += atime + (24 * 3600);
+			}
+			else
+			{
+				//Disable timer
+				item.bEnabled = false;
 			}
 		}
+		if (item.bEnabled)
+			m_schedulequeue.push(std::make_pair(item.startTime, itemIdx));
 	}
 }
 
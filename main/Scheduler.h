@@ -3,6 +3,8 @@
 #include "RFXNames.h"
 #include "../hardware/hardwaretypes.h"
 #include <string>
+#include <queue>
+#include <condition_variable>
 #include "StoppableTask.h"
 
 struct tScheduleItem
@@ -91,6 +93,11 @@ private:
 	std::mutex m_mutex;
 	std::shared_ptr<std::thread> m_thread;
 	std::vector<tScheduleItem> m_scheduleitems;
+	//next fire time of the scheduled items (startTime, index in m_scheduleitems), earliest on top
+	std::priority_queue<std::pair<time_t, size_t>, std::vector<std::pair<time_t, size_t>>, std::greater<std::pair<time_t, size_t>>> m_schedulequeue;
+	std::condition_variable m_cond;
+	bool m_bWakeUp = false;
+	time_t m_tLastCheck = 0;
 
 	//our thread
 	void Do_Work();
@@ -98,6 +105,7 @@ private:
 	//will set the new/next startTime
 	//returns false if timer is invalid (like no sunset/sunrise known yet)
 	bool AdjustScheduleItem(tScheduleItem *pItem, bool bForceAddDay);
+	void RebuildScheduleQueue();
 	//will check if anything needs to be scheduled
 	void CheckSchedules();
 	void DeleteExpiredTimers();
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <ctime>
+#include <map>
+#include <vector>
+
+//Hashed timing wheel with a resolution of one second
+//
+//Every key is armed with an absolute deadline and placed in the slot (deadline % slots).
+//Keys that are more than one revolution away simply stay in their slot until their deadline passes,
+//so advancing the wheel only visits the slots of the seconds that elapsed since the last call,
+//and collecting the expired keys costs O(expired) instead of a scan over all keys.
+//
+//Not thread safe, the owner should protect it with its own mutex
+template<typename T>
+class CTimerWheel
+{
+public:
+	explicit CTimerWheel(const size_t slots = 3600)
+		: m_slots(slots)
+	{
+	}
+
+	//(Re)arm a key, a previous deadline of this key is replaced
+	void Schedule(const T &key, const time_t deadline)
+	{
+		Cancel(key);
+		//a deadline that already passed is placed in the next slot to be processed
+		time_t slot_time = ((m_current == 0) || (deadline > m_current)) ? deadline : m_current + 1;
+		m_slots[SlotIndex(slot_time)][key] = deadline;
+		m_keys[key] = slot_time;
+	}
+
+	void Cancel(const T &key)
+	{
+		auto itt = m_keys.find(key);
+		if (itt == m_keys.end())
+			return;
+		m_slots[SlotIndex(itt->second)].erase(key);
+		m_keys.erase(itt);
+	}
+
+	void Clear()
+	{
+		for (auto &slot : m_slots)
+			slot.clear();
+		m_keys.clear();
+		m_current = 0;
+	}
+
+	bool IsScheduled(const T &key) const
+	{
+		return (m_keys.find(key) != m_keys.end());
+	}
+
+	size_t size() const
+	{
+		return m_keys.size();
+	}
+
+	//Move the wheel forward to 'now' and return all keys with a deadline <= now
+	//Expired keys are disarmed, the caller can re-arm them
+	void Advance(const time_t now, std::vector<T> &expired)
+	{
+		expired.clear();
+		if ((m_current != 0) && (now <= m_current))
+		{
+			//clock went backwards, keys will expire when their deadline is reached again
+			m_current = now;
+			return;
+		}
+		//the first time, or after a large clock jump, every slot is visited only once
+		time_t steps = now - m_current;
+		if ((m_current == 0) || (steps > static_cast<time_t>(m_slots.size())))
+			steps = static_cast<time_t>(m_slots.size());
+
+		for (time_t ii = 1; ii <= steps; ii++)
+		{
+			auto &slot = m_slots[SlotIndex(now - steps + ii)];
+			auto itt = slot.begin();
+			while (itt != slot.end())
+			{
+				if (itt->second <= now)
+				{
+					expired.push_back(itt->first);
+					m_keys.erase(itt->first);
+					itt = slot.erase(itt);
+				}
+				else
+					++itt;
+			}
+		}
+		m_current = now;
+	}
+
+private:
+	size_t SlotIndex(const time_t atime) const
+	{
+		return static_cast<size_t>(atime) % m_slots.size();
+	}
+
+	std::vector<std::map<T, time_t>> m_slots; //key -> deadline
+	std::map<T, time_t> m_keys; //key -> time used to select the slot
+	time_t m_current = 0; //last second that was processed
+};
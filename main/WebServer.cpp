@@ -47,6 +47,7 @@
 #include "../smtpclient/SMTPClient.h"
 #include <json/json.h>
 #include "../main/json_helper.h"
+#include "JSonWriter.h"
 #include "Logger.h"
 #include "SQLHelper.h"
 #include "../push/BasePush.h"
@@ -101,6 +102,70 @@ namespace
 		{ "pl", "Polish" },    { "pt", "Portuguese" }, { "ro", "Romanian" }, { "ru", "Russian" },      { "sr", "Serbian" },   { "sk", "Slovak" },
 		{ "sl", "Slovenian" }, { "es", "Spanish" },    { "sv", "Swedish" },  { "zh_TW", "Taiwanese" }, { "tr", "Turkish" },   { "uk", "Ukrainian" },
 	} };
+
+	//Cache of the UserSessions table, every authenticated request looks up its session
+	//Shared by the http and https server (same table), split in shards so parallel requests rarely wait on each other
+	constexpr size_t SESSION_CACHE_SHARDS = 16;
+	constexpr time_t SESSION_CACHE_TTL = 300;		//seconds an entry is used before the database is read again
+	constexpr size_t SESSION_CACHE_MAX_UNKNOWN = 256; //per shard, unknown session ids that are remembered
+
+	struct _tCachedSession
+	{
+		http::server::WebEmStoredSession session; //empty id: not in the database
+		time_t cached;
+	};
+	struct _tSessionCacheShard
+	{
+		std::mutex mutex;
+		std::map<std::string, _tCachedSession> sessions;
+		size_t unknown = 0;
+	};
+	std::array<_tSessionCacheShard, SESSION_CACHE_SHARDS> sessionCache;
+
+	_tSessionCacheShard &GetSessionCacheShard(const std::string &sessionId)
+	{
+		return sessionCache[std::hash<std::string>()(sessionId) % SESSION_CACHE_SHARDS];
+	}
+
+	void CacheSession(const std::string &sessionId, const http::server::WebEmStoredSession &session, const time_t now)
+	{
+		_tSessionCacheShard &shard = GetSessionCacheShard(sessionId);
+		std::lock_guard<std::mutex> l(shard.mutex);
+		auto itt = shard.sessions.find(sessionId);
+		if (itt != shard.sessions.end())
+		{
+			if (itt->second.session.id.empty())
+				shard.unknown--;
+			shard.sessions.erase(itt);
+		}
+		if (session.id.empty())
+		{
+			if (shard.unknown >= SESSION_CACHE_MAX_UNKNOWN)
+				return;
+			shard.unknown++;
+		}
+		shard.sessions[sessionId] = { session, now };
+	}
+
+	void UncacheSessions(const std::function<bool(const http::server::WebEmStoredSession &session, time_t cached)> &predicate)
+	{
+		for (auto &shard : sessionCache)
+		{
+			std::lock_guard<std::mutex> l(shard.mutex);
+			auto itt = shard.sessions.begin();
+			while (itt != shard.sessions.end())
+			{
+				if (predicate(itt->second.session, itt->second.cached))
+				{
+					if (itt->second.session.id.empty())
+						shard.unknown--;
+					itt = shard.sessions.erase(itt);
+				}
+				else
+					++itt;
+			}
+		}
+	}
 } // namespace
 
 extern http::server::CWebServerHelper m_webservers;
@@ -381,7 +446,7 @@ namespace http
 
 			RegisterCommandCode(
 				"getversion", [this](auto &&session, auto &&req, auto &&root) { Cmd_GetVersion(session, req, root); }, true);
-			RegisterCommandCode("getlog", [this](auto &&session, auto &&req, auto &&root) { Cmd_GetLog(session, req, root); });
+			RegisterStreamCommandCode("getlog", [this](auto &&session, auto &&req, auto &&writer) { Cmd_GetLog(session, req, writer); });
 			RegisterCommandCode("clearlog", [this](auto &&session, auto &&req, auto &&root) { Cmd_ClearLog(session, req, root); });
 			RegisterCommandCode(
 				"getauth", [this](auto &&session, auto &&req, auto &&root) { Cmd_GetAuth(session, req, root); }, true);
@@ -753,6 +818,11 @@ namespace http
 			m_webrtypes.insert(std::pair<std::string, webserver_response_function>(std::string(idname), ResponseFunction));
 		}
 
+		void CWebServer::RegisterStreamCommandCode(const char *idname, const webserver_stream_function &ResponseFunction)
+		{
+			m_webstreamcommands.insert(std::pair<std::string, webserver_stream_function>(std::string(idname), ResponseFunction));
+		}
+
 		void CWebServer::HandleRType(const std::string &rtype, WebEmSession &session, const request &req, Json::Value &root)
 		{
 			auto pf = m_webrtypes.find(rtype);
@@ -876,8 +946,19 @@ namespace http
 					goto exitjson;
 				}
 				_log.Debug(DEBUG_WEBSERVER, "WEBS GetJSon :%s :%s ", cparam.c_str(), req.uri.c_str());
+				auto pf = m_webstreamcommands.find(cparam);
+				if (pf != m_webstreamcommands.end())
+				{
+					HandleStreamCommand(pf->second, session, req, rep);
+					return;
+				}
 				HandleCommand(cparam, session, req, root);
 			} //(rtype=="command")
+			else if ((rtype == "graph") && (request::findValue(&req, "range") == "day") && (IsStreamGraphDay(request::findValue(&req, "sensor"))))
+			{
+				HandleStreamCommand([this](auto &&session, auto &&req, auto &&writer) { RType_HandleGraphDay(session, req, writer); }, session, req, rep);
+				return;
+			}
 			else
 			{
 				HandleRType(rtype, session, req, root);
@@ -892,6 +973,33 @@ namespace http
 			reply::set_content(&rep, "var data=" + root.toStyledString() + '\n' + jcallback + "(data);");
 		}
 
+		void CWebServer::HandleStreamCommand(const webserver_stream_function &StreamFunction, WebEmSession &session, const request &req, reply &rep)
+		{
+			std::string jcallback = request::findValue(&req, "jsoncallback");
+			//compressed while it is written, so no uncompressed copy of the response is kept
+			bool bGZip = false;
+			if ((jcallback.empty()) && (m_pWebEm->m_gzipmode == WWW_USE_GZIP))
+			{
+				const char *encoding_header = request::get_req_header(&req, "Accept-Encoding");
+				bGZip = ((encoding_header != nullptr) && (strstr(encoding_header, "gzip") != nullptr));
+			}
+
+			rep.content.clear();
+			if (!jcallback.empty())
+				rep.content = "var data=";
+			CJSonWriter writer(rep.content, bGZip);
+			StreamFunction(session, req, writer);
+			writer.Finish();
+			if (!jcallback.empty())
+				rep.content += '\n' + jcallback + "(data);";
+			if (writer.IsGZip())
+			{
+				rep.bIsGZIP = true;
+				reply::add_header(&rep, "Content-Length", std::to_string(rep.content.size()));
+				reply::add_header(&rep, "Content-Encoding", "gzip");
+			}
+		}
+
 		void CWebServer::Cmd_GetLanguage(WebEmSession &session, const request &req, Json::Value &root)
 		{
 			std::string sValue;
@@ -1034,6 +1142,9 @@ namespace http
 #endif
 				if (ii == HTYPE_PythonPlugin)
 					bDoAdd = false;
+				//test tool, only added through the JSON API
+				if (ii == HTYPE_RxReplay)
+					bDoAdd = false;
 
 				if (bDoAdd)
 					_htypes[Hardware_Type_Desc(ii)] = ii;
@@ -1369,6 +1480,11 @@ namespace http
 			{
 				// all fine here!
 			}
+			else if (htype == HTYPE_RxReplay)
+			{
+				if (address.empty())
+					return;
+			}
 			else
 				return;
 
@@ -1745,6 +1861,11 @@ namespace http
 			{
 				// all fine here!
 			}
+			else if (htype == HTYPE_RxReplay)
+			{
+				if (address.empty())
+					return;
+			}
 			else
 				return;
 
@@ -2119,11 +2240,8 @@ namespace http
 			m_sql.DeleteHardware(idx);
 		}
 
-		void CWebServer::Cmd_GetLog(WebEmSession &session, const request &req, Json::Value &root)
+		void CWebServer::Cmd_GetLog(WebEmSession &session, const request &req, CJSonWriter &writer)
 		{
-			root["status"] = "OK";
-			root["title"] = "GetLog";
-
 			time_t lastlogtime = 0;
 			std::string slastlogtime = request::findValue(&req, "lastlogtime");
 			if (!slastlogtime.empty())
@@ -2139,20 +2257,34 @@ namespace http
 				lLevel = (_eLogLevel)atoi(sloglevel.c_str());
 			}
 
-			std::list<CLogger::_tLogLineStruct> logmessages = _log.GetLog(lLevel);
-			int ii = 0;
+			//only the lines newer than the last poll are copied out of the log buffer
+			std::list<CLogger::_tLogLineStruct> logmessages = _log.GetLog(lLevel, lastlogtime);
+
+			writer.BeginObject();
+			writer.Member("status", "OK");
+			writer.Member("title", "GetLog");
+			bool bHaveResult = false;
+			time_t newlastlogtime = 0;
 			for (const auto &msg : logmessages)
 			{
-				if (msg.logtime > lastlogtime)
+				if (!bHaveResult)
 				{
-					std::stringstream szLogTime;
-					szLogTime << msg.logtime;
-					root["LastLogTime"] = szLogTime.str();
-					root["result"][ii]["level"] = static_cast<int>(msg.level);
-					root["result"][ii]["message"] = msg.logmessage;
-					ii++;
+					writer.Key("result");
+					writer.BeginArray();
+					bHaveResult = true;
 				}
+				newlastlogtime = msg.logtime;
+				writer.BeginObject();
+				writer.Member("level", static_cast<int>(msg.level));
+				writer.Member("message", msg.logmessage);
+				writer.EndObject();
+			}
+			if (bHaveResult)
+			{
+				writer.EndArray();
+				writer.Member("LastLogTime", std::to_string(newlastlogtime));
 			}
+			writer.EndObject();
 		}
 
 		void CWebServer::Cmd_ClearLog(WebEmSession &session, const request &req, Json::Value &root)
@@ -3430,12 +3562,10 @@ namespace http
 			if ((iUser < 0) || (iUser >= (int)m_users.size()))
 				return false;
 
-			if (m_users[iUser].TotSensors == 0)
+			auto pDevices = std::atomic_load(&m_users[iUser].SharedDevices);
+			if ((pDevices == nullptr) || (pDevices->empty()))
 				return true; // all sensors
-
-			std::vector<std::vector<std::string>> result =
-				m_sql.safe_query("SELECT DeviceRowID FROM SharedDevices WHERE (SharedUserID == '%d') AND (DeviceRowID == '%d')", m_users[iUser].ID, Idx);
-			return (!result.empty());
+			return (pDevices->find(static_cast<uint64_t>(Idx)) != pDevices->end());
 		}
 
 		void CWebServer::HandleCommand(const std::string &cparam, WebEmSession &session, const request &req, Json::Value &root)
@@ -3599,6 +3729,7 @@ namespace http
 						m_sql.safe_query("INSERT INTO SceneDevices (DeviceRowID, SceneRowID, Level, Color, OnDelay, OffDelay) VALUES ('%q','%q',%d,'%q',%d,%d)", devidx.c_str(),
 								 idx.c_str(), level, color.c_str(), ondelay, offdelay);
 					}
+					m_sql.InvalidateSceneStatus();
 					if (m_sql.m_bEnableEventSystem)
 						m_mainworker.m_eventsystem.GetCurrentScenesGroups();
 				}
@@ -3655,6 +3786,7 @@ namespace http
 				root["title"] = "DeleteSceneDevice";
 				m_sql.safe_query("DELETE FROM SceneDevices WHERE (ID == '%q')", idx.c_str());
 				m_sql.safe_query("DELETE FROM CamerasActiveDevices WHERE (DevSceneType==1) AND (DevSceneRowID == '%q')", idx.c_str());
+				m_sql.InvalidateSceneStatus();
 				if (m_sql.m_bEnableEventSystem)
 					m_mainworker.m_eventsystem.GetCurrentScenesGroups();
 			}
@@ -3801,6 +3933,7 @@ namespace http
 				root["status"] = "OK";
 				root["title"] = "DeleteAllSceneDevices";
 				result = m_sql.safe_query("DELETE FROM SceneDevices WHERE (SceneRowID == %q)", idx.c_str());
+				m_sql.InvalidateSceneStatus();
 			}
 			else if (cparam == "getmanualhardware")
 			{
@@ -6243,7 +6376,7 @@ namespace http
 				m_sql.safe_query("INSERT INTO Users (Active, Username, Password, Rights, RemoteSharing, TabsEnabled) VALUES (%d,'%q','%q','%d','%d','%d')",
 						 (senabled == "true") ? 1 : 0, base64_encode(username).c_str(), password.c_str(), rights, (sRemoteSharing == "true") ? 1 : 0,
 						 atoi(sTabsEnabled.c_str()));
-				LoadUsers();
+				m_webservers.LoadUsers();
 			}
 			else if (cparam == "updateuser")
 			{
@@ -6304,7 +6437,7 @@ namespace http
 				m_sql.safe_query("UPDATE Users SET Active=%d, Username='%q', Password='%q', Rights=%d, RemoteSharing=%d, TabsEnabled=%d WHERE (ID == '%q')",
 						 (senabled == "true") ? 1 : 0, sHashedUsername.c_str(), password.c_str(), rights, (sRemoteSharing == "true") ? 1 : 0, atoi(sTabsEnabled.c_str()),
 						 idx.c_str());
-				LoadUsers();
+				m_webservers.LoadUsers();
 			}
 			else if (cparam == "deleteuser")
 			{
@@ -6332,7 +6465,7 @@ namespace http
 
 				m_sql.safe_query("DELETE FROM SharedDevices WHERE (SharedUserID == '%q')", idx.c_str());
 
-				LoadUsers();
+				m_webservers.LoadUsers();
 			}
 			else if (cparam == "clearlightlog")
 			{
@@ -7675,27 +7808,46 @@ namespace http
 					}
 				}
 			}
+			LoadSharedDevices();
 			m_mainworker.LoadSharedUsers();
 		}
 
 		void CWebServer::AddUser(const unsigned long ID, const std::string &username, const std::string &password, const int userrights, const int activetabs)
 		{
-			std::vector<std::vector<std::string>> result = m_sql.safe_query("SELECT COUNT(*) FROM SharedDevices WHERE (SharedUserID == '%d')", ID);
-			if (result.empty())
-				return;
-
 			_tWebUserPassword wtmp;
 			wtmp.ID = ID;
 			wtmp.Username = username;
 			wtmp.Password = password;
 			wtmp.userrights = (_eUserRights)userrights;
 			wtmp.ActiveTabs = activetabs;
-			wtmp.TotSensors = atoi(result[0][0].c_str());
+			wtmp.TotSensors = 0;
+			wtmp.SharedDevices = std::make_shared<std::set<uint64_t>>();
 			m_users.push_back(wtmp);
 
 			m_pWebEm->AddUserPassword(ID, username, password, (_eUserRights)userrights, activetabs);
 		}
 
+		//Device visibility of all users in one query, requests and websocket pushes check these sets instead of SharedDevices
+		void CWebServer::LoadSharedDevices()
+		{
+			std::map<unsigned long, std::shared_ptr<std::set<uint64_t>>> userdevices;
+			auto result = m_sql.safe_query("SELECT SharedUserID, DeviceRowID FROM SharedDevices");
+			for (const auto &sd : result)
+			{
+				auto &pDevices = userdevices[std::strtoul(sd[0].c_str(), nullptr, 10)];
+				if (pDevices == nullptr)
+					pDevices = std::make_shared<std::set<uint64_t>>();
+				pDevices->insert(std::strtoull(sd[1].c_str(), nullptr, 10));
+			}
+			for (auto &user : m_users)
+			{
+				auto itt = userdevices.find(user.ID);
+				std::shared_ptr<const std::set<uint64_t>> pDevices = (itt != userdevices.end()) ? itt->second : std::make_shared<std::set<uint64_t>>();
+				user.TotSensors = static_cast<int>(pDevices->size());
+				std::atomic_store(&user.SharedDevices, pDevices);
+			}
+		}
+
 		void CWebServer::ClearUserPasswords()
 		{
 			m_users.clear();
@@ -8042,6 +8194,7 @@ namespace http
 			if (sensortimeout < 10)
 				sensortimeout = 10;
 			m_sql.UpdatePreferencesVar("SensorTimeout", sensortimeout);
+			m_sql.ReloadSensorTimeouts();
 
 			int batterylowlevel = atoi(request::findValue(&req, "BatterLowLevel").c_str());
 			if (batterylowlevel > 100)
@@ -8137,18 +8290,61 @@ namespace http
 			m_mainworker.StopDomoticzHardware();
 
 			m_sql.RestoreDatabase(dbasefile);
+			//the sessions of the restored UserSessions table are read again
+			UncacheSessions([](const WebEmStoredSession & /*session*/, const time_t /*cached*/) { return true; });
+			m_mainworker.ReloadSceneActivators();
 			m_mainworker.AddAllDomoticzHardware();
 		}
 
-		struct _tHardwareListInt
+		std::shared_ptr<const CWebServer::_tDeviceMetadata> CWebServer::GetDeviceMetadata()
 		{
-			std::string Name;
-			int HardwareTypeVal;
-			std::string HardwareType;
-			bool Enabled;
-			std::string Mode1; // Used to flag DimmerType as relative for some old LimitLessLight type bulbs
-			std::string Mode2; // Used to flag DimmerType as relative for some old LimitLessLight type bulbs
-		} tHardwareList;
+			std::lock_guard<std::mutex> l(m_devicemetadataMutex);
+			uint64_t hardwareversion = m_sql.GetTableVersion(CSQLHelper::WTABLE_HARDWARE);
+			uint64_t subdevicesversion = m_sql.GetTableVersion(CSQLHelper::WTABLE_LIGHTSUBDEVICES);
+			if ((m_devicemetadata != nullptr) && (m_devicemetadata->hardwareversion == hardwareversion) && (m_devicemetadata->subdevicesversion == subdevicesversion))
+				return m_devicemetadata;
+
+			auto pMetadata = std::make_shared<_tDeviceMetadata>();
+			pMetadata->hardwareversion = hardwareversion;
+			pMetadata->subdevicesversion = subdevicesversion;
+			bool bComplete = true;
+			std::vector<std::vector<std::string>> result;
+			result = m_sql.safe_query("SELECT ID, Name, Enabled, Type, Mode1, Mode2 FROM Hardware");
+			for (const auto &sd : result)
+			{
+				_tHardwareListInt tlist;
+				int ID = atoi(sd[0].c_str());
+				tlist.Name = sd[1];
+				tlist.Enabled = (atoi(sd[2].c_str()) != 0);
+				tlist.HardwareTypeVal = atoi(sd[3].c_str());
+#ifndef ENABLE_PYTHON
+				tlist.HardwareType = Hardware_Type_Desc(tlist.HardwareTypeVal);
+#else
+				if (tlist.HardwareTypeVal != HTYPE_PythonPlugin)
+				{
+					tlist.HardwareType = Hardware_Type_Desc(tlist.HardwareTypeVal);
+				}
+				else
+				{
+					tlist.HardwareType = PluginHardwareDesc(ID);
+					// the plugin describes itself once it is started, until then this is not cached
+					if ((tlist.Enabled) && (tlist.HardwareType == Hardware_Type_Desc(HTYPE_PythonPlugin)))
+						bComplete = false;
+				}
+#endif
+				tlist.Mode1 = sd[4];
+				tlist.Mode2 = sd[5];
+				pMetadata->hardware[ID] = tlist;
+			}
+			result = m_sql.safe_query("SELECT DISTINCT DeviceRowID FROM LightSubDevices");
+			for (const auto &sd : result)
+				pMetadata->subdevices.insert(std::stoull(sd[0]));
+
+			if (!bComplete)
+				return pMetadata;
+			m_devicemetadata = pMetadata;
+			return m_devicemetadata;
+		}
 
 		void CWebServer::GetJSonDevices(Json::Value &root, const std::string &rused, const std::string &rfilter, const std::string &order, const std::string &rowid, const std::string &planID,
 						const std::string &floorID, const bool bDisplayHidden, const bool bDisplayDisabled, const bool bFetchFavorites, const time_t LastUpdate,
@@ -8168,34 +8364,8 @@ namespace http
 			m_sql.GetPreferencesVar("SensorTimeout", SensorTimeOut);
 
 			// Get All Hardware ID's/Names, need them later
-			std::map<int, _tHardwareListInt> _hardwareNames;
-			result = m_sql.safe_query("SELECT ID, Name, Enabled, Type, Mode1, Mode2 FROM Hardware");
-			if (!result.empty())
-			{
-				for (const auto &sd : result)
-				{
-					_tHardwareListInt tlist;
-					int ID = atoi(sd[0].c_str());
-					tlist.Name = sd[1];
-					tlist.Enabled = (atoi(sd[2].c_str()) != 0);
-					tlist.HardwareTypeVal = atoi(sd[3].c_str());
-#ifndef ENABLE_PYTHON
-					tlist.HardwareType = Hardware_Type_Desc(tlist.HardwareTypeVal);
-#else
-					if (tlist.HardwareTypeVal != HTYPE_PythonPlugin)
-					{
-						tlist.HardwareType = Hardware_Type_Desc(tlist.HardwareTypeVal);
-					}
-					else
-					{
-						tlist.HardwareType = PluginHardwareDesc(ID);
-					}
-#endif
-					tlist.Mode1 = sd[4];
-					tlist.Mode2 = sd[5];
-					_hardwareNames[ID] = tlist;
-				}
-			}
+			auto pMetadata = GetDeviceMetadata();
+			const std::map<int, _tHardwareListInt> &_hardwareNames = pMetadata->hardware;
 
 			root["ActTime"] = static_cast<int>(now);
 
@@ -8248,6 +8418,7 @@ namespace http
 			bool bHaveUser = false;
 			int iUser = -1;
 			unsigned int totUserDevices = 0;
+			std::shared_ptr<const std::set<uint64_t>> pUserDevices;
 			bool bShowScenes = true;
 			bHaveUser = (!username.empty());
 			if (bHaveUser)
@@ -8258,11 +8429,9 @@ namespace http
 					_eUserRights urights = m_users[iUser].userrights;
 					if (urights != URIGHTS_ADMIN)
 					{
-						result = m_sql.safe_query("SELECT COUNT(*) FROM SharedDevices WHERE (SharedUserID == %lu)", m_users[iUser].ID);
-						if (!result.empty())
-						{
-							totUserDevices = (unsigned int)std::stoi(result[0][0]);
-						}
+						pUserDevices = std::atomic_load(&m_users[iUser].SharedDevices);
+						if (pUserDevices != nullptr)
+							totUserDevices = static_cast<unsigned int>(pUserDevices->size());
 						bShowScenes = (m_users[iUser].ActiveTabs & (1 << 1)) != 0;
 					}
 				}
@@ -8517,6 +8686,9 @@ namespace http
 				// Specific devices
 				if (!rowid.empty())
 				{
+					//not shared with this user, websocket pushes of other devices end here
+					if (pUserDevices->find(std::strtoull(rowid.c_str(), nullptr, 10)) == pUserDevices->end())
+						return;
 					//_log.Log(LOG_STATUS, "Getting device with id: %s for user %lu", rowid.c_str(), m_users[iUser].ID);
 					result = m_sql.safe_query("SELECT A.ID, A.DeviceID, A.Unit, A.Name, A.Used,"
 								  " A.Type, A.SubType, A.SignalLevel, A.BatteryLevel,"
@@ -8792,7 +8964,7 @@ namespace http
 					}
 
 					root["result"][ii]["HardwareID"] = hardwareID;
-					if (_hardwareNames.find(hardwareID) == _hardwareNames.end())
+					if (hItt == _hardwareNames.end())
 					{
 						root["result"][ii]["HardwareName"] = "Unknown?";
 						root["result"][ii]["HardwareTypeVal"] = 0;
@@ -8800,9 +8972,9 @@ namespace http
 					}
 					else
 					{
-						root["result"][ii]["HardwareName"] = _hardwareNames[hardwareID].Name;
-						root["result"][ii]["HardwareTypeVal"] = _hardwareNames[hardwareID].HardwareTypeVal;
-						root["result"][ii]["HardwareType"] = _hardwareNames[hardwareID].HardwareType;
+						root["result"][ii]["HardwareName"] = hItt->second.Name;
+						root["result"][ii]["HardwareTypeVal"] = hItt->second.HardwareTypeVal;
+						root["result"][ii]["HardwareType"] = hItt->second.HardwareType;
 					}
 					root["result"][ii]["HardwareDisabled"] = bIsHardwareDisabled;
 
@@ -9008,14 +9180,14 @@ namespace http
 						if (switchtype == STYPE_Dimmer)
 						{
 							DimmerType = "abs";
-							if (_hardwareNames.find(hardwareID) != _hardwareNames.end())
+							if (hItt != _hardwareNames.end())
 							{
 								// Milight V4/V5 bridges do not support absolute dimming for RGB or CW_WW lights
-								if (_hardwareNames[hardwareID].HardwareTypeVal == HTYPE_LimitlessLights &&
-								    atoi(_hardwareNames[hardwareID].Mode2.c_str()) != CLimitLess::LBTYPE_V6 &&
-								    (atoi(_hardwareNames[hardwareID].Mode1.c_str()) == sTypeColor_RGB ||
-								     atoi(_hardwareNames[hardwareID].Mode1.c_str()) == sTypeColor_White ||
-								     atoi(_hardwareNames[hardwareID].Mode1.c_str()) == sTypeColor_CW_WW))
+								if (hItt->second.HardwareTypeVal == HTYPE_LimitlessLights &&
+								    atoi(hItt->second.Mode2.c_str()) != CLimitLess::LBTYPE_V6 &&
+								    (atoi(hItt->second.Mode1.c_str()) == sTypeColor_RGB ||
+								     atoi(hItt->second.Mode1.c_str()) == sTypeColor_White ||
+								     atoi(hItt->second.Mode1.c_str()) == sTypeColor_CW_WW))
 								{
 									DimmerType = "rel";
 								}
@@ -9035,10 +9207,7 @@ namespace http
 							root["result"][ii]["CameraIdx"] = scidx.str();
 						}
 
-						bool bIsSubDevice = false;
-						std::vector<std::vector<std::string>> resultSD;
-						resultSD = m_sql.safe_query("SELECT ID FROM LightSubDevices WHERE (DeviceRowID=='%q')", sd[0].c_str());
-						bIsSubDevice = (!resultSD.empty());
+						bool bIsSubDevice = (pMetadata->subdevices.find(std::stoull(sd[0])) != pMetadata->subdevices.end());
 
 						root["result"][ii]["IsSubDevice"] = bIsSubDevice;
 
@@ -9402,11 +9571,11 @@ namespace http
 					}
 					else if (dType == pTypeThermostat1)
 					{
-						std::vector<std::string> strarray;
-						StringSplit(sValue, ";", strarray);
-						if (strarray.size() == 4)
+						double svalues[4];
+						size_t nsvalues = StringSplitDouble(sValue.c_str(), ';', svalues, 4);
+						if (nsvalues == 4)
 						{
-							double tvalue = ConvertTemperature(atof(strarray[0].c_str()), tempsign);
+							double tvalue = ConvertTemperature(svalues[0], tempsign);
 							root["result"][ii]["Temp"] = tvalue;
 							sprintf(szData, "%.1f %c", tvalue, tempsign);
 							root["result"][ii]["Data"] = szData;
@@ -9439,18 +9608,18 @@ namespace http
 					}
 					else if (dType == pTypeTEMP_HUM)
 					{
-						std::vector<std::string> strarray;
-						StringSplit(sValue, ";", strarray);
-						if (strarray.size() == 3)
+						double svalues[3];
+						size_t nsvalues = StringSplitDouble(sValue.c_str(), ';', svalues, 3);
+						if (nsvalues == 3)
 						{
-							double tempCelcius = atof(strarray[0].c_str());
+							double tempCelcius = svalues[0];
 							double temp = ConvertTemperature(tempCelcius, tempsign);
-							int humidity = atoi(strarray[1].c_str());
+							int humidity = static_cast<int>(svalues[1]);
 
 							root["result"][ii]["Temp"] = temp;
 							root["result"][ii]["Humidity"] = humidity;
-							root["result"][ii]["HumidityStatus"] = RFX_Humidity_Status_Desc(atoi(strarray[2].c_str()));
-							sprintf(szData, "%.1f %c, %d %%", temp, tempsign, atoi(strarray[1].c_str()));
+							root["result"][ii]["HumidityStatus"] = RFX_Humidity_Status_Desc(static_cast<int>(svalues[2]));
+							sprintf(szData, "%.1f %c, %d %%", temp, tempsign, static_cast<int>(svalues[1]));
 							root["result"][ii]["Data"] = szData;
 							root["result"][ii]["HaveTimeout"] = bHaveTimeout;
 
@@ -9470,39 +9639,39 @@ namespace http
 					}
 					else if (dType == pTypeTEMP_HUM_BARO)
 					{
-						std::vector<std::string> strarray;
-						StringSplit(sValue, ";", strarray);
-						if (strarray.size() == 5)
+						double svalues[5];
+						size_t nsvalues = StringSplitDouble(sValue.c_str(), ';', svalues, 5);
+						if (nsvalues == 5)
 						{
-							double tempCelcius = atof(strarray[0].c_str());
+							double tempCelcius = svalues[0];
 							double temp = ConvertTemperature(tempCelcius, tempsign);
-							int humidity = atoi(strarray[1].c_str());
+							int humidity = static_cast<int>(svalues[1]);
 
 							root["result"][ii]["Temp"] = temp;
 							root["result"][ii]["Humidity"] = humidity;
-							root["result"][ii]["HumidityStatus"] = RFX_Humidity_Status_Desc(atoi(strarray[2].c_str()));
-							root["result"][ii]["Forecast"] = atoi(strarray[4].c_str());
+							root["result"][ii]["HumidityStatus"] = RFX_Humidity_Status_Desc(static_cast<int>(svalues[2]));
+							root["result"][ii]["Forecast"] = static_cast<int>(svalues[4]);
 
 							sprintf(szTmp, "%.2f", ConvertTemperature(CalculateDewPoint(tempCelcius, humidity), tempsign));
 							root["result"][ii]["DewPoint"] = szTmp;
 
 							if (dSubType == sTypeTHBFloat)
 							{
-								root["result"][ii]["Barometer"] = atof(strarray[3].c_str());
-								root["result"][ii]["ForecastStr"] = RFX_WSForecast_Desc(atoi(strarray[4].c_str()));
+								root["result"][ii]["Barometer"] = svalues[3];
+								root["result"][ii]["ForecastStr"] = RFX_WSForecast_Desc(static_cast<int>(svalues[4]));
 							}
 							else
 							{
-								root["result"][ii]["Barometer"] = atoi(strarray[3].c_str());
-								root["result"][ii]["ForecastStr"] = RFX_Forecast_Desc(atoi(strarray[4].c_str()));
+								root["result"][ii]["Barometer"] = static_cast<int>(svalues[3]);
+								root["result"][ii]["ForecastStr"] = RFX_Forecast_Desc(static_cast<int>(svalues[4]));
 							}
 							if (dSubType == sTypeTHBFloat)
 							{
-								sprintf(szData, "%.1f %c, %d %%, %.1f hPa", temp, tempsign, atoi(strarray[1].c_str()), atof(strarray[3].c_str()));
+								sprintf(szData, "%.1f %c, %d %%, %.1f hPa", temp, tempsign, static_cast<int>(svalues[1]), svalues[3]);
 							}
 							else
 							{
-								sprintf(szData, "%.1f %c, %d %%, %d hPa", temp, tempsign, atoi(strarray[1].c_str()), atoi(strarray[3].c_str()));
+								sprintf(szData, "%.1f %c, %d %%, %d hPa", temp, tempsign, static_cast<int>(svalues[1]), static_cast<int>(svalues[3]));
 							}
 							root["result"][ii]["Data"] = szData;
 							root["result"][ii]["HaveTimeout"] = bHaveTimeout;
@@ -9518,18 +9687,18 @@ namespace http
 					}
 					else if (dType == pTypeTEMP_BARO)
 					{
-						std::vector<std::string> strarray;
-						StringSplit(sValue, ";", strarray);
-						if (strarray.size() >= 3)
+						double svalues[3];
+						size_t nsvalues = StringSplitDouble(sValue.c_str(), ';', svalues, 3);
+						if (nsvalues >= 3)
 						{
-							double tvalue = ConvertTemperature(atof(strarray[0].c_str()), tempsign);
+							double tvalue = ConvertTemperature(svalues[0], tempsign);
 							root["result"][ii]["Temp"] = tvalue;
-							int forecast = atoi(strarray[2].c_str());
+							int forecast = static_cast<int>(svalues[2]);
 							root["result"][ii]["Forecast"] = forecast;
 							root["result"][ii]["ForecastStr"] = BMP_Forecast_Desc(forecast);
-							root["result"][ii]["Barometer"] = atof(strarray[1].c_str());
+							root["result"][ii]["Barometer"] = svalues[1];
 
-							sprintf(szData, "%.1f %c, %.1f hPa", tvalue, tempsign, atof(strarray[1].c_str()));
+							sprintf(szData, "%.1f %c, %.1f hPa", tvalue, tempsign, svalues[1]);
 							root["result"][ii]["Data"] = szData;
 							root["result"][ii]["HaveTimeout"] = bHaveTimeout;
 
@@ -9650,7 +9819,7 @@ namespace http
 
 							if (dSubType == sTypeRAINWU || dSubType == sTypeRAINByRate)
 							{
-								result2 = m_sql.safe_query("SELECT Total, Rate FROM Rain WHERE (DeviceRowID='%q' AND Date>='%q') ORDER BY ROWID DESC LIMIT 1",
+								result2 = m_sql.safe_query("SELECT Total, Rate FROM Rain WHERE (DeviceRowID='%q' AND Date>='%q') ORDER BY Date DESC LIMIT 1",
 											   sd[0].c_str(), szDate);
 							}
 							else
@@ -10290,9 +10459,9 @@ namespace http
 					}
 					else if (dType == pTypeCURRENT)
 					{
-						std::vector<std::string> strarray;
-						StringSplit(sValue, ";", strarray);
-						if (strarray.size() == 3)
+						double svalues[3];
+						size_t nsvalues = StringSplitDouble(sValue.c_str(), ';', svalues, 3);
+						if (nsvalues == 3)
 						{
 							// CM113
 							int displaytype = 0;
@@ -10300,9 +10469,9 @@ namespace http
 							m_sql.GetPreferencesVar("CM113DisplayType", displaytype);
 							m_sql.GetPreferencesVar("ElectricVoltage", voltage);
 
-							double val1 = atof(strarray[0].c_str());
-							double val2 = atof(strarray[1].c_str());
-							double val3 = atof(strarray[2].c_str());
+							double val1 = svalues[0];
+							double val2 = svalues[1];
+							double val3 = svalues[2];
 
 							if (displaytype == 0)
 							{
@@ -10325,9 +10494,9 @@ namespace http
 					}
 					else if (dType == pTypeCURRENTENERGY)
 					{
-						std::vector<std::string> strarray;
-						StringSplit(sValue, ";", strarray);
-						if (strarray.size() == 4)
+						double svalues[4];
+						size_t nsvalues = StringSplitDouble(sValue.c_str(), ';', svalues, 4);
+						if (nsvalues == 4)
 						{
 							// CM180i
 							int displaytype = 0;
@@ -10335,15 +10504,15 @@ namespace http
 							m_sql.GetPreferencesVar("CM113DisplayType", displaytype);
 							m_sql.GetPreferencesVar("ElectricVoltage", voltage);
 
-							double total = atof(strarray[3].c_str());
+							double total = svalues[3];
 							if (displaytype == 0)
 							{
-								sprintf(szData, "%.1f A, %.1f A, %.1f A", atof(strarray[0].c_str()), atof(strarray[1].c_str()), atof(strarray[2].c_str()));
+								sprintf(szData, "%.1f A, %.1f A, %.1f A", svalues[0], svalues[1], svalues[2]);
 							}
 							else
 							{
-								sprintf(szData, "%d Watt, %d Watt, %d Watt", int(atof(strarray[0].c_str()) * voltage), int(atof(strarray[1].c_str()) * voltage),
-									int(atof(strarray[2].c_str()) * voltage));
+								sprintf(szData, "%d Watt, %d Watt, %d Watt", int(svalues[0] * voltage), int(svalues[1] * voltage),
+									int(svalues[2] * voltage));
 							}
 							if (total > 0)
 							{
@@ -10661,34 +10830,34 @@ namespace http
 						}
 						else if (dSubType == sTypeBaro)
 						{
-							std::vector<std::string> tstrarray;
-							StringSplit(sValue, ";", tstrarray);
-							if (tstrarray.empty())
+							double svalues[2];
+							size_t nsvalues = StringSplitDouble(sValue.c_str(), ';', svalues, 2);
+							if (nsvalues == 0)
 								continue;
-							sprintf(szData, "%g hPa", atof(tstrarray[0].c_str()));
+							sprintf(szData, "%g hPa", svalues[0]);
 							root["result"][ii]["Data"] = szData;
 							root["result"][ii]["TypeImg"] = "gauge";
 							root["result"][ii]["HaveTimeout"] = bHaveTimeout;
-							if (tstrarray.size() > 1)
+							if (nsvalues > 1)
 							{
-								root["result"][ii]["Barometer"] = atof(tstrarray[0].c_str());
-								int forecast = atoi(tstrarray[1].c_str());
+								root["result"][ii]["Barometer"] = svalues[0];
+								int forecast = static_cast<int>(svalues[1]);
 								root["result"][ii]["Forecast"] = forecast;
 								root["result"][ii]["ForecastStr"] = BMP_Forecast_Desc(forecast);
 							}
 						}
 						else if (dSubType == sTypeZWaveClock)
 						{
-							std::vector<std::string> tstrarray;
-							StringSplit(sValue, ";", tstrarray);
+							double svalues[3];
+							size_t nsvalues = StringSplitDouble(sValue.c_str(), ';', svalues, 3);
 							int day = 0;
 							int hour = 0;
 							int minute = 0;
-							if (tstrarray.size() == 3)
+							if (nsvalues == 3)
 							{
-								day = atoi(tstrarray[0].c_str());
-								hour = atoi(tstrarray[1].c_str());
-								minute = atoi(tstrarray[2].c_str());
+								day = static_cast<int>(svalues[0]);
+								hour = static_cast<int>(svalues[1]);
+								minute = static_cast<int>(svalues[2]);
 							}
 							sprintf(szData, "%s %02d:%02d", ZWave_Clock_Days(day), hour, minute);
 							root["result"][ii]["DayTime"] = sValue;
@@ -11150,6 +11319,7 @@ namespace http
 			root["title"] = "UpdateScene";
 			m_sql.safe_query("UPDATE Scenes SET Name='%q', Description='%q', SceneType=%d, Protected=%d, OnAction='%q', OffAction='%q' WHERE (ID == '%q')", name.c_str(),
 					 description.c_str(), atoi(stype.c_str()), iProtected, onaction.c_str(), offaction.c_str(), idx.c_str());
+			m_mainworker.ReloadSceneActivators(); //the SceneType decides if the codes are used
 			uint64_t ullidx = std::strtoull(idx.c_str(), nullptr, 10);
 			m_mainworker.m_eventsystem.WWWUpdateSingleState(ullidx, name, m_mainworker.m_eventsystem.REASON_SCENEGROUP);
 		}
@@ -11518,6 +11688,86 @@ namespace http
 			}
 		}
 
+		void CWebServer::RType_CreateRFLinkDevice(WebEmSession &session, const request &req, Json::Value &root)
+		{
+			if (session.rights != 2)
+			{
+				session.reply_status = reply::forbidden;
+				return; // Only admin user allowed
+			}
+
+			std::string idx = request::findValue(&req, "idx");
+			std::string scommand = request::findValue(&req, "command");
+			if (idx.empty() || scommand.empty())
+			{
+				return;
+			}
+
+#ifdef _DEBUG
+			_log.Log(LOG_STATUS, "RFLink Custom Command: %s", scommand.c_str());
+			_log.Log(LOG_STATUS, "RFLink Custom Command idx: %s", idx.c_str());
+#endif
+
+			bool bCreated = false; // flag to know if the command was a success
+			CRFLinkBase *pRFLINK = reinterpret_cast<CRFLinkBase*>(m_mainworker.GetHardware(atoi(idx.c_str())));
+			if (pRFLINK == nullptr)
+				return;
+
+			if (scommand.substr(0, 14) == "10;rfdebug=on;")
+			{
+				pRFLINK->m_bRFDebug = true; // enable debug
+				_log.Log(LOG_STATUS, "User: %s initiated RFLink Enable Debug mode with command: %s", session.username.c_str(), scommand.c_str());
+				pRFLINK->WriteInt("10;RFDEBUG=ON;\n");
+				root["status"] = "OK";
+				root["title"] = "DebugON";
+				return;
+			}
+			if (scommand.substr(0, 15) == "10;rfdebug=off;")
+			{
+				pRFLINK->m_bRFDebug = false; // disable debug
+				_log.Log(LOG_STATUS, "User: %s initiated RFLink Disable Debug mode with command: %s", session.username.c_str(), scommand.c_str());
+				pRFLINK->WriteInt("10;RFDEBUG=OFF;\n");
+				root["status"] = "OK";
+				root["title"] = "DebugOFF";
+				return;
+			}
+
+			_log.Log(LOG_STATUS, "User: %s initiated a RFLink Device Create command: %s", session.username.c_str(), scommand.c_str());
+			scommand = "11;" + scommand;
+#ifdef _DEBUG
+			_log.Log(LOG_STATUS, "User: %s initiated a RFLink Device Create command: %s", session.username.c_str(), scommand.c_str());
+#endif
+			scommand += "\r\n";
+
+			bCreated = true;
+			pRFLINK->m_bTXokay = false; // clear OK flag
+			pRFLINK->WriteInt(scommand);
+			time_t atime = mytime(nullptr);
+			time_t btime = mytime(nullptr);
+
+			// Wait for an OK response from RFLink to make sure the command was executed
+			while (pRFLINK->m_bTXokay == false)
+			{
+				if (difftime(btime, atime) > 4)
+				{
+					_log.Log(LOG_ERROR, "TX time out...");
+					bCreated = false;
+					break;
+				}
+				btime = mytime(nullptr);
+			}
+
+#ifdef _DEBUG
+			_log.Log(LOG_STATUS, "RFLink custom command done");
+#endif
+
+			if (bCreated)
+			{
+				root["status"] = "OK";
+				root["title"] = "CreateRFLinkDevice";
+			}
+		}
+
 		void CWebServer::RType_Devices(WebEmSession &session, const request &req, Json::Value &root)
 		{
 			std::string rfilter = request::findValue(&req, "filter");
@@ -11779,6 +12029,7 @@ namespace http
 				Activators += ":" + cmnd;
 			}
 			m_sql.safe_query("UPDATE Scenes SET Activators='%q' WHERE (ID==%q)", Activators.c_str(), sceneidx.c_str());
+			m_mainworker.ReloadSceneActivators();
 		}
 
 		void CWebServer::Cmd_RemoveSceneCode(WebEmSession &session, const request &req, Json::Value &root)
@@ -11847,6 +12098,7 @@ namespace http
 				if (Activators != newActivation)
 				{
 					m_sql.safe_query("UPDATE Scenes SET Activators='%q' WHERE (ID==%q)", newActivation.c_str(), sceneidx.c_str());
+					m_mainworker.ReloadSceneActivators();
 				}
 			}
 		}
@@ -11866,6 +12118,7 @@ namespace http
 			root["title"] = "ClearSceneCode";
 
 			m_sql.safe_query("UPDATE Scenes SET Activators='' WHERE (ID==%q)", sceneidx.c_str());
+			m_mainworker.ReloadSceneActivators();
 		}
 
 		void CWebServer::Cmd_GetSerialDevices(WebEmSession &session, const request &req, Json::Value &root)
@@ -12400,6 +12653,21 @@ namespace http
 			root["status"] = "OK";
 			root["title"] = "GetSharedUserDevices";
 
+			//inactive users are not loaded
+			unsigned long userID = std::strtoul(idx.c_str(), nullptr, 10);
+			auto itt = std::find_if(m_users.begin(), m_users.end(), [userID](const _tWebUserPassword &user) { return user.ID == userID; });
+			if (itt != m_users.end())
+			{
+				auto pDevices = std::atomic_load(&itt->SharedDevices);
+				int ii = 0;
+				for (const auto &device : *pDevices)
+				{
+					root["result"][ii]["DeviceRowIdx"] = std::to_string(device);
+					ii++;
+				}
+				return;
+			}
+
 			std::vector<std::vector<std::string>> result;
 			result = m_sql.safe_query("SELECT DeviceRowID FROM SharedDevices WHERE (SharedUserID == '%q')", idx.c_str());
 			if (!result.empty())
@@ -12436,7 +12704,8 @@ namespace http
 						 idx.c_str());
 			}
 			m_sql.safe_query("DELETE FROM SharedDevices WHERE SharedUserID == 0");
-			LoadUsers();
+			//every instance (http and https) keeps its own copy of the shared devices
+			m_webservers.ReloadSharedDevices();
 		}
 
 		void CWebServer::RType_SetUsed(WebEmSession &session, const request &req, Json::Value &root)
@@ -13332,6 +13601,184 @@ namespace http
 			}
 		}
 
+		//Day graphs with one short log row per sample, the other graphs build a Json::Value tree in RType_HandleGraph
+		bool CWebServer::IsStreamGraphDay(const std::string &sensor)
+		{
+			return ((sensor == "temp") || (sensor == "Percentage") || (sensor == "fan") || (sensor == "uv") || (sensor == "rain") || (sensor == "wind"));
+		}
+
+		void CWebServer::RType_HandleGraphDay(WebEmSession &session, const request &req, CJSonWriter &writer)
+		{
+			uint64_t idx = 0;
+			if (!request::findValue(&req, "idx").empty())
+			{
+				idx = std::strtoull(request::findValue(&req, "idx").c_str(), nullptr, 10);
+			}
+			std::string sensor = request::findValue(&req, "sensor");
+
+			writer.BeginObject();
+			std::vector<std::vector<std::string>> result;
+			result = m_sql.safe_query("SELECT Type, SubType, AddjMulti FROM DeviceStatus WHERE (ID == %" PRIu64 ")", idx);
+			if (result.empty())
+			{
+				writer.Member("status", "ERR");
+				writer.EndObject();
+				return;
+			}
+			unsigned char dType = atoi(result[0][0].c_str());
+			unsigned char dSubType = atoi(result[0][1].c_str());
+			double AddjMulti = atof(result[0][2].c_str());
+
+			writer.Member("status", "OK");
+			writer.Member("title", "Graph " + sensor + " day");
+
+			//the result array is only written when there is at least one row, as with a Json::Value tree
+			bool bHaveResult = false;
+			auto BeginRow = [&writer, &bHaveResult](const std::string &sDate) {
+				if (!bHaveResult)
+				{
+					writer.Key("result");
+					writer.BeginArray();
+					bHaveResult = true;
+				}
+				writer.BeginObject();
+				writer.Member("d", sDate);
+			};
+
+			char szTmp[50];
+			if (sensor == "temp")
+			{
+				unsigned char tempsign = m_sql.m_tempsign[0];
+				bool bHaveTemp = (dType == pTypeRego6XXTemp) || (dType == pTypeTEMP) || (dType == pTypeTEMP_HUM) || (dType == pTypeTEMP_HUM_BARO) || (dType == pTypeTEMP_BARO) ||
+						 ((dType == pTypeWIND) && (dSubType == sTypeWIND4)) || ((dType == pTypeUV) && (dSubType == sTypeUV3)) || (dType == pTypeThermostat1) ||
+						 (dType == pTypeRadiator1) || ((dType == pTypeRFXSensor) && (dSubType == sTypeRFXSensorTemp)) || ((dType == pTypeGeneral) && (dSubType == sTypeSystemTemp)) ||
+						 ((dType == pTypeGeneral) && (dSubType == sTypeBaro)) || ((dType == pTypeThermostat) && (dSubType == sTypeThermSetpoint)) || (dType == pTypeEvohomeZone) ||
+						 (dType == pTypeEvohomeWater);
+				bool bHaveChill = ((dType == pTypeWIND) && (dSubType == sTypeWIND4)) || ((dType == pTypeWIND) && (dSubType == sTypeWINDNoTemp));
+				bool bHaveHum = (dType == pTypeHUM) || (dType == pTypeTEMP_HUM) || (dType == pTypeTEMP_HUM_BARO);
+				bool bHaveBaro = (dType == pTypeTEMP_HUM_BARO) || (dType == pTypeTEMP_BARO) || ((dType == pTypeGeneral) && (dSubType == sTypeBaro));
+				//stored in 1/10 hPa
+				bool bBaroTenths = !((dType == pTypeTEMP_HUM_BARO) && (dSubType != sTypeTHBFloat));
+				bool bHaveSetPoint = (dType == pTypeEvohomeZone) || (dType == pTypeEvohomeWater);
+
+				result = m_sql.safe_query("SELECT Temperature, Chill, Humidity, Barometer, Date, SetPoint FROM Temperature WHERE (DeviceRowID==%" PRIu64 ") ORDER BY Date ASC", idx);
+				for (const auto &sd : result)
+				{
+					BeginRow(sd[4].substr(0, 16));
+					if (bHaveTemp)
+						writer.Member("te", ConvertTemperature(atof(sd[0].c_str()), tempsign));
+					if (bHaveChill)
+						writer.Member("ch", ConvertTemperature(atof(sd[1].c_str()), tempsign));
+					if (bHaveHum)
+						writer.Member("hu", sd[2]);
+					if (bHaveBaro)
+					{
+						if (bBaroTenths)
+						{
+							sprintf(szTmp, "%.1f", atof(sd[3].c_str()) / 10.0F);
+							writer.Member("ba", szTmp);
+						}
+						else
+							writer.Member("ba", sd[3]);
+					}
+					if (bHaveSetPoint)
+						writer.Member("se", ConvertTemperature(atof(sd[5].c_str()), tempsign));
+					writer.EndObject();
+				}
+			}
+			else if ((sensor == "Percentage") || (sensor == "fan") || (sensor == "uv"))
+			{
+				if (sensor == "Percentage")
+					result = m_sql.safe_query("SELECT Percentage, Date FROM Percentage WHERE (DeviceRowID==%" PRIu64 ") ORDER BY Date ASC", idx);
+				else if (sensor == "fan")
+					result = m_sql.safe_query("SELECT Speed, Date FROM Fan WHERE (DeviceRowID==%" PRIu64 ") ORDER BY Date ASC", idx);
+				else
+					result = m_sql.safe_query("SELECT Level, Date FROM UV WHERE (DeviceRowID==%" PRIu64 ") ORDER BY Date ASC", idx);
+				const char *szValueKey = (sensor == "uv") ? "uvi" : "v";
+				for (const auto &sd : result)
+				{
+					BeginRow(sd[1].substr(0, 16));
+					writer.Member(szValueKey, sd[0]);
+					writer.EndObject();
+				}
+			}
+			else if (sensor == "rain")
+			{
+				int LastHour = -1;
+				float LastTotalPreviousHour = -1;
+
+				float LastValue = -1;
+				std::string LastDate;
+
+				result = m_sql.safe_query("SELECT Total, Date FROM Rain WHERE (DeviceRowID==%" PRIu64 ") ORDER BY Date ASC", idx);
+				for (const auto &sd : result)
+				{
+					float ActTotal = static_cast<float>(atof(sd[0].c_str()));
+					int Hour = atoi(sd[1].substr(11, 2).c_str());
+					if (Hour != LastHour)
+					{
+						if (LastHour != -1)
+						{
+							int NextCalculatedHour = (LastHour + 1) % 24;
+							double mmval;
+							if (Hour != NextCalculatedHour)
+							{
+								// Looks like we have a GAP somewhere, finish the last hour
+								BeginRow(LastDate);
+								mmval = ActTotal - LastValue;
+							}
+							else
+							{
+								BeginRow(sd[1].substr(0, 16));
+								mmval = ActTotal - LastTotalPreviousHour;
+							}
+							mmval *= AddjMulti;
+							sprintf(szTmp, "%.1f", mmval);
+							writer.Member("mm", szTmp);
+							writer.EndObject();
+						}
+						LastHour = Hour;
+						LastTotalPreviousHour = ActTotal;
+					}
+					LastValue = ActTotal;
+					LastDate = sd[1];
+				}
+			}
+			else if (sensor == "wind")
+			{
+				result = m_sql.safe_query("SELECT Direction, Speed, Gust, Date FROM Wind WHERE (DeviceRowID==%" PRIu64 ") ORDER BY Date ASC", idx);
+				for (const auto &sd : result)
+				{
+					BeginRow(sd[3].substr(0, 16));
+					writer.Member("di", sd[0]);
+
+					int intSpeed = atoi(sd[1].c_str());
+					int intGust = atoi(sd[2].c_str());
+
+					if (m_sql.m_windunit != WINDUNIT_Beaufort)
+					{
+						sprintf(szTmp, "%.1f", float(intSpeed) * m_sql.m_windscale);
+						writer.Member("sp", szTmp);
+						sprintf(szTmp, "%.1f", float(intGust) * m_sql.m_windscale);
+						writer.Member("gu", szTmp);
+					}
+					else
+					{
+						float windspeedms = float(intSpeed) * 0.1F;
+						float windgustms = float(intGust) * 0.1F;
+						sprintf(szTmp, "%d", MStoBeaufort(windspeedms));
+						writer.Member("sp", szTmp);
+						sprintf(szTmp, "%d", MStoBeaufort(windgustms));
+						writer.Member("gu", szTmp);
+					}
+					writer.EndObject();
+				}
+			}
+			if (bHaveResult)
+				writer.EndArray();
+			writer.EndObject();
+		}
+
 		void CWebServer::RType_HandleGraph(WebEmSession &session, const request &req, Json::Value &root)
 		{
 			uint64_t idx = 0;
@@ -13449,106 +13896,7 @@ namespace http
 
 			if (srange == "day")
 			{
-				if (sensor == "temp")
-				{
-					root["status"] = "OK";
-					root["title"] = "Graph " + sensor + " " + srange;
-
-					result = m_sql.safe_query("SELECT Temperature, Chill, Humidity, Barometer, Date, SetPoint FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY Date ASC",
-								  dbasetable.c_str(), idx);
-					if (!result.empty())
-					{
-						int ii = 0;
-						for (const auto &sd : result)
-						{
-							root["result"][ii]["d"] = sd[4].substr(0, 16);
-							if ((dType == pTypeRego6XXTemp) || (dType == pTypeTEMP) || (dType == pTypeTEMP_HUM) || (dType == pTypeTEMP_HUM_BARO) ||
-							    (dType == pTypeTEMP_BARO) || ((dType == pTypeWIND) && (dSubType == sTypeWIND4)) || ((dType == pTypeUV) && (dSubType == sTypeUV3)) ||
-							    (dType == pTypeThermostat1) || (dType == pTypeRadiator1) || ((dType == pTypeRFXSensor) && (dSubType == sTypeRFXSensorTemp)) ||
-							    ((dType == pTypeGeneral) && (dSubType == sTypeSystemTemp)) || ((dType == pTypeGeneral) && (dSubType == sTypeBaro)) ||
-							    ((dType == pTypeThermostat) && (dSubType == sTypeThermSetpoint)) || (dType == pTypeEvohomeZone) || (dType == pTypeEvohomeWater))
-							{
-								double tvalue = ConvertTemperature(atof(sd[0].c_str()), tempsign);
-								root["result"][ii]["te"] = tvalue;
-							}
-							if (((dType == pTypeWIND) && (dSubType == sTypeWIND4)) || ((dType == pTypeWIND) && (dSubType == sTypeWINDNoTemp)))
-							{
-								double tvalue = ConvertTemperature(atof(sd[1].c_str()), tempsign);
-								root["result"][ii]["ch"] = tvalue;
-							}
-							if ((dType == pTypeHUM) || (dType == pTypeTEMP_HUM) || (dType == pTypeTEMP_HUM_BARO))
-							{
-								root["result"][ii]["hu"] = sd[2];
-							}
-							if ((dType == pTypeTEMP_HUM_BARO) || (dType == pTypeTEMP_BARO) || ((dType == pTypeGeneral) && (dSubType == sTypeBaro)))
-							{
-								if (dType == pTypeTEMP_HUM_BARO)
-								{
-									if (dSubType == sTypeTHBFloat)
-									{
-										sprintf(szTmp, "%.1f", atof(sd[3].c_str()) / 10.0F);
-										root["result"][ii]["ba"] = szTmp;
-									}
-									else
-										root["result"][ii]["ba"] = sd[3];
-								}
-								else if (dType == pTypeTEMP_BARO)
-								{
-									sprintf(szTmp, "%.1f", atof(sd[3].c_str()) / 10.0F);
-									root["result"][ii]["ba"] = szTmp;
-								}
-								else if ((dType == pTypeGeneral) && (dSubType == sTypeBaro))
-								{
-									sprintf(szTmp, "%.1f", atof(sd[3].c_str()) / 10.0F);
-									root["result"][ii]["ba"] = szTmp;
-								}
-							}
-							if ((dType == pTypeEvohomeZone) || (dType == pTypeEvohomeWater))
-							{
-								double se = ConvertTemperature(atof(sd[5].c_str()), tempsign);
-								root["result"][ii]["se"] = se;
-							}
-
-							ii++;
-						}
-					}
-				}
-				else if (sensor == "Percentage")
-				{
-					root["status"] = "OK";
-					root["title"] = "Graph " + sensor + " " + srange;
-
-					result = m_sql.safe_query("SELECT Percentage, Date FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY Date ASC", dbasetable.c_str(), idx);
-					if (!result.empty())
-					{
-						int ii = 0;
-						for (const auto &sd : result)
-						{
-							root["result"][ii]["d"] = sd[1].substr(0, 16);
-							root["result"][ii]["v"] = sd[0];
-							ii++;
-						}
-					}
-				}
-				else if (sensor == "fan")
-				{
-					root["status"] = "OK";
-					root["title"] = "Graph " + sensor + " " + srange;
-
-					result = m_sql.safe_query("SELECT Speed, Date FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY Date ASC", dbasetable.c_str(), idx);
-					if (!result.empty())
-					{
-						int ii = 0;
-						for (const auto &sd : result)
-						{
-							root["result"][ii]["d"] = sd[1].substr(0, 16);
-							root["result"][ii]["v"] = sd[0];
-							ii++;
-						}
-					}
-				}
-
-				else if (sensor == "counter")
+				if (sensor == "counter")
 				{
 					if (dType == pTypeP1Power)
 					{
@@ -14335,112 +14683,6 @@ namespace http
 						}
 					}
 				}
-				else if (sensor == "uv")
-				{
-					root["status"] = "OK";
-					root["title"] = "Graph " + sensor + " " + srange;
-
-					result = m_sql.safe_query("SELECT Level, Date FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY Date ASC", dbasetable.c_str(), idx);
-					if (!result.empty())
-					{
-						int ii = 0;
-						for (const auto &sd : result)
-						{
-							root["result"][ii]["d"] = sd[1].substr(0, 16);
-							root["result"][ii]["uvi"] = sd[0];
-							ii++;
-						}
-					}
-				}
-				else if (sensor == "rain")
-				{
-					root["status"] = "OK";
-					root["title"] = "Graph " + sensor + " " + srange;
-
-					int LastHour = -1;
-					float LastTotalPreviousHour = -1;
-
-					float LastValue = -1;
-					std::string LastDate;
-
-					result = m_sql.safe_query("SELECT Total, Date FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY Date ASC", dbasetable.c_str(), idx);
-					if (!result.empty())
-					{
-						int ii = 0;
-						for (const auto &sd : result)
-						{
-							float ActTotal = static_cast<float>(atof(sd[0].c_str()));
-							int Hour = atoi(sd[1].substr(11, 2).c_str());
-							if (Hour != LastHour)
-							{
-								if (LastHour != -1)
-								{
-									int NextCalculatedHour = (LastHour + 1) % 24;
-									if (Hour != NextCalculatedHour)
-									{
-										// Looks like we have a GAP somewhere, finish the last hour
-										root["result"][ii]["d"] = LastDate;
-										double mmval = ActTotal - LastValue;
-										mmval *= AddjMulti;
-										sprintf(szTmp, "%.1f", mmval);
-										root["result"][ii]["mm"] = szTmp;
-										ii++;
-									}
-									else
-									{
-										root["result"][ii]["d"] = sd[1].substr(0, 16);
-										double mmval = ActTotal - LastTotalPreviousHour;
-										mmval *= AddjMulti;
-										sprintf(szTmp, "%.1f", mmval);
-										root["result"][ii]["mm"] = szTmp;
-										ii++;
-									}
-								}
-								LastHour = Hour;
-								LastTotalPreviousHour = ActTotal;
-							}
-							LastValue = ActTotal;
-							LastDate = sd[1];
-						}
-					}
-				}
-				else if (sensor == "wind")
-				{
-					root["status"] = "OK";
-					root["title"] = "Graph " + sensor + " " + srange;
-
-					result = m_sql.safe_query("SELECT Direction, Speed, Gust, Date FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY Date ASC", dbasetable.c_str(), idx);
-					if (!result.empty())
-					{
-						int ii = 0;
-						for (const auto &sd : result)
-						{
-							root["result"][ii]["d"] = sd[3].substr(0, 16);
-							root["result"][ii]["di"] = sd[0];
-
-							int intSpeed = atoi(sd[1].c_str());
-							int intGust = atoi(sd[2].c_str());
-
-							if (m_sql.m_windunit != WINDUNIT_Beaufort)
-							{
-								sprintf(szTmp, "%.1f", float(intSpeed) * m_sql.m_windscale);
-								root["result"][ii]["sp"] = szTmp;
-								sprintf(szTmp, "%.1f", float(intGust) * m_sql.m_windscale);
-								root["result"][ii]["gu"] = szTmp;
-							}
-							else
-							{
-								float windspeedms = float(intSpeed) * 0.1F;
-								float windgustms = float(intGust) * 0.1F;
-								sprintf(szTmp, "%d", MStoBeaufort(windspeedms));
-								root["result"][ii]["sp"] = szTmp;
-								sprintf(szTmp, "%d", MStoBeaufort(windgustms));
-								root["result"][ii]["gu"] = szTmp;
-							}
-							ii++;
-						}
-					}
-				}
 				else if (sensor == "winddir")
 				{
 					root["status"] = "OK";
@@ -14720,7 +14962,7 @@ namespace http
 					// add today (have to calculate it)
 					if (dSubType == sTypeRAINWU || dSubType == sTypeRAINByRate)
 					{
-						result = m_sql.safe_query("SELECT Total, Total, Rate FROM Rain WHERE (DeviceRowID=%" PRIu64 " AND Date>='%q') ORDER BY ROWID DESC LIMIT 1", idx,
+						result = m_sql.safe_query("SELECT Total, Total, Rate FROM Rain WHERE (DeviceRowID=%" PRIu64 " AND Date>='%q') ORDER BY Date DESC LIMIT 1", idx,
 									  szDateEnd);
 					}
 					else
@@ -15383,7 +15625,7 @@ namespace http
 					// add today (have to calculate it)
 					if (dSubType == sTypeRAINWU || dSubType == sTypeRAINByRate)
 					{
-						result = m_sql.safe_query("SELECT Total, Total, Rate FROM Rain WHERE (DeviceRowID=%" PRIu64 " AND Date>='%q') ORDER BY ROWID DESC LIMIT 1", idx,
+						result = m_sql.safe_query("SELECT Total, Total, Rate FROM Rain WHERE (DeviceRowID=%" PRIu64 " AND Date>='%q') ORDER BY Date DESC LIMIT 1", idx,
 									  szDateEnd);
 					}
 					else
@@ -16934,7 +17176,7 @@ namespace http
 					// add today (have to calculate it)
 					if (dSubType == sTypeRAINWU || dSubType == sTypeRAINByRate)
 					{
-						result = m_sql.safe_query("SELECT Total, Total, Rate FROM Rain WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q') ORDER BY ROWID DESC LIMIT 1", idx,
+						result = m_sql.safe_query("SELECT Total, Total, Rate FROM Rain WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q') ORDER BY Date DESC LIMIT 1", idx,
 									  szDateEnd.c_str());
 					}
 					else
@@ -17220,25 +17462,34 @@ namespace http
 			if (sessionId.empty())
 			{
 				_log.Log(LOG_ERROR, "SessionStore : cannot get session without id.");
+				return session;
 			}
-			else
+
+			time_t now = mytime(nullptr);
 			{
-				std::vector<std::vector<std::string>> result;
-				result = m_sql.safe_query("SELECT SessionID, Username, AuthToken, ExpirationDate FROM UserSessions WHERE SessionID = '%q'", sessionId.c_str());
-				if (!result.empty())
-				{
-					session.id = result[0][0];
-					session.username = base64_decode(result[0][1]);
-					session.auth_token = result[0][2];
+				_tSessionCacheShard &shard = GetSessionCacheShard(sessionId);
+				std::lock_guard<std::mutex> l(shard.mutex);
+				auto itt = shard.sessions.find(sessionId);
+				if ((itt != shard.sessions.end()) && (now - itt->second.cached < SESSION_CACHE_TTL))
+					return itt->second.session;
+			}
 
-					std::string sExpirationDate = result[0][3];
-					// time_t now = mytime(NULL);
-					struct tm tExpirationDate;
-					ParseSQLdatetime(session.expires, tExpirationDate, sExpirationDate);
-					// RemoteHost is not used to restore the session
-					// LastUpdate is not used to restore the session
-				}
+			std::vector<std::vector<std::string>> result;
+			result = m_sql.safe_query("SELECT SessionID, Username, AuthToken, ExpirationDate FROM UserSessions WHERE SessionID = '%q'", sessionId.c_str());
+			if (!result.empty())
+			{
+				session.id = result[0][0];
+				session.username = base64_decode(result[0][1]);
+				session.auth_token = result[0][2];
+
+				std::string sExpirationDate = result[0][3];
+				// time_t now = mytime(NULL);
+				struct tm tExpirationDate;
+				ParseSQLdatetime(session.expires, tExpirationDate, sExpirationDate);
+				// RemoteHost is not used to restore the session
+				// LastUpdate is not used to restore the session
 			}
+			CacheSession(sessionId, session, now);
 
 			return session;
 		}
@@ -17390,12 +17641,18 @@ namespace http
 			{
 				m_sql.safe_query("INSERT INTO UserSessions (SessionID, Username, AuthToken, ExpirationDate, RemoteHost) VALUES ('%q', '%q', '%q', '%q', '%q')", session.id.c_str(),
 						 base64_encode(session.username).c_str(), session.auth_token.c_str(), szExpires, remote_host.c_str());
+				storedSession = session;
 			}
 			else
 			{
 				m_sql.safe_query("UPDATE UserSessions set AuthToken = '%q', ExpirationDate = '%q', RemoteHost = '%q', LastUpdate = datetime('now', 'localtime') WHERE SessionID = '%q'",
 						 session.auth_token.c_str(), szExpires, remote_host.c_str(), session.id.c_str());
+				//the username of an existing session is not updated
+				storedSession.auth_token = session.auth_token;
+				storedSession.expires = session.expires;
 			}
+			storedSession.remote_host.clear(); // not used to restore the session
+			CacheSession(session.id, storedSession, mytime(nullptr));
 		}
 
 		/**
@@ -17409,6 +17666,7 @@ namespace http
 				return;
 			}
 			m_sql.safe_query("DELETE FROM UserSessions WHERE SessionID = '%q'", sessionId.c_str());
+			CacheSession(sessionId, WebEmStoredSession(), mytime(nullptr));
 		}
 
 		/**
@@ -17418,6 +17676,11 @@ namespace http
 		{
 			//_log.Log(LOG_STATUS, "SessionStore : clean...");
 			m_sql.safe_query("DELETE FROM UserSessions WHERE ExpirationDate < datetime('now', 'localtime')");
+			//drop expired sessions and entries past their time to live in one pass, instead of on each lookup
+			time_t now = mytime(nullptr);
+			UncacheSessions([now](const WebEmStoredSession &session, const time_t cached) {
+				return ((now - cached >= SESSION_CACHE_TTL) || ((!session.id.empty()) && (session.expires < now)));
+			});
 		}
 
 		/**
@@ -17430,6 +17693,9 @@ namespace http
 		void CWebServer::RemoveUsersSessions(const std::string &username, const WebEmSession &exceptSession)
 		{
 			m_sql.safe_query("DELETE FROM UserSessions WHERE (Username=='%q') and (SessionID!='%q')", username.c_str(), exceptSession.id.c_str());
+			UncacheSessions([&](const WebEmStoredSession &session, const time_t /*cached*/) {
+				return ((!session.id.empty()) && (session.id != exceptSession.id) && (base64_encode(session.username) == username));
+			});
 		}
 
 	} // namespace server
@@ -7,6 +7,7 @@
 
 struct lua_State;
 struct lua_Debug;
+class CJSonWriter;
 
 namespace Json
 {
@@ -20,6 +21,7 @@ namespace http {
 class CWebServer : public session_store, public std::enable_shared_from_this<CWebServer>
 {
 	typedef std::function<void(WebEmSession &session, const request &req, Json::Value &root)> webserver_response_function;
+	typedef std::function<void(WebEmSession &session, const request &req, CJSonWriter &writer)> webserver_stream_function;
 
       public:
 	struct _tCustomIcon
@@ -35,6 +37,8 @@ class CWebServer : public session_store, public std::enable_shared_from_this<CWe
 	void StopServer();
 	void RegisterCommandCode(const char *idname, const webserver_response_function &ResponseFunction, bool bypassAuthentication = false);
 	void RegisterRType(const char *idname, const webserver_response_function &ResponseFunction);
+	//Commands with large responses, written directly instead of building a Json::Value tree first
+	void RegisterStreamCommandCode(const char *idname, const webserver_stream_function &ResponseFunction);
 
 	void DisplaySwitchTypesCombo(std::string & content_part);
 	void DisplayMeterTypesCombo(std::string & content_part);
@@ -74,6 +78,7 @@ class CWebServer : public session_store, public std::enable_shared_from_this<CWe
 	void LoadUsers();
 	void AddUser(unsigned long ID, const std::string &username, const std::string &password, int userrights, int activetabs);
 	void ClearUserPasswords();
+	void LoadSharedDevices();
 	bool FindAdminUser();
 	int FindUser(const char* szUserName);
 	void SetWebCompressionMode(_eWebCompressionMode gzmode);
@@ -96,6 +101,7 @@ class CWebServer : public session_store, public std::enable_shared_from_this<CWe
 
 private:
 	void HandleCommand(const std::string &cparam, WebEmSession & session, const request& req, Json::Value &root);
+	void HandleStreamCommand(const webserver_stream_function &StreamFunction, WebEmSession &session, const request &req, reply &rep);
 	void HandleRType(const std::string &rtype, WebEmSession & session, const request& req, Json::Value &root);
     void GroupBy(Json::Value &root, std::string dbasetable, uint64_t idx, std::string sgroupby, std::function<std::string (std::string)> counterExpr, std::function<std::string (std::string)> valueExpr, std::function<std::string (double)> sumToResult);
     void AddTodayValueToResult(Json::Value &root, std::string sgroupby, std::string today, float todayValue, std::string formatString);
@@ -161,7 +167,7 @@ private:
 	void Cmd_GetUserVariables(WebEmSession & session, const request& req, Json::Value &root);
 	void Cmd_GetUserVariable(WebEmSession & session, const request& req, Json::Value &root);
 	void Cmd_AllowNewHardware(WebEmSession & session, const request& req, Json::Value &root);
-	void Cmd_GetLog(WebEmSession & session, const request& req, Json::Value &root);
+	void Cmd_GetLog(WebEmSession & session, const request& req, CJSonWriter &writer);
 	void Cmd_ClearLog(WebEmSession & session, const request& req, Json::Value &root);
 	void Cmd_AddPlan(WebEmSession & session, const request& req, Json::Value &root);
 	void Cmd_UpdatePlan(WebEmSession & session, const request& req, Json::Value &root);
@@ -293,6 +299,8 @@ private:
 
 	//RTypes
 	void RType_HandleGraph(WebEmSession & session, const request& req, Json::Value &root);
+	static bool IsStreamGraphDay(const std::string &sensor);
+	void RType_HandleGraphDay(WebEmSession & session, const request& req, CJSonWriter &writer);
 	void RType_LightLog(WebEmSession & session, const request& req, Json::Value &root);
 	void RType_TextLog(WebEmSession & session, const request& req, Json::Value &root);
 	void RType_SceneLog(WebEmSession & session, const request& req, Json::Value &root);
@@ -381,9 +389,31 @@ private:
 
 	std::map < std::string, webserver_response_function > m_webcommands;
 	std::map < std::string, webserver_response_function > m_webrtypes;
+	std::map < std::string, webserver_stream_function > m_webstreamcommands;
 	void Do_Work();
 	std::vector<_tCustomIcon> m_custom_light_icons;
 	std::map<int, int> m_custom_light_icons_lookup;
+
+	struct _tHardwareListInt
+	{
+		std::string Name;
+		int HardwareTypeVal;
+		std::string HardwareType;
+		bool Enabled;
+		std::string Mode1; // Used to flag DimmerType as relative for some old LimitLessLight type bulbs
+		std::string Mode2; // Used to flag DimmerType as relative for some old LimitLessLight type bulbs
+	};
+	//What GetJSonDevices needs besides the devices themselves, rebuilt when the tables it is read from change
+	struct _tDeviceMetadata
+	{
+		uint64_t hardwareversion;
+		uint64_t subdevicesversion;
+		std::map<int, _tHardwareListInt> hardware;
+		std::set<uint64_t> subdevices; //switches that are a sub device of another switch
+	};
+	std::mutex m_devicemetadataMutex;
+	std::shared_ptr<const _tDeviceMetadata> m_devicemetadata;
+	std::shared_ptr<const _tDeviceMetadata> GetDeviceMetadata();
 	bool m_bDoStop;
 	std::string m_server_alias;
 };
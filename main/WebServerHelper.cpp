@@ -142,6 +142,14 @@ namespace http {
 			}
 		}
 		
+		void CWebServerHelper::ReloadSharedDevices()
+		{
+			for (auto &it : serverCollection)
+			{
+				it->LoadSharedDevices();
+			}
+		}
+
 		void CWebServerHelper::ClearUserPasswords()
 		{
 			for (auto &it : serverCollection)
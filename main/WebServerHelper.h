@@ -40,6 +40,7 @@ namespace http {
 					    const std::string &hardwareid = "");
 			// called from CSQLHelper
 			void ReloadCustomSwitchIcons();
+			void ReloadSharedDevices();
 			std::string our_listener_port;
 		private:
 			std::shared_ptr<CWebServer> plainServer_;
@@ -83,6 +83,8 @@ namespace
 #endif
 		"\t-noupdates do not use the internal update functionality\n"
 		"\t-dbase_disable_wal_mode\n"
+		"\t-dbase_compact_history (convert the log/history tables to a smaller and faster layout, one-time)\n"
+		"\t-rxrecord file_path (record all received frames, for replay with the RxReplay hardware)\n"
 #if defined WIN32
 		"\t-log file_path (for example D:\\domoticz.log)\n"
 #else
@@ -124,6 +126,7 @@ std::string szUserDataFolder;
 std::string szWWWFolder;
 std::string szWebRoot;
 std::string dbasefile;
+std::string szRxRecordFile;
 
 /*
 #define VCGENCMDTEMPCOMMAND "vcgencmd measure_temp"
@@ -586,6 +589,9 @@ bool ParseConfigFile(const std::string &szConfigFile)
 		else if ( (szFlag == "dbase_disable_wal_mode") && (GetConfigBool(sLine) ) )  {
 			journalMode = "DELETE";
 		}
+		else if (szFlag == "dbase_compact_history") {
+			m_sql.SetCompactHistory(GetConfigBool(sLine));
+		}
 
 		else if (szFlag == "startup_delay") {
 			int DelaySeconds = atoi(sLine.c_str());
@@ -595,6 +601,9 @@ bool ParseConfigFile(const std::string &szConfigFile)
 		else if (szFlag == "updates") {
 			g_bUseUpdater = GetConfigBool(sLine);
 		}
+		else if (szFlag == "rxrecord_file") {
+			szRxRecordFile = sLine;
+		}
 		else if (szFlag == "php_cgi_path") {
 			webserver_settings.php_cgi_path = sLine;
 #ifdef WWW_ENABLE_SSL
@@ -1006,6 +1015,10 @@ int main(int argc, char**argv)
 		{
 			journalMode = "DELETE";
 		}
+		if (cmdLine.HasSwitch("-dbase_compact_history"))
+		{
+			m_sql.SetCompactHistory(true);
+		}
 	}
 	m_sql.SetJournalMode(journalMode);
 
@@ -1025,6 +1038,15 @@ int main(int argc, char**argv)
 		{
 			g_bUseUpdater = false;
 		}
+		if (cmdLine.HasSwitch("-rxrecord"))
+		{
+			if (cmdLine.GetArgumentCount("-rxrecord") != 1)
+			{
+				_log.Log(LOG_ERROR, "Please specify a file to record to");
+				return 1;
+			}
+			szRxRecordFile = cmdLine.GetSafeArgument("-rxrecord", 0, "");
+		}
 	}
 
 #if defined WIN32
@@ -147,6 +147,7 @@
 #include "../hardware/OctoPrintMQTT.h"
 #include "../hardware/Meteorologisk.h"
 #include "../hardware/AirconWithMe.h"
+#include "../hardware/RxReplay.h"
 
 // load notifications configuration
 #include "../notifications/NotificationHelper.h"
@@ -165,6 +166,7 @@
 #endif
 
 #include "mainstructs.h"
+#include <condition_variable>
 #define __STDC_FORMAT_MACROS
 #include <inttypes.h>
 
@@ -181,8 +183,17 @@
 
 #define round(a) ( int ) ( a + .5 )
 
+//minimum time between two scene commands sent to the same hardware (ms)
+#define SCENE_SWITCH_HARDWARE_INTERVAL 50
+
+//hardware is started on a few threads at once, drivers can block on serial or network handshakes
+#define HARDWARE_START_THREADS 8
+//seconds, the startup continues without waiting for a driver that takes longer
+#define HARDWARE_START_TIMEOUT 15
+
 extern std::string szStartupFolder;
 extern std::string szUserDataFolder;
+extern std::string szRxRecordFile;
 extern std::string szWWWFolder;
 extern int iAppRevision;
 extern std::string szWebRoot;
@@ -300,9 +311,123 @@ void MainWorker::AddAllDomoticzHardware()
 
 void MainWorker::StartDomoticzHardware()
 {
-	for (const auto &device : m_hardwaredevices)
-		if (!device->IsStarted())
-			device->Start();
+	struct _tHardwareStart
+	{
+		std::mutex mutex;
+		std::condition_variable cond;
+		std::vector<CDomoticzHardwareBase *> hardware;
+		size_t next = 0;
+		std::map<size_t, std::chrono::steady_clock::time_point> running; //index -> start
+	};
+	auto state = std::make_shared<_tHardwareStart>();
+	{
+		std::lock_guard<std::mutex> l(m_devicemutex);
+		for (const auto &device : m_hardwaredevices)
+			if (!device->IsStarted())
+				state->hardware.push_back(device);
+	}
+	if (state->hardware.empty())
+		return;
+
+	auto worker = [this, state] {
+		std::unique_lock<std::mutex> l(state->mutex);
+		while (state->next < state->hardware.size())
+		{
+			size_t idx = state->next++;
+			CDomoticzHardwareBase *pHardware = state->hardware[idx];
+			l.unlock();
+			//it can have been restarted, updated or deleted while it was waiting for a thread
+			bool bStart = BeginHardwareStart(pHardware);
+			l.lock();
+			if (!bStart)
+				continue;
+			int HwdId = pHardware->m_HwdID;
+			auto tStart = std::chrono::steady_clock::now();
+			state->running[idx] = tStart;
+			l.unlock();
+			pHardware->Start();
+			double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - tStart).count();
+			_log.Debug(DEBUG_HARDWARE, "Hardware: %s started in %.1f seconds", pHardware->m_Name.c_str(), elapsed);
+			if (elapsed >= HARDWARE_START_TIMEOUT)
+				_log.Log(LOG_STATUS, "Hardware: %s needed %.1f seconds to start", pHardware->m_Name.c_str(), elapsed);
+			l.lock();
+			state->running.erase(idx);
+			state->cond.notify_all();
+			l.unlock();
+			//from here on the hardware can be stopped and deleted
+			EndHardwareStart(HwdId);
+			l.lock();
+		}
+	};
+
+	size_t nThreads = std::min<size_t>(state->hardware.size(), HARDWARE_START_THREADS);
+	for (size_t ii = 0; ii < nThreads; ii++)
+		m_hardwarestartthreads.emplace_back(worker);
+
+	std::set<size_t> timedout;
+	std::unique_lock<std::mutex> l(state->mutex);
+	while (true)
+	{
+		auto now = std::chrono::steady_clock::now();
+		bool bWaiting = false;
+		for (const auto &itt : state->running)
+		{
+			if (now - itt.second < std::chrono::seconds(HARDWARE_START_TIMEOUT))
+			{
+				bWaiting = true;
+				continue;
+			}
+			if (!timedout.insert(itt.first).second)
+				continue;
+			_log.Log(LOG_ERROR, "Hardware: %s is still starting after %d seconds, continuing without it", state->hardware[itt.first]->m_Name.c_str(), HARDWARE_START_TIMEOUT);
+			//this thread is stuck in the driver, keep the others going
+			if (state->next < state->hardware.size())
+				m_hardwarestartthreads.emplace_back(worker);
+		}
+		if ((!bWaiting) && (state->next >= state->hardware.size()))
+			break;
+		state->cond.wait_for(l, std::chrono::milliseconds(500));
+	}
+}
+
+bool MainWorker::BeginHardwareStart(CDomoticzHardwareBase *pHardware)
+{
+	std::lock_guard<std::mutex> l(m_devicemutex);
+	if (std::find(m_hardwaredevices.begin(), m_hardwaredevices.end(), pHardware) == m_hardwaredevices.end())
+		return false;
+	if (pHardware->IsStarted())
+		return false;
+	std::lock_guard<std::mutex> l2(m_hardwarestartmutex);
+	m_hardwarestarting.insert(pHardware->m_HwdID);
+	return true;
+}
+
+void MainWorker::EndHardwareStart(const int HwdId)
+{
+	std::lock_guard<std::mutex> l(m_hardwarestartmutex);
+	m_hardwarestarting.erase(HwdId);
+	m_hardwarestartcond.notify_all();
+}
+
+bool MainWorker::IsHardwareStarting(const int HwdId)
+{
+	std::lock_guard<std::mutex> l(m_hardwarestartmutex);
+	return (m_hardwarestarting.find(HwdId) != m_hardwarestarting.end());
+}
+
+//Call after the hardware has been taken out of m_hardwaredevices, so no start thread can pick it up anymore
+void MainWorker::WaitForHardwareStart(const CDomoticzHardwareBase *pHardware)
+{
+	std::unique_lock<std::mutex> l(m_hardwarestartmutex);
+	if (m_hardwarestarting.find(pHardware->m_HwdID) == m_hardwarestarting.end())
+		return;
+	_log.Log(LOG_STATUS, "Hardware: %s is still starting, waiting for it before stopping it", pHardware->m_Name.c_str());
+	m_hardwarestartcond.wait(l, [&] { return (m_hardwarestarting.find(pHardware->m_HwdID) == m_hardwarestarting.end()); });
+}
+
+void MainWorker::LogStartupTime(const char *szStep)
+{
+	_log.Log(LOG_STATUS, "Startup: %s after %.1f seconds", szStep, std::chrono::duration<double>(std::chrono::steady_clock::now() - m_tStartup).count());
 }
 
 void MainWorker::StopDomoticzHardware()
@@ -317,11 +442,24 @@ void MainWorker::StopDomoticzHardware()
 		m_hardwaredevices.clear();
 	}
 
+	//hardware that is still inside its Start() is stopped after the rest
+	std::vector<CDomoticzHardwareBase*> StartingHardwaredevices;
 	for (auto &device : OrgHardwaredevices)
 	{
 #ifdef ENABLE_PYTHON
 		m_pluginsystem.DeregisterPlugin(device->m_HwdID);
 #endif
+		if (IsHardwareStarting(device->m_HwdID))
+		{
+			StartingHardwaredevices.push_back(device);
+			continue;
+		}
+		device->Stop();
+		delete device;
+	}
+	for (auto &device : StartingHardwaredevices)
+	{
+		WaitForHardwareStart(device);
 		device->Stop();
 		delete device;
 	}
@@ -373,6 +511,7 @@ void MainWorker::RemoveDomoticzHardware(CDomoticzHardwareBase* pHardware)
 
 	if (pOrgHardware == pHardware)
 	{
+		WaitForHardwareStart(pOrgHardware);
 		try
 		{
 			pOrgHardware->Stop();
@@ -1071,6 +1210,10 @@ bool MainWorker::AddHardwareFromParams(
 	case HTYPE_TeleinfoMeterTCP:
 		pHardware = new CTeleinfoTCP(ID, Address, Port, DataTimeout, (Mode2 != 0), Mode3);
 		break;
+	case HTYPE_RxReplay:
+		//Address is the recording, Mode1 the speed (0 = max), Mode2 the number of copies, Mode3 loop
+		pHardware = new CRxReplay(ID, Address, Mode1, Mode2, (Mode3 != 0));
+		break;
 	}
 
 	if (pHardware)
@@ -1091,6 +1234,8 @@ bool MainWorker::AddHardwareFromParams(
 
 bool MainWorker::Start()
 {
+	m_tStartup = std::chrono::steady_clock::now();
+
 	utsname my_uname;
 	if (uname(&my_uname) == 0)
 	{
@@ -1102,9 +1247,11 @@ bool MainWorker::Start()
 	{
 		return false;
 	}
+	LogStartupTime("database opened");
 
 	HTTPClient::SetUserAgent(GenerateUserAgent());
 	m_notifications.Init();
+	ReloadSceneActivators();
 	GetSunSettings();
 	GetAvailableWebThemes();
 #ifdef ENABLE_PYTHON
@@ -1113,6 +1260,9 @@ bool MainWorker::Start()
 		m_pluginsystem.StartPluginSystem();
 	}
 #endif
+	m_pollservice.Start();
+	if (!szRxRecordFile.empty())
+		m_rxrecorder.Open(szRxRecordFile);
 	AddAllDomoticzHardware();
 	m_fibaropush.Start();
 	m_httppush.Start();
@@ -1173,6 +1323,8 @@ bool MainWorker::Start()
 		LoadSharedUsers();
 	}
 
+	LogStartupTime("webserver and scheduler started");
+
 	m_thread = std::make_shared<std::thread>([this] { Do_Work(); });
 	SetThreadName(m_thread->native_handle(), "MainWorker");
 	m_rxMessageThread = std::make_shared<std::thread>([this] { Do_Work_On_Rx_Messages(); });
@@ -1199,8 +1351,16 @@ bool MainWorker::Stop()
 	{
 		m_webservers.StopServers();
 		m_sharedserver.StopServer();
+		//the scene workers send to the hardware
+		StopSceneQueues();
 		_log.Log(LOG_STATUS, "Stopping all hardware...");
 		StopDomoticzHardware();
+		//the hardware is gone, a start thread has nothing left to pick up
+		for (auto &thread : m_hardwarestartthreads)
+			thread.join();
+		m_hardwarestartthreads.clear();
+		m_pollservice.Stop();
+		m_rxrecorder.Close();
 		m_scheduler.StopScheduler();
 		m_eventsystem.StopEventSystem();
 		m_notificationsystem.Stop();
@@ -1609,10 +1769,11 @@ void MainWorker::Do_Work()
 		if (m_bStartHardware)
 		{
 			m_hardwareStartCounter++;
-			if (m_hardwareStartCounter >= 2)
+			if (m_hardwareStartCounter >= 1)
 			{
 				m_bStartHardware = false;
 				StartDomoticzHardware();
+				LogStartupTime("hardware started");
 #ifdef ENABLE_PYTHON
 				m_pluginsystem.AllPluginsStarted();
 #endif
@@ -1620,6 +1781,7 @@ void MainWorker::Do_Work()
 				m_notificationsystem.Start();
 				m_eventsystem.SetEnabled(m_sql.m_bEnableEventSystem);
 				m_eventsystem.StartEventSystem();
+				LogStartupTime("event system started");
 				m_notificationsystem.Notify(Notification::DZ_START, Notification::STATUS_INFO);
 			}
 		}
@@ -1654,6 +1816,10 @@ void MainWorker::Do_Work()
 			}
 		}
 
+		//sensor timeouts are kept in timer wheels, this only handles the ones that expired
+		m_sql.CheckDeviceTimeout();
+		m_notifications.CheckAndHandleLastUpdateNotification();
+
 		time_t atime = mytime(nullptr);
 		struct tm ltime;
 		localtime_r(&atime, &ltime);
@@ -1680,7 +1846,6 @@ void MainWorker::Do_Work()
 					m_sql.UpdatePreferencesVar("WebPassword", "");
 					std::remove(szPwdResetFile.c_str());
 				}
-				m_notifications.CheckAndHandleLastUpdateNotification();
 			}
 			if (_log.NotificationLogsEnabled())
 			{
@@ -1699,7 +1864,6 @@ void MainWorker::Do_Work()
 				m_ScheduleLastHour = ltime.tm_hour;
 				GetSunSettings();
 
-				m_sql.CheckDeviceTimeout();
 				m_sql.CheckBatteryLow();
 
 				//check for daily schedule
@@ -1992,6 +2156,9 @@ void MainWorker::CheckAndPushRxMessage(const CDomoticzHardwareBase *pHardware, c
 		return;
 	}
 
+	if ((m_rxrecorder.IsOpen()) && (pHardware->HwdType != HTYPE_RxReplay))
+		m_rxrecorder.Record(pHardware->m_HwdID, pRXCommand, defaultName, BatteryLevel);
+
 	// Build queue item
 	_tRxQueueItem rxMessage;
 	if (defaultName != nullptr)
@@ -3076,7 +3243,7 @@ void MainWorker::decode_Rain(const CDomoticzHardwareBase* pHardware, const tRBUF
 
 			std::vector<std::vector<std::string>> result;
 			result = m_sql.safe_query(
-				"SELECT Rate, Date FROM Rain WHERE (DeviceRowID=%" PRIu64 " AND Date>='%04d-%02d-%02d') ORDER BY ROWID ASC",
+				"SELECT Rate, Date FROM Rain WHERE (DeviceRowID=%" PRIu64 " AND Date>='%04d-%02d-%02d') ORDER BY Date ASC",
 				ulID, ltime.tm_year + 1900, ltime.tm_mon + 1, ltime.tm_mday);
 			if (!result.empty())
 			{
@@ -12994,45 +13161,54 @@ bool MainWorker::SetThermostatState(const std::string& idx, const int newState)
 }
 
 
-//returns if a device activates a scene
-bool MainWorker::DoesDeviceActiveAScene(const uint64_t DevRowIdx, const int Cmnd)
+//Build the device -> scene index of all Scene/Group activators
+//Should be called whenever the Activators or SceneType of a scene change
+void MainWorker::ReloadSceneActivators()
 {
-	//check for scene code
-	std::vector<std::vector<std::string> > result;
+	std::multimap<uint64_t, _tSceneActivator> sceneactivators;
 
-	result = m_sql.safe_query("SELECT Activators, SceneType FROM Scenes WHERE (Activators!='')");
-	if (!result.empty())
+	std::vector<std::vector<std::string> > result;
+	result = m_sql.safe_query("SELECT ID, Activators, SceneType FROM Scenes WHERE (Activators!='')");
+	for (const auto &sd : result)
 	{
-		for (const auto &sd : result)
-		{
-			int SceneType = atoi(sd[1].c_str());
+		_tSceneActivator activator;
+		activator.SceneID = std::strtoull(sd[0].c_str(), nullptr, 10);
+		activator.SceneType = atoi(sd[2].c_str());
 
-			std::vector<std::string> arrayActivators;
-			StringSplit(sd[0], ";", arrayActivators);
-			for (const auto &sCodeCmd : arrayActivators)
-			{
-				std::vector<std::string> arrayCode;
-				StringSplit(sCodeCmd, ":", arrayCode);
+		std::vector<std::string> arrayActivators;
+		StringSplit(sd[1], ";", arrayActivators);
+		for (const auto &sCodeCmd : arrayActivators)
+		{
+			std::vector<std::string> arrayCode;
+			StringSplit(sCodeCmd, ":", arrayCode);
+			if (arrayCode.empty())
+				continue;
 
-				std::string sID = arrayCode[0];
-				std::string sCode;
-				if (arrayCode.size() == 2)
-				{
-					sCode = arrayCode[1];
-				}
+			activator.bHaveCode = ((arrayCode.size() == 2) && (!arrayCode[1].empty()));
+			activator.Code = (activator.bHaveCode) ? atoi(arrayCode[1].c_str()) : 0;
 
-				uint64_t aID = std::strtoull(sID.c_str(), nullptr, 10);
-				if (aID == DevRowIdx)
-				{
-					if ((SceneType == SGTYPE_GROUP) || (sCode.empty()))
-						return true;
-					int iCode = atoi(sCode.c_str());
-					if (iCode == Cmnd)
-						return true;
-				}
-			}
+			uint64_t aID = std::strtoull(arrayCode[0].c_str(), nullptr, 10);
+			sceneactivators.insert(std::make_pair(aID, activator));
 		}
 	}
+
+	std::lock_guard<std::mutex> l(m_sceneactivatormutex);
+	m_sceneactivators.swap(sceneactivators);
+}
+
+//returns if a device activates a scene
+bool MainWorker::DoesDeviceActiveAScene(const uint64_t DevRowIdx, const int Cmnd)
+{
+	std::lock_guard<std::mutex> l(m_sceneactivatormutex);
+	auto range = m_sceneactivators.equal_range(DevRowIdx);
+	for (auto itt = range.first; itt != range.second; ++itt)
+	{
+		const _tSceneActivator &activator = itt->second;
+		if ((activator.SceneType == SGTYPE_GROUP) || (!activator.bHaveCode))
+			return true;
+		if (activator.Code == Cmnd)
+			return true;
+	}
 	return false;
 }
 
@@ -13091,6 +13267,7 @@ bool MainWorker::SwitchScene(const uint64_t idx, std::string switchcmd, const st
 		nValue,
 		szLastUpdate.c_str(),
 		idx);
+	m_sql.SetSceneStatusValue(idx, nValue);
 
 	//Check if we need to email a snapshot of a Camera
 	std::string emailserver;
@@ -13136,6 +13313,8 @@ bool MainWorker::SwitchScene(const uint64_t idx, std::string switchcmd, const st
 	if (result.empty())
 		return true; //no devices in the scene
 
+	std::map<int, std::vector<_tSceneCommand>> hardwareCommands; //HardwareID -> commands, in scene order
+
 	for (const auto &sd : result)
 	{
 		int cmd = atoi(sd[1].c_str());
@@ -13149,6 +13328,7 @@ bool MainWorker::SwitchScene(const uint64_t idx, std::string switchcmd, const st
 		if (!result2.empty())
 		{
 			std::vector<std::string> sd2 = result2[0];
+			int HardwareID = atoi(sd2[0].c_str());
 			//uint8_t rnValue = atoi(sd2[6].c_str());
 			std::string sValue = sd2[7];
 			//uint8_t Unit = atoi(sd2[2].c_str());
@@ -13214,7 +13394,7 @@ bool MainWorker::SwitchScene(const uint64_t idx, std::string switchcmd, const st
 				int delay = (lstatus == "Off") ? offdelay : ondelay;
 				if (m_sql.m_bEnableEventSystem && !bEventTrigger)
 					m_eventsystem.SetEventTrigger(idx, m_eventsystem.REASON_DEVICE, static_cast<float>(delay));
-				SwitchLight(idx, lstatus, ilevel, color, false, delay, User);
+				hardwareCommands[HardwareID].push_back({ static_cast<uint64_t>(idx), lstatus, ilevel, color, delay, User });
 				if (scenetype == SGTYPE_SCENE)
 				{
 					if ((lstatus != "Off") && (offdelay > 0))
@@ -13222,7 +13402,7 @@ bool MainWorker::SwitchScene(const uint64_t idx, std::string switchcmd, const st
 						//switch with on delay, and off delay
 						if (m_sql.m_bEnableEventSystem && !bEventTrigger)
 							m_eventsystem.SetEventTrigger(idx, m_eventsystem.REASON_DEVICE, static_cast<float>(ondelay + offdelay));
-						SwitchLight(idx, "Off", ilevel, color, false, ondelay + offdelay, User);
+						hardwareCommands[HardwareID].push_back({ static_cast<uint64_t>(idx), "Off", ilevel, color, ondelay + offdelay, User });
 					}
 				}
 			}
@@ -13230,67 +13410,118 @@ bool MainWorker::SwitchScene(const uint64_t idx, std::string switchcmd, const st
 			{
 				if (m_sql.m_bEnableEventSystem && !bEventTrigger)
 					m_eventsystem.SetEventTrigger(idx, m_eventsystem.REASON_DEVICE, static_cast<float>(ondelay));
-				SwitchLight(idx, "On", ilevel, color, false, ondelay, User);
+				hardwareCommands[HardwareID].push_back({ static_cast<uint64_t>(idx), "On", ilevel, color, ondelay, User });
 			}
-			sleep_milliseconds(50);
 		}
 	}
+
+	for (const auto &itt : hardwareCommands)
+		QueueSceneCommands(itt.first, itt.second);
 	return true;
 }
 
-void MainWorker::CheckSceneCode(const uint64_t DevRowIdx, const uint8_t dType, const uint8_t dSubType, const int nValue, const char* sValue, const std::string& User)
+//Hand the commands of a scene for the devices of one hardware to its queue
+//Delayed commands are queued as a task, the others are paced by the worker of the hardware
+void MainWorker::QueueSceneCommands(const int HardwareID, const std::vector<_tSceneCommand> &commands)
 {
-	//check for scene code
-	std::vector<std::vector<std::string> > result;
+	std::vector<_tSceneCommand> direct;
+	for (const auto &command : commands)
+	{
+		if (command.delay != 0)
+			SwitchLight(command.idx, command.switchcmd, command.level, command.color, false, command.delay, command.User);
+		else
+			direct.push_back(command);
+	}
+	if (direct.empty())
+		return;
 
-	result = m_sql.safe_query("SELECT ID, Activators, SceneType FROM Scenes WHERE (Activators!='')");
-	if (!result.empty())
+	std::lock_guard<std::mutex> l(m_scenequeuemutex);
+	if (m_bStopSceneQueues)
+		return;
+	_tSceneHardwareQueue &queue = m_scenequeues[HardwareID];
+	queue.commands.insert(queue.commands.end(), direct.begin(), direct.end());
+	if (!queue.worker)
 	{
-		for (const auto &sd : result)
+		queue.worker = std::make_shared<std::thread>([this, HardwareID] { SceneQueueWorker(HardwareID); });
+		SetThreadName(queue.worker->native_handle(), "SceneSwitch");
+	}
+	queue.cond.notify_one();
+}
+
+//Sends the queued scene commands of one hardware, at most one every SCENE_SWITCH_HARDWARE_INTERVAL
+void MainWorker::SceneQueueWorker(const int HardwareID)
+{
+	std::unique_lock<std::mutex> l(m_scenequeuemutex);
+	_tSceneHardwareQueue &queue = m_scenequeues[HardwareID];
+	while (true)
+	{
+		queue.cond.wait(l, [&] { return m_bStopSceneQueues || !queue.commands.empty(); });
+		if (m_bStopSceneQueues)
+			break;
+		//the last send can be of another scene activation
+		if (queue.cond.wait_until(l, queue.lastsend + std::chrono::milliseconds(SCENE_SWITCH_HARDWARE_INTERVAL), [&] { return m_bStopSceneQueues; }))
+			break;
+		_tSceneCommand command = std::move(queue.commands.front());
+		queue.commands.pop_front();
+		l.unlock();
+		SwitchLight(command.idx, command.switchcmd, command.level, command.color, false, 0, command.User);
+		l.lock();
+		queue.lastsend = std::chrono::steady_clock::now();
+	}
+}
+
+void MainWorker::StopSceneQueues()
+{
+	std::vector<std::shared_ptr<std::thread>> workers;
+	{
+		std::lock_guard<std::mutex> l(m_scenequeuemutex);
+		m_bStopSceneQueues = true;
+		for (auto &itt : m_scenequeues)
 		{
-			std::vector<std::string> arrayActivators;
-			StringSplit(sd[1], ";", arrayActivators);
-			for (const auto &sCodeCmd : arrayActivators)
-			{
-				std::vector<std::string> arrayCode;
-				StringSplit(sCodeCmd, ":", arrayCode);
+			if (itt.second.worker)
+				workers.push_back(itt.second.worker);
+			itt.second.cond.notify_all();
+		}
+	}
+	for (auto &worker : workers)
+		worker->join();
+	std::lock_guard<std::mutex> l(m_scenequeuemutex);
+	m_scenequeues.clear();
+}
 
-				std::string sID = arrayCode[0];
-				std::string sCode;
-				if (arrayCode.size() == 2)
-				{
-					sCode = arrayCode[1];
-				}
+void MainWorker::CheckSceneCode(const uint64_t DevRowIdx, const uint8_t dType, const uint8_t dSubType, const int nValue, const char* sValue, const std::string& User)
+{
+	//check for scene code
+	std::vector<_tSceneActivator> activators;
+	{
+		std::lock_guard<std::mutex> l(m_sceneactivatormutex);
+		auto range = m_sceneactivators.equal_range(DevRowIdx);
+		for (auto itt = range.first; itt != range.second; ++itt)
+			activators.push_back(itt->second);
+	}
 
-				uint64_t aID = std::strtoull(sID.c_str(), nullptr, 10);
-				if (aID == DevRowIdx)
-				{
-					uint64_t ID = std::strtoull(sd[0].c_str(), nullptr, 10);
-					int scenetype = atoi(sd[2].c_str());
-					int rnValue = nValue;
+	for (const auto &activator : activators)
+	{
+		int rnValue = nValue;
 
-					if ((scenetype == SGTYPE_SCENE) && (!sCode.empty()))
-					{
-						//Also check code
-						int iCode = atoi(sCode.c_str());
-						if (iCode != nValue)
-							continue;
-						rnValue = 1; //A Scene can only be activated (On)
-					}
+		if ((activator.SceneType == SGTYPE_SCENE) && (activator.bHaveCode))
+		{
+			//Also check code
+			if (activator.Code != nValue)
+				continue;
+			rnValue = 1; //A Scene can only be activated (On)
+		}
 
-					std::string lstatus;
-					int llevel = 0;
-					bool bHaveDimmer = false;
-					bool bHaveGroupCmd = false;
-					int maxDimLevel = 0;
+		std::string lstatus;
+		int llevel = 0;
+		bool bHaveDimmer = false;
+		bool bHaveGroupCmd = false;
+		int maxDimLevel = 0;
 
-					GetLightStatus(dType, dSubType, STYPE_OnOff, rnValue, sValue, lstatus, llevel, bHaveDimmer, maxDimLevel, bHaveGroupCmd);
-					std::string switchcmd = (IsLightSwitchOn(lstatus) == true) ? "On" : "Off";
+		GetLightStatus(dType, dSubType, STYPE_OnOff, rnValue, sValue, lstatus, llevel, bHaveDimmer, maxDimLevel, bHaveGroupCmd);
+		std::string switchcmd = (IsLightSwitchOn(lstatus) == true) ? "On" : "Off";
 
-					m_sql.AddTaskItem(_tTaskItem::SwitchSceneEvent(0.2F, ID, switchcmd, "SceneTrigger", User));
-				}
-			}
-		}
+		m_sql.AddTaskItem(_tTaskItem::SwitchSceneEvent(0.2F, activator.SceneID, switchcmd, "SceneTrigger", User));
 	}
 }
 
@@ -13468,9 +13699,18 @@ void MainWorker::HeartbeatCheck()
 		}
 	}
 
+	std::set<int> starting;
+	{
+		std::lock_guard<std::mutex> l3(m_hardwarestartmutex);
+		starting = m_hardwarestarting;
+	}
+
 	//Check hardware heartbeats
 	for (const auto &pHardware : m_hardwaredevices)
 	{
+		//no heartbeat yet, and a restart would have to wait for the start anyway
+		if (starting.find(pHardware->m_HwdID) != starting.end())
+			continue;
 		if (!pHardware->m_bSkipReceiveCheck)
 		{
 			//Skip Dummy Hardware
@@ -5,8 +5,11 @@
 #include "Scheduler.h"
 #include "EventSystem.h"
 #include "NotificationSystem.h"
+#include "PollService.h"
+#include "../hardware/RxReplay.h"
 #include "Camera.h"
 #include <deque>
+#include <set>
 #include "WindCalculation.h"
 #include "TrendCalculator.h"
 #include "StoppableTask.h"
@@ -60,6 +63,7 @@ public:
 	bool SwitchScene(uint64_t idx, std::string switchcmd, const std::string &User);
 	void CheckSceneCode(uint64_t DevRowIdx, uint8_t dType, uint8_t dSubType, int nValue, const char *sValue, const std::string &User);
 	bool DoesDeviceActiveAScene(uint64_t DevRowIdx, int Cmnd);
+	void ReloadSceneActivators();
 
 	bool SetSetPoint(const std::string &idx, float TempValue);
 	bool SetSetPoint(const std::string &idx, float TempValue, const std::string &newMode, const std::string &until);
@@ -101,6 +105,7 @@ public:
 	CScheduler m_scheduler;
 	CEventSystem m_eventsystem;
 	CNotificationSystem m_notificationsystem;
+	CPollService m_pollservice;
 #ifdef ENABLE_PYTHON
 	Plugins::CPluginSystem m_pluginsystem;
 #endif
@@ -155,6 +160,54 @@ private:
 
 
 	std::mutex m_devicemutex;
+	std::vector<std::thread> m_hardwarestartthreads; //joined when stopping, a driver can still be starting
+	//IDs of the hardware that is inside its Start() on a start thread, it must not be stopped or deleted until that returns
+	std::mutex m_hardwarestartmutex;
+	std::condition_variable m_hardwarestartcond;
+	std::set<int> m_hardwarestarting;
+	bool BeginHardwareStart(CDomoticzHardwareBase *pHardware);
+	void EndHardwareStart(int HwdId);
+	bool IsHardwareStarting(int HwdId);
+	void WaitForHardwareStart(const CDomoticzHardwareBase *pHardware);
+
+	std::chrono::steady_clock::time_point m_tStartup;
+	void LogStartupTime(const char *szStep);
+
+	//Scene/Group activators (Scenes.Activators), indexed by the activating device
+	struct _tSceneActivator
+	{
+		uint64_t SceneID;
+		int SceneType;
+		bool bHaveCode;
+		int Code;
+	};
+	std::mutex m_sceneactivatormutex;
+	std::multimap<uint64_t, _tSceneActivator> m_sceneactivators;
+
+	struct _tSceneCommand
+	{
+		uint64_t idx;
+		std::string switchcmd;
+		int level;
+		_tColor color;
+		int delay;
+		std::string User;
+	};
+	//Scene commands that are sent directly go through a queue and worker per hardware, shared by all scene activations,
+	//so a controller is not flooded when scenes overlap, and a slow controller does not hold up the devices of the others
+	struct _tSceneHardwareQueue
+	{
+		std::deque<_tSceneCommand> commands;
+		std::condition_variable cond;
+		std::chrono::steady_clock::time_point lastsend;
+		std::shared_ptr<std::thread> worker;
+	};
+	std::mutex m_scenequeuemutex;
+	std::map<int, _tSceneHardwareQueue> m_scenequeues; //HardwareID -> queue, the workers are kept until Stop()
+	bool m_bStopSceneQueues = false;
+	void QueueSceneCommands(int HardwareID, const std::vector<_tSceneCommand> &commands);
+	void SceneQueueWorker(int HardwareID);
+	void StopSceneQueues();
 
 	std::string m_szDomoticzUpdateChecksumURL;
 	bool m_bDoDownloadDomoticzUpdate;
@@ -189,6 +242,7 @@ private:
 
 	// RxMessage queue resources
 	volatile unsigned long m_rxMessageIdx;
+	CRxRecorder m_rxrecorder;
 	std::shared_ptr<std::thread> m_rxMessageThread;
 	StoppableTask m_TaskRXMessage;
 	void Do_Work_On_Rx_Messages();
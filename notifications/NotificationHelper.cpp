@@ -1,6 +1,7 @@
 #include "stdafx.h"
 #include "../main/Logger.h"
 #include "../main/Helper.h"
+#include "../main/SValueFields.h"
 #include "../main/SQLHelper.h"
 #include "../main/localtime_r.h"
 #include "../main/RFXtrx.h"
@@ -199,19 +200,105 @@ std::string CNotificationHelper::ParseCustomMessage(const std::string &cMessage,
 	return ret;
 }
 
-bool CNotificationHelper::ApplyRule(const std::string &rule, const bool equal, const bool less)
+bool CNotificationHelper::ApplyRule(const _eNotificationRule rule, const bool equal, const bool less)
 {
-	if (((rule == ">") || (rule == ">=")) && (!less) && (!equal))
-		return true;
-	if (((rule == "<") || (rule == "<=")) && (less))
-		return true;
-	if (((rule == "=") || (rule == ">=") || (rule == "<=")) && (equal))
-		return true;
-	if ((rule == "!=") && (!equal))
-		return true;
+	switch (rule)
+	{
+	case NRULE_GREATER:
+		return (!less) && (!equal);
+	case NRULE_GREATER_EQUAL:
+		return (!less) || (equal);
+	case NRULE_EQUAL:
+		return equal;
+	case NRULE_NOT_EQUAL:
+		return !equal;
+	case NRULE_LESS_EQUAL:
+		return (less) || (equal);
+	case NRULE_LESS:
+		return less;
+	default:
+		break;
+	}
 	return false;
 }
 
+//Parse the Params string (Type;Rule;Value;Recovery) into its typed fields
+void CNotificationHelper::CompileNotification(_tNotification &n)
+{
+	std::vector<std::string> splitresults;
+	StringSplit(n.Params, ";", splitresults);
+	n.ParamCount = splitresults.size();
+
+	n.Type = -1;
+	if (!splitresults.empty())
+	{
+		for (int ii = NTYPE_TEMPERATURE; ii <= NTYPE_SLEEPING; ii++)
+		{
+			if (splitresults[0] == Notification_Type_Desc(ii, 1))
+			{
+				n.Type = ii;
+				break;
+			}
+		}
+	}
+
+	n.Rule = (splitresults.size() > 1) ? splitresults[1] : "";
+	if (n.Rule == ">")
+		n.eRule = NRULE_GREATER;
+	else if (n.Rule == ">=")
+		n.eRule = NRULE_GREATER_EQUAL;
+	else if (n.Rule == "=")
+		n.eRule = NRULE_EQUAL;
+	else if (n.Rule == "!=")
+		n.eRule = NRULE_NOT_EQUAL;
+	else if (n.Rule == "<=")
+		n.eRule = NRULE_LESS_EQUAL;
+	else if (n.Rule == "<")
+		n.eRule = NRULE_LESS;
+	else
+		n.eRule = NRULE_NONE;
+
+	n.Value = 0;
+	if (n.Type == NTYPE_VALUE)
+	{
+		//F;value
+		if (splitresults.size() > 1)
+			n.Value = static_cast<float>(atoi(splitresults[1].c_str()));
+	}
+	else if (splitresults.size() > 2)
+		n.Value = static_cast<float>(atof(splitresults[2].c_str()));
+
+	n.bRecovery = ((splitresults.size() > 3) && (splitresults[3] == "1"));
+
+	CompileCustomMessage(n);
+}
+
+//The CustomMessage holds the message and the recovery message separated by ;;
+void CNotificationHelper::CompileCustomMessage(_tNotification &n)
+{
+	std::vector<std::string> splitresults;
+	StringSplit(n.CustomMessage, ";;", splitresults);
+	n.Message = (!splitresults.empty()) ? splitresults[0] : "";
+	n.RecoveryMessage = (splitresults.size() > 1) ? splitresults[1] : "";
+}
+
+//m_mutex should be locked by the caller
+_tNotification *CNotificationHelper::FindNotification(const uint64_t ID)
+{
+	auto itt = m_notificationdevices.find(ID);
+	if (itt == m_notificationdevices.end())
+		return nullptr;
+	auto ittDev = m_notifications.find(itt->second);
+	if (ittDev == m_notifications.end())
+		return nullptr;
+	for (auto &n : ittDev->second)
+	{
+		if (n.ID == ID)
+			return &n;
+	}
+	return nullptr;
+}
+
 bool CNotificationHelper::CheckAndHandleNotification(const uint64_t DevRowIdx, const int HardwareID, const std::string &ID, const std::string &sName, const unsigned char unit, const unsigned char cType, const unsigned char cSubType, const int nValue) {
 	return CheckAndHandleNotification(DevRowIdx, HardwareID, ID, sName, unit, cType, cSubType, nValue, "", 0.0F);
 }
@@ -239,16 +326,20 @@ bool CNotificationHelper::CheckAndHandleNotification(const uint64_t DevRowIdx, c
 	if ((DevRowIdx == -1) || IsLightOrSwitch(cType, cSubType)) {
 		return false;
 	}
+	// Most devices have no notifications, don't bother parsing their values
+	if (!HasNotifications(DevRowIdx))
+		return false;
 
 	int meterType = 0;
-	std::vector<std::string> strarray;
-	StringSplit(sValue, ";", strarray);
-	nsize = strarray.size();
+	_tSValueFields sValueFields;
+	sValueFields.Parse(sValue);
+	const double *svalues = sValueFields.value;
+	nsize = static_cast<int>(sValueFields.count);
 	switch(cType) {
 		case pTypeP1Power:
 			nexpected = 5;
 			if (nsize >= nexpected) {
-				return CheckAndHandleNotification(DevRowIdx, sName, cType, cSubType, NTYPE_USAGE, (float)atof(strarray[4].c_str()));
+				return CheckAndHandleNotification(DevRowIdx, sName, cType, cSubType, NTYPE_USAGE, (float)svalues[4]);
 			}
 			break;
 		case pTypeRFXSensor:
@@ -277,8 +368,8 @@ bool CNotificationHelper::CheckAndHandleNotification(const uint64_t DevRowIdx, c
 		case pTypeTEMP_HUM:
 			nexpected = 2;
 			if (nsize >= nexpected) {
-				float Temp = (float)atof(strarray[0].c_str());
-				int Hum = atoi(strarray[1].c_str());
+				float Temp = (float)svalues[0];
+				int Hum = static_cast<int>(svalues[1]);
 				float dewpoint = (float)CalculateDewPoint(Temp, Hum);
 				r1 = CheckAndHandleTempHumidityNotification(DevRowIdx, sName, Temp, Hum, true, true);
 				r2 = CheckAndHandleDewPointNotification(DevRowIdx, sName, Temp, dewpoint);
@@ -288,27 +379,27 @@ bool CNotificationHelper::CheckAndHandleNotification(const uint64_t DevRowIdx, c
 		case pTypeTEMP_HUM_BARO:
 			nexpected = 4;
 			if (nsize >= nexpected) {
-				float Temp = (float)atof(strarray[0].c_str());
-				int Hum = atoi(strarray[1].c_str());
+				float Temp = (float)svalues[0];
+				int Hum = static_cast<int>(svalues[1]);
 				float dewpoint = (float)CalculateDewPoint(Temp, Hum);
 				r1 = CheckAndHandleTempHumidityNotification(DevRowIdx, sName, Temp, Hum, true, true);
 				r2 = CheckAndHandleDewPointNotification(DevRowIdx, sName, Temp, dewpoint);
-				r3 = CheckAndHandleNotification(DevRowIdx, sName, cType, cSubType, NTYPE_BARO, (float)atof(strarray[3].c_str()));
+				r3 = CheckAndHandleNotification(DevRowIdx, sName, cType, cSubType, NTYPE_BARO, (float)svalues[3]);
 				return r1 && r2 && r3;
 			}
 			break;
 		case pTypeRAIN:
 			nexpected = 2;
 			if (nsize >= nexpected) {
-				fValue2 = (float)atof(strarray[1].c_str());
+				fValue2 = (float)svalues[1];
 				return CheckAndHandleRainNotification(DevRowIdx, sName, cType, cSubType, NTYPE_RAIN, fValue2);
 			}
 			break;
 		case pTypeTEMP_BARO:
 			nexpected = 2;
 			if (nsize >= nexpected) {
-				float Temp = (float)atof(strarray[0].c_str());
-				float Baro = (float)atof(strarray[1].c_str());
+				float Temp = (float)svalues[0];
+				float Baro = (float)svalues[1];
 				r1 = CheckAndHandleTempHumidityNotification(DevRowIdx, sName, Temp, 0, true, false);
 				r2 = CheckAndHandleNotification(DevRowIdx, sName, cType, cSubType, NTYPE_BARO, Baro);
 				return r1 && r2;
@@ -317,8 +408,8 @@ bool CNotificationHelper::CheckAndHandleNotification(const uint64_t DevRowIdx, c
 		case pTypeUV:
 			nexpected = 2;
 			if (nsize >= nexpected) {
-				float Level = (float)atof(strarray[0].c_str());
-				float Temp = (float)atof(strarray[1].c_str());
+				float Level = (float)svalues[0];
+				float Temp = (float)svalues[1];
 				if (cSubType == sTypeUV3)
 				{
 					r1 = CheckAndHandleTempHumidityNotification(DevRowIdx, sName, Temp, 0, true, false);
@@ -332,26 +423,26 @@ bool CNotificationHelper::CheckAndHandleNotification(const uint64_t DevRowIdx, c
 		case pTypeCURRENT:
 			nexpected = 3;
 			if (nsize >= nexpected) {
-				float CurrentChannel1 = (float)atof(strarray[0].c_str());
-				float CurrentChannel2 = (float)atof(strarray[1].c_str());
-				float CurrentChannel3 = (float)atof(strarray[2].c_str());
+				float CurrentChannel1 = (float)svalues[0];
+				float CurrentChannel2 = (float)svalues[1];
+				float CurrentChannel3 = (float)svalues[2];
 				return CheckAndHandleAmpere123Notification(DevRowIdx, sName, CurrentChannel1, CurrentChannel2, CurrentChannel3);
 			}
 			break;
 		case pTypeCURRENTENERGY:
 			nexpected = 3;
 			if (nsize >= nexpected) {
-				float CurrentChannel1 = (float)atof(strarray[0].c_str());
-				float CurrentChannel2 = (float)atof(strarray[1].c_str());
-				float CurrentChannel3 = (float)atof(strarray[2].c_str());
+				float CurrentChannel1 = (float)svalues[0];
+				float CurrentChannel2 = (float)svalues[1];
+				float CurrentChannel3 = (float)svalues[2];
 				return CheckAndHandleAmpere123Notification(DevRowIdx, sName, CurrentChannel1, CurrentChannel2, CurrentChannel3);
 			}
 			break;
 		case pTypeWIND:
 			nexpected = 5;
 			if (nsize >= nexpected) {
-				float wspeedms = (float)(atof(strarray[2].c_str()) / 10.0F);
-				float temp = (float)atof(strarray[4].c_str());
+				float wspeedms = (float)(svalues[2] / 10.0F);
+				float temp = (float)svalues[4];
 				r1 = CheckAndHandleNotification(DevRowIdx, sName, cType, cSubType, NTYPE_WIND, wspeedms);
 				r2 = CheckAndHandleTempHumidityNotification(DevRowIdx, sName, temp, 0, true, false);
 				return r1 && r2;
@@ -360,7 +451,7 @@ bool CNotificationHelper::CheckAndHandleNotification(const uint64_t DevRowIdx, c
 		case pTypeYouLess:
 			nexpected = 2;
 			if (nsize >= nexpected) {
-				float usagecurrent = (float)atof(strarray[1].c_str());
+				float usagecurrent = (float)svalues[1];
 				return CheckAndHandleNotification(DevRowIdx, sName, cType, cSubType, NTYPE_USAGE, usagecurrent);
 			}
 			break;
@@ -374,7 +465,7 @@ bool CNotificationHelper::CheckAndHandleNotification(const uint64_t DevRowIdx, c
 		case pTypePOWER:
 			nexpected = 1;
 			if (nsize >= nexpected) {
-				fValue2 = (float)atof(strarray[0].c_str());
+				fValue2 = (float)svalues[0];
 				return CheckAndHandleNotification(DevRowIdx, sName, cType, cSubType, NTYPE_USAGE, fValue2);
 			}
 			break;
@@ -414,7 +505,7 @@ bool CNotificationHelper::CheckAndHandleNotification(const uint64_t DevRowIdx, c
 				case sTypeKwh:
 					nexpected = 1;
 					if (nsize >= nexpected) {
-						fValue2 = (float)atof(strarray[0].c_str());
+						fValue2 = (float)svalues[0];
 						return CheckAndHandleNotification(DevRowIdx, sName, cType, cSubType, NTYPE_USAGE, fValue2);
 					}
 					break;
@@ -498,8 +589,6 @@ bool CNotificationHelper::CheckAndHandleTempHumidityNotification(
 	std::string msg;
 
 	std::string label = Notification_Type_Label(NTYPE_TEMPERATURE);
-	std::string signtemp = Notification_Type_Desc(NTYPE_TEMPERATURE, 1);
-	std::string signhum = Notification_Type_Desc(NTYPE_HUMIDITY, 1);
 
 	for (const auto &n : notifications)
 	{
@@ -513,18 +602,15 @@ bool CNotificationHelper::CheckAndHandleTempHumidityNotification(
 			bRecoveryMessage = CustomRecoveryMessage(n.ID, recoverymsg, true);
 			if ((atime < n.LastSend) && (!n.SendAlways) && (!bRecoveryMessage))
 				continue;
-			std::vector<std::string> splitresults;
-			StringSplit(n.Params, ";", splitresults);
-			if (splitresults.size() < 3)
+			if (n.ParamCount < 3)
 				continue; //impossible
-			std::string ntype = splitresults[0];
 			std::string custommsg;
-			float svalue = static_cast<float>(atof(splitresults[2].c_str()));
+			float svalue = n.Value;
 			bool bSendNotification = false;
 			bool bCustomMessage = false;
 			bCustomMessage = CustomRecoveryMessage(n.ID, custommsg, false);
 
-			if ((ntype == signtemp) && (bHaveTemp))
+			if ((n.Type == NTYPE_TEMPERATURE) && (bHaveTemp))
 			{
 				//temperature
 				if (m_sql.m_tempunit == TEMPUNIT_F)
@@ -540,10 +626,10 @@ bool CNotificationHelper::CheckAndHandleTempHumidityNotification(
 				else if (temp > 10.0) szExtraData += "Image=temp-10-15|";
 				else if (temp > 5.0) szExtraData += "Image=temp-5-10|";
 				else szExtraData += "Image=temp48|";
-				bSendNotification = ApplyRule(splitresults[1], (temp == svalue), (temp < svalue));
+				bSendNotification = ApplyRule(n.eRule, (temp == svalue), (temp < svalue));
 				if (bSendNotification && (!bRecoveryMessage || n.SendAlways))
 				{
-					sprintf(szTmp, "%s Temperature is %.1f %s [%s %.1f %s]", devicename.c_str(), temp, label.c_str(), splitresults[1].c_str(), svalue, label.c_str());
+					sprintf(szTmp, "%s Temperature is %.1f %s [%s %.1f %s]", devicename.c_str(), temp, label.c_str(), n.Rule.c_str(), svalue, label.c_str());
 					msg = szTmp;
 					sprintf(szTmp, "%.1f", temp);
 					notValue = szTmp;
@@ -560,14 +646,14 @@ bool CNotificationHelper::CheckAndHandleTempHumidityNotification(
 					bSendNotification = false;
 				}
 			}
-			else if ((ntype == signhum) && (bHaveHumidity))
+			else if ((n.Type == NTYPE_HUMIDITY) && (bHaveHumidity))
 			{
 				//humidity
 				szExtraData += "Image=moisture48|";
-				bSendNotification = ApplyRule(splitresults[1], (humidity == svalue), (humidity < svalue));
+				bSendNotification = ApplyRule(n.eRule, (humidity == svalue), (humidity < svalue));
 				if (bSendNotification && (!bRecoveryMessage || n.SendAlways))
 				{
-					sprintf(szTmp, "%s Humidity is %d %% [%s %.0f %%]", devicename.c_str(), humidity, splitresults[1].c_str(), svalue);
+					sprintf(szTmp, "%s Humidity is %d %% [%s %.0f %%]", devicename.c_str(), humidity, n.Rule.c_str(), svalue);
 					msg = szTmp;
 					sprintf(szTmp, "%d", humidity);
 					notValue = szTmp;
@@ -622,21 +708,13 @@ bool CNotificationHelper::CheckAndHandleDewPointNotification(
 
 	std::string msg;
 
-	std::string signdewpoint = Notification_Type_Desc(NTYPE_DEWPOINT, 1);
-
 	for (const auto &n : notifications)
 	{
 		if (n.LastUpdate)
 			TouchLastUpdate(n.ID);
 		if ((atime >= n.LastSend) || (n.SendAlways)) // emergency always goes true
 		{
-			std::vector<std::string> splitresults;
-			StringSplit(n.Params, ";", splitresults);
-			if (splitresults.empty())
-				continue; //impossible
-			std::string ntype = splitresults[0];
-
-			if (ntype == signdewpoint)
+			if (n.Type == NTYPE_DEWPOINT)
 			{
 				//dewpoint
 				if (temp <= dewpoint)
@@ -677,22 +755,17 @@ bool CNotificationHelper::CheckAndHandleValueNotification(
 	std::string msg;
 	std::string notValue;
 
-	std::string signvalue = Notification_Type_Desc(NTYPE_VALUE, 1);
-
 	for (const auto &n : notifications)
 	{
 		if (n.LastUpdate)
 			TouchLastUpdate(n.ID);
 		if ((atime >= n.LastSend) || (n.SendAlways)) // emergency always goes true
 		{
-			std::vector<std::string> splitresults;
-			StringSplit(n.Params, ";", splitresults);
-			if (splitresults.size() < 2)
+			if (n.ParamCount < 2)
 				continue; //impossible
-			std::string ntype = splitresults[0];
-			int svalue = static_cast<int>(atoi(splitresults[1].c_str()));
+			int svalue = static_cast<int>(n.Value);
 
-			if (ntype == signvalue)
+			if (n.Type == NTYPE_VALUE)
 			{
 				if (value > svalue)
 				{
@@ -736,10 +809,6 @@ bool CNotificationHelper::CheckAndHandleAmpere123Notification(
 
 	std::string notValue;
 
-	std::string signamp1 = Notification_Type_Desc(NTYPE_AMPERE1, 1);
-	std::string signamp2 = Notification_Type_Desc(NTYPE_AMPERE2, 1);
-	std::string signamp3 = Notification_Type_Desc(NTYPE_AMPERE3, 1);
-
 	for (const auto &n : notifications)
 	{
 		if (n.LastUpdate)
@@ -752,38 +821,35 @@ bool CNotificationHelper::CheckAndHandleAmpere123Notification(
 			bRecoveryMessage = CustomRecoveryMessage(n.ID, recoverymsg, true);
 			if ((atime < n.LastSend) && (!n.SendAlways) && (!bRecoveryMessage))
 				continue;
-			std::vector<std::string> splitresults;
-			StringSplit(n.Params, ";", splitresults);
-			if (splitresults.size() < 3)
+			if (n.ParamCount < 3)
 				continue; //impossible
-			std::string ntype = splitresults[0];
 			std::string custommsg;
 			std::string ltype;
-			float svalue = static_cast<float>(atof(splitresults[2].c_str()));
+			float svalue = n.Value;
 			float ampere = 0.0F;
 			bool bSendNotification = false;
 			bool bCustomMessage = false;
 			bCustomMessage = CustomRecoveryMessage(n.ID, custommsg, false);
 
-			if (ntype == signamp1)
+			if (n.Type == NTYPE_AMPERE1)
 			{
 				ampere = Ampere1;
 				ltype = Notification_Type_Desc(NTYPE_AMPERE1, 0);
 			}
-			else if (ntype == signamp2)
+			else if (n.Type == NTYPE_AMPERE2)
 			{
 				ampere = Ampere2;
 				ltype = Notification_Type_Desc(NTYPE_AMPERE2, 0);
 			}
-			else if (ntype == signamp3)
+			else if (n.Type == NTYPE_AMPERE3)
 			{
 				ampere = Ampere3;
 				ltype = Notification_Type_Desc(NTYPE_AMPERE3, 0);
 			}
-			bSendNotification = ApplyRule(splitresults[1], (ampere == svalue), (ampere < svalue));
+			bSendNotification = ApplyRule(n.eRule, (ampere == svalue), (ampere < svalue));
 			if (bSendNotification && (!bRecoveryMessage || n.SendAlways))
 			{
-				sprintf(szTmp, "%s %s is %.1f Ampere [%s %.1f Ampere]", devicename.c_str(), ltype.c_str(), ampere, splitresults[1].c_str(), svalue);
+				sprintf(szTmp, "%s %s is %.1f Ampere [%s %.1f Ampere]", devicename.c_str(), ltype.c_str(), ampere, n.Rule.c_str(), svalue);
 				msg = szTmp;
 				sprintf(szTmp, "%.1f", ampere);
 				notValue = szTmp;
@@ -838,17 +904,11 @@ bool CNotificationHelper::CheckAndHandleNotification(
 	//check if not sent 12 hours ago, and if applicable
 	atime -= m_NotificationSensorInterval;
 
-	std::string ltype = Notification_Type_Desc(ntype, 1);
 	for (const auto &n : notifications)
 	{
 		if (n.LastUpdate)
 			TouchLastUpdate(n.ID);
-		std::vector<std::string> splitresults;
-		StringSplit(n.Params, ";", splitresults);
-		if (splitresults.empty())
-			continue; //impossible
-		std::string atype = splitresults[0];
-		if (atype == ltype)
+		if (n.Type == ntype)
 		{
 			if ((atime >= n.LastSend) || (n.SendAlways)) // emergency always goes true
 			{
@@ -899,7 +959,6 @@ bool CNotificationHelper::CheckAndHandleNotification(
 	std::string msg;
 
 	std::string ltype = Notification_Type_Desc(ntype, 0);
-	std::string nsign = Notification_Type_Desc(ntype, 1);
 	std::string label = Notification_Type_Label(ntype);
 
 	for (const auto &n : notifications)
@@ -914,23 +973,20 @@ bool CNotificationHelper::CheckAndHandleNotification(
 			bRecoveryMessage = CustomRecoveryMessage(n.ID, recoverymsg, true);
 			if ((atime < n.LastSend) && (!n.SendAlways) && (!bRecoveryMessage))
 				continue;
-			std::vector<std::string> splitresults;
-			StringSplit(n.Params, ";", splitresults);
-			if (splitresults.size() < 3)
+			if (n.ParamCount < 3)
 				continue; //impossible
-			std::string ntype = splitresults[0];
 			std::string custommsg;
-			float svalue = static_cast<float>(atof(splitresults[2].c_str()));
+			float svalue = n.Value;
 			bool bSendNotification = false;
 			bool bCustomMessage = false;
 			bCustomMessage = CustomRecoveryMessage(n.ID, custommsg, false);
 
-			if (ntype == nsign)
+			if (n.Type == ntype)
 			{
-				bSendNotification = ApplyRule(splitresults[1], (mvalue == svalue), (mvalue < svalue));
+				bSendNotification = ApplyRule(n.eRule, (mvalue == svalue), (mvalue < svalue));
 				if (bSendNotification && (!bRecoveryMessage || n.SendAlways))
 				{
-					sprintf(szTmp, "%s %s is %s %s [%s %.1f %s]", devicename.c_str(), ltype.c_str(), pvalue.c_str(), label.c_str(), splitresults[1].c_str(), svalue, label.c_str());
+					sprintf(szTmp, "%s %s is %s %s [%s %.1f %s]", devicename.c_str(), ltype.c_str(), pvalue.c_str(), label.c_str(), n.Rule.c_str(), svalue, label.c_str());
 					msg = szTmp;
 				}
 				else if (!bSendNotification && bRecoveryMessage)
@@ -981,8 +1037,6 @@ bool CNotificationHelper::CheckAndHandleSwitchNotification(
 
 	std::string msg;
 
-	std::string ltype = Notification_Type_Desc(ntype, 1);
-
 	time_t atime = mytime(nullptr);
 	atime -= m_NotificationSwitchInterval;
 
@@ -990,16 +1044,10 @@ bool CNotificationHelper::CheckAndHandleSwitchNotification(
 	{
 		if ((atime >= n.LastSend) || (n.SendAlways)) // emergency always goes true
 		{
-			std::vector<std::string> splitresults;
-			StringSplit(n.Params, ";", splitresults);
-			if (splitresults.empty())
-				continue; //impossible
-			std::string atype = splitresults[0];
-
 			bool bSendNotification = false;
 			std::string notValue;
 
-			if (atype == ltype)
+			if (n.Type == ntype)
 			{
 				bSendNotification = true;
 				msg = devicename;
@@ -1094,8 +1142,6 @@ bool CNotificationHelper::CheckAndHandleSwitchNotification(
 
 	std::string msg;
 
-	std::string ltype = Notification_Type_Desc(ntype, 1);
-
 	time_t atime = mytime(nullptr);
 	atime -= m_NotificationSwitchInterval;
 
@@ -1103,24 +1149,18 @@ bool CNotificationHelper::CheckAndHandleSwitchNotification(
 	{
 		if ((atime >= n.LastSend) || (n.SendAlways)) // emergency always goes true
 		{
-			std::vector<std::string> splitresults;
-			StringSplit(n.Params, ";", splitresults);
-			if (splitresults.empty())
-				continue; //impossible
-			std::string atype = splitresults[0];
-
 			bool bSendNotification = false;
 			std::string notValue;
 
-			if (atype == ltype)
+			if (n.Type == ntype)
 			{
 				msg = devicename;
 				if (ntype == NTYPE_SWITCH_ON)
 				{
-					if (splitresults.size() < 3)
+					if (n.ParamCount < 3)
 						continue; //impossible
-					bool bWhenEqual = (splitresults[1] == "=");
-					int iLevel = atoi(splitresults[2].c_str());
+					bool bWhenEqual = (n.eRule == NRULE_EQUAL);
+					int iLevel = static_cast<int>(n.Value);
 					if (!bWhenEqual || iLevel < 10 || iLevel > 100)
 						continue; //invalid
 
@@ -1225,89 +1265,114 @@ bool CNotificationHelper::CheckAndHandleRainNotification(
 }
 
 
+//Executed every second, only the notifications that are due are evaluated
 void CNotificationHelper::CheckAndHandleLastUpdateNotification()
 {
-	if (m_notifications.empty())
-		return;
+	std::vector<uint64_t> expired;
+	std::vector<std::pair<uint64_t, _tNotification>> duelist;
+	{
+		std::lock_guard<std::mutex> l(m_mutex);
+		m_lastupdatewheel.Advance(mytime(nullptr), expired);
+		for (const auto &nID : expired)
+		{
+			_tNotification *pNotification = FindNotification(nID);
+			if (pNotification != nullptr)
+				duelist.push_back(std::make_pair(m_notificationdevices[nID], *pNotification));
+		}
+	}
 
+	for (const auto &due : duelist)
+	{
+		time_t nextcheck = HandleLastUpdateNotification(due.first, due.second);
+		std::lock_guard<std::mutex> l(m_mutex);
+		//the device could have been updated (and rescheduled) in the meantime
+		if ((FindNotification(due.second.ID) != nullptr) && (!m_lastupdatewheel.IsScheduled(due.second.ID)))
+			m_lastupdatewheel.Schedule(due.second.ID, nextcheck);
+	}
+}
+
+//Returns the time this notification should be evaluated again
+time_t CNotificationHelper::HandleLastUpdateNotification(const uint64_t Idx, const _tNotification &n2)
+{
 	time_t atime = mytime(nullptr);
+	time_t nextcheck = atime + 60;
+
+	if (n2.ParamCount < 3)
+		return nextcheck;
+
+	uint32_t SensorTimeOut = static_cast<uint32_t>(n2.Value);  // minutes
+	time_t deadline = n2.LastUpdate + (SensorTimeOut * 60);
+	if (atime < deadline)
+	{
+		//'<', '<=' and '!=' rules are already true before the deadline and are checked every minute
+		if ((n2.eRule == NRULE_GREATER) || (n2.eRule == NRULE_GREATER_EQUAL) || (n2.eRule == NRULE_EQUAL) || (deadline < nextcheck))
+			nextcheck = deadline;
+	}
+	else if (atime == deadline)
+		nextcheck = atime + 1;
+
 	atime -= m_NotificationSensorInterval;
 
-	for (const auto &n : m_notifications)
+	if (((atime >= n2.LastSend) || (n2.SendAlways) || (!n2.CustomMessage.empty()))
+	    && (n2.LastUpdate)) // emergency always goes true
 	{
-		for (const auto &n2 : n.second)
+		std::string recoverymsg;
+		bool bRecoveryMessage = false;
+		bRecoveryMessage = CustomRecoveryMessage(n2.ID, recoverymsg, true);
+		if ((atime < n2.LastSend) && (!n2.SendAlways) && (!bRecoveryMessage))
+			return nextcheck;
+		extern time_t m_StartTime;
+		time_t btime = mytime(nullptr);
+		std::string msg;
+		std::string szExtraData;
+		std::string custommsg;
+		uint32_t diff = static_cast<uint32_t>(round(difftime(btime, n2.LastUpdate)));
+		bool bStartTime = (difftime(btime, m_StartTime) < SensorTimeOut * 60);
+		bool bSendNotification = ApplyRule(n2.eRule, (diff == SensorTimeOut * 60), (diff < SensorTimeOut * 60));
+		bool bCustomMessage = false;
+		bCustomMessage = CustomRecoveryMessage(n2.ID, custommsg, false);
+
+		if (bSendNotification && !bStartTime && (!bRecoveryMessage || n2.SendAlways))
 		{
-			if (((atime >= n2.LastSend) || (n2.SendAlways) || (!n2.CustomMessage.empty()))
-			    && (n2.LastUpdate)) // emergency always goes true
-			{
-				std::vector<std::string> splitresults;
-				StringSplit(n2.Params, ";", splitresults);
-				if (splitresults.size() < 3)
-					continue;
-				std::string ttype = Notification_Type_Desc(NTYPE_LASTUPDATE, 1);
-				if (splitresults[0] == ttype)
-				{
-					std::string recoverymsg;
-					bool bRecoveryMessage = false;
-					bRecoveryMessage = CustomRecoveryMessage(n2.ID, recoverymsg, true);
-					if ((atime < n2.LastSend) && (!n2.SendAlways) && (!bRecoveryMessage))
-						continue;
-					extern time_t m_StartTime;
-					time_t btime = mytime(nullptr);
-					std::string msg;
-					std::string szExtraData;
-					std::string custommsg;
-					uint64_t Idx = n.first;
-					uint32_t SensorTimeOut = static_cast<uint32_t>(atoi(splitresults[2].c_str()));  // minutes
-					uint32_t diff = static_cast<uint32_t>(round(difftime(btime, n2.LastUpdate)));
-					bool bStartTime = (difftime(btime, m_StartTime) < SensorTimeOut * 60);
-					bool bSendNotification = ApplyRule(splitresults[1], (diff == SensorTimeOut * 60), (diff < SensorTimeOut * 60));
-					bool bCustomMessage = false;
-					bCustomMessage = CustomRecoveryMessage(n2.ID, custommsg, false);
-
-					if (bSendNotification && !bStartTime && (!bRecoveryMessage || n2.SendAlways))
-					{
-						if (SystemUptime() < SensorTimeOut * 60 && (!bRecoveryMessage || n2.SendAlways))
-							continue;
-						std::vector<std::vector<std::string> > result;
-						result = m_sql.safe_query("SELECT SwitchType FROM DeviceStatus WHERE (ID=%" PRIu64 ")", Idx);
-						if (result.empty())
-							continue;
-						szExtraData = "|Name=" + n2.DeviceName + "|SwitchType=" + result[0][0] + "|";
-						std::string ltype = Notification_Type_Desc(NTYPE_LASTUPDATE, 0);
-						std::string label = Notification_Type_Label(NTYPE_LASTUPDATE);
-						char szDate[50];
-						char szTmp[300];
-						struct tm ltime;
-						localtime_r(&n2.LastUpdate, &ltime);
-						sprintf(szDate, "%04d-%02d-%02d %02d:%02d:%02d", ltime.tm_year + 1900, ltime.tm_mon + 1, ltime.tm_mday,
-							ltime.tm_hour, ltime.tm_min, ltime.tm_sec);
-						sprintf(szTmp, "Sensor %s %s: %s [%s %d %s]", n2.DeviceName.c_str(), ltype.c_str(), szDate,
-							splitresults[1].c_str(), SensorTimeOut, label.c_str());
-						msg = szTmp;
-					}
-					else if (!bSendNotification && bRecoveryMessage)
-					{
-						msg = recoverymsg;
-						std::string clearstr = "!";
-						CustomRecoveryMessage(n2.ID, clearstr, true);
-					}
-					else
-						continue;
-
-					if (bCustomMessage && !bRecoveryMessage)
-						msg = ParseCustomMessage(custommsg, n2.DeviceName, "");
-					SendMessageEx(Idx, n2.DeviceName, n2.ActiveSystems, msg, msg, szExtraData, n2.Priority,
-						      std::string(""), true);
-					if (!bRecoveryMessage)
-					{
-						TouchNotification(n2.ID);
-						CustomRecoveryMessage(n2.ID, msg, true);
-					}
-				}
-			}
+			if (SystemUptime() < SensorTimeOut * 60 && (!bRecoveryMessage || n2.SendAlways))
+				return nextcheck;
+			std::vector<std::vector<std::string> > result;
+			result = m_sql.safe_query("SELECT SwitchType FROM DeviceStatus WHERE (ID=%" PRIu64 ")", Idx);
+			if (result.empty())
+				return nextcheck;
+			szExtraData = "|Name=" + n2.DeviceName + "|SwitchType=" + result[0][0] + "|";
+			std::string ltype = Notification_Type_Desc(NTYPE_LASTUPDATE, 0);
+			std::string label = Notification_Type_Label(NTYPE_LASTUPDATE);
+			char szDate[50];
+			char szTmp[300];
+			struct tm ltime;
+			localtime_r(&n2.LastUpdate, &ltime);
+			sprintf(szDate, "%04d-%02d-%02d %02d:%02d:%02d", ltime.tm_year + 1900, ltime.tm_mon + 1, ltime.tm_mday,
+				ltime.tm_hour, ltime.tm_min, ltime.tm_sec);
+			sprintf(szTmp, "Sensor %s %s: %s [%s %d %s]", n2.DeviceName.c_str(), ltype.c_str(), szDate,
+				n2.Rule.c_str(), SensorTimeOut, label.c_str());
+			msg = szTmp;
+		}
+		else if (!bSendNotification && bRecoveryMessage)
+		{
+			msg = recoverymsg;
+			std::string clearstr = "!";
+			CustomRecoveryMessage(n2.ID, clearstr, true);
+		}
+		else
+			return nextcheck;
+
+		if (bCustomMessage && !bRecoveryMessage)
+			msg = ParseCustomMessage(custommsg, n2.DeviceName, "");
+		SendMessageEx(Idx, n2.DeviceName, n2.ActiveSystems, msg, msg, szExtraData, n2.Priority,
+			      std::string(""), true);
+		if (!bRecoveryMessage)
+		{
+			TouchNotification(n2.ID);
+			CustomRecoveryMessage(n2.ID, msg, true);
 		}
 	}
+	return nextcheck;
 }
 
 void CNotificationHelper::TouchNotification(const uint64_t ID)
@@ -1324,109 +1389,69 @@ void CNotificationHelper::TouchNotification(const uint64_t ID)
 
 	//Also touch it internally
 	std::lock_guard<std::mutex> l(m_mutex);
-
-	for (auto &m : m_notifications)
-	{
-		for (auto &n : m.second)
-		{
-			if (n.ID == ID)
-			{
-				n.LastSend = atime;
-				return;
-			}
-		}
-	}
+	_tNotification *pNotification = FindNotification(ID);
+	if (pNotification != nullptr)
+		pNotification->LastSend = atime;
 }
 
 void CNotificationHelper::TouchLastUpdate(const uint64_t ID)
 {
 	time_t atime = mytime(nullptr);
 	std::lock_guard<std::mutex> l(m_mutex);
-
-	for (auto &m : m_notifications)
-	{
-		for (auto &n : m.second)
-		{
-			if (n.ID == ID)
-			{
-				n.LastUpdate = atime;
-				return;
-			}
-		}
-	}
+	_tNotification *pNotification = FindNotification(ID);
+	if (pNotification == nullptr)
+		return;
+	pNotification->LastUpdate = atime;
+	//evaluate it right away for a possible recovery message, it will then wait for its deadline
+	if (pNotification->Type == NTYPE_LASTUPDATE)
+		m_lastupdatewheel.Schedule(ID, atime);
 }
 
 bool CNotificationHelper::CustomRecoveryMessage(const uint64_t ID, std::string &msg, const bool isRecovery)
 {
 	std::lock_guard<std::mutex> l(m_mutex);
+	_tNotification *pNotification = FindNotification(ID);
+	if (pNotification == nullptr)
+		return false;
+	_tNotification &n = *pNotification;
+
+	if ((isRecovery) && (!n.bRecovery))
+		return false;
 
-	for (auto &m : m_notifications)
+	if (msg.empty())
 	{
-		for (auto &n : m.second)
+		if (!n.Message.empty() && !isRecovery)
 		{
-			if (n.ID == ID)
-			{
-				std::vector<std::string> splitresults;
-				if (isRecovery)
-				{
-					StringSplit(n.Params, ";", splitresults);
-					if (splitresults.size() < 4)
-						return false;
-					if (splitresults[3] != "1")
-						return false;
-				}
-
-				std::string szTmp;
-				StringSplit(n.CustomMessage, ";;", splitresults);
-				if (msg.empty())
-				{
-					if (!splitresults.empty())
-					{
-						if (!splitresults[0].empty() && !isRecovery)
-						{
-							szTmp = splitresults[0];
-							msg = szTmp;
-							return true;
-						}
-						if (splitresults.size() > 1)
-						{
-							if (!splitresults[1].empty() && isRecovery)
-							{
-								szTmp = splitresults[1];
-								msg = szTmp;
-								return true;
-							}
-						}
-					}
-					return false;
-				}
-				if (!isRecovery)
-					return false;
-
-				if (!splitresults.empty())
-				{
-					if (!splitresults[0].empty())
-						szTmp = splitresults[0];
-				}
-				if ((msg.find('!') != 0) && (msg.size() > 1))
-				{
-					szTmp.append(";;[Recovered] ");
-					szTmp.append(msg);
-				}
-				std::vector<std::vector<std::string> > result;
-				result = m_sql.safe_query("SELECT ID FROM Notifications WHERE (ID=='%" PRIu64 "') AND (Params=='%q')", n.ID,
-							  n.Params.c_str());
-				if (result.empty())
-					return false;
-
-				m_sql.safe_query("UPDATE Notifications SET CustomMessage='%q' WHERE ID=='%" PRIu64 "'", szTmp.c_str(),
-						 n.ID);
-				n.CustomMessage = szTmp;
-				return true;
-			}
+			msg = n.Message;
+			return true;
+		}
+		if (!n.RecoveryMessage.empty() && isRecovery)
+		{
+			msg = n.RecoveryMessage;
+			return true;
 		}
+		return false;
 	}
-	return false;
+	if (!isRecovery)
+		return false;
+
+	std::string szTmp = n.Message;
+	if ((msg.find('!') != 0) && (msg.size() > 1))
+	{
+		szTmp.append(";;[Recovered] ");
+		szTmp.append(msg);
+	}
+	std::vector<std::vector<std::string> > result;
+	result = m_sql.safe_query("SELECT ID FROM Notifications WHERE (ID=='%" PRIu64 "') AND (Params=='%q')", n.ID,
+				  n.Params.c_str());
+	if (result.empty())
+		return false;
+
+	m_sql.safe_query("UPDATE Notifications SET CustomMessage='%q' WHERE ID=='%" PRIu64 "'", szTmp.c_str(),
+			 n.ID);
+	n.CustomMessage = szTmp;
+	CompileCustomMessage(n);
+	return true;
 }
 
 bool CNotificationHelper::AddNotification(
@@ -1508,6 +1533,8 @@ void CNotificationHelper::ReloadNotifications()
 {
 	std::lock_guard<std::mutex> l(m_mutex);
 	m_notifications.clear();
+	m_notificationdevices.clear();
+	m_lastupdatewheel.Clear();
 	std::vector<std::vector<std::string> > result;
 
 	m_sql.GetPreferencesVar("NotificationSensorInterval", m_NotificationSensorInterval);
@@ -1520,13 +1547,13 @@ void CNotificationHelper::ReloadNotifications()
 	time_t mtime = mytime(nullptr);
 	struct tm atime;
 	localtime_r(&mtime, &atime);
-	std::vector<std::string> splitresults;
 
 	std::stringstream sstr;
 
 	for (const auto &sd : result)
 	{
 		_tNotification notification;
+		notification.LastUpdate = 0;
 		uint64_t Idx;
 
 		sstr.clear();
@@ -1557,9 +1584,9 @@ void CNotificationHelper::ReloadNotifications()
 			struct tm ntime;
 			ParseSQLdatetime(notification.LastSend, ntime, stime, atime.tm_isdst);
 		}
-		std::string ttype = Notification_Type_Desc(NTYPE_LASTUPDATE, 1);
-		StringSplit(notification.Params, ";", splitresults);
-		if (splitresults[0] == ttype) {
+		CompileNotification(notification);
+		if (notification.Type == NTYPE_LASTUPDATE) {
+			std::string ttype = Notification_Type_Desc(NTYPE_LASTUPDATE, 1);
 			std::vector<std::vector<std::string> > result2;
 			result2 = m_sql.safe_query(
 				"SELECT B.Name, B.LastUpdate "
@@ -1577,7 +1604,9 @@ void CNotificationHelper::ReloadNotifications()
 				std::string stime = result2[0][1];
 				ParseSQLdatetime(notification.LastUpdate, ntime, stime, atime.tm_isdst);
 			}
+			m_lastupdatewheel.Schedule(notification.ID, mtime + 60);
 		}
+		m_notificationdevices[notification.ID] = Idx;
 		m_notifications[Idx].push_back(notification);
 	}
 }
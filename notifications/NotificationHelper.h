@@ -1,11 +1,23 @@
 #pragma once
 #include "NotificationBase.h"
 #include "../webserver/cWebem.h"
+#include "../main/TimerWheel.h"
 
 #include <string>
 
 #define NOTIFYALL std::string("")
 
+enum _eNotificationRule
+{
+	NRULE_NONE = 0,
+	NRULE_GREATER,
+	NRULE_GREATER_EQUAL,
+	NRULE_EQUAL,
+	NRULE_NOT_EQUAL,
+	NRULE_LESS_EQUAL,
+	NRULE_LESS,
+};
+
 struct _tNotification
 {
 	uint64_t ID;
@@ -17,6 +29,16 @@ struct _tNotification
 	std::string CustomMessage;
 	std::string ActiveSystems;
 	bool SendAlways;
+
+	//Compiled from Params/CustomMessage when (re)loaded, so they are not parsed on every update
+	int Type;		     //_eNotificationTypes, -1 when unknown
+	std::string Rule;	     //comparator as entered, used in the messages
+	_eNotificationRule eRule;
+	float Value;		     //threshold (level for switches)
+	size_t ParamCount;
+	bool bRecovery;		     //send a recovery message
+	std::string Message;	     //custom message
+	std::string RecoveryMessage; //custom recovery message
 };
 
 class CNotificationHelper
@@ -80,9 +102,15 @@ class CNotificationHelper
 	bool CheckAndHandleAmpere123Notification(uint64_t Idx, const std::string &DeviceName, float Ampere1, float Ampere2, float Ampere3);
 
 	std::string ParseCustomMessage(const std::string &cMessage, const std::string &sName, const std::string &sValue);
-	bool ApplyRule(const std::string &rule, bool equal, bool less);
+	bool ApplyRule(_eNotificationRule rule, bool equal, bool less);
+	static void CompileNotification(_tNotification &n);
+	static void CompileCustomMessage(_tNotification &n);
+	_tNotification *FindNotification(uint64_t ID);
+	time_t HandleLastUpdateNotification(uint64_t Idx, const _tNotification &n2);
 	std::mutex m_mutex;
 	std::map<uint64_t, std::vector<_tNotification>> m_notifications;
+	std::map<uint64_t, uint64_t> m_notificationdevices; // notification ID -> device idx
+	CTimerWheel<uint64_t> m_lastupdatewheel; // LastUpdate notification ID -> next evaluation time
 	int m_NotificationSensorInterval;
 	int m_NotificationSwitchInterval;
 };
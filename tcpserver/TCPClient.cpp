@@ -5,6 +5,8 @@
 #include "../main/Logger.h"
 #include "../webserver/proxyclient.h"
 
+#define TCPCLIENT_MAX_WRITE_QUEUE 500
+
 namespace tcp {
 namespace server {
 
@@ -85,15 +87,63 @@ void CTCPClient::write(const char *pData, size_t Length)
 {
 	if (!m_bIsLoggedIn)
 		return;
-	boost::asio::async_write(*socket_, boost::asio::buffer(pData, Length), [self = shared_from_this()](auto &&err, auto) { self->handleWrite(err); });
+	std::lock_guard<std::mutex> l(m_write_mutex);
+	if (m_write_queue.size() >= TCPCLIENT_MAX_WRITE_QUEUE)
+	{
+		//Client can't keep up, drop the oldest frame that is not yet in flight
+		//and disconnect it when it stalled for a complete queue
+		if (m_dropped_frames == 0)
+			_log.Log(LOG_ERROR, "TCPServer: Client %s (%s) is too slow, dropping frames!", m_username.c_str(), m_endpoint.c_str());
+		m_write_queue.erase(m_write_queue.begin() + (m_bWriting ? 1 : 0));
+		if (++m_dropped_frames >= TCPCLIENT_MAX_WRITE_QUEUE)
+		{
+			_log.Log(LOG_ERROR, "TCPServer: Client %s (%s) stalled, disconnecting!", m_username.c_str(), m_endpoint.c_str());
+			m_write_queue.clear();
+			boost::asio::post(socket_->get_executor(), [self = shared_from_this()] { self->pConnectionManager->stopClient(self); });
+			return;
+		}
+	}
+	m_write_queue.emplace_back(pData, Length);
+	if (m_bWriting)
+		return;
+	m_bWriting = true;
+	//The actual write is done from the io_service thread, never from the caller
+	boost::asio::post(socket_->get_executor(), [self = shared_from_this()] { self->doWrite(); });
+}
+
+void CTCPClient::doWrite()
+{
+	std::lock_guard<std::mutex> l(m_write_mutex);
+	if (m_write_queue.empty())
+	{
+		m_bWriting = false;
+		return;
+	}
+	//the front frame stays in the queue (and its buffer valid) until the write completes
+	const std::string &frame = m_write_queue.front();
+	boost::asio::async_write(*socket_, boost::asio::buffer(frame.data(), frame.size()), [self = shared_from_this()](auto &&err, auto) { self->handleWrite(err); });
 }
 
 void CTCPClient::handleWrite(const boost::system::error_code& error)
 {
 	if (error)
 	{
-		pConnectionManager->stopClient(shared_from_this());
+		{
+			std::lock_guard<std::mutex> l(m_write_mutex);
+			m_write_queue.clear();
+			m_bWriting = false;
+		}
+		if (error != boost::asio::error::operation_aborted)
+			pConnectionManager->stopClient(shared_from_this());
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> l(m_write_mutex);
+		if (!m_write_queue.empty())
+			m_write_queue.pop_front();
+		m_dropped_frames = 0;
 	}
+	doWrite();
 }
 
 #ifndef NOCLOUD
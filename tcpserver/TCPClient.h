@@ -2,6 +2,7 @@
 
 #include "../main/Noncopyable.h"
 #include <boost/asio.hpp>
+#include <deque>
 
 namespace http {
 	namespace server {
@@ -53,9 +54,16 @@ public:
       private:
 	void handleRead(const boost::system::error_code& error, size_t length);
 	void handleWrite(const boost::system::error_code& error);
+	void doWrite();
 
 	/// Buffer for incoming data.
 	std::array<char, 8192> buffer_;
+
+	/// Outgoing frames, the front one is in flight while m_bWriting is set
+	std::deque<std::string> m_write_queue;
+	std::mutex m_write_mutex;
+	bool m_bWriting = false;
+	size_t m_dropped_frames = 0;
 };
 
 #ifndef NOCLOUD
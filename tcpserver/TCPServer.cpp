@@ -164,6 +164,25 @@ void CTCPServerIntBase::SetRemoteUsers(const std::vector<_tRemoteShareUser> &use
 {
 	std::lock_guard<std::mutex> l(connectionMutex);
 	m_users=users;
+
+	//Precompute the device ACL per user, so SendToAll does not have to search the device lists
+	m_user_acl.clear();
+	for (const auto &user : m_users)
+	{
+		_tRemoteUserACL &acl = m_user_acl[user.Username];
+		acl.bAllDevices = user.Devices.empty();
+		acl.Devices.insert(user.Devices.begin(), user.Devices.end());
+	}
+}
+
+bool CTCPServerIntBase::IsDeviceAllowed(const std::string &username, const uint64_t DeviceRowID)
+{
+	auto itt = m_user_acl.find(username);
+	if (itt == m_user_acl.end())
+		return false;
+	if (itt->second.bAllDevices)
+		return true;
+	return (itt->second.Devices.find(DeviceRowID) != itt->second.Devices.end());
 }
 
 unsigned int CTCPServerIntBase::GetUserDevicesCount(const std::string &username)
@@ -188,25 +207,13 @@ void CTCPServerIntBase::SendToAll(const int /*HardwareID*/, const uint64_t Devic
 	for (const auto &c : connections_)
 	{
 		CTCPClientBase *pClient = c.get();
-		if (pClient==pClient2Ignore)
+		if ((pClient == nullptr) || (pClient == pClient2Ignore))
 			continue;
 
-		if (pClient)
-		{
-			_tRemoteShareUser *pUser=FindUser(pClient->m_username);
-			if (pUser != nullptr)
-			{
-				//check if we are allowed to get this device
-				bool bOk2Send=false;
-				if (pUser->Devices.empty())
-					bOk2Send=true;
-				else
-					bOk2Send = std::any_of(pUser->Devices.begin(), pUser->Devices.end(), [DeviceRowID](uint64_t d) { return d == DeviceRowID; });
-
-				if (bOk2Send)
-					pClient->write(pData,Length);
-			}
-		}
+		//check if we are allowed to get this device
+		//write only queues the frame, the socket is serviced by the server thread
+		if (IsDeviceAllowed(pClient->m_username, DeviceRowID))
+			pClient->write(pData, Length);
 	}
 }
 
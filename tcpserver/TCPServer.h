@@ -51,12 +51,20 @@ protected:
 		std::string string;
 	};
 
+	struct _tRemoteUserACL
+	{
+		bool bAllDevices;
+		std::set<uint64_t> Devices;
+	};
+
 	_tRemoteShareUser* FindUser(const std::string &username);
+	bool IsDeviceAllowed(const std::string &username, uint64_t DeviceRowID);
 
 	bool HandleAuthentication(const CTCPClient_ptr &c, const std::string &username, const std::string &password);
 	void DoDecodeMessage(const CTCPClientBase *pClient, const unsigned char *pRXCommand);
 
 	std::vector<_tRemoteShareUser> m_users;
+	std::map<std::string, _tRemoteUserACL> m_user_acl;
 	CTCPServer *m_pRoot;
 
 	std::set<CTCPClient_ptr> connections_;
@@ -0,0 +1,130 @@
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <vector>
+
+//Runs a fuzz target over the given files, for compilers without libFuzzer (and to replay a crash or the seed corpus)
+//
+//With -bench=N every file is parsed N times and the throughput and heap allocations per run are reported,
+//to measure the effect of parser changes on the seed corpus:
+//  ./fuzz_p1 -bench=10000 ../test/fuzz/corpus/p1/*
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+extern "C" __attribute__((weak)) int LLVMFuzzerInitialize(int *argc, char ***argv);
+
+//Counts the operator new calls, the parsers allocate through std::string/std::vector
+static std::atomic<uint64_t> g_allocations(0);
+
+void *operator new(size_t size)
+{
+	g_allocations.fetch_add(1, std::memory_order_relaxed);
+	void *p = malloc((size != 0) ? size : 1);
+	if (p == nullptr)
+		throw std::bad_alloc();
+	return p;
+}
+void *operator new[](size_t size)
+{
+	return operator new(size);
+}
+void *operator new(size_t size, const std::nothrow_t & /*tag*/) noexcept
+{
+	g_allocations.fetch_add(1, std::memory_order_relaxed);
+	return malloc((size != 0) ? size : 1);
+}
+void *operator new[](size_t size, const std::nothrow_t &tag) noexcept
+{
+	return operator new(size, tag);
+}
+void operator delete(void *p) noexcept
+{
+	free(p);
+}
+void operator delete[](void *p) noexcept
+{
+	free(p);
+}
+void operator delete(void *p, size_t /*size*/) noexcept
+{
+	free(p);
+}
+void operator delete[](void *p, size_t /*size*/) noexcept
+{
+	free(p);
+}
+
+static bool ReadFile(const char *szFile, std::vector<uint8_t> &data)
+{
+	FILE *fIn = fopen(szFile, "rb");
+	if (fIn == nullptr)
+	{
+		fprintf(stderr, "Could not open: %s\n", szFile);
+		return false;
+	}
+	uint8_t block[4096];
+	size_t bread;
+	while ((bread = fread(block, 1, sizeof(block), fIn)) > 0)
+		data.insert(data.end(), block, block + bread);
+	fclose(fIn);
+	return true;
+}
+
+static void Bench(const char *szFile, const std::vector<uint8_t> &data, const int iRuns, double &totSeconds, uint64_t &totBytes, uint64_t &totAllocations)
+{
+	uint64_t allocations = g_allocations.load();
+	auto tStart = std::chrono::steady_clock::now();
+	for (int ii = 0; ii < iRuns; ii++)
+		LLVMFuzzerTestOneInput(data.data(), data.size());
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - tStart).count();
+	allocations = g_allocations.load() - allocations;
+
+	uint64_t bytes = static_cast<uint64_t>(data.size()) * iRuns;
+	printf("%s: %d bytes, %.2f MB/s, %.1f allocations per run\n", szFile, static_cast<int>(data.size()), (seconds > 0) ? (bytes / seconds / 1e6) : 0.0,
+	       static_cast<double>(allocations) / iRuns);
+	totSeconds += seconds;
+	totBytes += bytes;
+	totAllocations += allocations;
+}
+
+int main(int argc, char *argv[])
+{
+	if (LLVMFuzzerInitialize != nullptr)
+		LLVMFuzzerInitialize(&argc, &argv);
+	int iRuns = 0;
+	int ret = 0;
+	double totSeconds = 0;
+	uint64_t totBytes = 0;
+	uint64_t totAllocations = 0;
+	int iFiles = 0;
+	for (int ii = 1; ii < argc; ii++)
+	{
+		if (strncmp(argv[ii], "-bench=", 7) == 0)
+		{
+			iRuns = atoi(argv[ii] + 7);
+			continue;
+		}
+		std::vector<uint8_t> data;
+		if (!ReadFile(argv[ii], data))
+		{
+			ret = 1;
+			continue;
+		}
+		if (iRuns > 0)
+		{
+			Bench(argv[ii], data, iRuns, totSeconds, totBytes, totAllocations);
+			iFiles++;
+			continue;
+		}
+		LLVMFuzzerTestOneInput(data.data(), data.size());
+		printf("%s: %d bytes\n", argv[ii], static_cast<int>(data.size()));
+	}
+	if (iFiles > 0)
+	{
+		printf("Total: %d files x %d runs, %.2f MB/s, %.1f allocations per KB\n", iFiles, iRuns, (totSeconds > 0) ? (totBytes / totSeconds / 1e6) : 0.0,
+		       (totBytes > 0) ? (totAllocations * 1024.0 / totBytes) : 0.0);
+	}
+	return ret;
+}
@@ -0,0 +1,52 @@
+#include "stdafx.h"
+#include "../../hardware/EnOceanESP3.h"
+
+//EnOcean serial protocol 3 frames (sync byte, header, CRC8H, data, optional data, CRC8D), as read from the USB gateway
+//The first input byte selects the format of the rest:
+//bit 0 = 0: raw serial data, including the framing and CRCs
+//bit 0 = 1: packets of [type][data length][optional data length][data][optional data], framed with valid CRCs,
+//           so mutations reach the telegram decoding instead of failing the CRC check
+class CEnOceanESP3Fuzzer : public CEnOceanESP3
+{
+      public:
+	CEnOceanESP3Fuzzer()
+		: CEnOceanESP3(1, "", 0)
+	{
+	}
+	void Parse(const uint8_t *pData, const size_t length)
+	{
+		ReadCallback(reinterpret_cast<const char *>(pData), length);
+	}
+	void ParsePackets(const uint8_t *pData, size_t length)
+	{
+		while (length >= 3)
+		{
+			uint8_t packettype = pData[0];
+			uint16_t datalen = pData[1];
+			uint8_t optdatalen = pData[2];
+			pData += 3;
+			length -= 3;
+			if (datalen > length)
+				datalen = static_cast<uint16_t>(length);
+			if (optdatalen > length - datalen)
+				optdatalen = static_cast<uint8_t>(length - datalen);
+			uint8_t *data = const_cast<uint8_t *>(pData);
+			std::string sFrame = FormatESP3Packet(packettype, data, datalen, data + datalen, optdatalen);
+			ReadCallback(sFrame.data(), sFrame.size());
+			pData += datalen + optdatalen;
+			length -= datalen + optdatalen;
+		}
+	}
+};
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+	if ((size < 1) || (size > 64 * 1024))
+		return 0;
+	CEnOceanESP3Fuzzer enocean;
+	if (data[0] & 0x01)
+		enocean.ParsePackets(data + 1, size - 1);
+	else
+		enocean.Parse(data + 1, size - 1);
+	return 0;
+}
@@ -0,0 +1,44 @@
+#include "stdafx.h"
+#include "../../hardware/P1MeterBase.h"
+
+//P1 smart meter telegrams, as read from the serial port or TCP gateway
+//The first input byte selects the options: bit 0 = check the CRC, bit 1 = encrypted (DSMR 5 / e-MUCS) frames
+class CP1MeterFuzzer : public P1MeterBase
+{
+      public:
+	explicit CP1MeterFuzzer(const bool bEncrypted)
+	{
+		if (bEncrypted)
+		{
+			m_bIsEncrypted = true;
+			m_szHexKey.assign(16, 0);
+		}
+	}
+	bool WriteToHardware(const char * /*pdata*/, const unsigned char /*length*/) override
+	{
+		return false;
+	}
+	void Parse(const uint8_t *pData, const size_t length, const bool bDisableCRC)
+	{
+		ParseP1Data(pData, static_cast<int>(length), bDisableCRC, 0);
+	}
+
+      private:
+	bool StartHardware() override
+	{
+		return true;
+	}
+	bool StopHardware() override
+	{
+		return true;
+	}
+};
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+	if ((size < 1) || (size > 64 * 1024))
+		return 0;
+	CP1MeterFuzzer p1((data[0] & 0x02) != 0);
+	p1.Parse(data + 1, size - 1, (data[0] & 0x01) == 0);
+	return 0;
+}
@@ -0,0 +1,45 @@
+#include "stdafx.h"
+#include "../../hardware/plugins/PluginMessages.h"
+#include "../../hardware/plugins/PluginProtocols.h"
+
+using namespace Plugins;
+
+//Plugin connection protocols, fed the way a transport feeds them
+//Input: protocol byte, read size byte, then the received data, delivered in reads of that size until the connection closes
+
+static const char *szProtocols[] = { "Line", "JSON", "XML", "HTTP", "MQTT", "WS" };
+
+extern "C" int LLVMFuzzerInitialize(int * /*argc*/, char *** /*argv*/)
+{
+	if (!Py_LoadLibrary())
+	{
+		fprintf(stderr, "Python library could not be loaded\n");
+		abort();
+	}
+	Py_Initialize();
+	return 0;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+	if ((size < 2) || (size > 64 * 1024))
+		return 0;
+	static CPlugin plugin(1, "Fuzz", "Fuzz");
+
+	//only the reference count is used, the protocols pass the connection on to the messages
+	CConnection connection = {};
+	((PyObject *)&connection)->ob_refcnt = 1;
+
+	std::unique_ptr<CPluginProtocol> pProtocol(CPluginProtocol::Create(szProtocols[data[0] % (sizeof(szProtocols) / sizeof(szProtocols[0]))]));
+	size_t readsize = (data[1] != 0) ? data[1] : size;
+	size_t pos = 2;
+	while (pos < size)
+	{
+		size_t length = std::min(readsize, size - pos);
+		ReadEvent Message(&plugin, &connection, static_cast<int>(length), data + pos);
+		pProtocol->ProcessInbound(&Message);
+		pos += length;
+	}
+	pProtocol->Flush(&plugin, &connection);
+	return 0;
+}
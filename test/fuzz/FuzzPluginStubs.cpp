@@ -0,0 +1,77 @@
+#include "stdafx.h"
+#include "../../hardware/plugins/PluginMessages.h"
+
+//Stand-in for the plugin a connection belongs to, the protocol messages it receives are dropped
+
+namespace Plugins
+{
+	std::mutex PythonMutex;
+
+	CPlugin::CPlugin(const int HwdID, const std::string &sName, const std::string &sPluginKey)
+		: m_iPollInterval(10)
+		, m_PyInterpreter(nullptr)
+		, m_PyModule(nullptr)
+		, m_Notifier(nullptr)
+		, m_PluginKey(sPluginKey)
+		, m_DeviceDict(nullptr)
+		, m_ImageDict(nullptr)
+		, m_SettingsDict(nullptr)
+		, m_bDebug(PDM_NONE)
+	{
+		m_HwdID = HwdID;
+		m_Name = sName;
+		m_bIsStarting = false;
+		m_bIsStopped = false;
+		m_bTracing = false;
+	}
+
+	CPlugin::~CPlugin() = default;
+
+	bool CPlugin::StartHardware()
+	{
+		return true;
+	}
+
+	bool CPlugin::StopHardware()
+	{
+		return true;
+	}
+
+	bool CPlugin::WriteToHardware(const char * /*pdata*/, const unsigned char /*length*/)
+	{
+		return false;
+	}
+
+	void CPlugin::MessagePlugin(CPluginMessageBase *pMessage)
+	{
+		onMessageCallback *pCallback = dynamic_cast<onMessageCallback *>(pMessage);
+		if (pCallback != nullptr)
+			Py_XDECREF(pCallback->m_Data);
+		delete pMessage;
+	}
+
+	void CPlugin::ConnectionRead(CPluginMessageBase * /*pMessage*/)
+	{
+	}
+
+	void CPlugin::DisconnectEvent(CEventBase * /*pMessage*/)
+	{
+	}
+
+	void CPlugin::Callback(PyObject * /*pTarget*/, const std::string & /*sHandler*/, PyObject * /*pParams*/)
+	{
+	}
+
+	//the fuzzer is single threaded and keeps the GIL
+	void CPlugin::RestoreThread()
+	{
+	}
+
+	void CPlugin::ReleaseThread()
+	{
+	}
+
+	void CPlugin::WriteDebugBuffer(const std::vector<byte> & /*Buffer*/, bool /*Incoming*/)
+	{
+	}
+} // namespace Plugins
@@ -0,0 +1,35 @@
+#include "stdafx.h"
+#include "../../hardware/RFLinkBase.h"
+
+//RFLink gateway lines ("20;2D;Oregon TempHygro;ID=0A4D;TEMP=00be;HUM=40;BAT=OK;")
+class CRFLinkFuzzer : public CRFLinkBase
+{
+      public:
+	bool WriteInt(const std::string & /*sendString*/) override
+	{
+		return true;
+	}
+	void Parse(const uint8_t *pData, const size_t length)
+	{
+		ParseData(reinterpret_cast<const char *>(pData), length);
+	}
+
+      private:
+	bool StartHardware() override
+	{
+		return true;
+	}
+	bool StopHardware() override
+	{
+		return true;
+	}
+};
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+	if (size > 64 * 1024)
+		return 0;
+	CRFLinkFuzzer rflink;
+	rflink.Parse(data, size);
+	return 0;
+}
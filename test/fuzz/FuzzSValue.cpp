@@ -0,0 +1,56 @@
+#include "stdafx.h"
+#include "../../main/SValueFields.h"
+#include <cmath>
+
+//Device sValues ("21.5;65;1"), one per line, parsed the way the log aggregators and UpdateValue do for every row/update
+//The first input byte selects the options: bit 0 = also split with StringSplit + atof and check that both agree
+//Benchmarked with -bench=N, the sval_* seeds report the allocations per update of the parse without (bit 0 clear)
+//and with (bit 0 set) the old StringSplit path
+static bool SameValue(const double v1, const double v2)
+{
+	if (std::isnan(v1) || std::isnan(v2))
+		return std::isnan(v1) && std::isnan(v2);
+	return v1 == v2;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+	if ((size < 1) || (size > 64 * 1024))
+		return 0;
+	const bool bCompare = (data[0] & 0x01) != 0;
+	const char *pData = reinterpret_cast<const char *>(data + 1);
+	const char *pEnd = pData + size - 1;
+
+	std::string sValue;
+	while (pData < pEnd)
+	{
+		const char *pEol = static_cast<const char *>(memchr(pData, '\n', pEnd - pData));
+		if (pEol == nullptr)
+			pEol = pEnd;
+		sValue.assign(pData, pEol - pData);
+		pData = pEol + 1;
+
+		//c_str() stops at an embedded 0, like the sValue that is stored in the database
+		sValue.resize(strlen(sValue.c_str()));
+
+		_tSValueFields fields;
+		fields.Parse(sValue);
+		double fValues[2];
+		size_t nValues = StringSplitDouble(sValue.c_str(), ';', fValues, 2);
+		if (nValues != fields.count)
+			abort();
+
+		if (!bCompare)
+			continue;
+		std::vector<std::string> splitresults;
+		StringSplit(sValue, ";", splitresults);
+		if (splitresults.size() != fields.count)
+			abort();
+		for (size_t ii = 0; ii < splitresults.size() && ii < SVALUE_MAX_FIELDS; ii++)
+		{
+			if (!SameValue(atof(splitresults[ii].c_str()), fields.value[ii]))
+				abort();
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,143 @@
+#include "stdafx.h"
+#include "../../hardware/DomoticzHardware.h"
+#include "../../main/Logger.h"
+#include "../../main/SQLHelper.h"
+#include "../../main/RFXNames.h"
+
+//Minimal stand-ins for the parts of Domoticz the protocol parsers call into
+//Decoded values are dropped, the database is empty and logging is discarded, only the parsing itself is exercised
+
+CLogger _log;
+CSQLHelper m_sql;
+
+CLogger::CLogger() = default;
+CLogger::~CLogger() = default;
+void CLogger::Log(_eLogLevel /*level*/, const char * /*logline*/, ...)
+{
+}
+void CLogger::Log(_eLogLevel /*level*/, const std::string & /*sLogline*/)
+{
+}
+void CLogger::Debug(_eDebugLevel /*level*/, const char * /*logline*/, ...)
+{
+}
+void CLogger::Debug(_eDebugLevel /*level*/, const std::string & /*sLogline*/)
+{
+}
+
+CSQLHelper::CSQLHelper() = default;
+CSQLHelper::~CSQLHelper() = default;
+std::vector<std::vector<std::string>> CSQLHelper::safe_query(const char * /*fmt*/, ...)
+{
+	return std::vector<std::vector<std::string>>();
+}
+
+//RFXNames.cpp pulls in most of the hardware classes
+unsigned char Get_Humidity_Level(const unsigned char /*hlevel*/)
+{
+	return 0;
+}
+
+CDomoticzHardwareBase::CDomoticzHardwareBase() = default;
+int CDomoticzHardwareBase::SetThreadNameInt(const std::thread::native_handle_type & /*thread*/)
+{
+	return 0;
+}
+bool CDomoticzHardwareBase::CustomCommand(uint64_t /*idx*/, const std::string & /*sCommand*/)
+{
+	return false;
+}
+void CDomoticzHardwareBase::Log(_eLogLevel /*level*/, const char * /*logline*/, ...)
+{
+}
+void CDomoticzHardwareBase::Log(_eLogLevel /*level*/, const std::string & /*sLogline*/)
+{
+}
+void CDomoticzHardwareBase::Debug(_eDebugLevel /*level*/, const char * /*logline*/, ...)
+{
+}
+void CDomoticzHardwareBase::Debug(_eDebugLevel /*level*/, const std::string & /*sLogline*/)
+{
+}
+bool CDomoticzHardwareBase::GetWindSensorValue(int, int &, float &, float &, float &, float &, bool, bool &bExists)
+{
+	bExists = false;
+	return false;
+}
+
+//Sensor helpers, the values are dropped
+void CDomoticzHardwareBase::SendTempSensor(int, int, float, const std::string &, int)
+{
+}
+void CDomoticzHardwareBase::SendHumiditySensor(int, int, int, const std::string &, int)
+{
+}
+void CDomoticzHardwareBase::SendBaroSensor(int, int, int, float, int, const std::string &)
+{
+}
+void CDomoticzHardwareBase::SendTempHumSensor(int, int, float, int, const std::string &, int)
+{
+}
+void CDomoticzHardwareBase::SendTempHumBaroSensor(int, int, float, int, float, int, const std::string &, int)
+{
+}
+void CDomoticzHardwareBase::SendKwhMeterOldWay(int, int, int, double, double, const std::string &, int)
+{
+}
+void CDomoticzHardwareBase::SendWattMeter(uint8_t, uint8_t, int, float, const std::string &, int)
+{
+}
+void CDomoticzHardwareBase::SendLuxSensor(uint8_t, uint8_t, uint8_t, float, const std::string &)
+{
+}
+void CDomoticzHardwareBase::SendAirQualitySensor(uint8_t, uint8_t, int, int, const std::string &)
+{
+}
+void CDomoticzHardwareBase::SendRGBWSwitch(int, uint8_t, int, int, bool, const std::string &, const std::string &)
+{
+}
+void CDomoticzHardwareBase::SendVoltageSensor(int, uint32_t, int, float, const std::string &)
+{
+}
+void CDomoticzHardwareBase::SendCurrentSensor(int, int, float, float, float, const std::string &, int)
+{
+}
+void CDomoticzHardwareBase::SendPercentageSensor(int, uint8_t, int, float, const std::string &)
+{
+}
+void CDomoticzHardwareBase::SendRainSensor(int, int, float, const std::string &, int)
+{
+}
+void CDomoticzHardwareBase::SendWind(int, int, int, float, float, float, float, bool, bool, const std::string &, int)
+{
+}
+void CDomoticzHardwareBase::SendDistanceSensor(int, int, int, float, const std::string &, int)
+{
+}
+void CDomoticzHardwareBase::SendMeterSensor(int, int, int, float, const std::string &, int)
+{
+}
+void CDomoticzHardwareBase::SendUVSensor(int, int, int, float, const std::string &, int)
+{
+}
+void CDomoticzHardwareBase::SendBlindSensor(uint8_t, uint8_t, int, uint8_t, const std::string &, const std::string &, int)
+{
+}
+void CDomoticzHardwareBase::SendSoundSensor(int, int, int, const std::string &)
+{
+}
+void CDomoticzHardwareBase::SendCustomSensor(int, uint8_t, int, float, const std::string &, const std::string &, int)
+{
+}
+void CDomoticzHardwareBase::SendKwhMeter(int, int, int, double, double, const std::string &, int)
+{
+}
+void CDomoticzHardwareBase::SendAlertSensor(int, int, int, const std::string &, const std::string &)
+{
+}
+void CDomoticzHardwareBase::SendSwitch(int, uint8_t, int, bool, double, const std::string &, const std::string &, int)
+{
+}
+void CDomoticzHardwareBase::SendGeneralSwitch(int, int, int, uint8_t, uint8_t, const std::string &, const std::string &, int)
+{
+}
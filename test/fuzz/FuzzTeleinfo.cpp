@@ -0,0 +1,43 @@
+#include "stdafx.h"
+#include "../../hardware/TeleinfoBase.h"
+
+//Teleinfo (French Linky/electronic meter) frames, as read from the serial port
+//The first input byte selects the options: bit 0 = check the checksums
+class CTeleinfoFuzzer : public CTeleinfoBase
+{
+      public:
+	explicit CTeleinfoFuzzer(const bool bDisableCRC)
+	{
+		m_bDisableCRC = bDisableCRC;
+		m_iBaudRate = 1200;
+		m_iRateLimit = 0;
+		m_iDataTimeout = 0;
+	}
+	bool WriteToHardware(const char * /*pdata*/, const unsigned char /*length*/) override
+	{
+		return false;
+	}
+	void Parse(const uint8_t *pData, const size_t length)
+	{
+		ParseTeleinfoData(reinterpret_cast<const char *>(pData), static_cast<int>(length));
+	}
+
+      private:
+	bool StartHardware() override
+	{
+		return true;
+	}
+	bool StopHardware() override
+	{
+		return true;
+	}
+};
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+	if ((size < 1) || (size > 64 * 1024))
+		return 0;
+	CTeleinfoFuzzer teleinfo((data[0] & 0x01) == 0);
+	teleinfo.Parse(data + 1, size - 1);
+	return 0;
+}
@@ -2,6 +2,8 @@
 
 #include <boost/asio.hpp>
 #include <boost/thread.hpp>
+#include <memory>
+#include <set>
 #include "server.hpp"
 #include "session_store.hpp"
 
@@ -34,6 +36,7 @@ namespace http
 			_eUserRights userrights;
 			int TotSensors;
 			int ActiveTabs;
+			std::shared_ptr<const std::set<uint64_t>> SharedDevices; //devices shared with this user, swapped as a whole (std::atomic_load/store)
 		} WebUserPassword;
 
 		typedef struct _tWebEmSession